@@ -0,0 +1,194 @@
+#ifndef TM_KIT_TRANSPORT_BENCHMARKS_BENCHMARK_HELPER_HPP_
+#define TM_KIT_TRANSPORT_BENCHMARKS_BENCHMARK_HELPER_HPP_
+
+#include <tm_kit/transport/TransportMetricsComponent.hpp>
+
+#include <nlohmann/json.hpp>
+
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <map>
+#include <regex>
+#include <sstream>
+#include <functional>
+#include <cstdint>
+#include <cstring>
+
+namespace dev { namespace cd606 { namespace tm { namespace transport { namespace benchmarks {
+
+    //Command line options shared by all benchmark executables:
+    //  --filter=<regex>       only run the cases whose full name matches
+    //  --messages=<n>         messages (or iterations) per case
+    //  --payload=<n>[,<n>...] payload sizes in bytes
+    //  --timeout-ms=<n>       how long to wait for a message before it counts
+    //                         as lost
+    //  --port-base=<n>        first port used by the network cases
+    //The results go to stdout as one JSON document, a readable summary goes
+    //to stderr.
+    struct BenchmarkOptions {
+        std::regex filter {".*"};
+        std::size_t messages = 100000;
+        std::vector<std::size_t> payloadSizes {64, 4096};
+        std::chrono::milliseconds timeout {1000};
+        int portBase = 34500;
+
+        static BenchmarkOptions parse(int argc, char **argv, std::size_t defaultMessages) {
+            BenchmarkOptions ret;
+            ret.messages = defaultMessages;
+            for (int ii=1; ii<argc; ++ii) {
+                std::string arg = argv[ii];
+                auto eq = arg.find('=');
+                std::string key = arg.substr(0, eq);
+                std::string value = (eq == std::string::npos)?"":arg.substr(eq+1);
+                if (key == "--filter") {
+                    ret.filter = std::regex(value);
+                } else if (key == "--messages") {
+                    ret.messages = std::stoul(value);
+                } else if (key == "--payload") {
+                    ret.payloadSizes.clear();
+                    std::istringstream iss(value);
+                    std::string part;
+                    while (std::getline(iss, part, ',')) {
+                        ret.payloadSizes.push_back(std::stoul(part));
+                    }
+                } else if (key == "--timeout-ms") {
+                    ret.timeout = std::chrono::milliseconds(std::stol(value));
+                } else if (key == "--port-base") {
+                    ret.portBase = std::stoi(value);
+                } else {
+                    throw std::runtime_error("Unknown benchmark option '"+arg+"'");
+                }
+            }
+            return ret;
+        }
+    };
+
+    struct BenchmarkResult {
+        std::string name;
+        std::map<std::string, std::string> params;
+        uint64_t iterations = 0;
+        uint64_t bytes = 0;
+        //for transports, messages sent but not received within the timeout
+        uint64_t lost = 0;
+        std::chrono::steady_clock::duration elapsed {0};
+        TransportLatencySnapshot latency;
+    };
+
+    class BenchmarkReporter {
+    private:
+        std::string suite_;
+        BenchmarkOptions options_;
+        nlohmann::json results_;
+    public:
+        BenchmarkReporter(std::string const &suite, BenchmarkOptions const &options)
+            : suite_(suite), options_(options), results_(nlohmann::json::array())
+        {}
+        BenchmarkOptions const &options() const {
+            return options_;
+        }
+        bool selected(std::string const &name) const {
+            return std::regex_search(name, options_.filter);
+        }
+        void report(BenchmarkResult const &r) {
+            double seconds = std::chrono::duration<double>(r.elapsed).count();
+            nlohmann::json item;
+            item["name"] = r.name;
+            item["params"] = r.params;
+            item["iterations"] = r.iterations;
+            item["bytes"] = r.bytes;
+            item["lost"] = r.lost;
+            item["seconds"] = seconds;
+            item["per_second"] = (seconds > 0)?(static_cast<double>(r.iterations)/seconds):0.0;
+            item["bytes_per_second"] = (seconds > 0)?(static_cast<double>(r.bytes)/seconds):0.0;
+            item["ns_per_iteration"] = (r.iterations > 0)?(seconds*1e9/static_cast<double>(r.iterations)):0.0;
+            if (r.latency.count > 0) {
+                item["latency_ns"] = {
+                    {"count", r.latency.count}
+                    , {"min", r.latency.minNanos}
+                    , {"p50", r.latency.percentileNanos(0.5)}
+                    , {"p90", r.latency.percentileNanos(0.9)}
+                    , {"p99", r.latency.percentileNanos(0.99)}
+                    , {"p999", r.latency.percentileNanos(0.999)}
+                    , {"max", r.latency.maxNanos}
+                };
+            }
+            results_.push_back(item);
+
+            std::cerr << std::left << std::setw(56) << r.name
+                << std::right << std::setw(14) << std::fixed << std::setprecision(1) << item["per_second"].get<double>() << "/s"
+                << std::setw(12) << std::setprecision(1) << item["ns_per_iteration"].get<double>() << "ns/it";
+            if (r.latency.count > 0) {
+                std::cerr << "  p50=" << r.latency.percentileNanos(0.5) << "ns p99=" << r.latency.percentileNanos(0.99) << "ns";
+            }
+            if (r.lost > 0) {
+                std::cerr << "  lost=" << r.lost;
+            }
+            std::cerr << '\n';
+        }
+        void finish() {
+            nlohmann::json doc;
+            doc["format_version"] = 1;
+            doc["suite"] = suite_;
+            doc["messages"] = options_.messages;
+            doc["results"] = results_;
+            std::cout << doc.dump(2) << std::endl;
+        }
+    };
+
+    inline std::string caseName(std::string const &base, std::map<std::string, std::string> const &params) {
+        std::string ret = base;
+        for (auto const &p : params) {
+            ret += "/"+p.first+":"+p.second;
+        }
+        return ret;
+    }
+
+    //Runs f for the given number of iterations, f gets the iteration index
+    //and returns the number of bytes it processed
+    inline BenchmarkResult runLoop(std::string const &name, std::map<std::string, std::string> const &params, std::size_t iterations, std::function<std::size_t(std::size_t)> const &f) {
+        BenchmarkResult ret;
+        ret.name = caseName(name, params);
+        ret.params = params;
+        for (std::size_t ii=0; ii<std::min<std::size_t>(iterations/10+1, 1000); ++ii) {
+            f(ii);
+        }
+        auto start = std::chrono::steady_clock::now();
+        for (std::size_t ii=0; ii<iterations; ++ii) {
+            ret.bytes += f(ii);
+        }
+        ret.elapsed = std::chrono::steady_clock::now()-start;
+        ret.iterations = iterations;
+        return ret;
+    }
+
+    //The latency cases put the send time (steady clock) into the first 8
+    //bytes of the payload, sender and receiver are in the same process
+    inline int64_t steadyNowNanos() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()
+        ).count();
+    }
+    inline std::string makePayload(std::size_t size) {
+        std::string ret(std::max<std::size_t>(size, sizeof(int64_t)), '\0');
+        for (std::size_t ii=sizeof(int64_t); ii<ret.size(); ++ii) {
+            ret[ii] = static_cast<char>('a'+ii%26);
+        }
+        return ret;
+    }
+    inline void writeSendTime(std::string &payload, int64_t t) {
+        std::memcpy(payload.data(), &t, sizeof(int64_t));
+    }
+    inline int64_t readSendTime(std::string const &payload) {
+        int64_t t = 0;
+        if (payload.size() >= sizeof(int64_t)) {
+            std::memcpy(&t, payload.data(), sizeof(int64_t));
+        }
+        return t;
+    }
+
+} } } } }
+
+#endif
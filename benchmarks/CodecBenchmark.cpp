@@ -0,0 +1,176 @@
+#include "BenchmarkHelper.hpp"
+
+#include <tm_kit/basic/ByteData.hpp>
+#include <tm_kit/transport/ByteDataHook.hpp>
+#include <tm_kit/transport/LatencyStamping.hpp>
+
+#include <variant>
+
+using namespace dev::cd606::tm;
+using namespace dev::cd606::tm::transport;
+using namespace dev::cd606::tm::transport::benchmarks;
+
+namespace {
+    void cborCases(BenchmarkReporter &reporter) {
+        auto const &opts = reporter.options();
+        for (auto size : opts.payloadSizes) {
+            std::map<std::string, std::string> params {{"payload", std::to_string(size)}};
+            basic::ByteDataWithTopic withTopic {"bench.topic.a", makePayload(size)};
+            basic::ByteDataWithID withID {"0123456789abcdef0123456789abcdef", makePayload(size)};
+            auto encodedWithTopic = basic::bytedata_utils::RunCBORSerializer<basic::ByteDataWithTopic>::apply(withTopic);
+            auto encodedWithID = basic::bytedata_utils::RunCBORSerializer<basic::ByteDataWithID>::apply(withID);
+
+            if (reporter.selected(caseName("cbor/encode_with_topic", params))) {
+                reporter.report(runLoop("cbor/encode_with_topic", params, opts.messages, [&withTopic](std::size_t) {
+                    return basic::bytedata_utils::RunCBORSerializer<basic::ByteDataWithTopic>::apply(withTopic).length();
+                }));
+            }
+            if (reporter.selected(caseName("cbor/decode_with_topic", params))) {
+                reporter.report(runLoop("cbor/decode_with_topic", params, opts.messages, [&encodedWithTopic](std::size_t) -> std::size_t {
+                    auto res = basic::bytedata_utils::RunCBORDeserializer<basic::ByteDataWithTopic>::apply(std::string_view {encodedWithTopic}, 0);
+                    return res?std::get<0>(*res).content.length():0;
+                }));
+            }
+            if (reporter.selected(caseName("cbor/encode_with_id", params))) {
+                reporter.report(runLoop("cbor/encode_with_id", params, opts.messages, [&withID](std::size_t) {
+                    return basic::bytedata_utils::RunCBORSerializer<basic::ByteDataWithID>::apply(withID).length();
+                }));
+            }
+            if (reporter.selected(caseName("cbor/decode_with_id", params))) {
+                reporter.report(runLoop("cbor/decode_with_id", params, opts.messages, [&encodedWithID](std::size_t) -> std::size_t {
+                    auto res = basic::bytedata_utils::RunCBORDeserializer<basic::ByteDataWithID>::apply(std::string_view {encodedWithID}, 0);
+                    return res?std::get<0>(*res).content.length():0;
+                }));
+            }
+        }
+    }
+
+    //a stage that touches every byte, so that the chains do comparable work
+    UserToWireHook xorHook(char key) {
+        return UserToWireHook {
+            [key](basic::ByteData &&d) -> basic::ByteData {
+                for (auto &c : d.content) {
+                    c ^= key;
+                }
+                return std::move(d);
+            }
+        };
+    }
+    BufferedUserToWireHook bufferedXorHook(char key) {
+        return BufferedUserToWireHook {
+            [](std::size_t n) {return n;}
+            , [key](basic::ByteDataView const &input, char *output, std::size_t outputCapacity) -> std::optional<std::size_t> {
+                if (input.content.length() <= outputCapacity) {
+                    for (std::size_t ii=0; ii<input.content.length(); ++ii) {
+                        output[ii] = input.content[ii]^key;
+                    }
+                }
+                return input.content.length();
+            }
+        };
+    }
+
+    void hookCases(BenchmarkReporter &reporter) {
+        auto const &opts = reporter.options();
+        for (auto size : opts.payloadSizes) {
+            auto payload = makePayload(size);
+            for (std::size_t depth : {1, 2, 4}) {
+                std::map<std::string, std::string> params {{"payload", std::to_string(size)}, {"depth", std::to_string(depth)}};
+
+                std::optional<UserToWireHook> composed;
+                std::vector<BufferedUserToWireHook> bufferedChain;
+                for (std::size_t ii=0; ii<depth; ++ii) {
+                    composed = composeUserToWireHook(composed, std::optional<UserToWireHook> {xorHook(static_cast<char>(ii+1))});
+                    bufferedChain.push_back(bufferedXorHook(static_cast<char>(ii+1)));
+                }
+                if (reporter.selected(caseName("hook/composed_chain", params))) {
+                    reporter.report(runLoop("hook/composed_chain", params, opts.messages, [&composed,&payload](std::size_t) {
+                        return composed->hook(basic::ByteData {payload}).content.length();
+                    }));
+                }
+                auto fromBuffered = userToWireHookFromBufferedChain(bufferedChain);
+                if (reporter.selected(caseName("hook/buffered_chain", params))) {
+                    reporter.report(runLoop("hook/buffered_chain", params, opts.messages, [&fromBuffered,&payload](std::size_t) {
+                        return fromBuffered.hook(basic::ByteData {payload}).content.length();
+                    }));
+                }
+                HookScratchBuffers scratch;
+                if (reporter.selected(caseName("hook/buffered_chain_no_copy", params))) {
+                    reporter.report(runLoop("hook/buffered_chain_no_copy", params, opts.messages, [&bufferedChain,&payload,&scratch](std::size_t) -> std::size_t {
+                        auto res = byte_data_hook_utils::runBufferedHookChain(bufferedChain, basic::ByteDataView {payload}, scratch);
+                        return res?res->content.length():0;
+                    }));
+                }
+            }
+
+            std::map<std::string, std::string> params {{"payload", std::to_string(size)}};
+            auto stampOut = LatencyStampingHelper::outgoingHook();
+            auto stampIn = LatencyStampingHelper::incomingHook(nullptr);
+            auto stamped = stampOut.hook(basic::ByteData {payload});
+            if (reporter.selected(caseName("hook/latency_stamp", params))) {
+                reporter.report(runLoop("hook/latency_stamp", params, opts.messages, [&stampOut,&payload](std::size_t) {
+                    return stampOut.hook(basic::ByteData {payload}).content.length();
+                }));
+            }
+            if (reporter.selected(caseName("hook/latency_unstamp", params))) {
+                reporter.report(runLoop("hook/latency_unstamp", params, opts.messages, [&stampIn,&stamped](std::size_t) -> std::size_t {
+                    auto res = stampIn.hook(basic::byteDataView(stamped));
+                    return res?res->content.length():0;
+                }));
+            }
+        }
+    }
+
+    //the same dispatch the broadcast components do for each incoming
+    //message: every no-filter client, then exact topic matches, then regex
+    //matches
+    void topicCases(BenchmarkReporter &reporter) {
+        auto const &opts = reporter.options();
+        for (std::size_t subscribers : {1, 8, 64}) {
+            std::vector<std::string> exact;
+            std::vector<std::regex> patterns;
+            for (std::size_t ii=0; ii<subscribers; ++ii) {
+                exact.push_back("bench.topic."+std::to_string(ii));
+                patterns.push_back(std::regex("bench\\.topic\\."+std::to_string(ii)+"(\\..*)?"));
+            }
+            std::vector<std::string> incoming;
+            for (std::size_t ii=0; ii<subscribers*2; ++ii) {
+                incoming.push_back("bench.topic."+std::to_string(ii));
+            }
+            std::map<std::string, std::string> params {{"subscribers", std::to_string(subscribers)}};
+            if (reporter.selected(caseName("topic/exact", params))) {
+                reporter.report(runLoop("topic/exact", params, opts.messages, [&exact,&incoming](std::size_t ii) {
+                    auto const &t = incoming[ii%incoming.size()];
+                    std::size_t matched = 0;
+                    for (auto const &e : exact) {
+                        if (t == e) {
+                            ++matched;
+                        }
+                    }
+                    return (matched > 0)?t.length():0;
+                }));
+            }
+            if (reporter.selected(caseName("topic/regex", params))) {
+                reporter.report(runLoop("topic/regex", params, opts.messages, [&patterns,&incoming](std::size_t ii) {
+                    auto const &t = incoming[ii%incoming.size()];
+                    std::size_t matched = 0;
+                    for (auto const &p : patterns) {
+                        if (std::regex_match(t, p)) {
+                            ++matched;
+                        }
+                    }
+                    return (matched > 0)?t.length():0;
+                }));
+            }
+        }
+    }
+}
+
+int main(int argc, char **argv) {
+    BenchmarkReporter reporter("codec", BenchmarkOptions::parse(argc, argv, 200000));
+    cborCases(reporter);
+    hookCases(reporter);
+    topicCases(reporter);
+    reporter.finish();
+    return 0;
+}
@@ -0,0 +1,258 @@
+#include "BenchmarkHelper.hpp"
+
+#include <tm_kit/transport/multicast/MulticastComponent.hpp>
+#include <tm_kit/transport/shared_memory_broadcast/SharedMemoryBroadcastComponent.hpp>
+#include <tm_kit/transport/zeromq/ZeroMQComponent.hpp>
+#include <tm_kit/transport/nng/NNGComponent.hpp>
+#include <tm_kit/transport/singlecast/SinglecastComponent.hpp>
+#include <tm_kit/transport/inproc/InprocComponent.hpp>
+
+#include <boost/interprocess/shared_memory_object.hpp>
+
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <thread>
+
+#ifdef _MSC_VER
+#include <process.h>
+#define TM_BENCH_GETPID _getpid
+#else
+#include <unistd.h>
+#define TM_BENCH_GETPID getpid
+#endif
+
+using namespace dev::cd606::tm;
+using namespace dev::cd606::tm::transport;
+using namespace dev::cd606::tm::transport::benchmarks;
+
+namespace {
+    //One transport under test: all of them are used through the same
+    //subscribe/unsubscribe/publish shape as the broadcast components have.
+    struct PubSubChannel {
+        std::function<uint32_t(std::function<void(basic::ByteDataWithTopic &&)>)> subscribe;
+        std::function<void(uint32_t)> unsubscribe;
+        std::function<void(basic::ByteDataWithTopic &&)> publish;
+    };
+
+    struct ReceiveState {
+        TransportLatencyHistogram latency;
+        std::atomic<uint64_t> received {0};
+        std::atomic<int64_t> lastReceiveNanos {0};
+        std::mutex mutex;
+        std::condition_variable cond;
+
+        void onMessage(basic::ByteDataWithTopic &&d) {
+            auto now = steadyNowNanos();
+            auto sent = readSendTime(d.content);
+            if (sent > 0) {
+                latency.record(static_cast<uint64_t>(std::max<int64_t>(now-sent, 0)));
+            }
+            lastReceiveNanos.store(now, std::memory_order_relaxed);
+            {
+                std::lock_guard<std::mutex> _(mutex);
+                received.fetch_add(1, std::memory_order_release);
+            }
+            cond.notify_one();
+        }
+        bool waitFor(uint64_t count, std::chrono::milliseconds timeout) {
+            std::unique_lock<std::mutex> lock(mutex);
+            return cond.wait_for(lock, timeout, [this,count]() {
+                return received.load(std::memory_order_acquire) >= count;
+            });
+        }
+    };
+
+    //Subscribes, then publishes until the first message gets through, since
+    //the connection-based transports drop what is published before the
+    //subscriber is connected
+    std::shared_ptr<ReceiveState> connect(PubSubChannel const &channel, uint32_t &subscriptionID, std::chrono::milliseconds timeout) {
+        auto state = std::make_shared<ReceiveState>();
+        subscriptionID = channel.subscribe([state](basic::ByteDataWithTopic &&d) {
+            state->onMessage(std::move(d));
+        });
+        auto deadline = std::chrono::steady_clock::now()+timeout*5;
+        while (std::chrono::steady_clock::now() < deadline) {
+            channel.publish({"bench.topic", std::string(sizeof(int64_t), '\0')});
+            if (state->waitFor(1, std::chrono::milliseconds(50))) {
+                //let the rest of the warm-up messages drain
+                std::this_thread::sleep_for(std::chrono::milliseconds(100));
+                return state;
+            }
+        }
+        channel.unsubscribe(subscriptionID);
+        return nullptr;
+    }
+
+    //Publishes as fast as possible, the latency includes the queueing at
+    //the receiver
+    void throughputCase(BenchmarkReporter &reporter, std::string const &transport, PubSubChannel const &channel, std::size_t payloadSize) {
+        auto const &opts = reporter.options();
+        std::map<std::string, std::string> params {{"transport", transport}, {"payload", std::to_string(payloadSize)}};
+        auto name = caseName("pubsub/throughput", params);
+        if (!reporter.selected(name)) {
+            return;
+        }
+        uint32_t id;
+        auto state = connect(channel, id, opts.timeout);
+        if (!state) {
+            std::cerr << name << ": no message got through, skipped\n";
+            return;
+        }
+        auto base = state->received.load();
+        auto payload = makePayload(payloadSize);
+        auto start = std::chrono::steady_clock::now();
+        for (std::size_t ii=0; ii<opts.messages; ++ii) {
+            writeSendTime(payload, steadyNowNanos());
+            channel.publish({"bench.topic", payload});
+        }
+        //waits until everything is in, or nothing comes in for the timeout
+        while (true) {
+            auto got = state->received.load()-base;
+            if (got >= opts.messages || !state->waitFor(base+got+1, opts.timeout)) {
+                break;
+            }
+        }
+        channel.unsubscribe(id);
+
+        BenchmarkResult r;
+        r.name = name;
+        r.params = params;
+        r.iterations = std::min<uint64_t>(state->received.load()-base, opts.messages);
+        r.lost = opts.messages-r.iterations;
+        r.bytes = r.iterations*payloadSize;
+        if (r.iterations > 0) {
+            r.elapsed = std::chrono::nanoseconds(state->lastReceiveNanos.load())-start.time_since_epoch();
+        }
+        r.latency = state->latency.snapshot();
+        reporter.report(r);
+    }
+
+    //One message in flight at a time
+    void latencyCase(BenchmarkReporter &reporter, std::string const &transport, PubSubChannel const &channel, std::size_t payloadSize) {
+        auto const &opts = reporter.options();
+        std::map<std::string, std::string> params {{"transport", transport}, {"payload", std::to_string(payloadSize)}};
+        auto name = caseName("pubsub/latency", params);
+        if (!reporter.selected(name)) {
+            return;
+        }
+        uint32_t id;
+        auto state = connect(channel, id, opts.timeout);
+        if (!state) {
+            std::cerr << name << ": no message got through, skipped\n";
+            return;
+        }
+        //the warm-up messages carry no send time, so they are not in the
+        //histogram
+        auto rounds = std::max<std::size_t>(opts.messages/10, 1);
+        auto payload = makePayload(payloadSize);
+        uint64_t lost = 0;
+        auto start = std::chrono::steady_clock::now();
+        for (std::size_t ii=0; ii<rounds; ++ii) {
+            auto before = state->received.load();
+            writeSendTime(payload, steadyNowNanos());
+            channel.publish({"bench.topic", payload});
+            if (!state->waitFor(before+1, opts.timeout)) {
+                ++lost;
+            }
+        }
+        auto elapsed = std::chrono::steady_clock::now()-start;
+        channel.unsubscribe(id);
+
+        BenchmarkResult r;
+        r.name = name;
+        r.params = params;
+        r.iterations = rounds-lost;
+        r.lost = lost;
+        r.bytes = r.iterations*payloadSize;
+        r.elapsed = elapsed;
+        r.latency = state->latency.snapshot();
+        reporter.report(r);
+    }
+
+    void runChannel(BenchmarkReporter &reporter, std::string const &transport, PubSubChannel const &channel) {
+        for (auto size : reporter.options().payloadSizes) {
+            throughputCase(reporter, transport, channel, size);
+            latencyCase(reporter, transport, channel, size);
+        }
+    }
+}
+
+int main(int argc, char **argv) {
+    BenchmarkReporter reporter("pubsub", BenchmarkOptions::parse(argc, argv, 100000));
+    auto const &opts = reporter.options();
+    auto pid = std::to_string(TM_BENCH_GETPID());
+
+    {
+        multicast::MulticastComponent c;
+        auto locator = ConnectionLocator::parse("239.255.77.1:"+std::to_string(opts.portBase));
+        auto pub = c.multicast_getPublisher(locator);
+        runChannel(reporter, "multicast", PubSubChannel {
+            [&c,&locator](auto &&f) {return c.multicast_addSubscriptionClient(locator, multicast::MulticastComponent::NoTopicSelection {}, f);}
+            , [&c](uint32_t id) {c.multicast_removeSubscriptionClient(id);}
+            , [&pub](basic::ByteDataWithTopic &&d) {pub(std::move(d), 1);}
+        });
+    }
+    {
+        singlecast::SinglecastComponent c;
+        auto locator = ConnectionLocator::parse("127.0.0.1:"+std::to_string(opts.portBase+1));
+        auto pub = c.singlecast_getPublisher(locator);
+        runChannel(reporter, "singlecast", PubSubChannel {
+            [&c,&locator](auto &&f) {return c.singlecast_addSubscriptionClient(locator, singlecast::SinglecastComponent::NoTopicSelection {}, f);}
+            , [&c](uint32_t id) {c.singlecast_removeSubscriptionClient(id);}
+            , pub
+        });
+    }
+    {
+        std::string shmName = "tm_transport_bench_"+pid;
+        {
+            shared_memory_broadcast::SharedMemoryBroadcastComponent c;
+            auto locator = ConnectionLocator::parse("::::"+shmName+"[size=268435456]");
+            auto pub = c.shared_memory_broadcast_getPublisher(locator);
+            runChannel(reporter, "shared_memory_broadcast", PubSubChannel {
+                [&c,&locator](auto &&f) {return c.shared_memory_broadcast_addSubscriptionClient(locator, shared_memory_broadcast::SharedMemoryBroadcastComponent::NoTopicSelection {}, f);}
+                , [&c](uint32_t id) {c.shared_memory_broadcast_removeSubscriptionClient(id);}
+                , pub
+            });
+        }
+        boost::interprocess::shared_memory_object::remove(shmName.c_str());
+    }
+    for (auto const &z : std::vector<std::tuple<std::string, std::string>> {
+        {"zeromq_inproc", "inproc::::tm_transport_bench_"+pid}
+        , {"zeromq_ipc", "ipc::::/tmp/tm_transport_bench_"+pid+".ipc"}
+        , {"zeromq_tcp", "127.0.0.1:"+std::to_string(opts.portBase+2)}
+    }) {
+        zeromq::ZeroMQComponent c;
+        auto locator = ConnectionLocator::parse(std::get<1>(z));
+        //the publisher binds, so it is created first (inproc needs that)
+        auto pub = c.zeroMQ_getPublisher(locator);
+        runChannel(reporter, std::get<0>(z), PubSubChannel {
+            [&c,&locator](auto &&f) {return c.zeroMQ_addSubscriptionClient(locator, zeromq::ZeroMQComponent::NoTopicSelection {}, f);}
+            , [&c](uint32_t id) {c.zeroMQ_removeSubscriptionClient(id);}
+            , pub
+        });
+    }
+    {
+        inproc::InprocComponent c;
+        auto locator = ConnectionLocator::parse("::::tm_transport_bench");
+        auto pub = c.inproc_getPublisher(locator);
+        runChannel(reporter, "inproc", PubSubChannel {
+            [&c,&locator](auto &&f) {return c.inproc_addSubscriptionClient(locator, inproc::InprocComponent::NoTopicSelection {}, f);}
+            , [&c](uint32_t id) {c.inproc_removeSubscriptionClient(id);}
+            , pub
+        });
+    }
+    {
+        nng::NNGComponent c;
+        auto locator = ConnectionLocator::parse("127.0.0.1:"+std::to_string(opts.portBase+3));
+        auto pub = c.nng_getPublisher(locator);
+        runChannel(reporter, "nng", PubSubChannel {
+            [&c,&locator](auto &&f) {return c.nng_addSubscriptionClient(locator, nng::NNGComponent::NoTopicSelection {}, f);}
+            , [&c](uint32_t id) {c.nng_removeSubscriptionClient(id);}
+            , pub
+        });
+    }
+
+    reporter.finish();
+    return 0;
+}
@@ -0,0 +1,196 @@
+#include "BenchmarkHelper.hpp"
+
+#include <tm_kit/transport/socket_rpc/SocketRPCComponent.hpp>
+#include <tm_kit/transport/websocket/WebSocketComponent.hpp>
+
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <thread>
+
+using namespace dev::cd606::tm;
+using namespace dev::cd606::tm::transport;
+using namespace dev::cd606::tm::transport::benchmarks;
+
+namespace {
+    struct ReplyState {
+        TransportLatencyHistogram latency;
+        std::atomic<uint64_t> replies {0};
+        std::mutex mutex;
+        std::condition_variable cond;
+
+        void onReply(basic::ByteDataWithID &&d) {
+            auto sent = readSendTime(d.content);
+            if (sent > 0) {
+                latency.record(static_cast<uint64_t>(std::max<int64_t>(steadyNowNanos()-sent, 0)));
+            }
+            {
+                std::lock_guard<std::mutex> _(mutex);
+                replies.fetch_add(1, std::memory_order_release);
+            }
+            cond.notify_one();
+        }
+        bool waitFor(uint64_t count, std::chrono::milliseconds timeout) {
+            std::unique_lock<std::mutex> lock(mutex);
+            return cond.wait_for(lock, timeout, [this,count]() {
+                return replies.load(std::memory_order_acquire) >= count;
+            });
+        }
+    };
+
+    //The server side echoes every request as the final reply. The state is
+    //swapped per case, the client callback is registered only once.
+    struct RPCChannel {
+        std::function<void(basic::ByteDataWithID &&)> request;
+        std::shared_ptr<std::shared_ptr<ReplyState>> state;
+    };
+
+    std::shared_ptr<ReplyState> resetState(RPCChannel const &channel) {
+        auto s = std::make_shared<ReplyState>();
+        std::atomic_store(channel.state.get(), s);
+        return s;
+    }
+    std::function<void(bool, basic::ByteDataWithID &&)> replyHandler(std::shared_ptr<std::shared_ptr<ReplyState>> const &state) {
+        return [state](bool isFinal, basic::ByteDataWithID &&d) {
+            if (!isFinal) {
+                return;
+            }
+            auto s = std::atomic_load(state.get());
+            if (s) {
+                s->onReply(std::move(d));
+            }
+        };
+    }
+
+    bool connect(RPCChannel const &channel, std::chrono::milliseconds timeout) {
+        auto state = resetState(channel);
+        auto deadline = std::chrono::steady_clock::now()+timeout*5;
+        uint64_t sent = 0;
+        while (std::chrono::steady_clock::now() < deadline) {
+            channel.request({"warmup"+std::to_string(sent++), std::string(sizeof(int64_t), '\0')});
+            if (state->waitFor(1, std::chrono::milliseconds(100))) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(100));
+                return true;
+            }
+        }
+        return false;
+    }
+
+    //One request in flight at a time
+    void roundTripCase(BenchmarkReporter &reporter, std::string const &transport, RPCChannel const &channel, std::size_t payloadSize) {
+        auto const &opts = reporter.options();
+        std::map<std::string, std::string> params {{"transport", transport}, {"payload", std::to_string(payloadSize)}};
+        auto name = caseName("rpc/round_trip", params);
+        if (!reporter.selected(name)) {
+            return;
+        }
+        if (!connect(channel, opts.timeout)) {
+            std::cerr << name << ": no reply got through, skipped\n";
+            return;
+        }
+        auto state = resetState(channel);
+        auto payload = makePayload(payloadSize);
+        uint64_t lost = 0;
+        auto start = std::chrono::steady_clock::now();
+        for (std::size_t ii=0; ii<opts.messages; ++ii) {
+            auto before = state->replies.load();
+            writeSendTime(payload, steadyNowNanos());
+            channel.request({std::to_string(ii), payload});
+            if (!state->waitFor(before+1, opts.timeout)) {
+                ++lost;
+            }
+        }
+        BenchmarkResult r;
+        r.name = name;
+        r.params = params;
+        r.elapsed = std::chrono::steady_clock::now()-start;
+        r.iterations = opts.messages-lost;
+        r.lost = lost;
+        r.bytes = r.iterations*payloadSize;
+        r.latency = state->latency.snapshot();
+        reporter.report(r);
+    }
+
+    //Up to window requests in flight
+    void pipelinedCase(BenchmarkReporter &reporter, std::string const &transport, RPCChannel const &channel, std::size_t payloadSize, std::size_t window) {
+        auto const &opts = reporter.options();
+        std::map<std::string, std::string> params {{"transport", transport}, {"payload", std::to_string(payloadSize)}, {"window", std::to_string(window)}};
+        auto name = caseName("rpc/pipelined", params);
+        if (!reporter.selected(name)) {
+            return;
+        }
+        if (!connect(channel, opts.timeout)) {
+            std::cerr << name << ": no reply got through, skipped\n";
+            return;
+        }
+        auto state = resetState(channel);
+        auto payload = makePayload(payloadSize);
+        bool stalled = false;
+        auto start = std::chrono::steady_clock::now();
+        for (std::size_t ii=0; ii<opts.messages; ++ii) {
+            if (ii >= window && !state->waitFor(ii-window+1, opts.timeout)) {
+                stalled = true;
+                break;
+            }
+            writeSendTime(payload, steadyNowNanos());
+            channel.request({std::to_string(ii), payload});
+        }
+        if (!stalled) {
+            state->waitFor(opts.messages, opts.timeout);
+        }
+        BenchmarkResult r;
+        r.name = name;
+        r.params = params;
+        r.elapsed = std::chrono::steady_clock::now()-start;
+        r.iterations = std::min<uint64_t>(state->replies.load(), opts.messages);
+        r.lost = opts.messages-r.iterations;
+        r.bytes = r.iterations*payloadSize;
+        r.latency = state->latency.snapshot();
+        reporter.report(r);
+    }
+
+    void runChannel(BenchmarkReporter &reporter, std::string const &transport, RPCChannel const &channel) {
+        for (auto size : reporter.options().payloadSizes) {
+            roundTripCase(reporter, transport, channel, size);
+            pipelinedCase(reporter, transport, channel, size, 64);
+        }
+    }
+}
+
+int main(int argc, char **argv) {
+    BenchmarkReporter reporter("rpc", BenchmarkOptions::parse(argc, argv, 20000));
+    auto const &opts = reporter.options();
+
+    {
+        socket_rpc::SocketRPCComponent server;
+        socket_rpc::SocketRPCComponent client;
+        auto locator = ConnectionLocator::parse("127.0.0.1:"+std::to_string(opts.portBase+10));
+        auto replier = std::make_shared<std::function<void(bool, basic::ByteDataWithID &&)>>();
+        *replier = server.socket_rpc_setRPCServer(locator, [replier](basic::ByteDataWithID &&d) {
+            (*replier)(true, std::move(d));
+        });
+        RPCChannel channel {{}, std::make_shared<std::shared_ptr<ReplyState>>()};
+        channel.request = client.socket_rpc_setRPCClient(locator, replyHandler(channel.state));
+        runChannel(reporter, "socket_rpc", channel);
+        client.socket_rpc_removeRPCClient(locator);
+    }
+    {
+        web_socket::WebSocketComponent server;
+        web_socket::WebSocketComponent client;
+        auto locator = ConnectionLocator::parse("127.0.0.1:"+std::to_string(opts.portBase+11)+":::tm_transport_bench");
+        auto replier = std::make_shared<std::function<void(bool, basic::ByteDataWithID &&)>>();
+        *replier = server.websocket_setRPCServer(locator, [replier](basic::ByteDataWithID &&d) {
+            (*replier)(true, std::move(d));
+        });
+        //the websocket servers only start listening here
+        server.finalizeEnvironment();
+        RPCChannel channel {{}, std::make_shared<std::shared_ptr<ReplyState>>()};
+        uint32_t clientNumber = 0;
+        channel.request = client.websocket_setRPCClient(locator, replyHandler(channel.state), std::nullopt, &clientNumber);
+        runChannel(reporter, "websocket", channel);
+        client.websocket_removeRPCClient(locator, clientNumber);
+    }
+
+    reporter.finish();
+    return 0;
+}
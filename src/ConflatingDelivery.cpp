@@ -0,0 +1,118 @@
+#include <tm_kit/transport/ConflatingDelivery.hpp>
+
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace dev { namespace cd606 { namespace tm { namespace transport {
+
+    class ConflatingDeliveryImpl {
+    private:
+        std::function<void(basic::ByteDataWithTopic &&)> deliver_;
+        std::chrono::milliseconds interval_;
+        std::shared_ptr<TransportChannelMetrics> metrics_;
+        std::mutex mutex_;
+        std::condition_variable cond_;
+        std::unordered_map<std::string, std::string> slots_;
+        std::vector<std::string> dirtyTopics_;
+        bool running_;
+        std::thread thread_;
+
+        void run() {
+            std::vector<std::string> topics;
+            std::vector<basic::ByteDataWithTopic> batch;
+            while (true) {
+                {
+                    std::unique_lock<std::mutex> lock(mutex_);
+                    cond_.wait(lock, [this]() {
+                        return (!running_ || !dirtyTopics_.empty());
+                    });
+                    if (!running_) {
+                        return;
+                    }
+                    std::swap(topics, dirtyTopics_);
+                    for (auto &t : topics) {
+                        auto iter = slots_.find(t);
+                        batch.push_back({std::move(t), std::move(iter->second)});
+                        slots_.erase(iter);
+                    }
+                    topics.clear();
+                }
+                if (metrics_) {
+                    metrics_->setQueueDepth(0);
+                }
+                for (auto &d : batch) {
+                    deliver_(std::move(d));
+                }
+                batch.clear();
+                if (interval_.count() > 0) {
+                    std::unique_lock<std::mutex> lock(mutex_);
+                    if (cond_.wait_for(lock, interval_, [this]() {return !running_;})) {
+                        return;
+                    }
+                }
+            }
+        }
+    public:
+        ConflatingDeliveryImpl(std::function<void(basic::ByteDataWithTopic &&)> const &deliver, std::chrono::milliseconds interval, std::shared_ptr<TransportChannelMetrics> const &metrics)
+            : deliver_(deliver), interval_(interval), metrics_(metrics), mutex_(), cond_(), slots_(), dirtyTopics_(), running_(true), thread_()
+        {
+            thread_ = std::thread(&ConflatingDeliveryImpl::run, this);
+        }
+        ~ConflatingDeliveryImpl() {
+            {
+                std::lock_guard<std::mutex> _(mutex_);
+                running_ = false;
+            }
+            cond_.notify_one();
+            if (thread_.joinable()) {
+                thread_.join();
+            }
+        }
+        void push(basic::ByteDataWithTopic &&data) {
+            bool newlyDirty;
+            std::size_t depth;
+            {
+                std::lock_guard<std::mutex> _(mutex_);
+                auto iter = slots_.find(data.topic);
+                newlyDirty = (iter == slots_.end());
+                if (newlyDirty) {
+                    dirtyTopics_.push_back(data.topic);
+                    slots_.insert({std::move(data.topic), std::move(data.content)});
+                } else {
+                    iter->second = std::move(data.content);
+                }
+                depth = dirtyTopics_.size();
+            }
+            if (metrics_) {
+                if (newlyDirty) {
+                    metrics_->setQueueDepth(static_cast<int64_t>(depth));
+                } else {
+                    metrics_->recordConflated();
+                }
+            }
+            if (newlyDirty) {
+                cond_.notify_one();
+            }
+        }
+    };
+
+    std::chrono::milliseconds ConflatingDelivery::intervalFor(ConnectionLocator const &locator) {
+        try {
+            return std::chrono::milliseconds(std::stoll(locator.query("conflate_interval_ms", std::to_string(DefaultInterval.count()))));
+        } catch (std::exception const &) {
+            return DefaultInterval;
+        }
+    }
+
+    ConflatingDelivery::ConflatingDelivery(std::function<void(basic::ByteDataWithTopic &&)> const &deliver, std::chrono::milliseconds interval, std::shared_ptr<TransportChannelMetrics> const &metrics)
+        : impl_(std::make_unique<ConflatingDeliveryImpl>(deliver, interval, metrics))
+    {}
+    ConflatingDelivery::~ConflatingDelivery() {}
+    void ConflatingDelivery::push(basic::ByteDataWithTopic &&data) {
+        impl_->push(std::move(data));
+    }
+
+} } } }
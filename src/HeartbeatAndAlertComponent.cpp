@@ -19,6 +19,53 @@ namespace dev { namespace cd606 { namespace tm { namespace transport {
         std::unordered_map<std::string, std::string> facilityChannels_;
         std::map<std::string, HeartbeatMessage::OneItemStatus> status_;
         std::vector<std::function<void(HeartbeatMessage &&)>> extraHandlers_;
+        //delta heartbeat state, the changed sets hold the entries that
+        //changed since the last full heartbeat
+        std::size_t fullHeartbeatInterval_ = 1;
+        int64_t heartbeatCount_ = 0;
+        std::chrono::system_clock::time_point lastFullHeartbeatTime_;
+        std::unordered_set<std::string> changedBroadcastChannels_;
+        std::unordered_set<std::string> changedFacilityChannels_;
+        std::unordered_set<std::string> changedStatus_;
+
+        HeartbeatMessage fullHeartbeat(std::chrono::system_clock::time_point now) const {
+            return HeartbeatMessage {
+                uuidStr_
+                , now
+                , host_
+                , pid_
+                , identity_
+                , std::map<std::string, std::vector<std::string>> {broadcastChannels_.begin(), broadcastChannels_.end()}
+                , std::map<std::string, std::string> {facilityChannels_.begin(), facilityChannels_.end()}
+                , status_
+            };
+        }
+        HeartbeatMessage deltaHeartbeat(std::chrono::system_clock::time_point now) const {
+            std::map<std::string, std::vector<std::string>> broadcastChannels;
+            for (auto const &name : changedBroadcastChannels_) {
+                broadcastChannels.insert({name, broadcastChannels_.at(name)});
+            }
+            std::map<std::string, std::string> facilityChannels;
+            for (auto const &name : changedFacilityChannels_) {
+                facilityChannels.insert({name, facilityChannels_.at(name)});
+            }
+            std::map<std::string, HeartbeatMessage::OneItemStatus> status;
+            for (auto const &name : changedStatus_) {
+                status.insert({name, status_.at(name)});
+            }
+            HeartbeatMessage msg {
+                uuidStr_
+                , now
+                , host_
+                , pid_
+                , identity_
+                , std::move(broadcastChannels)
+                , std::move(facilityChannels)
+                , status
+            };
+            msg.markAsDelta(heartbeatCount_, lastFullHeartbeatTime_);
+            return msg;
+        }
     public:
         HeartbeatAndAlertComponentImpl() : uuidStr_(BoostUUIDComponent::id_to_string(BoostUUIDComponent::new_id())), clock_(nullptr), host_(), pid_(0), identity_(), publisher_(std::nullopt), mutex_(), broadcastChannels_(), facilityChannels_(), status_(), extraHandlers_() {}
         HeartbeatAndAlertComponentImpl(basic::real_time_clock::ClockComponent *clock, std::string const &identity) : uuidStr_(BoostUUIDComponent::id_to_string(BoostUUIDComponent::new_id())), clock_(clock), host_(hostname_util::hostname()), pid_(infra::pid_util::getpid()), identity_(identity), publisher_(std::nullopt), mutex_(), broadcastChannels_(), facilityChannels_(), status_(), extraHandlers_() {}
@@ -33,21 +80,36 @@ namespace dev { namespace cd606 { namespace tm { namespace transport {
         }
         void setStatus(std::string const &itemDescription, HeartbeatMessage::Status status, std::string const &info="") {
             std::lock_guard<std::mutex> _(mutex_);
-            status_[itemDescription] = {status, info};
+            auto iter = status_.find(itemDescription);
+            if (iter == status_.end()) {
+                status_.insert({itemDescription, {status, info}});
+            } else if (iter->second.status != status || iter->second.info != info) {
+                iter->second = {status, info};
+            } else {
+                return;
+            }
+            changedStatus_.insert(itemDescription);
         }
         void addBroadcastChannel(std::string const &name, std::string const &c) {
             std::lock_guard<std::mutex> _(mutex_);
             auto &channelVec = broadcastChannels_[name];
             if (std::find(channelVec.begin(), channelVec.end(), c) == channelVec.end()) {
                 channelVec.push_back(c);
+                changedBroadcastChannels_.insert(name);
             }
         }
         void addFacilityChannel(std::string const &name, std::string const &c) {
             std::lock_guard<std::mutex> _(mutex_);
             if (facilityChannels_.find(name) == facilityChannels_.end()) {
                 facilityChannels_.insert({name, c});
+                changedFacilityChannels_.insert(name);
             }
         }
+        void setFullHeartbeatInterval(std::size_t everyNPeriods) {
+            std::lock_guard<std::mutex> _(mutex_);
+            fullHeartbeatInterval_ = everyNPeriods;
+            heartbeatCount_ = 0;
+        }
         void sendAlert(std::string const &alertTopic, infra::LogLevel level, std::string const &message) {
             if (publisher_ && clock_) {
                 AlertMessage msg {clock_->now(), host_, pid_, identity_, level, message};
@@ -63,29 +125,46 @@ namespace dev { namespace cd606 { namespace tm { namespace transport {
         }
         void publishHeartbeat(std::string const &heartbeatTopic) {
             if (publisher_ && clock_) {
-                HeartbeatMessage msg;
+                std::optional<HeartbeatMessage> fullMsg;
+                std::optional<HeartbeatMessage> deltaMsg;
                 {
                     std::lock_guard<std::mutex> _(mutex_);
-                    msg = HeartbeatMessage {
-                        uuidStr_
-                        , clock_->now()
-                        , host_
-                        , pid_
-                        , identity_
-                        , std::map<std::string, std::vector<std::string>> {broadcastChannels_.begin(), broadcastChannels_.end()}
-                        , std::map<std::string, std::string> {facilityChannels_.begin(), facilityChannels_.end()}
-                        , status_
-                    };
+                    auto now = clock_->now();
+                    bool sendFull = (
+                        fullHeartbeatInterval_ <= 1
+                        ||
+                        (heartbeatCount_ % static_cast<int64_t>(fullHeartbeatInterval_)) == 0
+                    );
+                    ++heartbeatCount_;
+                    if (sendFull) {
+                        lastFullHeartbeatTime_ = now;
+                        changedBroadcastChannels_.clear();
+                        changedFacilityChannels_.clear();
+                        changedStatus_.clear();
+                    } else {
+                        deltaMsg = deltaHeartbeat(now);
+                    }
+                    //the in-process handlers always get full heartbeats
+                    if (sendFull || !extraHandlers_.empty()) {
+                        fullMsg = fullHeartbeat(now);
+                    }
                 }
                 std::string buf;
-                msg.SerializeToString(&buf);
+                if (deltaMsg) {
+                    deltaMsg->SerializeToString(&buf);
+                } else {
+                    fullMsg->SerializeToString(&buf);
+                }
                 (*publisher_)({heartbeatTopic, std::move(buf)});
+                if (!fullMsg) {
+                    return;
+                }
                 auto sz = extraHandlers_.size();
                 for (std::size_t ii=0; ii<sz; ++ii) {
                     if (ii == sz-1) {
-                        (extraHandlers_[ii])(std::move(msg));
+                        (extraHandlers_[ii])(std::move(*fullMsg));
                     } else {
-                        (extraHandlers_[ii])(HeartbeatMessage {msg});
+                        (extraHandlers_[ii])(HeartbeatMessage {*fullMsg});
                     }
                 }
             }
@@ -122,6 +201,9 @@ namespace dev { namespace cd606 { namespace tm { namespace transport {
     void HeartbeatAndAlertComponent::sendAlert(std::string const &alertTopic, infra::LogLevel level, std::string const &message) {
         impl_->sendAlert(alertTopic, level, message);
     }
+    void HeartbeatAndAlertComponent::setFullHeartbeatInterval(std::size_t everyNPeriods) {
+        impl_->setFullHeartbeatInterval(everyNPeriods);
+    }
     void HeartbeatAndAlertComponent::publishHeartbeat(std::string const &heartbeatTopic) {
         impl_->publishHeartbeat(heartbeatTopic);
     }
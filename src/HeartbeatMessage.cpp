@@ -183,6 +183,56 @@ namespace dev { namespace cd606 { namespace tm { namespace transport {
     void HeartbeatMessage::SerializeToString(std::string *s) const {
         int64_t t = infra::withtime_utils::sinceEpoch<std::chrono::microseconds>(heartbeatTime_);
 
+        if (deltaInfo_) {
+            std::tuple<
+                std::string const *
+                , int64_t const *
+                , std::string const *
+                , int64_t const *
+                , std::string const *
+                , std::map<std::string, std::vector<std::string>> const *
+                , std::map<std::string, std::string> const *
+                , std::map<std::string, OneItemStatus> const *
+                , int64_t const *
+                , int64_t const *
+            > x {
+                &uuidStr_
+                , &t 
+                , &host_
+                , &pid_
+                , &senderDescription_
+                , &broadcastChannels_
+                , &facilityChannels_
+                , &details_
+                , &(deltaInfo_->version)
+                , &(deltaInfo_->baseTimestamp)
+            };
+            *s = basic::bytedata_utils::RunCBORSerializerWithNameList<
+                std::tuple<
+                    std::string const *
+                    , int64_t const *
+                    , std::string const *
+                    , int64_t const *
+                    , std::string const *
+                    , std::map<std::string, std::vector<std::string>> const *
+                    , std::map<std::string, std::string> const *
+                    , std::map<std::string, OneItemStatus> const *
+                    , int64_t const *
+                    , int64_t const *
+                >
+                , 10
+            >::apply(
+                x
+                , {
+                    "uuid_str", "timestamp", "host", "pid", "sender_description"
+                    , "broadcast_channels", "facility_channels"
+                    , "details"
+                    , "delta_version", "delta_base_timestamp"
+                }
+            );
+            return;
+        }
+
         std::tuple<
             std::string const *
             , int64_t const *
@@ -224,6 +274,50 @@ namespace dev { namespace cd606 { namespace tm { namespace transport {
         );
     }
     bool HeartbeatMessage::ParseFromString(std::string const &s) {
+        //a full heartbeat is an 8-entry CBOR map and a delta heartbeat is
+        //a 10-entry CBOR map
+        if (!s.empty() && static_cast<unsigned char>(s[0]) == 0xAA) {
+            auto t = basic::bytedata_utils::RunCBORDeserializerWithNameList<
+                std::tuple<
+                    std::string
+                    , int64_t
+                    , std::string
+                    , int64_t
+                    , std::string
+                    , std::map<std::string, std::vector<std::string>>
+                    , std::map<std::string, std::string>
+                    , std::map<std::string, OneItemStatus>
+                    , int64_t
+                    , int64_t
+                >
+                , 10
+            >::apply(
+                std::string_view {s}, 0
+                , {
+                    "uuid_str", "timestamp", "host", "pid", "sender_description"
+                    , "broadcast_channels", "facility_channels"
+                    , "details"
+                    , "delta_version", "delta_base_timestamp"
+                }
+            );
+            if (!t) {
+                return false;
+            }
+            if (std::get<1>(*t) != s.length()) {
+                return false;
+            }
+            auto &x = std::get<0>(*t);
+            uuidStr_ = std::move(std::get<0>(x));
+            heartbeatTime_ = infra::withtime_utils::epochDurationToTime<std::chrono::microseconds>(std::get<1>(x));
+            host_ = std::move(std::get<2>(x));
+            pid_ = std::get<3>(x);
+            senderDescription_ = std::move(std::get<4>(x));
+            broadcastChannels_ = std::move(std::get<5>(x));
+            facilityChannels_ = std::move(std::get<6>(x));
+            details_ = std::move(std::get<7>(x));
+            deltaInfo_ = DeltaInfo {std::get<8>(x), std::get<9>(x)};
+            return true;
+        }
         auto t = basic::bytedata_utils::RunCBORDeserializerWithNameList<
             std::tuple<
                 std::string
@@ -259,8 +353,34 @@ namespace dev { namespace cd606 { namespace tm { namespace transport {
         broadcastChannels_ = std::get<5>(x);
         facilityChannels_ = std::get<6>(x);
         details_ = std::get<7>(x);
+        deltaInfo_ = std::nullopt;
         return true; 
     }
+    void HeartbeatMessage::markAsDelta(int64_t version, std::chrono::system_clock::time_point baseTime) {
+        deltaInfo_ = DeltaInfo {
+            version
+            , infra::withtime_utils::sinceEpoch<std::chrono::microseconds>(baseTime)
+        };
+    }
+    bool HeartbeatMessage::isDeltaBasedOn(std::chrono::system_clock::time_point fullHeartbeatTime) const {
+        return (
+            deltaInfo_
+            && 
+            deltaInfo_->baseTimestamp == infra::withtime_utils::sinceEpoch<std::chrono::microseconds>(fullHeartbeatTime)
+        );
+    }
+    void HeartbeatMessage::mergeDelta(HeartbeatMessage const &delta) {
+        heartbeatTime_ = delta.heartbeatTime_;
+        for (auto const &item : delta.broadcastChannels_) {
+            broadcastChannels_[item.first] = item.second;
+        }
+        for (auto const &item : delta.facilityChannels_) {
+            facilityChannels_[item.first] = item.second;
+        }
+        for (auto const &item : delta.details_) {
+            details_[item.first] = item.second;
+        }
+    }
     std::optional<HeartbeatMessage::OneItemStatus> HeartbeatMessage::status(std::string const &entry) const {
         auto iter = details_.find(entry);
         if (iter == details_.end()) {
@@ -284,4 +404,29 @@ namespace dev { namespace cd606 { namespace tm { namespace transport {
         }
         return ret;
     }
+
+    std::optional<HeartbeatMessage> HeartbeatDeltaApplier::apply(HeartbeatMessage &&msg) {
+        if (!msg.isDelta()) {
+            senders_[msg.uuidStr()] = SenderState {msg.heartbeatTime(), msg, 0};
+            return std::move(msg);
+        }
+        auto iter = senders_.find(msg.uuidStr());
+        if (iter == senders_.end()) {
+            return std::nullopt;
+        }
+        auto &state = iter->second;
+        if (!msg.isDeltaBasedOn(state.baseTime)) {
+            return std::nullopt;
+        }
+        auto version = *(msg.deltaVersion());
+        if (version <= state.lastVersion) {
+            return std::nullopt;
+        }
+        state.current.mergeDelta(msg);
+        state.lastVersion = version;
+        return state.current;
+    }
+    void HeartbeatDeltaApplier::removeSender(std::string const &uuidStr) {
+        senders_.erase(uuidStr);
+    }
 } } } }
\ No newline at end of file
@@ -0,0 +1,148 @@
+#include <tm_kit/transport/LatencyStamping.hpp>
+
+#include <atomic>
+#include <mutex>
+#include <random>
+#include <unordered_map>
+#include <algorithm>
+#include <cstring>
+
+namespace dev { namespace cd606 { namespace tm { namespace transport {
+
+    namespace {
+        //0xff cannot start a CBOR item, so the marker does not collide with
+        //the CBOR payloads that make up most of the traffic
+        constexpr char StampMarker[4] = {'\xff', 'L', 'S', '\x01'};
+
+        void writeUint64(char *p, uint64_t v) {
+            for (int ii=0; ii<8; ++ii) {
+                p[ii] = static_cast<char>((v >> (8*ii)) & 0xff);
+            }
+        }
+        uint64_t readUint64(char const *p) {
+            uint64_t v = 0;
+            for (int ii=0; ii<8; ++ii) {
+                v |= (static_cast<uint64_t>(static_cast<unsigned char>(p[ii])) << (8*ii));
+            }
+            return v;
+        }
+
+        class LatencyStampReceiver {
+        private:
+            struct SenderState {
+                uint64_t lastSequence;
+                //the window minimum is kept over two half-windows, so that
+                //it follows the clocks when they move
+                int64_t currentMin;
+                int64_t previousMin;
+                int64_t currentStart;
+            };
+            std::shared_ptr<TransportChannelMetrics> metrics_;
+            int64_t halfWindow_;
+            std::mutex mutex_;
+            std::unordered_map<uint64_t, SenderState> senders_;
+        public:
+            LatencyStampReceiver(std::shared_ptr<TransportChannelMetrics> const &metrics, std::chrono::system_clock::duration window)
+                : metrics_(metrics)
+                , halfWindow_(std::chrono::duration_cast<std::chrono::nanoseconds>(window).count()/2)
+                , mutex_()
+                , senders_()
+            {
+                if (halfWindow_ <= 0) {
+                    halfWindow_ = 1;
+                }
+            }
+            void record(LatencyStamp const &s, int64_t recvTime) {
+                if (!metrics_) {
+                    return;
+                }
+                int64_t raw = recvTime-s.sendTimeNanos;
+                int64_t windowMin;
+                uint64_t missing = 0;
+                {
+                    std::lock_guard<std::mutex> _(mutex_);
+                    auto iter = senders_.find(s.senderID);
+                    if (iter == senders_.end()) {
+                        iter = senders_.insert({s.senderID, SenderState {s.sequence, raw, raw, recvTime}}).first;
+                    } else {
+                        auto &st = iter->second;
+                        if (s.sequence > st.lastSequence+1) {
+                            missing = s.sequence-st.lastSequence-1;
+                        }
+                        if (s.sequence > st.lastSequence) {
+                            st.lastSequence = s.sequence;
+                        }
+                        if (recvTime-st.currentStart > halfWindow_) {
+                            st.previousMin = st.currentMin;
+                            st.currentMin = raw;
+                            st.currentStart = recvTime;
+                        } else if (raw < st.currentMin) {
+                            st.currentMin = raw;
+                        }
+                    }
+                    windowMin = std::min(iter->second.currentMin, iter->second.previousMin);
+                }
+                if (missing > 0) {
+                    metrics_->recordSequenceGap(missing);
+                }
+                int64_t offset = (windowMin < 0)?windowMin:0;
+                metrics_->setEstimatedClockOffset(offset);
+                metrics_->oneWayLatency().record(std::chrono::nanoseconds(raw-offset));
+            }
+        };
+    }
+
+    basic::ByteData LatencyStampingHelper::stamp(basic::ByteData &&data, LatencyStamp const &s) {
+        std::string out;
+        out.resize(HeaderSize+data.content.length());
+        std::memcpy(out.data(), StampMarker, 4);
+        writeUint64(out.data()+4, s.senderID);
+        writeUint64(out.data()+12, s.sequence);
+        writeUint64(out.data()+20, static_cast<uint64_t>(s.sendTimeNanos));
+        std::memcpy(out.data()+HeaderSize, data.content.data(), data.content.length());
+        return basic::ByteData {std::move(out)};
+    }
+    std::optional<std::tuple<LatencyStamp, basic::ByteDataView>> LatencyStampingHelper::parse(basic::ByteDataView const &data) {
+        if (data.content.length() < HeaderSize || std::memcmp(data.content.data(), StampMarker, 4) != 0) {
+            return std::nullopt;
+        }
+        char const *p = data.content.data();
+        return std::tuple<LatencyStamp, basic::ByteDataView> {
+            LatencyStamp {
+                readUint64(p+4)
+                , readUint64(p+12)
+                , static_cast<int64_t>(readUint64(p+20))
+            }
+            , basic::ByteDataView {data.content.substr(HeaderSize)}
+        };
+    }
+    UserToWireHook LatencyStampingHelper::outgoingHook() {
+        std::random_device rd;
+        uint64_t senderID = (static_cast<uint64_t>(rd()) << 32) | static_cast<uint64_t>(rd());
+        auto sequence = std::make_shared<std::atomic<uint64_t>>(0);
+        return UserToWireHook {
+            [senderID,sequence](basic::ByteData &&data) -> basic::ByteData {
+                return stamp(std::move(data), LatencyStamp {
+                    senderID
+                    , ++(*sequence)
+                    , nowNanos()
+                });
+            }
+        };
+    }
+    WireToUserHook LatencyStampingHelper::incomingHook(std::shared_ptr<TransportChannelMetrics> const &metrics, std::chrono::system_clock::duration offsetWindow) {
+        auto receiver = std::make_shared<LatencyStampReceiver>(metrics, offsetWindow);
+        return WireToUserHook {
+            [receiver](basic::ByteDataView const &data) -> std::optional<basic::ByteData> {
+                auto recvTime = nowNanos();
+                auto parsed = parse(data);
+                if (!parsed) {
+                    return basic::ByteData {std::string(data.content)};
+                }
+                receiver->record(std::get<0>(*parsed), recvTime);
+                return basic::ByteData {std::string(std::get<1>(*parsed).content)};
+            }
+        };
+    }
+
+} } } }
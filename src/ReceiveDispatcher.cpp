@@ -0,0 +1,224 @@
+#include <tm_kit/transport/ReceiveDispatcher.hpp>
+
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <vector>
+#include <chrono>
+#include <cstdint>
+#include <algorithm>
+
+namespace dev { namespace cd606 { namespace tm { namespace transport {
+
+    namespace {
+        //Bounded multi-producer single-consumer ring (D. Vyukov's bounded
+        //queue): every cell has a sequence number that tells whether it is
+        //free for the producer of a given position, or filled for the
+        //consumer, so no lock is needed on either side.
+        class BoundedMPSCQueue {
+        private:
+            struct Cell {
+                std::atomic<std::size_t> sequence;
+                basic::ByteDataWithTopic data;
+            };
+            std::unique_ptr<Cell[]> cells_;
+            std::size_t mask_;
+            alignas(64) std::atomic<std::size_t> enqueuePos_;
+            alignas(64) std::size_t dequeuePos_;
+        public:
+            BoundedMPSCQueue(std::size_t capacity) : cells_(), mask_(0), enqueuePos_(0), dequeuePos_(0) {
+                std::size_t size = 2;
+                while (size < capacity) {
+                    size <<= 1;
+                }
+                cells_ = std::make_unique<Cell[]>(size);
+                mask_ = size-1;
+                for (std::size_t ii=0; ii<size; ++ii) {
+                    cells_[ii].sequence.store(ii, std::memory_order_relaxed);
+                }
+            }
+            //data is only moved from on success
+            bool tryPush(basic::ByteDataWithTopic &&data) {
+                auto pos = enqueuePos_.load(std::memory_order_relaxed);
+                Cell *cell;
+                while (true) {
+                    cell = &cells_[pos & mask_];
+                    auto seq = cell->sequence.load(std::memory_order_acquire);
+                    auto diff = static_cast<std::intptr_t>(seq)-static_cast<std::intptr_t>(pos);
+                    if (diff == 0) {
+                        if (enqueuePos_.compare_exchange_weak(pos, pos+1, std::memory_order_relaxed)) {
+                            break;
+                        }
+                    } else if (diff < 0) {
+                        return false;
+                    } else {
+                        pos = enqueuePos_.load(std::memory_order_relaxed);
+                    }
+                }
+                cell->data = std::move(data);
+                cell->sequence.store(pos+1, std::memory_order_release);
+                return true;
+            }
+            //only to be called from the consumer thread
+            bool tryPop(basic::ByteDataWithTopic &data) {
+                Cell *cell = &cells_[dequeuePos_ & mask_];
+                auto seq = cell->sequence.load(std::memory_order_acquire);
+                if (seq != dequeuePos_+1) {
+                    return false;
+                }
+                data = std::move(cell->data);
+                cell->sequence.store(dequeuePos_+mask_+1, std::memory_order_release);
+                ++dequeuePos_;
+                return true;
+            }
+        };
+
+        struct Worker {
+            BoundedMPSCQueue queue;
+            std::mutex mutex;
+            std::condition_variable cond;
+            std::atomic<bool> sleeping;
+            std::thread thread;
+
+            Worker(std::size_t capacity) : queue(capacity), mutex(), cond(), sleeping(false), thread() {}
+            void wake() {
+                std::atomic_thread_fence(std::memory_order_seq_cst);
+                if (sleeping.load(std::memory_order_relaxed)) {
+                    std::lock_guard<std::mutex> _(mutex);
+                    cond.notify_one();
+                }
+            }
+        };
+    }
+
+    class ReceiveDispatcherImpl {
+    private:
+        static constexpr int SpinCount = 64;
+
+        std::function<void(basic::ByteDataWithTopic &&)> deliver_;
+        ReceiveDispatcher::OverflowPolicy overflowPolicy_;
+        std::shared_ptr<TransportChannelMetrics> metrics_;
+        std::atomic<bool> running_;
+        std::vector<std::unique_ptr<Worker>> workers_;
+
+        void run(Worker *w) {
+            basic::ByteDataWithTopic d;
+            int idle = 0;
+            while (running_.load(std::memory_order_acquire)) {
+                if (w->queue.tryPop(d)) {
+                    idle = 0;
+                    if (metrics_) {
+                        metrics_->addQueueDepth(-1);
+                    }
+                    deliver_(std::move(d));
+                    continue;
+                }
+                if (++idle < SpinCount) {
+                    std::this_thread::yield();
+                    continue;
+                }
+                //the timeout covers a wake-up that is missed between the
+                //producer's check and the wait
+                std::unique_lock<std::mutex> lock(w->mutex);
+                w->sleeping.store(true, std::memory_order_relaxed);
+                std::atomic_thread_fence(std::memory_order_seq_cst);
+                if (w->queue.tryPop(d)) {
+                    w->sleeping.store(false, std::memory_order_relaxed);
+                    lock.unlock();
+                    idle = 0;
+                    if (metrics_) {
+                        metrics_->addQueueDepth(-1);
+                    }
+                    deliver_(std::move(d));
+                    continue;
+                }
+                if (running_.load(std::memory_order_acquire)) {
+                    w->cond.wait_for(lock, std::chrono::milliseconds(1));
+                }
+                w->sleeping.store(false, std::memory_order_relaxed);
+            }
+        }
+    public:
+        ReceiveDispatcherImpl(std::function<void(basic::ByteDataWithTopic &&)> const &deliver, ReceiveDispatcher::Options const &options, std::shared_ptr<TransportChannelMetrics> const &metrics)
+            : deliver_(deliver), overflowPolicy_(options.overflowPolicy), metrics_(metrics), running_(true), workers_()
+        {
+            auto threadCount = std::max<std::size_t>(options.threadCount, 1);
+            for (std::size_t ii=0; ii<threadCount; ++ii) {
+                workers_.push_back(std::make_unique<Worker>(options.queueSize));
+            }
+            for (auto &w : workers_) {
+                w->thread = std::thread(&ReceiveDispatcherImpl::run, this, w.get());
+            }
+        }
+        ~ReceiveDispatcherImpl() {
+            running_.store(false, std::memory_order_release);
+            for (auto &w : workers_) {
+                {
+                    std::lock_guard<std::mutex> _(w->mutex);
+                    w->cond.notify_one();
+                }
+                if (w->thread.joinable()) {
+                    w->thread.join();
+                }
+            }
+        }
+        void push(basic::ByteDataWithTopic &&data) {
+            auto &w = *workers_[std::hash<std::string>()(data.topic)%workers_.size()];
+            //counted before the push, so that the worker never takes the
+            //depth below zero
+            if (metrics_) {
+                metrics_->addQueueDepth(1);
+            }
+            if (!w.queue.tryPush(std::move(data))) {
+                if (overflowPolicy_ == ReceiveDispatcher::OverflowPolicy::Drop) {
+                    if (metrics_) {
+                        metrics_->addQueueDepth(-1);
+                        metrics_->recordDrop();
+                    }
+                    return;
+                }
+                if (metrics_) {
+                    metrics_->recordBackpressure();
+                }
+                do {
+                    w.wake();
+                    if (!running_.load(std::memory_order_acquire)) {
+                        if (metrics_) {
+                            metrics_->addQueueDepth(-1);
+                        }
+                        return;
+                    }
+                    std::this_thread::yield();
+                } while (!w.queue.tryPush(std::move(data)));
+            }
+            w.wake();
+        }
+    };
+
+    ReceiveDispatcher::Options ReceiveDispatcher::optionsFor(ConnectionLocator const &locator) {
+        Options ret;
+        try {
+            ret.threadCount = std::stoul(locator.query("dispatch_threads", "0"));
+        } catch (std::exception const &) {
+            ret.threadCount = 0;
+        }
+        try {
+            ret.queueSize = std::stoul(locator.query("dispatch_queue_size", "4096"));
+        } catch (std::exception const &) {
+        }
+        if (locator.query("dispatch_overflow", "block") == "drop") {
+            ret.overflowPolicy = OverflowPolicy::Drop;
+        }
+        return ret;
+    }
+
+    ReceiveDispatcher::ReceiveDispatcher(std::function<void(basic::ByteDataWithTopic &&)> const &deliver, Options const &options, std::shared_ptr<TransportChannelMetrics> const &metrics)
+        : impl_(std::make_unique<ReceiveDispatcherImpl>(deliver, options, metrics))
+    {}
+    ReceiveDispatcher::~ReceiveDispatcher() {}
+    void ReceiveDispatcher::push(basic::ByteDataWithTopic &&data) {
+        impl_->push(std::move(data));
+    }
+
+} } } }
@@ -0,0 +1,134 @@
+#include <tm_kit/transport/SharedMemorySegment.hpp>
+
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <cstdint>
+
+#ifdef _MSC_VER
+#include <windows.h>
+#else
+#include <unistd.h>
+#include <sys/mman.h>
+#endif
+
+namespace dev { namespace cd606 { namespace tm { namespace transport {
+
+    namespace {
+        std::size_t systemPageSize() {
+#ifdef _MSC_VER
+            SYSTEM_INFO info;
+            GetSystemInfo(&info);
+            return static_cast<std::size_t>(info.dwPageSize);
+#else
+            auto s = sysconf(_SC_PAGESIZE);
+            return (s > 0)?static_cast<std::size_t>(s):4096;
+#endif
+        }
+#ifdef __linux__
+        //ShmemPmdMapped of the mapping that starts at address, from
+        ///proc/self/smaps
+        std::size_t hugePageBytesInMapping(void *address) {
+            std::ifstream ifs("/proc/self/smaps");
+            if (!ifs.good()) {
+                return 0;
+            }
+            auto start = reinterpret_cast<std::uintptr_t>(address);
+            bool inMapping = false;
+            std::string line;
+            while (std::getline(ifs, line)) {
+                auto dash = line.find('-');
+                auto colon = line.find(':');
+                if (dash != std::string::npos && (colon == std::string::npos || dash < colon)) {
+                    //the header line of a mapping
+                    if (inMapping) {
+                        break;
+                    }
+                    try {
+                        inMapping = (static_cast<std::uintptr_t>(std::stoull(line.substr(0, dash), nullptr, 16)) == start);
+                    } catch (std::exception const &) {
+                        inMapping = false;
+                    }
+                    continue;
+                }
+                if (inMapping && line.compare(0, 15, "ShmemPmdMapped:") == 0) {
+                    std::istringstream iss(line.substr(15));
+                    std::size_t kb = 0;
+                    iss >> kb;
+                    return kb*1024;
+                }
+            }
+            return 0;
+        }
+#endif
+    }
+
+    SharedMemorySegmentOptions SharedMemorySegmentOptions::fromLocator(ConnectionLocator const &locator) {
+        SharedMemorySegmentOptions ret;
+        ret.hugePages = (locator.query("huge_pages", "false") == "true");
+        ret.prefault = (locator.query("prefault", "false") == "true");
+        ret.lock = (locator.query("mlock", "false") == "true");
+        return ret;
+    }
+
+    SharedMemorySegmentLayout prepareSharedMemorySegment(void *address, std::size_t size, SharedMemorySegmentOptions const &options) {
+        SharedMemorySegmentLayout ret;
+        ret.address = address;
+        ret.size = size;
+        ret.pageSize = systemPageSize();
+        if (!address || size == 0) {
+            return ret;
+        }
+        char *p = static_cast<char *>(address);
+#if defined(__linux__) && defined(MADV_HUGEPAGE)
+        //this has to come before the faulting, since pages that are
+        //already in are not converted
+        if (options.hugePages) {
+            ret.hugePagesAdvised = (madvise(p, size, MADV_HUGEPAGE) == 0);
+        }
+#endif
+#ifndef _MSC_VER
+        if (options.lock) {
+            ret.locked = (mlock(p, size) == 0);
+            ret.prefaulted = ret.locked;
+        }
+#endif
+        if (options.prefault && !ret.prefaulted) {
+#if defined(__linux__) && defined(MADV_POPULATE_WRITE)
+            ret.prefaulted = (madvise(p, size, MADV_POPULATE_WRITE) == 0);
+#endif
+            if (!ret.prefaulted) {
+                //other processes may be writing into the segment already,
+                //so the pages are only read. In a shared mapping of shared
+                //memory that still brings in writable pages.
+                volatile char const *q = p;
+                char sink = 0;
+                for (std::size_t ii=0; ii<size; ii+=ret.pageSize) {
+                    sink ^= q[ii];
+                }
+                (void) sink;
+                ret.prefaulted = true;
+            }
+        }
+#ifdef __linux__
+        if (ret.hugePagesAdvised) {
+            ret.hugePageBytes = hugePageBytesInMapping(address);
+        }
+#endif
+        return ret;
+    }
+
+    std::ostream &operator<<(std::ostream &os, SharedMemorySegmentLayout const &layout) {
+        os << "SharedMemorySegmentLayout{"
+            << "address=" << layout.address
+            << ",size=" << layout.size
+            << ",pageSize=" << layout.pageSize
+            << ",hugePagesAdvised=" << (layout.hugePagesAdvised?"true":"false")
+            << ",hugePageBytes=" << layout.hugePageBytes
+            << ",prefaulted=" << (layout.prefaulted?"true":"false")
+            << ",locked=" << (layout.locked?"true":"false")
+            << "}";
+        return os;
+    }
+
+} } } }
@@ -0,0 +1,256 @@
+#include <tm_kit/transport/TransportMetricsComponent.hpp>
+
+#include <nlohmann/json.hpp>
+
+#include <map>
+#include <functional>
+#include <algorithm>
+#include <mutex>
+#include <sstream>
+#include <iomanip>
+#include <limits>
+#include <cmath>
+
+namespace dev { namespace cd606 { namespace tm { namespace transport {
+
+    uint64_t TransportLatencySnapshot::percentileNanos(double p) const {
+        if (count == 0 || buckets.empty()) {
+            return 0;
+        }
+        if (p <= 0) {
+            return minNanos;
+        }
+        if (p >= 1) {
+            return maxNanos;
+        }
+        auto target = static_cast<uint64_t>(std::ceil(p*static_cast<double>(count)));
+        uint64_t seen = 0;
+        for (auto const &b : buckets) {
+            seen += std::get<1>(b);
+            if (seen >= target) {
+                return std::min(std::get<0>(b), maxNanos);
+            }
+        }
+        return maxNanos;
+    }
+
+    TransportLatencyHistogram::TransportLatencyHistogram()
+        : counts_(), count_(0), sum_(0), min_(std::numeric_limits<uint64_t>::max()), max_(0)
+    {
+        for (auto &c : counts_) {
+            c.store(0, std::memory_order_relaxed);
+        }
+    }
+    uint64_t TransportLatencyHistogram::bucketUpperBound(std::size_t index) {
+        if (index < SubBucketCount) {
+            return static_cast<uint64_t>(index);
+        }
+        std::size_t shift = index/SubBucketCount-1;
+        uint64_t sub = static_cast<uint64_t>(index%SubBucketCount);
+        uint64_t lower = (static_cast<uint64_t>(SubBucketCount)+sub) << shift;
+        return lower+((uint64_t(1) << shift)-1);
+    }
+    TransportLatencySnapshot TransportLatencyHistogram::snapshot() const {
+        TransportLatencySnapshot ret;
+        ret.count = count_.load(std::memory_order_relaxed);
+        ret.sumNanos = sum_.load(std::memory_order_relaxed);
+        if (ret.count > 0) {
+            ret.minNanos = min_.load(std::memory_order_relaxed);
+            ret.maxNanos = max_.load(std::memory_order_relaxed);
+        }
+        for (std::size_t ii=0; ii<BucketCount; ++ii) {
+            auto c = counts_[ii].load(std::memory_order_relaxed);
+            if (c > 0) {
+                ret.buckets.push_back({bucketUpperBound(ii), c});
+            }
+        }
+        return ret;
+    }
+
+    std::size_t TransportChannelMetrics::nextStripe() {
+        static std::atomic<std::size_t> counter {0};
+        return (counter++)%StripeCount;
+    }
+    TransportChannelMetrics::TransportChannelMetrics(std::string const &transport, ConnectionLocator const &locator)
+        : transport_(transport), locator_(locator), stripes_(), queueDepth_(0), sendLatency_(), estimatedClockOffset_(0), oneWayLatency_(), reportedBadCount_(0)
+    {}
+    TransportChannelMetricsSnapshot TransportChannelMetrics::snapshot() const {
+        TransportChannelMetricsSnapshot ret;
+        ret.transport = transport_;
+        ret.locator = locator_;
+        for (auto const &s : stripes_) {
+            ret.messagesIn += s.messagesIn.load(std::memory_order_relaxed);
+            ret.bytesIn += s.bytesIn.load(std::memory_order_relaxed);
+            ret.messagesOut += s.messagesOut.load(std::memory_order_relaxed);
+            ret.bytesOut += s.bytesOut.load(std::memory_order_relaxed);
+            ret.drops += s.drops.load(std::memory_order_relaxed);
+            ret.decodeFailures += s.decodeFailures.load(std::memory_order_relaxed);
+            ret.conflated += s.conflated.load(std::memory_order_relaxed);
+            ret.backpressure += s.backpressure.load(std::memory_order_relaxed);
+            ret.sequenceGaps += s.sequenceGaps.load(std::memory_order_relaxed);
+        }
+        ret.queueDepth = queueDepth_.load(std::memory_order_relaxed);
+        ret.sendLatency = sendLatency_.snapshot();
+        ret.estimatedClockOffsetNanos = estimatedClockOffset_.load(std::memory_order_relaxed);
+        ret.oneWayLatency = oneWayLatency_.snapshot();
+        return ret;
+    }
+
+    class TransportMetricsComponentImpl {
+    private:
+        mutable std::mutex mutex_;
+        std::map<std::tuple<std::string, ConnectionLocator>, std::shared_ptr<TransportChannelMetrics>> channels_;
+
+        static std::string escapeLabel(std::string const &s) {
+            std::string ret;
+            ret.reserve(s.length());
+            for (char c : s) {
+                switch (c) {
+                case '\\':
+                    ret += "\\\\";
+                    break;
+                case '"':
+                    ret += "\\\"";
+                    break;
+                case '\n':
+                    ret += "\\n";
+                    break;
+                default:
+                    ret += c;
+                    break;
+                }
+            }
+            return ret;
+        }
+        static void writeCounter(std::ostringstream &oss, std::string const &name, std::string const &help, std::string const &type, std::vector<TransportChannelMetricsSnapshot> const &snapshots, std::function<int64_t(TransportChannelMetricsSnapshot const &)> const &f) {
+            oss << "# HELP " << name << ' ' << help << '\n';
+            oss << "# TYPE " << name << ' ' << type << '\n';
+            for (auto const &s : snapshots) {
+                oss << name << "{transport=\"" << escapeLabel(s.transport)
+                    << "\",locator=\"" << escapeLabel(s.locator.toSerializationFormat())
+                    << "\"} " << f(s) << '\n';
+            }
+        }
+        static void writeHistogram(std::ostringstream &oss, std::string const &name, std::string const &help, std::vector<TransportChannelMetricsSnapshot> const &snapshots, std::function<TransportLatencySnapshot const &(TransportChannelMetricsSnapshot const &)> const &f) {
+            oss << "# HELP " << name << ' ' << help << '\n';
+            oss << "# TYPE " << name << " histogram\n";
+            oss << std::setprecision(9);
+            for (auto const &s : snapshots) {
+                auto const &h = f(s);
+                if (h.count == 0) {
+                    continue;
+                }
+                std::string labels = "transport=\""+escapeLabel(s.transport)+"\",locator=\""+escapeLabel(s.locator.toSerializationFormat())+"\"";
+                uint64_t cumulative = 0;
+                for (auto const &b : h.buckets) {
+                    cumulative += std::get<1>(b);
+                    oss << name << "_bucket{" << labels << ",le=\""
+                        << static_cast<double>(std::get<0>(b))*1e-9 << "\"} " << cumulative << '\n';
+                }
+                oss << name << "_bucket{" << labels << ",le=\"+Inf\"} " << h.count << '\n';
+                oss << name << "_sum{" << labels << "} " << static_cast<double>(h.sumNanos)*1e-9 << '\n';
+                oss << name << "_count{" << labels << "} " << h.count << '\n';
+            }
+        }
+        static nlohmann::json histogramJson(TransportLatencySnapshot const &h) {
+            return {
+                {"count", h.count}
+                , {"min", h.minNanos}
+                , {"max", h.maxNanos}
+                , {"p50", h.percentileNanos(0.5)}
+                , {"p99", h.percentileNanos(0.99)}
+                , {"p999", h.percentileNanos(0.999)}
+            };
+        }
+    public:
+        TransportMetricsComponentImpl() : mutex_(), channels_() {}
+        std::shared_ptr<TransportChannelMetrics> channel(std::string const &transport, ConnectionLocator const &locator) {
+            auto l = locator.modifyPassword("");
+            std::lock_guard<std::mutex> _(mutex_);
+            auto key = std::tuple<std::string, ConnectionLocator> {transport, l};
+            auto iter = channels_.find(key);
+            if (iter == channels_.end()) {
+                iter = channels_.insert({key, std::make_shared<TransportChannelMetrics>(transport, l)}).first;
+            }
+            return iter->second;
+        }
+        std::vector<TransportChannelMetricsSnapshot> snapshot() const {
+            std::vector<std::shared_ptr<TransportChannelMetrics>> channels;
+            {
+                std::lock_guard<std::mutex> _(mutex_);
+                for (auto const &item : channels_) {
+                    channels.push_back(item.second);
+                }
+            }
+            std::vector<TransportChannelMetricsSnapshot> ret;
+            ret.reserve(channels.size());
+            for (auto const &c : channels) {
+                ret.push_back(c->snapshot());
+            }
+            return ret;
+        }
+        std::string prometheusText() const {
+            auto snapshots = snapshot();
+            std::ostringstream oss;
+            writeCounter(oss, "tm_transport_messages_in_total", "Messages received", "counter", snapshots, [](auto const &s) {return static_cast<int64_t>(s.messagesIn);});
+            writeCounter(oss, "tm_transport_bytes_in_total", "Bytes received", "counter", snapshots, [](auto const &s) {return static_cast<int64_t>(s.bytesIn);});
+            writeCounter(oss, "tm_transport_messages_out_total", "Messages sent", "counter", snapshots, [](auto const &s) {return static_cast<int64_t>(s.messagesOut);});
+            writeCounter(oss, "tm_transport_bytes_out_total", "Bytes sent", "counter", snapshots, [](auto const &s) {return static_cast<int64_t>(s.bytesOut);});
+            writeCounter(oss, "tm_transport_drops_total", "Messages dropped", "counter", snapshots, [](auto const &s) {return static_cast<int64_t>(s.drops);});
+            writeCounter(oss, "tm_transport_decode_failures_total", "Messages that could not be decoded", "counter", snapshots, [](auto const &s) {return static_cast<int64_t>(s.decodeFailures);});
+            writeCounter(oss, "tm_transport_conflated_total", "Messages overwritten by a later one on the same topic before delivery", "counter", snapshots, [](auto const &s) {return static_cast<int64_t>(s.conflated);});
+            writeCounter(oss, "tm_transport_backpressure_total", "Messages that waited for room in a full dispatch queue", "counter", snapshots, [](auto const &s) {return static_cast<int64_t>(s.backpressure);});
+            writeCounter(oss, "tm_transport_queue_depth", "Messages waiting in the transport queue", "gauge", snapshots, [](auto const &s) {return s.queueDepth;});
+            writeCounter(oss, "tm_transport_sequence_gaps_total", "Messages missing from the latency stamp sequences", "counter", snapshots, [](auto const &s) {return static_cast<int64_t>(s.sequenceGaps);});
+            writeCounter(oss, "tm_transport_estimated_clock_offset_nanoseconds", "Estimated clock offset of the latency stamping sender", "gauge", snapshots, [](auto const &s) {return s.estimatedClockOffsetNanos;});
+            writeHistogram(oss, "tm_transport_send_latency_seconds", "Time spent in the publish call", snapshots, [](auto const &s) -> TransportLatencySnapshot const & {return s.sendLatency;});
+            writeHistogram(oss, "tm_transport_one_way_latency_seconds", "Latency from the sender's stamp to the receipt", snapshots, [](auto const &s) -> TransportLatencySnapshot const & {return s.oneWayLatency;});
+            return oss.str();
+        }
+        std::string json() const {
+            auto snapshots = snapshot();
+            nlohmann::json ret = nlohmann::json::array();
+            for (auto const &s : snapshots) {
+                nlohmann::json item;
+                item["transport"] = s.transport;
+                item["locator"] = s.locator.toSerializationFormat();
+                item["messages_in"] = s.messagesIn;
+                item["bytes_in"] = s.bytesIn;
+                item["messages_out"] = s.messagesOut;
+                item["bytes_out"] = s.bytesOut;
+                item["drops"] = s.drops;
+                item["decode_failures"] = s.decodeFailures;
+                item["conflated"] = s.conflated;
+                item["backpressure"] = s.backpressure;
+                item["queue_depth"] = s.queueDepth;
+                item["send_latency_ns"] = histogramJson(s.sendLatency);
+                if (s.oneWayLatency.count > 0) {
+                    item["sequence_gaps"] = s.sequenceGaps;
+                    item["estimated_clock_offset_ns"] = s.estimatedClockOffsetNanos;
+                    item["one_way_latency_ns"] = histogramJson(s.oneWayLatency);
+                }
+                ret.push_back(item);
+            }
+            return ret.dump();
+        }
+    };
+
+    TransportMetricsComponent::TransportMetricsComponent() : impl_(std::make_unique<TransportMetricsComponentImpl>()) {}
+    TransportMetricsComponent::TransportMetricsComponent(TransportMetricsComponent &&) = default;
+    TransportMetricsComponent &TransportMetricsComponent::operator=(TransportMetricsComponent &&) = default;
+    TransportMetricsComponent::~TransportMetricsComponent() {}
+
+    std::shared_ptr<TransportChannelMetrics> TransportMetricsComponent::transportMetrics_channel(std::string const &transport, ConnectionLocator const &locator) {
+        return impl_->channel(transport, locator);
+    }
+    std::vector<TransportChannelMetricsSnapshot> TransportMetricsComponent::transportMetrics_snapshot() const {
+        return impl_->snapshot();
+    }
+    std::string TransportMetricsComponent::transportMetrics_prometheusText() const {
+        return impl_->prometheusText();
+    }
+    std::string TransportMetricsComponent::transportMetrics_json() const {
+        return impl_->json();
+    }
+
+} } } }
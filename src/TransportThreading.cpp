@@ -0,0 +1,139 @@
+#include <tm_kit/transport/TransportThreading.hpp>
+
+#include <boost/algorithm/string.hpp>
+
+#include <string>
+#include <iostream>
+#include <cstring>
+#include <cerrno>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#include <sys/socket.h>
+#endif
+
+namespace dev { namespace cd606 { namespace tm { namespace transport {
+
+    namespace {
+        //"1;3;8-11"
+        std::vector<int> parseCPUList(std::string const &s) {
+            std::vector<int> ret;
+            std::vector<std::string> parts;
+            boost::split(parts, s, boost::is_any_of(";"));
+            for (auto const &p : parts) {
+                auto x = boost::trim_copy(p);
+                if (x.empty()) {
+                    continue;
+                }
+                try {
+                    auto dash = x.find('-');
+                    if (dash == std::string::npos) {
+                        ret.push_back(std::stoi(x));
+                    } else {
+                        auto from = std::stoi(x.substr(0, dash));
+                        auto to = std::stoi(x.substr(dash+1));
+                        for (int ii=from; ii<=to; ++ii) {
+                            ret.push_back(ii);
+                        }
+                    }
+                } catch (std::exception const &) {
+                }
+            }
+            return ret;
+        }
+        void logFailure(std::string const &channel, std::string const &what, int err) {
+            std::cerr << "TransportThreadingConfig: cannot set " << what;
+            if (!channel.empty()) {
+                std::cerr << " for " << channel;
+            }
+            if (err != 0) {
+                std::cerr << ": " << std::strerror(err);
+            }
+            std::cerr << "\n";
+        }
+        std::optional<int> parseInt(std::string const &s) {
+            if (s.empty()) {
+                return std::nullopt;
+            }
+            try {
+                return std::stoi(s);
+            } catch (std::exception const &) {
+                return std::nullopt;
+            }
+        }
+    }
+
+    TransportThreadingConfig TransportThreadingConfig::fromLocator(ConnectionLocator const &locator) {
+        TransportThreadingConfig ret;
+        ret.cpus = parseCPUList(locator.query("cpu_affinity", ""));
+        ret.priority = parseInt(locator.query("thread_priority", ""));
+        ret.busyLoop = (locator.query("busyLoop", "false") == "true");
+        ret.busyPollMicros = parseInt(locator.query("busy_poll", ""));
+        return ret;
+    }
+    ConnectionLocator TransportThreadingConfig::threadingPropertiesOf(ConnectionLocator const &base, ConnectionLocator const &locator) {
+        auto ret = base.clearProperties();
+        for (auto const *name : {"cpu_affinity", "thread_priority", "busyLoop", "busy_poll"}) {
+            auto v = locator.query(name, "");
+            if (v != "") {
+                ret = ret.addProperty(name, v);
+            }
+        }
+        return ret;
+    }
+
+    bool TransportThreadingConfig::applyToCurrentThread(std::string const &channel) const {
+        bool ok = true;
+#ifdef __linux__
+        if (!cpus.empty()) {
+            cpu_set_t cpuSet;
+            CPU_ZERO(&cpuSet);
+            for (auto c : cpus) {
+                if (c >= 0 && c < CPU_SETSIZE) {
+                    CPU_SET(c, &cpuSet);
+                }
+            }
+            int err = pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), &cpuSet);
+            if (err != 0) {
+                logFailure(channel, "cpu_affinity", err);
+                ok = false;
+            }
+        }
+        if (priority && *priority > 0) {
+            sched_param param {};
+            param.sched_priority = *priority;
+            int err = pthread_setschedparam(pthread_self(), SCHED_FIFO, &param);
+            if (err != 0) {
+                logFailure(channel, "thread_priority", err);
+                ok = false;
+            }
+        }
+#else
+        if (!cpus.empty() || priority) {
+            logFailure(channel, "cpu_affinity/thread_priority (not supported on this platform)", 0);
+            ok = false;
+        }
+#endif
+        return ok;
+    }
+
+    bool TransportThreadingConfig::applyToSocket(std::intptr_t nativeSocket, std::string const &channel) const {
+        if (!busyPollMicros) {
+            return true;
+        }
+#if defined(__linux__) && defined(SO_BUSY_POLL)
+        int v = *busyPollMicros;
+        if (setsockopt(static_cast<int>(nativeSocket), SOL_SOCKET, SO_BUSY_POLL, &v, sizeof(v)) != 0) {
+            logFailure(channel, "busy_poll", errno);
+            return false;
+        }
+        return true;
+#else
+        (void) nativeSocket;
+        logFailure(channel, "busy_poll (not supported on this platform)", 0);
+        return false;
+#endif
+    }
+
+} } } }
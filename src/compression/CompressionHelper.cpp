@@ -0,0 +1,337 @@
+#include <mutex>
+#include <limits>
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <stdexcept>
+#include <unordered_map>
+
+#include <tm_kit/transport/compression/CompressionHelper.hpp>
+
+#include <lz4.h>
+#include <zstd.h>
+#include <zdict.h>
+
+namespace dev { namespace cd606 { namespace tm { namespace transport { namespace compression {
+    namespace {
+        //Header layout:
+        //  STORED    : tag | data
+        //  LZ4       : tag | original size (4 bytes, little endian) | compressed data
+        //  ZSTD      : tag | original size (4 bytes, little endian) | compressed data
+        //  ZSTD_DICT : tag | original size (4 bytes, little endian) | dictionary ID (4 bytes, little endian) | compressed data
+        constexpr char StoredTag = 0x00;
+        constexpr char LZ4Tag = 0x01;
+        constexpr char ZstdTag = 0x02;
+        constexpr char ZstdDictTag = 0x03;
+
+        constexpr std::size_t SizeFieldLength = 4;
+        constexpr std::size_t MaxHeaderLength = 1+2*SizeFieldLength;
+
+        inline void encodeUInt32(uint32_t x, char *p) {
+            for (std::size_t ii=0; ii<SizeFieldLength; ++ii) {
+                p[ii] = static_cast<char>((x >> (8*ii)) & 0xff);
+            }
+        }
+        inline uint32_t decodeUInt32(char const *p) {
+            uint32_t x = 0;
+            for (std::size_t ii=0; ii<SizeFieldLength; ++ii) {
+                x |= (static_cast<uint32_t>(static_cast<unsigned char>(p[ii])) << (8*ii));
+            }
+            return x;
+        }
+
+        //zstd contexts are not thread-safe but are expensive to create, so
+        //each thread keeps its own
+        struct CCtxDeleter {
+            void operator()(ZSTD_CCtx *p) const { ZSTD_freeCCtx(p); }
+        };
+        struct DCtxDeleter {
+            void operator()(ZSTD_DCtx *p) const { ZSTD_freeDCtx(p); }
+        };
+        inline ZSTD_CCtx *threadCCtx() {
+            thread_local std::unique_ptr<ZSTD_CCtx, CCtxDeleter> ctx {ZSTD_createCCtx()};
+            return ctx.get();
+        }
+        inline ZSTD_DCtx *threadDCtx() {
+            thread_local std::unique_ptr<ZSTD_DCtx, DCtxDeleter> ctx {ZSTD_createDCtx()};
+            return ctx.get();
+        }
+        struct CDictDeleter {
+            void operator()(ZSTD_CDict *p) const { ZSTD_freeCDict(p); }
+        };
+        struct DDictDeleter {
+            void operator()(ZSTD_DDict *p) const { ZSTD_freeDDict(p); }
+        };
+
+        inline std::optional<std::size_t> storeUncompressed(basic::ByteDataView const &input, char *output, std::size_t outputCapacity) {
+            std::size_t needed = 1+input.content.length();
+            if (needed > outputCapacity) {
+                return needed;
+            }
+            output[0] = StoredTag;
+            std::memcpy(output+1, input.content.data(), input.content.length());
+            return needed;
+        }
+    }
+
+    class CompressorImpl {
+    private:
+        CompressionOptions options_;
+        std::unique_ptr<ZSTD_CDict, CDictDeleter> cdict_;
+        uint32_t dictID_;
+    public:
+        CompressorImpl(CompressionOptions const &options)
+            : options_(options), cdict_(), dictID_(0)
+        {
+            if (options_.algorithm == CompressionAlgorithm::Zstd && options_.dictionary) {
+                cdict_.reset(ZSTD_createCDict(options_.dictionary->data(), options_.dictionary->length(), options_.level));
+                if (!cdict_) {
+                    throw std::runtime_error("CompressionHelper: cannot load zstd dictionary");
+                }
+                dictID_ = ZSTD_getDictID_fromDict(options_.dictionary->data(), options_.dictionary->length());
+            }
+        }
+        ~CompressorImpl() {}
+        std::size_t maxOutputSize(std::size_t inputSize) const {
+            if (inputSize < options_.threshold) {
+                return 1+inputSize;
+            }
+            switch (options_.algorithm) {
+            case CompressionAlgorithm::LZ4:
+                return MaxHeaderLength+static_cast<std::size_t>(LZ4_compressBound(static_cast<int>(inputSize)));
+            case CompressionAlgorithm::Zstd:
+            default:
+                return MaxHeaderLength+ZSTD_compressBound(inputSize);
+            }
+        }
+        std::optional<std::size_t> compress(basic::ByteDataView const &input, char *output, std::size_t outputCapacity) const {
+            std::size_t inputSize = input.content.length();
+            if (inputSize < options_.threshold || inputSize > std::numeric_limits<uint32_t>::max()) {
+                return storeUncompressed(input, output, outputCapacity);
+            }
+            std::size_t needed = maxOutputSize(inputSize);
+            if (needed > outputCapacity) {
+                return needed;
+            }
+            std::size_t headerLen = 1+SizeFieldLength;
+            std::size_t compressedLen = 0;
+            if (options_.algorithm == CompressionAlgorithm::LZ4) {
+                output[0] = LZ4Tag;
+                int res = LZ4_compress_fast(
+                    input.content.data(), output+headerLen
+                    , static_cast<int>(inputSize), static_cast<int>(outputCapacity-headerLen)
+                    , std::max(options_.level, 1)
+                );
+                if (res <= 0) {
+                    return storeUncompressed(input, output, outputCapacity);
+                }
+                compressedLen = static_cast<std::size_t>(res);
+            } else {
+                std::size_t res;
+                if (cdict_) {
+                    output[0] = ZstdDictTag;
+                    encodeUInt32(dictID_, output+headerLen);
+                    headerLen += SizeFieldLength;
+                    res = ZSTD_compress_usingCDict(
+                        threadCCtx()
+                        , output+headerLen, outputCapacity-headerLen
+                        , input.content.data(), inputSize
+                        , cdict_.get()
+                    );
+                } else {
+                    output[0] = ZstdTag;
+                    res = ZSTD_compressCCtx(
+                        threadCCtx()
+                        , output+headerLen, outputCapacity-headerLen
+                        , input.content.data(), inputSize
+                        , options_.level
+                    );
+                }
+                if (ZSTD_isError(res)) {
+                    return storeUncompressed(input, output, outputCapacity);
+                }
+                compressedLen = res;
+            }
+            //incompressible data is sent as it is
+            if (headerLen+compressedLen >= 1+inputSize) {
+                return storeUncompressed(input, output, outputCapacity);
+            }
+            encodeUInt32(static_cast<uint32_t>(inputSize), output+1);
+            return headerLen+compressedLen;
+        }
+    };
+
+    CompressionHelper::Compressor::Compressor()
+        : impl_(std::make_unique<CompressorImpl>(CompressionOptions {}))
+        {}
+    CompressionHelper::Compressor::Compressor(CompressionOptions const &options)
+        : impl_(std::make_unique<CompressorImpl>(options))
+        {}
+    CompressionHelper::Compressor::~Compressor() {}
+    CompressionHelper::Compressor::Compressor(CompressionHelper::Compressor &&) = default;
+    CompressionHelper::Compressor &CompressionHelper::Compressor::operator=(CompressionHelper::Compressor &&) = default;
+    std::size_t CompressionHelper::Compressor::maxOutputSize(std::size_t inputSize) const {
+        return impl_->maxOutputSize(inputSize);
+    }
+    std::optional<std::size_t> CompressionHelper::Compressor::compress(basic::ByteDataView const &input, char *output, std::size_t outputCapacity) const {
+        return impl_->compress(input, output, outputCapacity);
+    }
+
+    class DecompressorImpl {
+    private:
+        std::size_t maxDecompressedSize_;
+        std::size_t maxCompressionRatio_;
+        //dictionaries are added at setup time and read on every message, so
+        //the readers take a snapshot and the writers copy-and-swap
+        using DictMap = std::unordered_map<uint32_t, std::shared_ptr<ZSTD_DDict>>;
+        std::shared_ptr<DictMap const> dicts_;
+        std::mutex writerMutex_;
+    public:
+        DecompressorImpl(std::size_t maxDecompressedSize, std::size_t maxCompressionRatio)
+            : maxDecompressedSize_(maxDecompressedSize), maxCompressionRatio_(maxCompressionRatio), dicts_(std::make_shared<DictMap const>()), writerMutex_()
+        {}
+        ~DecompressorImpl() {}
+        void addDictionary(std::string const &dictionary) {
+            std::shared_ptr<ZSTD_DDict> ddict {
+                ZSTD_createDDict(dictionary.data(), dictionary.length())
+                , DDictDeleter {}
+            };
+            if (!ddict) {
+                throw std::runtime_error("CompressionHelper: cannot load zstd dictionary");
+            }
+            uint32_t dictID = ZSTD_getDictID_fromDict(dictionary.data(), dictionary.length());
+            std::lock_guard<std::mutex> _(writerMutex_);
+            auto newDicts = std::make_shared<DictMap>(*std::atomic_load(&dicts_));
+            (*newDicts)[dictID] = ddict;
+            std::atomic_store(&dicts_, std::shared_ptr<DictMap const>(std::move(newDicts)));
+        }
+        std::size_t maxOutputSize(std::size_t inputSize) const {
+            //only a guess, the exact size is in the header
+            return 4*inputSize;
+        }
+        std::optional<std::size_t> decompress(basic::ByteDataView const &input, char *output, std::size_t outputCapacity) const {
+            auto const &content = input.content;
+            if (content.empty()) {
+                return std::nullopt;
+            }
+            if (content[0] == StoredTag) {
+                std::size_t needed = content.length()-1;
+                if (needed > outputCapacity) {
+                    return needed;
+                }
+                std::memcpy(output, content.data()+1, needed);
+                return needed;
+            }
+            if (content.length() < 1+SizeFieldLength) {
+                return std::nullopt;
+            }
+            std::size_t originalSize = decodeUInt32(content.data()+1);
+            if (originalSize > maxDecompressedSize_) {
+                return std::nullopt;
+            }
+            //the size in the header is checked against what the payload
+            //could plausibly expand to before any buffer is sized by it
+            if (
+                originalSize > CompressionHelper::MinRatioCheckedSize
+                && maxCompressionRatio_ > 0
+                && originalSize/maxCompressionRatio_ > content.length()
+            ) {
+                return std::nullopt;
+            }
+            if (originalSize > outputCapacity) {
+                return originalSize;
+            }
+            std::size_t headerLen = 1+SizeFieldLength;
+            switch (content[0]) {
+            case LZ4Tag:
+                {
+                    int res = LZ4_decompress_safe(
+                        content.data()+headerLen, output
+                        , static_cast<int>(content.length()-headerLen), static_cast<int>(originalSize)
+                    );
+                    if (res < 0 || static_cast<std::size_t>(res) != originalSize) {
+                        return std::nullopt;
+                    }
+                    return originalSize;
+                }
+            case ZstdTag:
+                {
+                    std::size_t res = ZSTD_decompressDCtx(
+                        threadDCtx()
+                        , output, originalSize
+                        , content.data()+headerLen, content.length()-headerLen
+                    );
+                    if (ZSTD_isError(res) || res != originalSize) {
+                        return std::nullopt;
+                    }
+                    return originalSize;
+                }
+            case ZstdDictTag:
+                {
+                    if (content.length() < MaxHeaderLength) {
+                        return std::nullopt;
+                    }
+                    uint32_t dictID = decodeUInt32(content.data()+headerLen);
+                    headerLen += SizeFieldLength;
+                    auto dicts = std::atomic_load(&dicts_);
+                    auto iter = dicts->find(dictID);
+                    if (iter == dicts->end()) {
+                        return std::nullopt;
+                    }
+                    std::size_t res = ZSTD_decompress_usingDDict(
+                        threadDCtx()
+                        , output, originalSize
+                        , content.data()+headerLen, content.length()-headerLen
+                        , iter->second.get()
+                    );
+                    if (ZSTD_isError(res) || res != originalSize) {
+                        return std::nullopt;
+                    }
+                    return originalSize;
+                }
+            default:
+                return std::nullopt;
+            }
+        }
+    };
+
+    CompressionHelper::Decompressor::Decompressor()
+        : impl_(std::make_unique<DecompressorImpl>(CompressionHelper::DefaultMaxDecompressedSize, CompressionHelper::DefaultMaxCompressionRatio))
+        {}
+    CompressionHelper::Decompressor::Decompressor(std::size_t maxDecompressedSize, std::size_t maxCompressionRatio)
+        : impl_(std::make_unique<DecompressorImpl>(maxDecompressedSize, maxCompressionRatio))
+        {}
+    CompressionHelper::Decompressor::~Decompressor() {}
+    CompressionHelper::Decompressor::Decompressor(CompressionHelper::Decompressor &&) = default;
+    CompressionHelper::Decompressor &CompressionHelper::Decompressor::operator=(CompressionHelper::Decompressor &&) = default;
+    void CompressionHelper::Decompressor::addDictionary(std::string const &dictionary) {
+        impl_->addDictionary(dictionary);
+    }
+    std::size_t CompressionHelper::Decompressor::maxOutputSize(std::size_t inputSize) const {
+        return impl_->maxOutputSize(inputSize);
+    }
+    std::optional<std::size_t> CompressionHelper::Decompressor::decompress(basic::ByteDataView const &input, char *output, std::size_t outputCapacity) const {
+        return impl_->decompress(input, output, outputCapacity);
+    }
+
+    std::string CompressionHelper::trainDictionary(std::vector<std::string> const &samples, std::size_t dictionarySize) {
+        std::string samplesBuffer;
+        std::vector<std::size_t> sampleSizes;
+        sampleSizes.reserve(samples.size());
+        for (auto const &s : samples) {
+            samplesBuffer.append(s);
+            sampleSizes.push_back(s.length());
+        }
+        std::string dict;
+        dict.resize(dictionarySize);
+        std::size_t res = ZDICT_trainFromBuffer(
+            dict.data(), dict.length()
+            , samplesBuffer.data(), sampleSizes.data(), static_cast<unsigned>(sampleSizes.size())
+        );
+        if (ZDICT_isError(res)) {
+            throw std::runtime_error(std::string("CompressionHelper: cannot train zstd dictionary: ")+ZDICT_getErrorName(res));
+        }
+        dict.resize(res);
+        return dict;
+    }
+} } } } }
@@ -0,0 +1,500 @@
+#include <mutex>
+#include <atomic>
+#include <vector>
+#include <unordered_map>
+#include <unordered_set>
+#include <algorithm>
+#include <shared_mutex>
+
+#include <tm_kit/transport/inproc/InprocComponent.hpp>
+#include <tm_kit/transport/TransportMetricsComponent.hpp>
+
+namespace dev { namespace cd606 { namespace tm { namespace transport { namespace inproc {
+
+    namespace {
+        ConnectionLocator channelKey(ConnectionLocator const &locator) {
+            return ConnectionLocator {locator.host(), locator.port(), "", "", locator.identifier()};
+        }
+
+        using Client = std::function<void(InprocMessage const &)>;
+
+        //A publisher may still be delivering from an old snapshot after the
+        //client has been removed, so each delivery holds the entry's lock
+        //(shared), and removal takes it exclusively to wait for them. A
+        //client removed from its own callback is only marked dead, since
+        //its thread already holds the lock.
+        struct ClientEntry {
+            Client client;
+            std::shared_mutex mutex;
+            std::atomic<bool> alive;
+            ClientEntry(Client const &c) : client(c), mutex(), alive(true) {}
+        };
+        using ClientEntryPtr = std::shared_ptr<ClientEntry>;
+
+        thread_local std::vector<ClientEntry const *> entriesBeingDelivered;
+
+        bool isBeingDeliveredOnThisThread(ClientEntry const *e) {
+            return std::find(entriesBeingDelivered.begin(), entriesBeingDelivered.end(), e) != entriesBeingDelivered.end();
+        }
+        void deliver(ClientEntryPtr const &e, InprocMessage const &m) {
+            if (isBeingDeliveredOnThisThread(e.get())) {
+                if (e->alive) {
+                    e->client(m);
+                }
+                return;
+            }
+            std::shared_lock<std::shared_mutex> _(e->mutex);
+            if (!e->alive) {
+                return;
+            }
+            entriesBeingDelivered.push_back(e.get());
+            try {
+                e->client(m);
+            } catch (...) {
+                entriesBeingDelivered.pop_back();
+                throw;
+            }
+            entriesBeingDelivered.pop_back();
+        }
+        void retire(ClientEntryPtr const &e) {
+            e->alive = false;
+            if (!isBeingDeliveredOnThisThread(e.get())) {
+                std::unique_lock<std::shared_mutex> _(e->mutex);
+            }
+        }
+
+        struct SubscriberSnapshot {
+            std::vector<std::tuple<uint32_t, ClientEntryPtr>> noFilterClients;
+            std::unordered_multimap<std::string, std::tuple<uint32_t, ClientEntryPtr>> stringMatchClients;
+            std::vector<std::tuple<uint32_t, std::regex, ClientEntryPtr>> regexMatchClients;
+        };
+
+        //The subscriber lists are copied on every change and swapped in,
+        //so that publishing only needs an atomic load
+        class BroadcastChannel {
+        private:
+            std::mutex writeMutex_;
+            std::shared_ptr<SubscriberSnapshot const> snapshot_;
+        public:
+            BroadcastChannel() : writeMutex_(), snapshot_(std::make_shared<SubscriberSnapshot const>()) {}
+            void addClient(uint32_t id, InprocComponent::TopicSelection const &topic, Client const &client) {
+                std::lock_guard<std::mutex> _(writeMutex_);
+                auto s = std::make_shared<SubscriberSnapshot>(*snapshot_);
+                auto entry = std::make_shared<ClientEntry>(client);
+                std::visit([id,&entry,&s](auto const &t) {
+                    using T = std::decay_t<decltype(t)>;
+                    if constexpr (std::is_same_v<T, InprocComponent::NoTopicSelection>) {
+                        s->noFilterClients.push_back({id, entry});
+                    } else if constexpr (std::is_same_v<T, std::string>) {
+                        s->stringMatchClients.insert({t, {id, entry}});
+                    } else if constexpr (std::is_same_v<T, std::regex>) {
+                        s->regexMatchClients.push_back({id, t, entry});
+                    }
+                }, topic);
+                std::atomic_store(&snapshot_, std::shared_ptr<SubscriberSnapshot const> {s});
+            }
+            //when this returns, the client is not being called and will not
+            //be called again (unless this is called from the client itself)
+            void removeClient(uint32_t id) {
+                std::vector<ClientEntryPtr> removed;
+                {
+                    std::lock_guard<std::mutex> _(writeMutex_);
+                    auto s = std::make_shared<SubscriberSnapshot>(*snapshot_);
+                    s->noFilterClients.erase(
+                        std::remove_if(s->noFilterClients.begin(), s->noFilterClients.end(), [id,&removed](auto const &c) {
+                            if (std::get<0>(c) == id) {
+                                removed.push_back(std::get<1>(c));
+                                return true;
+                            }
+                            return false;
+                        })
+                        , s->noFilterClients.end()
+                    );
+                    for (auto iter = s->stringMatchClients.begin(); iter != s->stringMatchClients.end(); ) {
+                        if (std::get<0>(iter->second) == id) {
+                            removed.push_back(std::get<1>(iter->second));
+                            iter = s->stringMatchClients.erase(iter);
+                        } else {
+                            ++iter;
+                        }
+                    }
+                    s->regexMatchClients.erase(
+                        std::remove_if(s->regexMatchClients.begin(), s->regexMatchClients.end(), [id,&removed](auto const &c) {
+                            if (std::get<0>(c) == id) {
+                                removed.push_back(std::get<2>(c));
+                                return true;
+                            }
+                            return false;
+                        })
+                        , s->regexMatchClients.end()
+                    );
+                    std::atomic_store(&snapshot_, std::shared_ptr<SubscriberSnapshot const> {s});
+                }
+                //outside writeMutex_, so that the clients being waited for
+                //can still add or remove subscriptions
+                for (auto const &e : removed) {
+                    retire(e);
+                }
+            }
+            void publish(InprocMessage const &m) {
+                auto s = std::atomic_load(&snapshot_);
+                for (auto const &c : s->noFilterClients) {
+                    deliver(std::get<1>(c), m);
+                }
+                auto range = s->stringMatchClients.equal_range(m.topic());
+                for (auto iter = range.first; iter != range.second; ++iter) {
+                    deliver(std::get<1>(iter->second), m);
+                }
+                for (auto const &c : s->regexMatchClients) {
+                    if (std::regex_match(m.topic(), std::get<1>(c))) {
+                        deliver(std::get<2>(c), m);
+                    }
+                }
+            }
+        };
+
+        struct RPCClientState {
+            std::mutex mutex;
+            std::function<void(bool, basic::ByteDataWithID &&)> client;
+            std::optional<ByteDataHookPair> hookPair;
+
+            void deliver(bool isFinal, basic::ByteDataWithID &&data) {
+                std::function<void(bool, basic::ByteDataWithID &&)> c;
+                {
+                    std::lock_guard<std::mutex> _(mutex);
+                    c = client;
+                }
+                if (!c) {
+                    return;
+                }
+                if (hookPair && hookPair->wireToUser) {
+                    auto b = (hookPair->wireToUser->hook)(basic::ByteDataView {std::string_view(data.content)});
+                    if (!b) {
+                        return;
+                    }
+                    c(isFinal, {std::move(data.id), std::move(b->content)});
+                } else {
+                    c(isFinal, std::move(data));
+                }
+            }
+            //ends a request that will never get its reply, with an empty
+            //final reply (bypassing the hook), as is done for a rejected
+            //final reply
+            void abandon(std::string const &id) {
+                std::function<void(bool, basic::ByteDataWithID &&)> c;
+                {
+                    std::lock_guard<std::mutex> _(mutex);
+                    c = client;
+                }
+                if (c) {
+                    c(true, {std::string {id}, std::string {}});
+                }
+            }
+        };
+
+        class RPCChannel {
+        private:
+            std::mutex mutex_;
+            std::function<void(basic::ByteDataWithID &&)> server_;
+            std::optional<ByteDataHookPair> serverHookPair_;
+            std::unordered_map<std::string, std::shared_ptr<RPCClientState>> outstanding_;
+
+            void callServer(std::function<void(basic::ByteDataWithID &&)> const &server, std::optional<ByteDataHookPair> const &hookPair, basic::ByteDataWithID &&data) {
+                if (hookPair && hookPair->wireToUser) {
+                    auto b = (hookPair->wireToUser->hook)(basic::ByteDataView {std::string_view(data.content)});
+                    if (!b) {
+                        return;
+                    }
+                    server({std::move(data.id), std::move(b->content)});
+                } else {
+                    server(std::move(data));
+                }
+            }
+        public:
+            RPCChannel() : mutex_(), server_(), serverHookPair_(), outstanding_() {}
+            bool setServer(std::function<void(basic::ByteDataWithID &&)> const &server, std::optional<ByteDataHookPair> const &hookPair) {
+                std::lock_guard<std::mutex> _(mutex_);
+                if (server_) {
+                    return false;
+                }
+                server_ = server;
+                serverHookPair_ = hookPair;
+                return true;
+            }
+            void removeServer() {
+                std::unordered_map<std::string, std::shared_ptr<RPCClientState>> outstanding;
+                {
+                    std::lock_guard<std::mutex> _(mutex_);
+                    server_ = std::function<void(basic::ByteDataWithID &&)>();
+                    serverHookPair_ = std::nullopt;
+                    outstanding.swap(outstanding_);
+                }
+                for (auto const &item : outstanding) {
+                    item.second->abandon(item.first);
+                }
+            }
+            //false if there is no server to take the request
+            bool request(std::shared_ptr<RPCClientState> const &client, basic::ByteDataWithID &&data) {
+                std::function<void(basic::ByteDataWithID &&)> server;
+                std::optional<ByteDataHookPair> hookPair;
+                {
+                    std::lock_guard<std::mutex> _(mutex_);
+                    if (!server_) {
+                        return false;
+                    }
+                    outstanding_[data.id] = client;
+                    server = server_;
+                    hookPair = serverHookPair_;
+                }
+                callServer(server, hookPair, std::move(data));
+                return true;
+            }
+            void reply(bool isFinal, basic::ByteDataWithID &&data) {
+                std::shared_ptr<RPCClientState> client;
+                std::optional<ByteDataHookPair> hookPair;
+                {
+                    std::lock_guard<std::mutex> _(mutex_);
+                    auto iter = outstanding_.find(data.id);
+                    if (iter == outstanding_.end()) {
+                        return;
+                    }
+                    client = iter->second;
+                    if (isFinal) {
+                        outstanding_.erase(iter);
+                    }
+                    hookPair = serverHookPair_;
+                }
+                if (hookPair && hookPair->userToWire) {
+                    auto x = byte_data_hook_utils::tryUserToWireHookForReply(hookPair->userToWire->hook, isFinal, basic::ByteData {std::move(data.content)});
+                    if (!x) {
+                        return;
+                    }
+                    data.content = std::move(x->content);
+                }
+                client->deliver(isFinal, std::move(data));
+            }
+        };
+
+        class InprocRegistry {
+        private:
+            std::mutex mutex_;
+            std::unordered_map<ConnectionLocator, std::shared_ptr<BroadcastChannel>> broadcastChannels_;
+            std::unordered_map<ConnectionLocator, std::shared_ptr<RPCChannel>> rpcChannels_;
+            std::unordered_map<uint32_t, std::shared_ptr<BroadcastChannel>> subscriptions_;
+            uint32_t counter_ = 0;
+        public:
+            static InprocRegistry &instance() {
+                static InprocRegistry registry;
+                return registry;
+            }
+            std::shared_ptr<BroadcastChannel> broadcastChannel(ConnectionLocator const &locator) {
+                std::lock_guard<std::mutex> _(mutex_);
+                auto &c = broadcastChannels_[channelKey(locator)];
+                if (!c) {
+                    c = std::make_shared<BroadcastChannel>();
+                }
+                return c;
+            }
+            std::shared_ptr<RPCChannel> rpcChannel(ConnectionLocator const &locator) {
+                std::lock_guard<std::mutex> _(mutex_);
+                auto &c = rpcChannels_[channelKey(locator)];
+                if (!c) {
+                    c = std::make_shared<RPCChannel>();
+                }
+                return c;
+            }
+            uint32_t addSubscriptionClient(ConnectionLocator const &locator, InprocComponent::TopicSelection const &topic, Client const &client) {
+                auto channel = broadcastChannel(locator);
+                uint32_t id;
+                {
+                    std::lock_guard<std::mutex> _(mutex_);
+                    id = ++counter_;
+                    subscriptions_[id] = channel;
+                }
+                channel->addClient(id, topic, client);
+                return id;
+            }
+            void removeSubscriptionClient(uint32_t id) {
+                std::shared_ptr<BroadcastChannel> channel;
+                {
+                    std::lock_guard<std::mutex> _(mutex_);
+                    auto iter = subscriptions_.find(id);
+                    if (iter == subscriptions_.end()) {
+                        return;
+                    }
+                    channel = iter->second;
+                    subscriptions_.erase(iter);
+                }
+                channel->removeClient(id);
+            }
+        };
+    }
+
+    //Only keeps track of what this component registered, so that it can be
+    //taken off the channels when the component goes away
+    class InprocComponentImpl {
+    private:
+        std::mutex mutex_;
+        std::unordered_set<uint32_t> subscriptions_;
+        std::unordered_map<ConnectionLocator, std::shared_ptr<RPCClientState>> rpcClients_;
+        std::vector<std::shared_ptr<RPCChannel>> rpcServers_;
+    public:
+        InprocComponentImpl() : mutex_(), subscriptions_(), rpcClients_(), rpcServers_() {}
+        ~InprocComponentImpl() {
+            auto &registry = InprocRegistry::instance();
+            for (auto id : subscriptions_) {
+                registry.removeSubscriptionClient(id);
+            }
+            for (auto &c : rpcClients_) {
+                std::lock_guard<std::mutex> _(c.second->mutex);
+                c.second->client = std::function<void(bool, basic::ByteDataWithID &&)>();
+            }
+            for (auto &s : rpcServers_) {
+                s->removeServer();
+            }
+        }
+        uint32_t addMessageSubscriptionClient(ConnectionLocator const &locator, InprocComponent::TopicSelection const &topic, Client const &client) {
+            auto id = InprocRegistry::instance().addSubscriptionClient(locator, topic, client);
+            std::lock_guard<std::mutex> _(mutex_);
+            subscriptions_.insert(id);
+            return id;
+        }
+        void removeSubscriptionClient(uint32_t id) {
+            {
+                std::lock_guard<std::mutex> _(mutex_);
+                subscriptions_.erase(id);
+            }
+            InprocRegistry::instance().removeSubscriptionClient(id);
+        }
+        std::function<void(InprocMessage &&)> getMessagePublisher(ConnectionLocator const &locator) {
+            auto channel = InprocRegistry::instance().broadcastChannel(locator);
+            return [channel](InprocMessage &&m) {
+                channel->publish(m);
+            };
+        }
+        std::function<void(basic::ByteDataWithID &&)> setRPCClient(ConnectionLocator const &locator,
+                        std::function<void(bool, basic::ByteDataWithID &&)> client,
+                        std::optional<ByteDataHookPair> hookPair) {
+            auto state = std::make_shared<RPCClientState>();
+            state->client = client;
+            state->hookPair = hookPair;
+            {
+                std::lock_guard<std::mutex> _(mutex_);
+                auto key = channelKey(locator);
+                if (rpcClients_.find(key) != rpcClients_.end()) {
+                    throw InprocComponentException("Cannot create duplicate RPC client connection for "+key.toSerializationFormat());
+                }
+                rpcClients_[key] = state;
+            }
+            auto channel = InprocRegistry::instance().rpcChannel(locator);
+            return [channel,state,key=channelKey(locator)](basic::ByteDataWithID &&data) {
+                if (state->hookPair && state->hookPair->userToWire) {
+                    data.content = state->hookPair->userToWire->hook(basic::ByteData {std::move(data.content)}).content;
+                }
+                if (!channel->request(state, std::move(data))) {
+                    throw InprocComponentException("No RPC server for "+key.toSerializationFormat());
+                }
+            };
+        }
+        void removeRPCClient(ConnectionLocator const &locator) {
+            std::shared_ptr<RPCClientState> state;
+            {
+                std::lock_guard<std::mutex> _(mutex_);
+                auto iter = rpcClients_.find(channelKey(locator));
+                if (iter == rpcClients_.end()) {
+                    return;
+                }
+                state = iter->second;
+                rpcClients_.erase(iter);
+            }
+            std::lock_guard<std::mutex> _(state->mutex);
+            state->client = std::function<void(bool, basic::ByteDataWithID &&)>();
+        }
+        std::function<void(bool, basic::ByteDataWithID &&)> setRPCServer(ConnectionLocator const &locator,
+                        std::function<void(basic::ByteDataWithID &&)> server,
+                        std::optional<ByteDataHookPair> hookPair) {
+            auto channel = InprocRegistry::instance().rpcChannel(locator);
+            if (!channel->setServer(server, hookPair)) {
+                throw InprocComponentException("Cannot create duplicate RPC server connection for "+channelKey(locator).toSerializationFormat());
+            }
+            {
+                std::lock_guard<std::mutex> _(mutex_);
+                rpcServers_.push_back(channel);
+            }
+            return [channel](bool isFinal, basic::ByteDataWithID &&data) {
+                channel->reply(isFinal, std::move(data));
+            };
+        }
+    };
+
+    InprocComponent::InprocComponent() : impl_(std::make_unique<InprocComponentImpl>()) {}
+    InprocComponent::~InprocComponent() {}
+    InprocComponent::InprocComponent(InprocComponent &&) = default;
+    InprocComponent &InprocComponent::operator=(InprocComponent &&) = default;
+    uint32_t InprocComponent::inproc_addMessageSubscriptionClient(ConnectionLocator const &locator,
+        InprocComponent::TopicSelection const &topic,
+        std::function<void(InprocMessage const &)> client) {
+        return impl_->addMessageSubscriptionClient(locator, topic, client);
+    }
+    std::function<void(InprocMessage &&)> InprocComponent::inproc_getMessagePublisher(ConnectionLocator const &locator) {
+        return impl_->getMessagePublisher(locator);
+    }
+    uint32_t InprocComponent::inproc_addSubscriptionClient(ConnectionLocator const &locator,
+        InprocComponent::TopicSelection const &topic,
+        std::function<void(basic::ByteDataWithTopic &&)> client,
+        std::optional<WireToUserHook> wireToUserHook) {
+        return impl_->addMessageSubscriptionClient(
+            locator
+            , topic
+            , [client,wireToUserHook](InprocMessage const &m) {
+                auto const *bytes = m.bytes();
+                if (!bytes) {
+                    return;
+                }
+                if (wireToUserHook) {
+                    auto b = (wireToUserHook->hook)(basic::ByteDataView {std::string_view(*bytes)});
+                    if (b) {
+                        client({m.topic(), std::move(b->content)});
+                    }
+                } else {
+                    client({m.topic(), *bytes});
+                }
+            }
+        );
+    }
+    void InprocComponent::inproc_removeSubscriptionClient(uint32_t id) {
+        impl_->removeSubscriptionClient(id);
+    }
+    std::function<void(basic::ByteDataWithTopic &&)> InprocComponent::inproc_getPublisher(ConnectionLocator const &locator, std::optional<UserToWireHook> userToWireHook) {
+        auto p = impl_->getMessagePublisher(locator);
+        if (userToWireHook) {
+            return [p,userToWireHook](basic::ByteDataWithTopic &&data) {
+                auto x = byte_data_hook_utils::tryUserToWireHook(userToWireHook->hook, basic::ByteData {std::move(data.content)});
+                if (!x) {
+                    return;
+                }
+                p(InprocMessage {std::move(data.topic), std::move(x->content)});
+            };
+        } else {
+            return [p](basic::ByteDataWithTopic &&data) {
+                p(InprocMessage {std::move(data.topic), std::move(data.content)});
+            };
+        }
+    }
+    std::function<void(basic::ByteDataWithID &&)> InprocComponent::inproc_setRPCClient(ConnectionLocator const &locator,
+        std::function<void(bool, basic::ByteDataWithID &&)> client,
+        std::optional<ByteDataHookPair> hookPair) {
+        auto metrics = transportRPCChannelMetrics(dynamic_cast<TransportMetricsComponent *>(this), "inproc", locator);
+        return countRPCSend(metrics, impl_->setRPCClient(locator, countRPCReceive(metrics, client), hookPair));
+    }
+    void InprocComponent::inproc_removeRPCClient(ConnectionLocator const &locator) {
+        impl_->removeRPCClient(locator);
+    }
+    std::function<void(bool, basic::ByteDataWithID &&)> InprocComponent::inproc_setRPCServer(ConnectionLocator const &locator,
+        std::function<void(basic::ByteDataWithID &&)> server,
+        std::optional<ByteDataHookPair> hookPair) {
+        auto metrics = transportRPCChannelMetrics(dynamic_cast<TransportMetricsComponent *>(this), "inproc", locator);
+        return countRPCSend(metrics, impl_->setRPCServer(locator, countRPCReceive(metrics, server), hookPair));
+    }
+
+} } } } }
@@ -6,6 +6,7 @@
 #include <boost/bind/bind.hpp>
 
 #include <tm_kit/transport/multicast/MulticastComponent.hpp>
+#include <tm_kit/transport/TransportThreading.hpp>
 #include "InterfaceToIP.hpp"
 
 namespace dev { namespace cd606 { namespace tm { namespace transport { namespace multicast {
@@ -29,6 +30,9 @@ namespace dev { namespace cd606 { namespace tm { namespace transport { namespace
         private:
             MulticastComponentTopicEncodingChoice encodingChoice_;
             ConnectionLocator locator_;
+            //owned here and declared before the socket, so that the socket
+            //goes away first
+            std::unique_ptr<boost::asio::io_service> service_;
             boost::asio::ip::udp::socket sock_;
             boost::asio::ip::udp::endpoint senderPoint_;
             boost::asio::ip::address mcastAddr_;
@@ -45,6 +49,7 @@ namespace dev { namespace cd606 { namespace tm { namespace transport { namespace
             std::mutex mutex_;
 
             std::atomic<bool> running_;
+            std::thread th_;
 
             inline void callClient(ClientCB const &c, basic::ByteDataWithTopic &&d) {
                 if (c.hook) {
@@ -116,13 +121,13 @@ namespace dev { namespace cd606 { namespace tm { namespace transport { namespace
                 }
             }
         public:
-            OneMulticastSubscription(MulticastComponentTopicEncodingChoice encodingChoice, boost::asio::io_service *service, ConnectionLocator const &locator, std::string const &interface) 
-                : encodingChoice_(encodingChoice), locator_(locator), sock_(*service), senderPoint_(), mcastAddr_(), buffer_()
+            OneMulticastSubscription(MulticastComponentTopicEncodingChoice encodingChoice, ConnectionLocator const &locator, std::string const &interface, TransportThreadingConfig const &threading) 
+                : encodingChoice_(encodingChoice), locator_(locator), service_(std::make_unique<boost::asio::io_service>()), sock_(*service_), senderPoint_(), mcastAddr_(), buffer_()
                 , noFilterClients_(), stringMatchClients_(), regexMatchClients_()
                 , thHandle_()
-                , mutex_(), running_(true)
+                , mutex_(), running_(true), th_()
             {
-                boost::asio::ip::udp::resolver resolver(*service);
+                boost::asio::ip::udp::resolver resolver(*service_);
 
                 {
                     boost::asio::ip::udp::resolver::query query("0.0.0.0", std::to_string(locator.port()));
@@ -130,6 +135,7 @@ namespace dev { namespace cd606 { namespace tm { namespace transport { namespace
                     sock_.open(listenPoint.protocol());
                     sock_.set_option(boost::asio::ip::udp::socket::reuse_address(true));
                     sock_.set_option(boost::asio::ip::udp::socket::receive_buffer_size(16*1024*1024));
+                    threading.applyToSocket(static_cast<std::intptr_t>(sock_.native_handle()), locator.toPrintFormat());
                     //sock_.set_option(boost::asio::ip::multicast::enable_loopback(true));
                     sock_.bind(listenPoint);
                 }
@@ -164,11 +170,38 @@ namespace dev { namespace cd606 { namespace tm { namespace transport { namespace
                                 , boost::asio::placeholders::error
                                 , boost::asio::placeholders::bytes_transferred)
                 );
+
+                th_ = std::thread([this,threading]() {
+                    threading.applyToCurrentThread(locator_.toPrintFormat());
+                    boost::asio::io_service::work work(*service_);
+                    if (threading.busyLoop) {
+                        while (running_) {
+                            service_->poll();
+                        }
+                    } else {
+                        service_->run();
+                    }
+                });
+                thHandle_ = th_.native_handle();
             }
+            //must not be called on the subscription's own thread, see
+            //isOnOwnThread
             ~OneMulticastSubscription() {
+                //the thread is stopped and joined before the socket is
+                //closed, so no handler runs on this object afterwards
                 running_ = false;
+                service_->stop();
+                try {
+                    if (th_.joinable()) {
+                        th_.join();
+                    }
+                } catch (std::system_error const &) {
+                }
                 sock_.close();
             }
+            bool isOnOwnThread() const {
+                return (std::this_thread::get_id() == th_.get_id());
+            }
             ConnectionLocator const &locator() const {
                 return locator_;
             }
@@ -235,10 +268,6 @@ namespace dev { namespace cd606 { namespace tm { namespace transport { namespace
                     return false;
                 }
             }
-            void setThreadHandle(std::thread::native_handle_type h) {
-                std::lock_guard<std::mutex> _(mutex_);
-                thHandle_ = h;
-            }
             std::optional<std::thread::native_handle_type> getThreadHandle() {
                 std::lock_guard<std::mutex> _(mutex_);
                 return thHandle_;
@@ -323,21 +352,27 @@ namespace dev { namespace cd606 { namespace tm { namespace transport { namespace
             if (iter == subscriptions_.end()) {
                 auto choice = parseEncodingChoice(d.query("envelop", "cbor"));
                 auto interface = d.query("interface", "");
-                std::unique_ptr<boost::asio::io_service> svc = std::make_unique<boost::asio::io_service>();
-                iter = subscriptions_.insert({hostAndPort, std::make_unique<OneMulticastSubscription>(choice, svc.get(), hostAndPort, interface)}).first;
-                std::thread th([svc=std::move(svc)] {
-                    boost::asio::io_service::work work(*svc);
-                    svc->run();
-                });
-                th.detach();
-                iter->second->setThreadHandle(th.native_handle());
+                iter = subscriptions_.insert({hostAndPort, std::make_unique<OneMulticastSubscription>(choice, hostAndPort, interface, TransportThreadingConfig::fromLocator(d))}).first;
             }
             return iter->second.get();
         }
+        //the subscription is destroyed without holding mutex_, since that
+        //waits for its thread, and if this is called on that thread (by a
+        //client removing itself), on another thread
         void potentiallyStopSubscription(OneMulticastSubscription *p) {
-            std::lock_guard<std::mutex> _(mutex_);
-            if (p->checkWhetherNeedsToStop()) {
-                subscriptions_.erase(p->locator());
+            std::unique_ptr<OneMulticastSubscription> toStop;
+            {
+                std::lock_guard<std::mutex> _(mutex_);
+                if (p->checkWhetherNeedsToStop()) {
+                    auto iter = subscriptions_.find(p->locator());
+                    if (iter != subscriptions_.end()) {
+                        toStop = std::move(iter->second);
+                        subscriptions_.erase(iter);
+                    }
+                }
+            }
+            if (toStop && toStop->isOnOwnThread()) {
+                std::thread([toStop=std::move(toStop)]() {}).detach();
             }
         }
         OneMulticastSender *getOrStartSender(ConnectionLocator const &d) {
@@ -366,12 +401,14 @@ namespace dev { namespace cd606 { namespace tm { namespace transport { namespace
         }
         ~MulticastComponentImpl() {
             bool b;
+            decltype(subscriptions_) subscriptions;
             {
                 std::lock_guard<std::mutex> _(mutex_);
-                subscriptions_.clear();
+                std::swap(subscriptions, subscriptions_);
                 senders_.clear();
                 b = senderThreadStarted_;
             }
+            subscriptions.clear();
             if (b) {
                 senderService_.stop();
                 try {
@@ -414,8 +451,11 @@ namespace dev { namespace cd606 { namespace tm { namespace transport { namespace
             if (userToWireHook) {
                 auto hook = userToWireHook->hook;
                 return [p,hook](basic::ByteDataWithTopic &&data, int ttl) {
-                    auto w = hook(basic::ByteData {std::move(data.content)});
-                    p->publish({std::move(data.topic), std::move(w.content)}, ttl);
+                    auto w = byte_data_hook_utils::tryUserToWireHook(hook, basic::ByteData {std::move(data.content)});
+                    if (!w) {
+                        return;
+                    }
+                    p->publish({std::move(data.topic), std::move(w->content)}, ttl);
                 };
             } else {
                 return [p](basic::ByteDataWithTopic &&data, int ttl) {
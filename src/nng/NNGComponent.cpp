@@ -11,6 +11,7 @@
 #include <nngpp/protocol/sub0.h>
 
 #include <tm_kit/transport/nng/NNGComponent.hpp>
+#include <tm_kit/transport/TransportThreading.hpp>
 
 namespace dev { namespace cd606 { namespace tm { namespace transport { namespace nng {
     class NNGComponentImpl {
@@ -41,7 +42,8 @@ namespace dev { namespace cd606 { namespace tm { namespace transport { namespace
                 }
             }
 
-            void run(ConnectionLocator const &locator) {
+            void run(ConnectionLocator const &locator, TransportThreadingConfig const &threading) {
+                threading.applyToCurrentThread(locator.toPrintFormat());
                 auto sock = ::nng::sub::open();
                 nng_setopt(sock.get(), NNG_OPT_SUB_SUBSCRIBE, "", 0);
                 sock.set_opt_ms(NNG_OPT_RECVTIMEO, 1000);
@@ -70,10 +72,22 @@ namespace dev { namespace cd606 { namespace tm { namespace transport { namespace
                     }
             
                     int missedCount = 0;
+                    //when busy looping, every second without data counts
+                    //as one timeout
+                    auto lastReceived = std::chrono::steady_clock::now();
                     while (running_ && missedCount < 10) {
                         char *data = nullptr;
                         std::size_t sz;
-                        int r = nng_recv(sock.get(), &data, &sz, NNG_FLAG_ALLOC);
+                        int r = nng_recv(sock.get(), &data, &sz, NNG_FLAG_ALLOC | (threading.busyLoop?NNG_FLAG_NONBLOCK:0));
+                        if (r == NNG_EAGAIN) {
+                            auto now = std::chrono::steady_clock::now();
+                            if (now-lastReceived >= std::chrono::seconds(1)) {
+                                ++missedCount;
+                                lastReceived = now;
+                            }
+                            continue;
+                        }
+                        lastReceived = std::chrono::steady_clock::now();
                         if (r == NNG_ETIMEDOUT) {
                             ++missedCount;
                             if (data) {
@@ -118,12 +132,12 @@ namespace dev { namespace cd606 { namespace tm { namespace transport { namespace
                 sock.~socket();
             }
         public:
-            OneNNGSubscription(ConnectionLocator const &locator) 
+            OneNNGSubscription(ConnectionLocator const &locator, TransportThreadingConfig const &threading) 
                 : locator_(locator)
                 , noFilterClients_(), stringMatchClients_(), regexMatchClients_()
                 , mutex_(), th_(), running_(true)
             {
-                th_ = std::thread(&OneNNGSubscription::run, this, locator);
+                th_ = std::thread(&OneNNGSubscription::run, this, locator, threading);
             }
             ~OneNNGSubscription() {
                 running_ = false;
@@ -245,7 +259,7 @@ namespace dev { namespace cd606 { namespace tm { namespace transport { namespace
             std::lock_guard<std::mutex> _(mutex_);
             auto iter = subscriptions_.find(hostAndPort);
             if (iter == subscriptions_.end()) {
-                iter = subscriptions_.insert({hostAndPort, std::make_unique<OneNNGSubscription>(hostAndPort)}).first;
+                iter = subscriptions_.insert({hostAndPort, std::make_unique<OneNNGSubscription>(hostAndPort, TransportThreadingConfig::fromLocator(d))}).first;
             }
             return iter->second.get();
         }
@@ -308,8 +322,11 @@ namespace dev { namespace cd606 { namespace tm { namespace transport { namespace
             if (userToWireHook) {
                 auto hook = userToWireHook->hook;
                 return [p,hook](basic::ByteDataWithTopic &&data) {
-                    auto w = hook(basic::ByteData {std::move(data.content)});
-                    p->publish({std::move(data.topic), std::move(w.content)});
+                    auto w = byte_data_hook_utils::tryUserToWireHook(hook, basic::ByteData {std::move(data.content)});
+                    if (!w) {
+                        return;
+                    }
+                    p->publish({std::move(data.topic), std::move(w->content)});
                 };
             } else {
                 return [p](basic::ByteDataWithTopic &&data) {
@@ -1,5 +1,7 @@
 #include <tm_kit/transport/rabbitmq/RabbitMQComponent.hpp>
 #include <tm_kit/transport/TLSConfigurationComponent.hpp>
+#include <tm_kit/transport/TransportThreading.hpp>
+#include <tm_kit/transport/TransportMetricsComponent.hpp>
 
 #include <thread>
 #include <mutex>
@@ -7,6 +9,10 @@
 #include <condition_variable>
 #include <vector>
 #include <unordered_map>
+#include <map>
+#include <deque>
+#include <algorithm>
+#include <chrono>
 
 #ifdef _MSC_VER
 #include <winsock.h>
@@ -97,43 +103,113 @@ namespace dev { namespace cd606 { namespace tm { namespace transport { namespace
             return conn;
         }
 
+        //Consumer options come from the locator properties:
+        //  prefetch=N: the broker sends at most N unacknowledged messages
+        //  consume_batch=N: up to N messages that are already buffered
+        //    are taken at each wakeup, handled together and acknowledged
+        //    with one cumulative ack
+        static void setPrefetch(amqp_connection_state_t conn, ConnectionLocator const &l, uint16_t defaultPrefetch) {
+            uint16_t prefetch = static_cast<uint16_t>(std::stoul(l.query("prefetch", std::to_string(defaultPrefetch))));
+            if (prefetch == 0) {
+                return;
+            }
+            amqp_basic_qos(conn, 1, 0, prefetch, false);
+            if (amqp_get_rpc_reply(conn).reply_type != AMQP_RESPONSE_NORMAL) {
+                throw RabbitMQComponentException("Cannot set QoS on RabbitMQ queue for "+l.toPrintFormat());
+            }
+        }
+        static std::size_t consumeBatchSize(ConnectionLocator const &l) {
+            return std::max<std::size_t>(1, std::stoul(l.query("consume_batch", "1")));
+        }
+        struct EnvelopeBatch {
+            std::vector<amqp_envelope_t> envelopes;
+            ~EnvelopeBatch() {
+                for (auto &e : envelopes) {
+                    amqp_destroy_envelope(&e);
+                }
+            }
+            uint64_t lastDeliveryTag() const {
+                return envelopes.back().delivery_tag;
+            }
+        };
+        //waits up to one second for the first message, then takes whatever
+        //is already buffered without further waiting
+        static void consumeBatch(amqp_connection_state_t conn, std::size_t maxBatch, EnvelopeBatch &batch) {
+            amqp_maybe_release_buffers(conn);
+            struct timeval tv {1, 0};
+            while (batch.envelopes.size() < maxBatch) {
+                amqp_envelope_t envelop;
+                auto res = amqp_consume_message(conn, &envelop, &tv, 0);
+                if (res.reply_type != AMQP_RESPONSE_NORMAL) {
+                    break;
+                }
+                batch.envelopes.push_back(envelop);
+                if (!amqp_data_in_buffer(conn) && !amqp_frames_enqueued(conn)) {
+                    break;
+                }
+                tv = {0, 0};
+            }
+        }
+
         class OneExchangeSubscriptionConnection {
         private:
             amqp_connection_state_t connection_;
             ConnectionLocator locator_;
             std::function<void(basic::ByteDataWithTopic &&)> callback_;
+            std::function<void(std::vector<basic::ByteDataWithTopic> &&)> batchCallback_;
             std::optional<WireToUserHook> wireToUserHook_;
+            std::size_t batchSize_;
             std::thread th_;
             std::atomic<bool> running_;
             RabbitMQComponent::ExceptionPolicy exceptionPolicy_;
+            std::optional<basic::ByteDataWithTopic> convert(amqp_envelope_t const &envelop) {
+                if (wireToUserHook_) {
+                    auto b = (wireToUserHook_->hook)(basic::ByteDataView {std::string_view((char const *) envelop.message.body.bytes, envelop.message.body.len)});
+                    if (!b) {
+                        return std::nullopt;
+                    }
+                    return basic::ByteDataWithTopic { 
+                        std::string((char const *) envelop.routing_key.bytes, envelop.routing_key.len)
+                        , std::move(b->content)
+                    };
+                } else {
+                    return basic::ByteDataWithTopic {
+                        std::string((char const *) envelop.routing_key.bytes, envelop.routing_key.len)
+                        , std::string((char const *) envelop.message.body.bytes, envelop.message.body.len)
+                    };
+                }
+            }
             void run(std::string const &tag) {
                 while (running_) {
                     try {
-                        amqp_rpc_reply_t res;
-                        amqp_envelope_t envelop;
-
-                        amqp_maybe_release_buffers(connection_);
-                        struct timeval tv {1, 0};
-                        res = amqp_consume_message(connection_, &envelop, &tv, 0);
-                        if (res.reply_type == AMQP_RESPONSE_NORMAL) {
-                            if (running_) {
-                                if (wireToUserHook_) {
-                                    auto b = (wireToUserHook_->hook)(basic::ByteDataView {std::string_view((char const *) envelop.message.body.bytes, envelop.message.body.len)});
-                                    if (b) {
-                                        callback_({ 
-                                            std::string((char const *) envelop.routing_key.bytes, envelop.routing_key.len)
-                                            , std::move(b->content)
-                                        });
+                        EnvelopeBatch batch;
+                        consumeBatch(connection_, batchSize_, batch);
+                        if (batch.envelopes.empty()) {
+                            continue;
+                        }
+                        if (running_) {
+                            if (batchCallback_) {
+                                std::vector<basic::ByteDataWithTopic> data;
+                                data.reserve(batch.envelopes.size());
+                                for (auto const &envelop : batch.envelopes) {
+                                    auto d = convert(envelop);
+                                    if (d) {
+                                        data.push_back(std::move(*d));
+                                    }
+                                }
+                                if (!data.empty()) {
+                                    batchCallback_(std::move(data));
+                                }
+                            } else {
+                                for (auto const &envelop : batch.envelopes) {
+                                    auto d = convert(envelop);
+                                    if (d) {
+                                        callback_(std::move(*d));
                                     }
-                                } else {
-                                    callback_({
-                                        std::string((char const *) envelop.routing_key.bytes, envelop.routing_key.len)
-                                        , std::string((char const *) envelop.message.body.bytes, envelop.message.body.len)
-                                    });
                                 }
                             }
-                            amqp_destroy_envelope(&envelop);
                         }
+                        amqp_basic_ack(connection_, 1, batch.lastDeliveryTag(), true);
                     } catch (std::exception &ex) {
                         switch (exceptionPolicy_) {
                         case RabbitMQComponent::ExceptionPolicy::Throw:
@@ -156,11 +232,13 @@ namespace dev { namespace cd606 { namespace tm { namespace transport { namespace
                 }
             }
         public:
-            OneExchangeSubscriptionConnection(RabbitMQComponent::ExceptionPolicy exceptionPolicy, ConnectionLocator const &l, std::string const &topic, std::function<void(basic::ByteDataWithTopic &&)> callback, std::optional<WireToUserHook> wireToUserHook, TLSClientConfigurationComponent const *config)
+            OneExchangeSubscriptionConnection(RabbitMQComponent::ExceptionPolicy exceptionPolicy, ConnectionLocator const &l, std::string const &topic, std::function<void(basic::ByteDataWithTopic &&)> callback, std::function<void(std::vector<basic::ByteDataWithTopic> &&)> batchCallback, std::optional<WireToUserHook> wireToUserHook, TLSClientConfigurationComponent const *config)
                 : connection_(createConnection(l, config))
                 , locator_(l)
                 , callback_(callback)
+                , batchCallback_(batchCallback)
                 , wireToUserHook_(wireToUserHook)
+                , batchSize_(consumeBatchSize(l))
                 , th_()
                 , running_(true)
                 , exceptionPolicy_(exceptionPolicy)
@@ -204,6 +282,7 @@ namespace dev { namespace cd606 { namespace tm { namespace transport { namespace
                 if (amqp_get_rpc_reply(connection_).reply_type != AMQP_RESPONSE_NORMAL) {
                     throw RabbitMQComponentException("Cannot bind RabbitMQ queue for "+l.toPrintFormat());
                 }
+                setPrefetch(connection_, l, 0);
                 amqp_basic_consume(
                     connection_
                     , 1 
@@ -217,7 +296,10 @@ namespace dev { namespace cd606 { namespace tm { namespace transport { namespace
                 if (amqp_get_rpc_reply(connection_).reply_type != AMQP_RESPONSE_NORMAL) {
                     throw RabbitMQComponentException("Cannot consume on RabbitMQ queue for "+l.toPrintFormat());
                 }
-                th_ = std::thread(&OneExchangeSubscriptionConnection::run, this, queueName);
+                th_ = std::thread([this,queueName,threading=TransportThreadingConfig::fromLocator(l),channel=l.toPrintFormat()]() {
+                    threading.applyToCurrentThread(channel);
+                    run(queueName);
+                });
             }
             ~OneExchangeSubscriptionConnection() {
                 running_ = false;
@@ -238,19 +320,231 @@ namespace dev { namespace cd606 { namespace tm { namespace transport { namespace
         };
         std::unordered_map<uint32_t, std::unique_ptr<OneExchangeSubscriptionConnection>> exchangeSubscriptionConnections_;
 
+        //Publishing options come from the locator properties:
+        //  persistent=true: messages are sent as persistent and without
+        //    the default expiration
+        //  confirm=true: publisher confirms are used on the exchange
+        //    publishes, at most max_in_flight (default 1024) messages can
+        //    be unconfirmed, and nacked messages are published again up to
+        //    max_publish_retries (default 3) times. The confirms are also
+        //    read every confirm_drain_interval_ms (default 100) milliseconds
+        //    by a background thread, so that the unconfirmed messages are
+        //    cleared (and nacked ones resent) when nothing more is published.
+        //    A publish that waits for room in the window for more than
+        //    confirm_timeout_ms (default 30000) milliseconds fails.
         class OnePublishingConnection {
         private:
+            static constexpr amqp_channel_t ConfirmChannel = 2;
+            struct UnconfirmedMessage {
+                std::string exchange;
+                std::string topic;
+                std::string content;
+                int retries;
+            };
             amqp_connection_state_t connection_;
             std::mutex mutex_;
             RabbitMQComponent::ExceptionPolicy exceptionPolicy_;
+            bool persistent_;
+            bool confirm_;
+            std::size_t maxInFlight_;
+            int maxRetries_;
+            uint64_t nextDeliveryTag_;
+            std::map<uint64_t, UnconfirmedMessage> unconfirmed_;
+            //nacked messages waiting to be published again
+            std::deque<UnconfirmedMessage> toResend_;
+            std::chrono::milliseconds confirmTimeout_;
+            std::chrono::milliseconds drainInterval_;
+            std::condition_variable drainCond_;
+            bool draining_;
+            std::thread drainThread_;
+
+            void sendOnExchange(amqp_channel_t channel, std::string const &exchange, std::string const &topic, std::string const &content) {
+                amqp_basic_properties_t props;
+                if (persistent_) {
+                    props._flags = AMQP_BASIC_DELIVERY_MODE_FLAG;
+                    props.delivery_mode = AMQP_DELIVERY_PERSISTENT;
+                } else {
+                    props._flags = AMQP_BASIC_DELIVERY_MODE_FLAG | AMQP_BASIC_EXPIRATION_FLAG;
+                    props.delivery_mode = AMQP_DELIVERY_NONPERSISTENT;
+                    props.expiration = amqp_cstring_bytes("1000");
+                }
+
+                amqp_bytes_t b {content.length(), const_cast<char *>(content.c_str())};
+                amqp_basic_publish(
+                    connection_
+                    , channel
+                    , amqp_cstring_bytes(exchange.c_str())
+                    , amqp_cstring_bytes(topic.c_str())
+                    , false 
+                    , false 
+                    , &props
+                    , b
+                );
+                auto reply = amqp_get_rpc_reply(connection_);
+                if (reply.reply_type != AMQP_RESPONSE_NORMAL) {
+                    throw std::runtime_error("Publishing on exchange");
+                }
+            }
+            void sendUnconfirmed(UnconfirmedMessage &&msg) {
+                auto tag = nextDeliveryTag_++;
+                auto iter = unconfirmed_.insert({tag, std::move(msg)}).first;
+                sendOnExchange(ConfirmChannel, iter->second.exchange, iter->second.topic, iter->second.content);
+            }
+            //returns false on timeout
+            bool processOneConfirmFrame(struct timeval *tv) {
+                amqp_frame_t frame;
+                auto status = amqp_simple_wait_frame_noblock(connection_, &frame, tv);
+                if (status == AMQP_STATUS_TIMEOUT) {
+                    return false;
+                }
+                if (status != AMQP_STATUS_OK) {
+                    throw std::runtime_error("Waiting for publisher confirms");
+                }
+                if (frame.frame_type != AMQP_FRAME_METHOD || frame.channel != ConfirmChannel) {
+                    return true;
+                }
+                uint64_t tag;
+                bool multiple;
+                bool ack;
+                if (frame.payload.method.id == AMQP_BASIC_ACK_METHOD) {
+                    auto *m = (amqp_basic_ack_t *) frame.payload.method.decoded;
+                    tag = m->delivery_tag;
+                    multiple = m->multiple;
+                    ack = true;
+                } else if (frame.payload.method.id == AMQP_BASIC_NACK_METHOD) {
+                    auto *m = (amqp_basic_nack_t *) frame.payload.method.decoded;
+                    tag = m->delivery_tag;
+                    multiple = m->multiple;
+                    ack = false;
+                } else {
+                    return true;
+                }
+                std::vector<UnconfirmedMessage> nacked;
+                auto end = (multiple?unconfirmed_.upper_bound(tag):unconfirmed_.find(tag));
+                auto begin = (multiple?unconfirmed_.begin():end);
+                if (!multiple) {
+                    if (end == unconfirmed_.end()) {
+                        return true;
+                    }
+                    ++end;
+                }
+                if (!ack) {
+                    for (auto iter=begin; iter!=end; ++iter) {
+                        nacked.push_back(std::move(iter->second));
+                    }
+                }
+                unconfirmed_.erase(begin, end);
+                amqp_maybe_release_buffers(connection_);
+                for (auto &msg : nacked) {
+                    toResend_.push_back(std::move(msg));
+                }
+                resendNacked();
+                return true;
+            }
+            //a message is taken off the queue only when it is resent or
+            //given up on, so if this throws, the rest are resent next time
+            void resendNacked() {
+                while (!toResend_.empty()) {
+                    auto msg = std::move(toResend_.front());
+                    toResend_.pop_front();
+                    if (msg.retries >= maxRetries_) {
+                        throw std::runtime_error("Message on exchange "+msg.exchange+" with topic "+msg.topic+" was rejected by the broker");
+                    }
+                    ++msg.retries;
+                    sendUnconfirmed(std::move(msg));
+                }
+            }
+            void processConfirms(bool waitForWindow) {
+                resendNacked();
+                struct timeval zero {0, 0};
+                while (processOneConfirmFrame(&zero)) {
+                }
+                auto deadline = std::chrono::steady_clock::now()+confirmTimeout_;
+                while (waitForWindow && unconfirmed_.size() >= maxInFlight_) {
+                    if (std::chrono::steady_clock::now() >= deadline) {
+                        throw std::runtime_error("Timed out waiting for publisher confirms with "+std::to_string(unconfirmed_.size())+" messages unconfirmed");
+                    }
+                    struct timeval tv {1, 0};
+                    processOneConfirmFrame(&tv);
+                }
+            }
+            void drainConfirms() {
+                std::unique_lock<std::mutex> lock(mutex_);
+                while (draining_) {
+                    drainCond_.wait_for(lock, drainInterval_);
+                    if (!draining_) {
+                        break;
+                    }
+                    if (unconfirmed_.empty() && toResend_.empty()) {
+                        continue;
+                    }
+                    try {
+                        processConfirms(false);
+                    } catch (std::exception const &ex) {
+                        //there is no publisher to throw to here
+                        if (exceptionPolicy_ != RabbitMQComponent::ExceptionPolicy::Ignore) {
+                            std::cerr << "RabbitMQComponent publishing exception: " << ex.what() << "\n";
+                        }
+                    }
+                }
+            }
         public:
             OnePublishingConnection(RabbitMQComponent::ExceptionPolicy exceptionPolicy, ConnectionLocator const &l, TLSClientConfigurationComponent const *config) 
                 : connection_(createConnection(l, config))
                 , mutex_()
                 , exceptionPolicy_(exceptionPolicy)
+                , persistent_(l.query("persistent", "false") == "true")
+                , confirm_(l.query("confirm", "false") == "true")
+                , maxInFlight_(std::max<std::size_t>(1, std::stoul(l.query("max_in_flight", "1024"))))
+                , maxRetries_(std::stoi(l.query("max_publish_retries", "3")))
+                , nextDeliveryTag_(1)
+                , unconfirmed_()
+                , toResend_()
+                , confirmTimeout_(std::max(1, std::stoi(l.query("confirm_timeout_ms", "30000"))))
+                , drainInterval_(std::max(1, std::stoi(l.query("confirm_drain_interval_ms", "100"))))
+                , drainCond_()
+                , draining_(false)
+                , drainThread_()
             {
+                if (confirm_) {
+                    amqp_channel_open(connection_, ConfirmChannel);
+                    if (amqp_get_rpc_reply(connection_).reply_type != AMQP_RESPONSE_NORMAL) {
+                        throw RabbitMQComponentException("Cannot open RabbitMQ confirm channel for "+l.toPrintFormat());
+                    }
+                    amqp_confirm_select(connection_, ConfirmChannel);
+                    if (amqp_get_rpc_reply(connection_).reply_type != AMQP_RESPONSE_NORMAL) {
+                        throw RabbitMQComponentException("Cannot enable RabbitMQ publisher confirms for "+l.toPrintFormat());
+                    }
+                    draining_ = true;
+                    drainThread_ = std::thread(&OnePublishingConnection::drainConfirms, this);
+                }
             }
             ~OnePublishingConnection() {
+                if (confirm_) {
+                    {
+                        std::lock_guard<std::mutex> _(mutex_);
+                        draining_ = false;
+                    }
+                    drainCond_.notify_all();
+                    if (drainThread_.joinable()) {
+                        drainThread_.join();
+                    }
+                    //give the outstanding messages a chance to be confirmed
+                    try {
+                        std::lock_guard<std::mutex> _(mutex_);
+                        auto deadline = std::chrono::steady_clock::now()+std::chrono::seconds(5);
+                        while (!unconfirmed_.empty() && std::chrono::steady_clock::now() < deadline) {
+                            struct timeval tv {1, 0};
+                            processOneConfirmFrame(&tv);
+                        }
+                        if (!unconfirmed_.empty() || !toResend_.empty()) {
+                            std::cerr << "RabbitMQComponent publishing connection closed with " << unconfirmed_.size() << " unconfirmed messages and " << toResend_.size() << " nacked messages not resent\n";
+                        }
+                    } catch (std::exception const &ex) {
+                        std::cerr << "RabbitMQComponent publishing exception: " << ex.what() << "\n";
+                    }
+                    amqp_channel_close(connection_, ConfirmChannel, AMQP_REPLY_SUCCESS);
+                }
                 amqp_channel_close(connection_, 1, AMQP_REPLY_SUCCESS);
                 amqp_connection_close(connection_, AMQP_REPLY_SUCCESS);
                 amqp_destroy_connection(connection_);
@@ -258,27 +552,13 @@ namespace dev { namespace cd606 { namespace tm { namespace transport { namespace
             void publishOnExchange(std::string const &exchange, basic::ByteDataWithTopic &&data) {
                 {
                     std::lock_guard<std::mutex> _(mutex_);
-
-                    amqp_basic_properties_t props;
-                    props._flags = AMQP_BASIC_DELIVERY_MODE_FLAG | AMQP_BASIC_EXPIRATION_FLAG;
-                    props.delivery_mode = AMQP_DELIVERY_NONPERSISTENT;
-                    props.expiration = amqp_cstring_bytes("1000");
-
-                    amqp_bytes_t b {data.content.length(), const_cast<char *>(data.content.c_str())};
-                    amqp_basic_publish(
-                        connection_
-                        , 1
-                        , amqp_cstring_bytes(exchange.c_str())
-                        , amqp_cstring_bytes(data.topic.c_str())
-                        , false 
-                        , false 
-                        , &props
-                        , b
-                    );
-                    try {     
-                        auto reply = amqp_get_rpc_reply(connection_);
-                        if (reply.reply_type != AMQP_RESPONSE_NORMAL) {
-                            throw std::runtime_error("Publishing on exchange");
+                    try {
+                        if (confirm_) {
+                            processConfirms(true);
+                            sendUnconfirmed(UnconfirmedMessage {exchange, std::move(data.topic), std::move(data.content), 0});
+                            processConfirms(false);
+                        } else {
+                            sendOnExchange(1, exchange, data.topic, data.content);
                         }
                     } catch (std::exception &ex) {
                         switch (exceptionPolicy_) {
@@ -337,6 +617,10 @@ namespace dev { namespace cd606 { namespace tm { namespace transport { namespace
             }
         };
         std::unordered_map<ConnectionLocator, std::unique_ptr<OnePublishingConnection>> publishingConnections_;
+        //exchanges published with publish_connections=N (N>1) spread the
+        //publishes over N connections, picked by topic so that the order
+        //of messages on each topic is kept
+        std::unordered_map<ConnectionLocator, std::vector<std::unique_ptr<OnePublishingConnection>>> publishingConnectionPools_;
         
         class OneRPCQueueClientConnection {
         private:
@@ -355,18 +639,15 @@ namespace dev { namespace cd606 { namespace tm { namespace transport { namespace
             std::atomic<bool> running_;
             OnePublishingConnection *publishing_;
             bool persistent_;
+            std::size_t batchSize_;
             RabbitMQComponent::ExceptionPolicy exceptionPolicy_;
 
             void run() {
                 while (running_) {
                     try {
-                        amqp_rpc_reply_t res;
-                        amqp_envelope_t envelop;
-
-                        amqp_maybe_release_buffers(connection_);
-                        struct timeval tv {1, 0};
-                        res = amqp_consume_message(connection_, &envelop, &tv, 0);
-                        if (res.reply_type == AMQP_RESPONSE_NORMAL) {
+                        EnvelopeBatch batch;
+                        consumeBatch(connection_, batchSize_, batch);
+                        for (auto const &envelop : batch.envelopes) {
                             if (running_) {
                                 std::string corrID { (char *) envelop.message.properties.correlation_id.bytes, envelop.message.properties.correlation_id.len};
                                 bool isFinal = (
@@ -396,7 +677,9 @@ namespace dev { namespace cd606 { namespace tm { namespace transport { namespace
                                     }
                                 }
                             }
-                            amqp_destroy_envelope(&envelop);
+                        }
+                        if (!batch.envelopes.empty()) {
+                            amqp_basic_ack(connection_, 1, batch.lastDeliveryTag(), true);
                         }
                     } catch (std::exception const &ex) {
                         switch (exceptionPolicy_) {
@@ -433,6 +716,7 @@ namespace dev { namespace cd606 { namespace tm { namespace transport { namespace
                 , running_(true)
                 , publishing_(publishing)
                 , persistent_(l.query("persistent", "false") == "true")
+                , batchSize_(consumeBatchSize(l))
                 , exceptionPolicy_(exceptionPolicy)
             {
                 auto q = amqp_queue_declare(
@@ -449,6 +733,7 @@ namespace dev { namespace cd606 { namespace tm { namespace transport { namespace
                     throw RabbitMQComponentException("Cannot declare RabbitMQ queue for "+l.toPrintFormat());
                 }
                 localQueue_ = std::string {(char *) q->queue.bytes, q->queue.len};
+                setPrefetch(connection_, l, 0);
                 amqp_basic_consume(
                     connection_
                     , 1 
@@ -462,7 +747,10 @@ namespace dev { namespace cd606 { namespace tm { namespace transport { namespace
                 if (amqp_get_rpc_reply(connection_).reply_type != AMQP_RESPONSE_NORMAL) {
                     throw RabbitMQComponentException("Cannot consume on RabbitMQ queue for "+l.toPrintFormat());
                 }
-                th_ = std::thread(&OneRPCQueueClientConnection::run, this);
+                th_ = std::thread([this,threading=TransportThreadingConfig::fromLocator(l),channel=l.toPrintFormat()]() {
+                    threading.applyToCurrentThread(channel);
+                    run();
+                });
             }
             ~OneRPCQueueClientConnection() {
                 running_ = false;
@@ -524,18 +812,17 @@ namespace dev { namespace cd606 { namespace tm { namespace transport { namespace
             std::mutex mutex_;
             std::atomic<bool> running_;
             OnePublishingConnection *publishing_;
+            std::size_t batchSize_;
             RabbitMQComponent::ExceptionPolicy exceptionPolicy_;
             void run() {
                 while (running_) {
                     try {
-                        amqp_rpc_reply_t res;
-                        amqp_envelope_t envelop;
-
-                        amqp_maybe_release_buffers(connection_);
-                        struct timeval tv {1, 0};
-                        res = amqp_consume_message(connection_, &envelop, &tv, 0);
-                        if (res.reply_type == AMQP_RESPONSE_NORMAL) {
-                            amqp_basic_ack(connection_, 1, envelop.delivery_tag, false);
+                        EnvelopeBatch batch;
+                        consumeBatch(connection_, batchSize_, batch);
+                        if (!batch.envelopes.empty()) {
+                            amqp_basic_ack(connection_, 1, batch.lastDeliveryTag(), true);
+                        }
+                        for (auto const &envelop : batch.envelopes) {
                             if (running_) {
                                 std::string corrID { (char *) envelop.message.properties.correlation_id.bytes, envelop.message.properties.correlation_id.len};
                                 {
@@ -551,7 +838,6 @@ namespace dev { namespace cd606 { namespace tm { namespace transport { namespace
                                     callback_({corrID, std::string((char *) envelop.message.body.bytes, envelop.message.body.len)});
                                 }
                             }
-                            amqp_destroy_envelope(&envelop);
                         }
                     } catch (std::exception &ex) {
                         switch (exceptionPolicy_) {
@@ -585,6 +871,7 @@ namespace dev { namespace cd606 { namespace tm { namespace transport { namespace
                 , mutex_()
                 , running_(true)
                 , publishing_(publishing)
+                , batchSize_(consumeBatchSize(l))
                 , exceptionPolicy_(exceptionPolicy)
             {
                 amqp_queue_declare(
@@ -613,17 +900,11 @@ namespace dev { namespace cd606 { namespace tm { namespace transport { namespace
                 if (amqp_get_rpc_reply(connection_).reply_type != AMQP_RESPONSE_NORMAL) {
                     throw RabbitMQComponentException("Cannot consume on RabbitMQ queue for "+l.toPrintFormat());
                 }
-                amqp_basic_qos(
-                    connection_
-                    , 1
-                    , 0
-                    , 0
-                    , false
-                );
-                if (amqp_get_rpc_reply(connection_).reply_type != AMQP_RESPONSE_NORMAL) {
-                    throw RabbitMQComponentException("Cannot set QoS on RabbitMQ queue for "+l.toPrintFormat());
-                }
-                th_ = std::thread(&OneRPCQueueServerConnection::run, this);
+                setPrefetch(connection_, l, 0);
+                th_ = std::thread([this,threading=TransportThreadingConfig::fromLocator(l),channel=l.toPrintFormat()]() {
+                    threading.applyToCurrentThread(channel);
+                    run();
+                });
             }
             ~OneRPCQueueServerConnection() {
                 running_ = false;
@@ -687,6 +968,23 @@ namespace dev { namespace cd606 { namespace tm { namespace transport { namespace
             }
             return iter->second.get();
         }
+        std::vector<OnePublishingConnection *> publishingConnectionPool(ConnectionLocator const &l, std::size_t poolSize, TLSClientConfigurationComponent const *config) {
+            std::lock_guard<std::mutex> _(mutex_);
+            auto basicPortion = l.copyOfBasicPortionWithProperties();
+            auto iter = publishingConnectionPools_.find(basicPortion);
+            if (iter == publishingConnectionPools_.end()) {
+                std::vector<std::unique_ptr<OnePublishingConnection>> pool;
+                for (std::size_t ii=0; ii<poolSize; ++ii) {
+                    pool.push_back(std::make_unique<OnePublishingConnection>(exceptionPolicy_, basicPortion, config));
+                }
+                iter = publishingConnectionPools_.insert({basicPortion, std::move(pool)}).first;
+            }
+            std::vector<OnePublishingConnection *> ret;
+            for (auto const &c : iter->second) {
+                ret.push_back(c.get());
+            }
+            return ret;
+        }
         OneRPCQueueClientConnection *createRpcQueueClientConnection(ConnectionLocator const &l, TLSClientConfigurationComponent const *config) {
             std::lock_guard<std::mutex> _(mutex_);
             auto iter = rpcQueueClientConnections_.find(l);
@@ -712,6 +1010,7 @@ namespace dev { namespace cd606 { namespace tm { namespace transport { namespace
         RabbitMQComponentImpl(RabbitMQComponent::ExceptionPolicy exceptionPolicy) :
             exchangeSubscriptionConnections_()
             , publishingConnections_()
+            , publishingConnectionPools_()
             , rpcQueueClientConnections_()
             , rpcQueueServerConnections_()
             , mutex_()
@@ -722,12 +1021,14 @@ namespace dev { namespace cd606 { namespace tm { namespace transport { namespace
             std::lock_guard<std::mutex> _(mutex_);
             exchangeSubscriptionConnections_.clear();
             publishingConnections_.clear();
+            publishingConnectionPools_.clear();
             rpcQueueClientConnections_.clear();
             rpcQueueServerConnections_.clear();
         }
         uint32_t addExchangeSubscriptionClient(ConnectionLocator const &locator,
             std::string const &topic,
             std::function<void(basic::ByteDataWithTopic &&)> client,
+            std::function<void(std::vector<basic::ByteDataWithTopic> &&)> batchClient,
             std::optional<WireToUserHook> wireToUserHook,
             TLSClientConfigurationComponent const *config) {
             std::lock_guard<std::mutex> _(mutex_);
@@ -735,7 +1036,7 @@ namespace dev { namespace cd606 { namespace tm { namespace transport { namespace
                 std::make_pair(
                     ++counter_
                     , std::make_unique<OneExchangeSubscriptionConnection>(
-                        exceptionPolicy_, locator, topic, client, wireToUserHook, config
+                        exceptionPolicy_, locator, topic, client, batchClient, wireToUserHook, config
                     )
                 )
             );
@@ -746,13 +1047,36 @@ namespace dev { namespace cd606 { namespace tm { namespace transport { namespace
             exchangeSubscriptionConnections_.erase(id);
         }
         std::function<void(basic::ByteDataWithTopic &&)> getExchangePublisher(ConnectionLocator const &locator, std::optional<UserToWireHook> userToWireHook, TLSClientConfigurationComponent const *config) {
-            auto *conn = publishingConnection(locator, config);
             auto id = locator.identifier();
+            std::size_t poolSize = std::stoul(locator.query("publish_connections", "1"));
+            if (poolSize > 1) {
+                auto conns = publishingConnectionPool(locator, poolSize, config);
+                std::optional<std::function<basic::ByteData(basic::ByteData &&)>> hook;
+                if (userToWireHook) {
+                    hook = userToWireHook->hook;
+                }
+                return [id,conns,hook](basic::ByteDataWithTopic &&data) {
+                    auto *conn = conns[std::hash<std::string>()(data.topic)%conns.size()];
+                    if (hook) {
+                        auto x = byte_data_hook_utils::tryUserToWireHook(*hook, basic::ByteData {std::move(data.content)});
+                        if (!x) {
+                            return;
+                        }
+                        conn->publishOnExchange(id, {std::move(data.topic), std::move(x->content)});
+                    } else {
+                        conn->publishOnExchange(id, std::move(data));
+                    }
+                };
+            }
+            auto *conn = publishingConnection(locator, config);
             if (userToWireHook) {
                 auto hook = userToWireHook->hook;
                 return [id,conn,hook](basic::ByteDataWithTopic &&data) {
-                    auto x = hook(basic::ByteData {std::move(data.content)});
-                    conn->publishOnExchange(id, {std::move(data.topic), std::move(x.content)});
+                    auto x = byte_data_hook_utils::tryUserToWireHook(hook, basic::ByteData {std::move(data.content)});
+                    if (!x) {
+                        return;
+                    }
+                    conn->publishOnExchange(id, {std::move(data.topic), std::move(x->content)});
                 };
             } else {
                 return [id,conn](basic::ByteDataWithTopic &&data) {
@@ -812,8 +1136,11 @@ namespace dev { namespace cd606 { namespace tm { namespace transport { namespace
             if (hookPair && hookPair->userToWire) {
                 auto hook = hookPair->userToWire->hook;
                 return [conn,hook](bool isFinal, basic::ByteDataWithID &&data) {
-                    auto x = hook(basic::ByteData {std::move(data.content)});
-                    conn->sendReply(isFinal, {data.id, std::move(x.content)});
+                    auto x = byte_data_hook_utils::tryUserToWireHookForReply(hook, isFinal, basic::ByteData {std::move(data.content)});
+                    if (!x) {
+                        return;
+                    }
+                    conn->sendReply(isFinal, {data.id, std::move(x->content)});
                 };
             } else {
                 return [conn](bool isFinal, basic::ByteDataWithID &&data) {
@@ -846,7 +1173,13 @@ namespace dev { namespace cd606 { namespace tm { namespace transport { namespace
         std::string const &topic,
         std::function<void(basic::ByteDataWithTopic &&)> client,
         std::optional<WireToUserHook> wireToUserHook) {
-        return impl_->addExchangeSubscriptionClient(locator, topic, client, wireToUserHook, dynamic_cast<TLSClientConfigurationComponent const *>(this));
+        return impl_->addExchangeSubscriptionClient(locator, topic, client, {}, wireToUserHook, dynamic_cast<TLSClientConfigurationComponent const *>(this));
+    }
+    uint32_t RabbitMQComponent::rabbitmq_addExchangeBatchSubscriptionClient(ConnectionLocator const &locator,
+        std::string const &topic,
+        std::function<void(std::vector<basic::ByteDataWithTopic> &&)> client,
+        std::optional<WireToUserHook> wireToUserHook) {
+        return impl_->addExchangeSubscriptionClient(locator, topic, {}, client, wireToUserHook, dynamic_cast<TLSClientConfigurationComponent const *>(this));
     }
     void RabbitMQComponent::rabbitmq_removeExchangeSubscriptionClient(uint32_t id) {
         impl_->removeExchangeSubscriptionClient(id);
@@ -858,7 +1191,8 @@ namespace dev { namespace cd606 { namespace tm { namespace transport { namespace
         std::function<void(bool, basic::ByteDataWithID &&)> client,
         std::optional<ByteDataHookPair> hookPair,
         uint32_t *clientNumberOutput) {
-        return impl_->setRPCQueueClient(locator, client, hookPair, dynamic_cast<TLSClientConfigurationComponent const *>(this), clientNumberOutput);
+        auto metrics = transportRPCChannelMetrics(dynamic_cast<TransportMetricsComponent *>(this), "rabbitmq", locator);
+        return countRPCSend(metrics, impl_->setRPCQueueClient(locator, countRPCReceive(metrics, client), hookPair, dynamic_cast<TLSClientConfigurationComponent const *>(this), clientNumberOutput));
     }
     void RabbitMQComponent::rabbitmq_removeRPCQueueClient(ConnectionLocator const &locator, uint32_t clientNumber) {
         impl_->removeRPCQueueClient(locator, clientNumber);
@@ -866,7 +1200,8 @@ namespace dev { namespace cd606 { namespace tm { namespace transport { namespace
     std::function<void(bool, basic::ByteDataWithID &&)> RabbitMQComponent::rabbitmq_setRPCQueueServer(ConnectionLocator const &locator,
         std::function<void(basic::ByteDataWithID &&)> server,
         std::optional<ByteDataHookPair> hookPair) {
-        return impl_->setRPCQueueServer(locator, server, hookPair, dynamic_cast<TLSClientConfigurationComponent const *>(this));
+        auto metrics = transportRPCChannelMetrics(dynamic_cast<TransportMetricsComponent *>(this), "rabbitmq", locator);
+        return countRPCSend(metrics, impl_->setRPCQueueServer(locator, countRPCReceive(metrics, server), hookPair, dynamic_cast<TLSClientConfigurationComponent const *>(this)));
     }
     std::unordered_map<ConnectionLocator, std::thread::native_handle_type> RabbitMQComponent::rabbitmq_threadHandles() {
         return impl_->threadHandles();
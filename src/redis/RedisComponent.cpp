@@ -4,46 +4,879 @@
 #include <cstring>
 #include <sstream>
 #include <unordered_map>
+#include <unordered_set>
+#include <future>
+#include <vector>
+#include <deque>
+#include <chrono>
+#include <algorithm>
+#include <iostream>
 
 #include <tm_kit/transport/redis/RedisComponent.hpp>
+#include <tm_kit/transport/HostNameUtil.hpp>
+#include <tm_kit/transport/TransportThreading.hpp>
+#include <tm_kit/transport/TransportMetricsComponent.hpp>
+#include <tm_kit/infra/PidUtil.hpp>
 
 #ifdef _MSC_VER
 #include <winsock2.h>
 #endif
 #include <hiredis/hiredis.h>
+#include <hiredis/async.h>
+#include <boost/asio.hpp>
 
 namespace dev { namespace cd606 { namespace tm { namespace transport { namespace redis {
     class RedisComponentImpl {
     private:
-        static void auth(ConnectionLocator const &locator, redisContext *ctx) {
-            if (locator.password() == "") {
-                return;
+        //All subscriptions, publishes and RPC channels to one Redis server
+        //go through one event loop thread. Two async hiredis contexts are
+        //used, since a context that has subscribed cannot issue other
+        //commands: one carries every PSUBSCRIBE/SUBSCRIBE, the other
+        //carries the publishes. Publishes are queued and written out in
+        //batches without waiting for the replies.
+        class OneRedisServer {
+        public:
+            using TopicHandler = std::function<void(std::string &&, std::string_view const &)>;
+#ifdef _MSC_VER
+            using Socket = boost::asio::ip::tcp::socket;
+#else
+            using Socket = boost::asio::posix::stream_descriptor;
+#endif
+            //hooks one hiredis async context into the io_service, hiredis
+            //tells the adapter whether it wants to read or write, and the
+            //adapter calls back into hiredis when the socket is ready
+            class AsioAdapter : public std::enable_shared_from_this<AsioAdapter> {
+            private:
+                redisAsyncContext *ctx_;
+                Socket socket_;
+                bool wantRead_, wantWrite_;
+                bool readWaiting_, writeWaiting_;
+
+                void waitRead() {
+                    if (!ctx_ || !wantRead_ || readWaiting_) {
+                        return;
+                    }
+                    readWaiting_ = true;
+                    socket_.async_wait(Socket::wait_read, [this,self=shared_from_this()](boost::system::error_code const &ec) {
+                        readWaiting_ = false;
+                        if (ec || !ctx_ || !wantRead_) {
+                            return;
+                        }
+                        redisAsyncHandleRead(ctx_);
+                        waitRead();
+                    });
+                }
+                void waitWrite() {
+                    if (!ctx_ || !wantWrite_ || writeWaiting_) {
+                        return;
+                    }
+                    writeWaiting_ = true;
+                    socket_.async_wait(Socket::wait_write, [this,self=shared_from_this()](boost::system::error_code const &ec) {
+                        writeWaiting_ = false;
+                        if (ec || !ctx_ || !wantWrite_) {
+                            return;
+                        }
+                        redisAsyncHandleWrite(ctx_);
+                        waitWrite();
+                    });
+                }
+                static void addRead(void *p) {
+                    auto *a = static_cast<AsioAdapter *>(p);
+                    a->wantRead_ = true;
+                    a->waitRead();
+                }
+                static void delRead(void *p) {
+                    static_cast<AsioAdapter *>(p)->wantRead_ = false;
+                }
+                static void addWrite(void *p) {
+                    auto *a = static_cast<AsioAdapter *>(p);
+                    a->wantWrite_ = true;
+                    a->waitWrite();
+                }
+                static void delWrite(void *p) {
+                    static_cast<AsioAdapter *>(p)->wantWrite_ = false;
+                }
+                //hiredis closes the socket itself, so asio must let go of it
+                static void cleanup(void *p) {
+                    auto *a = static_cast<AsioAdapter *>(p);
+                    a->wantRead_ = false;
+                    a->wantWrite_ = false;
+                    a->ctx_ = nullptr;
+                    try {
+                        boost::system::error_code ec;
+                        a->socket_.cancel(ec);
+                        a->socket_.release();
+                    } catch (boost::system::system_error const &) {
+                    }
+                }
+            public:
+                AsioAdapter(boost::asio::io_service &service, redisAsyncContext *ctx)
+                    : ctx_(ctx)
+#ifdef _MSC_VER
+                    , socket_(service, boost::asio::ip::tcp::v4(), ctx->c.fd)
+#else
+                    , socket_(service, ctx->c.fd)
+#endif
+                    , wantRead_(false), wantWrite_(false)
+                    , readWaiting_(false), writeWaiting_(false)
+                {
+                    ctx->ev.data = this;
+                    ctx->ev.addRead = &AsioAdapter::addRead;
+                    ctx->ev.delRead = &AsioAdapter::delRead;
+                    ctx->ev.addWrite = &AsioAdapter::addWrite;
+                    ctx->ev.delWrite = &AsioAdapter::delWrite;
+                    ctx->ev.cleanup = &AsioAdapter::cleanup;
+                }
+            };
+        private:
+
+            ConnectionLocator locator_;
+            //from the locator of the first connection to the server
+            TransportThreadingConfig threading_;
+            boost::asio::io_service service_;
+            std::optional<boost::asio::io_service::work> work_;
+            std::optional<boost::asio::steady_timer> stopTimer_;
+            redisAsyncContext *subCtx_;
+            redisAsyncContext *pubCtx_;
+            std::shared_ptr<AsioAdapter> subAdapter_;
+            std::shared_ptr<AsioAdapter> pubAdapter_;
+            //only touched on the loop thread
+            std::unordered_map<std::string, TopicHandler> patternHandlers_;
+            std::unordered_map<std::string, TopicHandler> channelHandlers_;
+            //the (P)SUBSCRIBE commands waiting for the server's
+            //confirmation, by pendingSubscriptionKey, also only touched on
+            //the loop thread
+            std::unordered_map<std::string, std::deque<std::shared_ptr<std::promise<bool>>>> pendingSubscriptions_;
+            //a message with a stream key is added to that stream, otherwise
+            //it is published on its topic
+            struct OutgoingMessage {
+                basic::ByteDataWithTopic data;
+                std::string streamKey;
+                std::size_t streamMaxLength;
+            };
+            std::mutex publishMutex_;
+            std::vector<OutgoingMessage> publishQueue_;
+            std::vector<OutgoingMessage> publishQueueBeingFlushed_;
+            bool flushScheduled_;
+            std::thread th_;
+
+            redisAsyncContext *connect(std::shared_ptr<AsioAdapter> &adapter) {
+                return connectAdditionalContext(adapter, this, &OneRedisServer::onDisconnect);
             }
-            redisReply *r = nullptr;
-            if (locator.userName() != "") {
-                r = (redisReply *) redisCommand(ctx, "AUTH %s %s", locator.userName().c_str(), locator.password().c_str());
-            } else {
-                r = (redisReply *) redisCommand(ctx, "AUTH %s", locator.password().c_str());
+            static std::string pendingSubscriptionKey(bool isPattern, std::string const &topic) {
+                return (isPattern?"p:":"c:")+topic;
+            }
+            void failPendingSubscriptions() {
+                for (auto &item : pendingSubscriptions_) {
+                    for (auto &p : item.second) {
+                        p->set_value(false);
+                    }
+                }
+                pendingSubscriptions_.clear();
+            }
+            static void onDisconnect(redisAsyncContext const *ctx, int /*status*/) {
+                auto *s = static_cast<OneRedisServer *>(ctx->data);
+                if (ctx == s->subCtx_) {
+                    s->subCtx_ = nullptr;
+                    s->failPendingSubscriptions();
+                } else if (ctx == s->pubCtx_) {
+                    s->pubCtx_ = nullptr;
+                    if (s->stopTimer_) {
+                        s->stopTimer_->cancel();
+                    }
+                }
+            }
+            static void onAuthReply(redisAsyncContext * /*ctx*/, void *r, void *privdata) {
+                auto *reply = static_cast<redisReply *>(r);
+                static_cast<std::promise<bool> *>(privdata)->set_value(
+                    reply != nullptr && reply->type != REDIS_REPLY_ERROR
+                );
+            }
+            static void onSubscriptionMessage(redisAsyncContext *ctx, void *r, void * /*privdata*/) {
+                auto *reply = static_cast<redisReply *>(r);
+                if (reply == nullptr || reply->type != REDIS_REPLY_ARRAY || reply->elements < 3) {
+                    return;
+                }
+                if (reply->element[0]->type != REDIS_REPLY_STRING) {
+                    return;
+                }
+                auto *s = static_cast<OneRedisServer *>(ctx->data);
+                std::string_view kind {reply->element[0]->str, reply->element[0]->len};
+                if ((kind == "subscribe" || kind == "psubscribe") && reply->element[1]->type == REDIS_REPLY_STRING) {
+                    auto iter = s->pendingSubscriptions_.find(pendingSubscriptionKey(
+                        kind == "psubscribe", std::string(reply->element[1]->str, reply->element[1]->len)
+                    ));
+                    if (iter != s->pendingSubscriptions_.end()) {
+                        iter->second.front()->set_value(true);
+                        iter->second.pop_front();
+                        if (iter->second.empty()) {
+                            s->pendingSubscriptions_.erase(iter);
+                        }
+                    }
+                    return;
+                }
+                if (kind == "pmessage" && reply->elements == 4) {
+                    auto iter = s->patternHandlers_.find(std::string(reply->element[1]->str, reply->element[1]->len));
+                    if (iter == s->patternHandlers_.end()) {
+                        return;
+                    }
+                    //the handler may unsubscribe itself
+                    auto h = iter->second;
+                    h(
+                        std::string(reply->element[2]->str, reply->element[2]->len)
+                        , std::string_view {reply->element[3]->str, reply->element[3]->len}
+                    );
+                } else if (kind == "message" && reply->elements == 3) {
+                    std::string channel(reply->element[1]->str, reply->element[1]->len);
+                    auto iter = s->channelHandlers_.find(channel);
+                    if (iter == s->channelHandlers_.end()) {
+                        return;
+                    }
+                    auto h = iter->second;
+                    h(
+                        std::move(channel)
+                        , std::string_view {reply->element[2]->str, reply->element[2]->len}
+                    );
+                }
+            }
+            void sendAuth(redisAsyncContext *ctx, std::promise<bool> *result) {
+                authenticate(ctx, &OneRedisServer::onAuthReply, result);
+            }
+            void flushPublishQueue() {
+                {
+                    std::lock_guard<std::mutex> _(publishMutex_);
+                    std::swap(publishQueue_, publishQueueBeingFlushed_);
+                    flushScheduled_ = false;
+                }
+                if (pubCtx_) {
+                    //the replies are not waited for, hiredis appends all the
+                    //commands to its output buffer and writes them together
+                    for (auto const &m : publishQueueBeingFlushed_) {
+                        if (m.streamKey == "") {
+                            redisAsyncCommand(
+                                pubCtx_, nullptr, nullptr
+                                , "PUBLISH %s %b"
+                                , m.data.topic.c_str()
+                                , m.data.content.c_str()
+                                , m.data.content.length()
+                            );
+                        } else if (m.streamMaxLength > 0) {
+                            redisAsyncCommand(
+                                pubCtx_, nullptr, nullptr
+                                , "XADD %s MAXLEN ~ %llu * topic %s data %b"
+                                , m.streamKey.c_str()
+                                , static_cast<unsigned long long>(m.streamMaxLength)
+                                , m.data.topic.c_str()
+                                , m.data.content.c_str()
+                                , m.data.content.length()
+                            );
+                        } else {
+                            redisAsyncCommand(
+                                pubCtx_, nullptr, nullptr
+                                , "XADD %s * topic %s data %b"
+                                , m.streamKey.c_str()
+                                , m.data.topic.c_str()
+                                , m.data.content.c_str()
+                                , m.data.content.length()
+                            );
+                        }
+                    }
+                }
+                publishQueueBeingFlushed_.clear();
             }
-            if (!r || r->type == REDIS_REPLY_ERROR) {
-                throw std::runtime_error("Failure to authenticate with Redis server for "+locator.toSerializationFormat());
+            void run() {
+                threading_.applyToCurrentThread(locator_.toPrintFormat());
+                while (true) {
+                    try {
+                        if (threading_.busyLoop) {
+                            //poll stops the service once there is no work
+                            //left, as run would return
+                            while (!service_.stopped()) {
+                                service_.poll();
+                            }
+                        } else {
+                            service_.run();
+                        }
+                        break;
+                    } catch (...) {
+                    }
+                }
+            }
+            void stop() {
+                boost::asio::post(service_, [this]() {
+                    if (subCtx_) {
+                        auto *c = subCtx_;
+                        subCtx_ = nullptr;
+                        redisAsyncFree(c);
+                    }
+                    failPendingSubscriptions();
+                    flushPublishQueue();
+                    if (pubCtx_) {
+                        //lets the queued publishes go out before closing,
+                        //but not forever
+                        stopTimer_.emplace(service_, std::chrono::seconds(5));
+                        stopTimer_->async_wait([this](boost::system::error_code const &ec) {
+                            if (!ec) {
+                                service_.stop();
+                            }
+                        });
+                        redisAsyncDisconnect(pubCtx_);
+                    }
+                });
+                work_.reset();
+                try {
+                    if (th_.joinable()) {
+                        th_.join();
+                    }
+                } catch (std::system_error const &) {
+                }
+                if (pubCtx_) {
+                    auto *c = pubCtx_;
+                    pubCtx_ = nullptr;
+                    redisAsyncFree(c);
+                }
+            }
+        public:
+            OneRedisServer(ConnectionLocator const &locator)
+                : locator_(locator)
+                , threading_(TransportThreadingConfig::fromLocator(locator))
+                , service_()
+                , work_(std::in_place, service_)
+                , stopTimer_()
+                , subCtx_(nullptr)
+                , pubCtx_(nullptr)
+                , subAdapter_()
+                , pubAdapter_()
+                , patternHandlers_()
+                , channelHandlers_()
+                , publishMutex_()
+                , publishQueue_()
+                , publishQueueBeingFlushed_()
+                , flushScheduled_(false)
+                , th_()
+            {
+                subCtx_ = connect(subAdapter_);
+                try {
+                    pubCtx_ = connect(pubAdapter_);
+                } catch (...) {
+                    redisAsyncFree(subCtx_);
+                    throw;
+                }
+                std::promise<bool> subAuth, pubAuth;
+                bool needAuth = (locator_.password() != "");
+                if (needAuth) {
+                    sendAuth(subCtx_, &subAuth);
+                    sendAuth(pubCtx_, &pubAuth);
+                }
+                th_ = std::thread(&OneRedisServer::run, this);
+                if (needAuth) {
+                    if (!subAuth.get_future().get() || !pubAuth.get_future().get()) {
+                        stop();
+                        throw RedisComponentException("Failure to authenticate with Redis server for "+locator_.toSerializationFormat());
+                    }
+                }
+            }
+            ~OneRedisServer() {
+                stop();
+            }
+            //for connections that need their own context on this loop, must
+            //be called on the loop thread once the loop is running
+            redisAsyncContext *connectAdditionalContext(std::shared_ptr<AsioAdapter> &adapter, void *data, redisDisconnectCallback *onDisconnect) {
+                redisAsyncContext *ctx = redisAsyncConnect(locator_.host().c_str(), locator_.port());
+                if (ctx == nullptr) {
+                    throw RedisComponentException("Cannot allocate Redis context for "+locator_.toSerializationFormat());
+                }
+                if (ctx->err) {
+                    std::string err = ctx->errstr;
+                    redisAsyncFree(ctx);
+                    throw RedisComponentException("Failure to connect to Redis server for "+locator_.toSerializationFormat()+": "+err);
+                }
+                ctx->data = data;
+                threading_.applyToSocket(static_cast<std::intptr_t>(ctx->c.fd), locator_.toPrintFormat());
+                adapter = std::make_shared<AsioAdapter>(service_, ctx);
+                redisAsyncSetDisconnectCallback(ctx, onDisconnect);
+                return ctx;
+            }
+            void authenticate(redisAsyncContext *ctx, redisCallbackFn *cb, void *privdata) {
+                if (locator_.password() == "") {
+                    return;
+                }
+                if (locator_.userName() != "") {
+                    redisAsyncCommand(ctx, cb, privdata, "AUTH %s %s", locator_.userName().c_str(), locator_.password().c_str());
+                } else {
+                    redisAsyncCommand(ctx, cb, privdata, "AUTH %s", locator_.password().c_str());
+                }
+            }
+            boost::asio::io_service &service() {
+                return service_;
+            }
+            void post(std::function<void()> f) {
+                boost::asio::post(service_, std::move(f));
+            }
+            void runOnLoop(std::function<void()> const &f) {
+                if (std::this_thread::get_id() == th_.get_id()) {
+                    f();
+                    return;
+                }
+                std::promise<void> done;
+                auto fut = done.get_future();
+                boost::asio::post(service_, [&f,&done]() {
+                    f();
+                    done.set_value();
+                });
+                fut.wait();
+            }
+            //returns once the server has confirmed the subscription, since
+            //what is published before that is not delivered (and an RPC
+            //request sent before its reply topic is subscribed would lose
+            //the reply), throws if the confirmation does not come. Called
+            //on the loop thread (from a handler), it cannot wait.
+            void subscribe(bool isPattern, std::string const &topic, TopicHandler handler) {
+                auto confirmed = std::make_shared<std::promise<bool>>();
+                auto confirmation = confirmed->get_future();
+                boost::asio::post(service_, [this,isPattern,topic,handler=std::move(handler),confirmed]() {
+                    if (isPattern) {
+                        patternHandlers_[topic] = handler;
+                    } else {
+                        channelHandlers_[topic] = handler;
+                    }
+                    if (!subCtx_) {
+                        confirmed->set_value(false);
+                        return;
+                    }
+                    pendingSubscriptions_[pendingSubscriptionKey(isPattern, topic)].push_back(confirmed);
+                    redisAsyncCommand(subCtx_, &OneRedisServer::onSubscriptionMessage, nullptr, (isPattern?"PSUBSCRIBE %s":"SUBSCRIBE %s"), topic.c_str());
+                });
+                if (std::this_thread::get_id() == th_.get_id()) {
+                    return;
+                }
+                if (confirmation.wait_for(std::chrono::seconds(10)) != std::future_status::ready || !confirmation.get()) {
+                    unsubscribe(isPattern, topic);
+                    throw RedisComponentException("Redis server did not confirm subscription to '"+topic+"' for "+locator_.toSerializationFormat());
+                }
+            }
+            //when this returns, the handler will not be called any more
+            void unsubscribe(bool isPattern, std::string const &topic) {
+                runOnLoop([this,isPattern,&topic]() {
+                    if (isPattern) {
+                        patternHandlers_.erase(topic);
+                        if (subCtx_) {
+                            redisAsyncCommand(subCtx_, nullptr, nullptr, "PUNSUBSCRIBE %s", topic.c_str());
+                        }
+                    } else {
+                        channelHandlers_.erase(topic);
+                        if (subCtx_) {
+                            redisAsyncCommand(subCtx_, nullptr, nullptr, "UNSUBSCRIBE %s", topic.c_str());
+                        }
+                    }
+                });
+            }
+            void publish(basic::ByteDataWithTopic &&data) {
+                enqueue({std::move(data), std::string(), 0});
+            }
+            //streamMaxLength is applied as an approximate MAXLEN, 0 means
+            //the stream is never trimmed
+            void addToStream(std::string const &streamKey, std::size_t streamMaxLength, basic::ByteDataWithTopic &&data) {
+                enqueue({std::move(data), streamKey, streamMaxLength});
+            }
+            void enqueue(OutgoingMessage &&m) {
+                bool needFlush = false;
+                {
+                    std::lock_guard<std::mutex> _(publishMutex_);
+                    publishQueue_.push_back(std::move(m));
+                    if (!flushScheduled_) {
+                        flushScheduled_ = true;
+                        needFlush = true;
+                    }
+                }
+                if (needFlush) {
+                    boost::asio::post(service_, [this]() {
+                        flushPublishQueue();
+                    });
+                }
+            }
+            std::thread::native_handle_type getThreadHandle() {
+                return th_.native_handle();
+            }
+        };
+
+        std::unordered_map<ConnectionLocator, std::unique_ptr<OneRedisServer>> servers_;
+
+        //Reads one Redis stream on its own context (the reads block on the
+        //server side), on the event loop of the server. With a consumer
+        //group, the entries are acknowledged in one XACK per batch after
+        //the handler has seen them; entries that this consumer read but
+        //did not acknowledge before (e.g. before a restart) are delivered
+        //first, and if claim_idle_ms is set, entries left pending by other
+        //consumers for that long are claimed periodically.
+        class OneRedisStreamReader {
+        public:
+            //gets the topic and the data of each entry
+            using EntryHandler = std::function<void(std::string &&, std::string_view const &)>;
+        private:
+            OneRedisServer *server_;
+            std::string streamKey_;
+            std::string group_;
+            std::string consumer_;
+            std::size_t count_;
+            long blockMillis_;
+            long claimIdleMillis_;
+            EntryHandler handler_;
+            redisAsyncContext *ctx_;
+            std::shared_ptr<OneRedisServer::AsioAdapter> adapter_;
+            std::optional<boost::asio::steady_timer> claimTimer_;
+            std::optional<boost::asio::steady_timer> reconnectTimer_;
+            std::string startID_;
+            std::string lastID_;
+            std::string claimCursor_;
+            bool readingPending_;
+            bool stopped_;
+
+            static std::string defaultConsumerName() {
+                static std::atomic<uint32_t> counter {0};
+                return hostname_util::hostname()+"-"+std::to_string(infra::pid_util::getpid())+"-"+std::to_string(++counter);
+            }
+            static void onDisconnect(redisAsyncContext const *ctx, int /*status*/) {
+                auto *self = static_cast<OneRedisStreamReader *>(ctx->data);
+                if (ctx == self->ctx_) {
+                    self->ctx_ = nullptr;
+                    self->scheduleReconnect();
+                }
+            }
+            //hiredis frees the context itself when the connection fails
+            static void onConnect(redisAsyncContext const *ctx, int status) {
+                if (status != REDIS_OK) {
+                    onDisconnect(ctx, status);
+                }
+            }
+            //an error reply (failed AUTH, a group deleted under us, ...)
+            //drops the connection, and the reconnection starts over
+            void disconnectOnError(redisAsyncContext *ctx, redisReply *reply) {
+                std::cerr << "RedisComponent stream reader on '" << streamKey_ << "' got error: " << std::string(reply->str, reply->len) << ", reconnecting\n";
+                if (ctx == ctx_) {
+                    redisAsyncDisconnect(ctx);
+                }
+            }
+            static void onAuthReply(redisAsyncContext *ctx, void *r, void * /*privdata*/) {
+                auto *reply = static_cast<redisReply *>(r);
+                if (reply != nullptr && reply->type == REDIS_REPLY_ERROR) {
+                    static_cast<OneRedisStreamReader *>(ctx->data)->disconnectOnError(ctx, reply);
+                }
+            }
+            static void onLastIDReply(redisAsyncContext *ctx, void *r, void * /*privdata*/) {
+                auto *reply = static_cast<redisReply *>(r);
+                if (reply == nullptr) {
+                    return;
+                }
+                auto *self = static_cast<OneRedisStreamReader *>(ctx->data);
+                if (reply->type == REDIS_REPLY_ERROR) {
+                    self->disconnectOnError(ctx, reply);
+                    return;
+                }
+                //[[id, fields]] for the last entry, empty if there is none
+                self->lastID_ = "0-0";
+                if (reply->type == REDIS_REPLY_ARRAY && reply->elements > 0) {
+                    auto *e = reply->element[0];
+                    if (e->type == REDIS_REPLY_ARRAY && e->elements > 0 && e->element[0]->type == REDIS_REPLY_STRING) {
+                        self->lastID_ = std::string(e->element[0]->str, e->element[0]->len);
+                    }
+                }
+                self->read();
+            }
+            static void onReadReply(redisAsyncContext *ctx, void *r, void * /*privdata*/) {
+                auto *reply = static_cast<redisReply *>(r);
+                if (reply == nullptr) {
+                    return;
+                }
+                auto *self = static_cast<OneRedisStreamReader *>(ctx->data);
+                if (reply->type == REDIS_REPLY_ERROR) {
+                    self->disconnectOnError(ctx, reply);
+                    return;
+                }
+                //nil means the read timed out
+                if (reply->type == REDIS_REPLY_ARRAY) {
+                    //one element per stream, each being [key, entries]
+                    for (std::size_t ii=0; ii<reply->elements; ++ii) {
+                        auto *s = reply->element[ii];
+                        if (s->type == REDIS_REPLY_ARRAY && s->elements == 2) {
+                            std::size_t n = self->handleEntries(s->element[1]);
+                            if (self->readingPending_ && n == 0) {
+                                self->readingPending_ = false;
+                            }
+                        }
+                    }
+                } else if (self->readingPending_) {
+                    self->readingPending_ = false;
+                }
+                self->read();
+            }
+            static void onClaimReply(redisAsyncContext *ctx, void *r, void * /*privdata*/) {
+                auto *reply = static_cast<redisReply *>(r);
+                if (reply == nullptr) {
+                    return;
+                }
+                auto *self = static_cast<OneRedisStreamReader *>(ctx->data);
+                //[next cursor, entries, (deleted IDs since Redis 7)]
+                if (reply->type == REDIS_REPLY_ARRAY && reply->elements >= 2) {
+                    if (reply->element[0]->type == REDIS_REPLY_STRING) {
+                        self->claimCursor_ = std::string(reply->element[0]->str, reply->element[0]->len);
+                    }
+                    self->handleEntries(reply->element[1]);
+                }
+                self->scheduleClaim();
+            }
+            //returns the number of entries, including the ones that have
+            //been deleted from the stream while pending
+            std::size_t handleEntries(redisReply *entries) {
+                if (entries->type != REDIS_REPLY_ARRAY) {
+                    return 0;
+                }
+                //every entry is acknowledged, including the ones that the
+                //handler filters out by topic and the ones that cannot be
+                //parsed, otherwise they would stay in the group's pending
+                //list forever
+                std::vector<std::string> ackIDs;
+                ackIDs.reserve(entries->elements);
+                for (std::size_t ii=0; ii<entries->elements; ++ii) {
+                    auto *e = entries->element[ii];
+                    if (e->type != REDIS_REPLY_ARRAY || e->elements != 2 || e->element[0]->type != REDIS_REPLY_STRING) {
+                        continue;
+                    }
+                    std::string id(e->element[0]->str, e->element[0]->len);
+                    lastID_ = id;
+                    auto *fields = e->element[1];
+                    ackIDs.push_back(std::move(id));
+                    if (fields->type != REDIS_REPLY_ARRAY) {
+                        continue;
+                    }
+                    std::optional<std::string> topic;
+                    std::optional<std::string_view> data;
+                    for (std::size_t jj=0; jj+1<fields->elements; jj+=2) {
+                        std::string_view f {fields->element[jj]->str, fields->element[jj]->len};
+                        if (f == "topic") {
+                            topic = std::string(fields->element[jj+1]->str, fields->element[jj+1]->len);
+                        } else if (f == "data") {
+                            data = std::string_view {fields->element[jj+1]->str, fields->element[jj+1]->len};
+                        }
+                    }
+                    if (topic && data) {
+                        handler_(std::move(*topic), *data);
+                    }
+                }
+                if (!ackIDs.empty() && group_ != "" && ctx_) {
+                    std::vector<char const *> argv {"XACK", streamKey_.c_str(), group_.c_str()};
+                    for (auto const &id : ackIDs) {
+                        argv.push_back(id.c_str());
+                    }
+                    redisAsyncCommandArgv(ctx_, nullptr, nullptr, static_cast<int>(argv.size()), argv.data(), nullptr);
+                }
+                return entries->elements;
+            }
+            void read() {
+                if (!ctx_) {
+                    return;
+                }
+                auto count = std::to_string(count_);
+                auto block = std::to_string(blockMillis_);
+                if (group_ != "") {
+                    //while catching up on our own pending entries, the ID
+                    //pages through them, afterwards ">" asks for new ones
+                    std::string id = (readingPending_?lastID_:">");
+                    redisAsyncCommand(
+                        ctx_, &OneRedisStreamReader::onReadReply, nullptr
+                        , "XREADGROUP GROUP %s %s COUNT %s BLOCK %s STREAMS %s %s"
+                        , group_.c_str(), consumer_.c_str(), count.c_str(), block.c_str(), streamKey_.c_str(), id.c_str()
+                    );
+                } else {
+                    redisAsyncCommand(
+                        ctx_, &OneRedisStreamReader::onReadReply, nullptr
+                        , "XREAD COUNT %s BLOCK %s STREAMS %s %s"
+                        , count.c_str(), block.c_str(), streamKey_.c_str(), lastID_.c_str()
+                    );
+                }
+            }
+            void scheduleClaim() {
+                if (!ctx_ || !claimTimer_) {
+                    return;
+                }
+                claimTimer_->expires_after(std::chrono::milliseconds(claimIdleMillis_));
+                claimTimer_->async_wait([this](boost::system::error_code const &ec) {
+                    if (ec || !ctx_) {
+                        return;
+                    }
+                    auto idle = std::to_string(claimIdleMillis_);
+                    auto count = std::to_string(count_);
+                    redisAsyncCommand(
+                        ctx_, &OneRedisStreamReader::onClaimReply, nullptr
+                        , "XAUTOCLAIM %s %s %s %s %s COUNT %s"
+                        , streamKey_.c_str(), group_.c_str(), consumer_.c_str(), idle.c_str(), claimCursor_.c_str(), count.c_str()
+                    );
+                });
+            }
+            void scheduleReconnect() {
+                if (stopped_) {
+                    return;
+                }
+                if (!reconnectTimer_) {
+                    reconnectTimer_.emplace(server_->service());
+                }
+                reconnectTimer_->expires_after(std::chrono::seconds(1));
+                reconnectTimer_->async_wait([this](boost::system::error_code const &ec) {
+                    if (!ec) {
+                        start();
+                    }
+                });
+            }
+            //on the loop thread, also used to reconnect
+            void start() {
+                if (stopped_ || ctx_) {
+                    return;
+                }
+                try {
+                    ctx_ = server_->connectAdditionalContext(adapter_, this, &OneRedisStreamReader::onDisconnect);
+                } catch (RedisComponentException const &ex) {
+                    std::cerr << "RedisComponent stream reader on '" << streamKey_ << "': " << ex.what() << ", retrying\n";
+                    scheduleReconnect();
+                    return;
+                }
+                redisAsyncSetConnectCallback(ctx_, &OneRedisStreamReader::onConnect);
+                server_->authenticate(ctx_, &OneRedisStreamReader::onAuthReply, nullptr);
+                if (group_ != "") {
+                    //fails harmlessly if the group is already there
+                    redisAsyncCommand(
+                        ctx_, nullptr, nullptr
+                        , "XGROUP CREATE %s %s %s MKSTREAM"
+                        , streamKey_.c_str(), group_.c_str(), startID_.c_str()
+                    );
+                    //our own pending entries first, also after reconnecting
+                    //since the last acknowledgements may not have gone out
+                    lastID_ = "0";
+                    readingPending_ = true;
+                    if (claimIdleMillis_ > 0) {
+                        if (!claimTimer_) {
+                            claimTimer_.emplace(server_->service());
+                        }
+                        scheduleClaim();
+                    }
+                } else if (lastID_ == "$") {
+                    //"$" is only used to find where the stream ends, after
+                    //that reads continue from the last seen ID, so that
+                    //nothing added between two reads is skipped
+                    redisAsyncCommand(
+                        ctx_, &OneRedisStreamReader::onLastIDReply, nullptr
+                        , "XREVRANGE %s + - COUNT 1"
+                        , streamKey_.c_str()
+                    );
+                    return;
+                }
+                read();
+            }
+        public:
+            //the locator properties are:
+            //  group: the consumer group, without it every reader gets all
+            //         the entries
+            //  consumer: the name in the group (default is unique for each
+            //            subscription), give a fixed one so that the pending
+            //            entries are picked up again after a restart, or use
+            //            claim_idle_ms to have them claimed
+            //  start_id: where a new group, or a reader without group,
+            //            starts; "$" (default) is new entries only, "0" is
+            //            the whole stream, and any entry ID resumes after
+            //            that entry
+            //  count: maximum number of entries per read (default 100)
+            //  block_ms: how long one read waits on the server (default 1000)
+            //  claim_idle_ms: claim entries that other consumers in the
+            //                 group have left pending for this long (default
+            //                 0, meaning never)
+            OneRedisStreamReader(OneRedisServer *server, ConnectionLocator const &locator, EntryHandler handler)
+                : server_(server)
+                , streamKey_(locator.identifier())
+                , group_(locator.query("group", ""))
+                , consumer_(locator.query("consumer", defaultConsumerName()))
+                , count_(std::max<std::size_t>(1, std::stoul(locator.query("count", "100"))))
+                , blockMillis_(std::stol(locator.query("block_ms", "1000")))
+                , claimIdleMillis_(std::stol(locator.query("claim_idle_ms", "0")))
+                , handler_(std::move(handler))
+                , ctx_(nullptr)
+                , adapter_()
+                , claimTimer_()
+                , reconnectTimer_()
+                , startID_(locator.query("start_id", "$"))
+                , lastID_(startID_)
+                , claimCursor_("0-0")
+                , readingPending_(false)
+                , stopped_(false)
+            {
+                if (streamKey_ == "") {
+                    throw RedisComponentException("Redis stream subscription needs the stream key as identifier in "+locator.toSerializationFormat());
+                }
+                boost::asio::post(server_->service(), [this]() {
+                    start();
+                });
+            }
+            ~OneRedisStreamReader() {
+                server_->runOnLoop([this]() {
+                    stopped_ = true;
+                    if (claimTimer_) {
+                        claimTimer_->cancel();
+                    }
+                    if (reconnectTimer_) {
+                        reconnectTimer_->cancel();
+                    }
+                    if (ctx_) {
+                        auto *c = ctx_;
+                        ctx_ = nullptr;
+                        redisAsyncFree(c);
+                    }
+                });
+            }
+        };
+
+
+        //the same glob matching as PSUBSCRIBE, without character classes
+        static bool topicMatches(std::string_view const &pattern, std::string_view const &topic) {
+            if (pattern.empty()) {
+                return topic.empty();
+            }
+            switch (pattern[0]) {
+            case '*':
+                for (std::size_t ii=0; ii<=topic.length(); ++ii) {
+                    if (topicMatches(pattern.substr(1), topic.substr(ii))) {
+                        return true;
+                    }
+                }
+                return false;
+            case '?':
+                return !topic.empty() && topicMatches(pattern.substr(1), topic.substr(1));
+            case '\\':
+                if (pattern.length() > 1) {
+                    return !topic.empty() && topic[0] == pattern[1] && topicMatches(pattern.substr(2), topic.substr(1));
+                }
+                [[fallthrough]];
+            default:
+                return !topic.empty() && topic[0] == pattern[0] && topicMatches(pattern.substr(1), topic.substr(1));
             }
-            freeReplyObject((void *) r);
         }
+
+        //with the locator property "stream=true", the subscription reads
+        //the Redis stream given as the locator identifier instead of using
+        //PSUBSCRIBE, and the topic is matched against the topic field of
+        //the stream entries
         class OneRedisSubscription {
         private:
             ConnectionLocator locator_;
             std::string topic_;
-            redisContext *ctx_;
+            std::string key_;
+            OneRedisServer *server_;
+            std::unique_ptr<OneRedisStreamReader> streamReader_;
             struct ClientCB {
                 uint32_t id;
                 std::function<void(basic::ByteDataWithTopic &&)> cb;
                 std::optional<WireToUserHook> hook;
             };
             std::vector<ClientCB> clients_;
-            std::thread th_;
             std::mutex mutex_;
-            std::atomic<bool> running_;
+            bool subscribed_;
 
             inline void callClient(ClientCB const &c, basic::ByteDataWithTopic &&d) {
                 if (c.hook) {
@@ -56,94 +889,48 @@ namespace dev { namespace cd606 { namespace tm { namespace transport { namespace
                 }
             }
 
-            void run() {
-                struct redisReply *reply = nullptr;
-                try {
-                    while (running_) {
-                        struct timeval tv = { 0, 1000 };
-                        if (redisSetTimeout(ctx_, tv) != REDIS_OK) {
-                            break;
-                        }
-                        int r = redisGetReply(ctx_, (void **) &reply);
-                        if (r != REDIS_OK) {
-                            if (ctx_->err == REDIS_ERR_EOF) {
-                                break;
-                            }
-                            if (ctx_->err == REDIS_ERR_IO && errno == EAGAIN) {
-                                ctx_->err = 0;
-                                continue;
-                            }
-                            if (ctx_->err == 0) {
-                                if (reply != nullptr) {
-                                    freeReplyObject((void *) &reply);
-                                }
-                            }
-                            continue;
-                        }
-                        if (!running_) {
-                            break;
-                        }
-                        if (reply == nullptr) {
-                            continue;
-                        }
-                        if (reply->type != REDIS_REPLY_ARRAY || (reply->elements != 4 /*&& reply->elements != 3*/)) {
-                            freeReplyObject((void *) reply);
-                            continue;
-                        }
-                        //std::cerr << "get good type reply 1\n";
-                        if (reply->element[0]->type != REDIS_REPLY_STRING
-                            ||
-                            std::string(reply->element[0]->str, reply->element[0]->len) != "pmessage") {
-                            freeReplyObject((void *) reply);
-                            continue;
-                        }
-                        //std::cerr << "get good type reply 2\n";
-                        std::string topic(reply->element[2]->str, reply->element[2]->len);
-                        std::string content(reply->element[3]->str, reply->element[3]->len);
-                        freeReplyObject((void *) reply);
-
-                        if (!running_) {
-                            break;
-                        }
-                        std::lock_guard<std::mutex> _(mutex_);
-                        for (auto const &cb : clients_) {
-                            callClient(cb, {topic, content});
-                        }
-                    }
-                } catch (...) {}
+            void handleMessage(std::string &&topic, std::string_view const &content) {
+                std::lock_guard<std::mutex> _(mutex_);
+                for (auto const &cb : clients_) {
+                    callClient(cb, {topic, std::string(content)});
+                }
             }
         public:
-            OneRedisSubscription(ConnectionLocator const &locator, std::string const &topic) 
+            OneRedisSubscription(ConnectionLocator const &locator, std::string const &topic, std::string const &key, OneRedisServer *server) 
                 : locator_(locator)
                 , topic_(topic)
-                , ctx_(nullptr)
+                , key_(key)
+                , server_(server)
+                , streamReader_()
                 , clients_()
-                , th_()
                 , mutex_()
-                , running_(true)
+                , subscribed_(true)
             {
-                ctx_ = redisConnect(locator.host().c_str(), locator.port());
-                if (ctx_ != nullptr) {
-                    RedisComponentImpl::auth(locator, ctx_);
-                    redisReply *r = (redisReply *) redisCommand(ctx_, "PSUBSCRIBE %s", topic.c_str());
-                    freeReplyObject((void *) r);
-                    th_ = std::thread(&OneRedisSubscription::run, this);
-                    th_.detach();
+                if (isStream(locator_)) {
+                    streamReader_ = std::make_unique<OneRedisStreamReader>(server_, locator_, [this](std::string &&t, std::string_view const &content) {
+                        if (topic_ == "*" || topicMatches(topic_, t)) {
+                            handleMessage(std::move(t), content);
+                        }
+                    });
+                } else {
+                    server_->subscribe(true, topic_, [this](std::string &&t, std::string_view const &content) {
+                        handleMessage(std::move(t), content);
+                    });
                 }
             }
-            ~OneRedisSubscription() {
-                //std::cerr << this << ": being released\n";
-                running_ = false;
-                if (th_.joinable()) {
-                    try {
-                        th_.join();
-                    } catch (std::system_error const &) {
-                    }
-                }
-                //std::cerr << this << ": redis subscription really exiting\n";
-                if (ctx_ && !ctx_->err) {
-                    redisFree(ctx_);
+            static bool isStream(ConnectionLocator const &locator) {
+                return (locator.query("stream", "false") == "true");
+            }
+            //stream subscriptions with different stream keys or groups are
+            //different subscriptions even if the topic is the same
+            static std::string subscriptionKey(ConnectionLocator const &locator, std::string const &topic) {
+                if (isStream(locator)) {
+                    return locator.toSerializationFormat()+"#"+topic;
                 }
+                return topic;
+            }
+            ~OneRedisSubscription() {
+                unsubscribe();
             }
             void addSubscription(
                 uint32_t id
@@ -165,76 +952,33 @@ namespace dev { namespace cd606 { namespace tm { namespace transport { namespace
             }
             bool checkWhetherNeedsToStop() {
                 std::lock_guard<std::mutex> _(mutex_);
-                if (clients_.empty()) {
-                    running_ = false;
-                    return true;
-                } else {
-                    return false;
-                }
+                return clients_.empty();
             }
             void unsubscribe() {
-                //std::cerr << this << ": calling unsubscribe\n";
-                running_ = false;
-                if (th_.joinable()) {
-                    try {
-                        th_.join();
-                    } catch (std::system_error const &) {
-                    }
-                }
-                //std::cerr << this << ": unsubscribing on server level\n";
-                if (ctx_ && !ctx_->err) {
-                    redisReply *r = (redisReply *) redisCommand(ctx_, "PUNSUBSCRIBE %s", topic_.c_str());
-                    if (r) {
-                        freeReplyObject((void *) r);
+                if (subscribed_) {
+                    subscribed_ = false;
+                    if (streamReader_) {
+                        streamReader_.reset();
+                    } else {
+                        server_->unsubscribe(true, topic_);
                     }
                 }
             }
             ConnectionLocator const &locator() const {
                 return locator_;
             }
+            std::string const &key() const {
+                return key_;
+            }
             std::thread::native_handle_type getThreadHandle() {
-                return th_.native_handle();
+                return server_->getThreadHandle();
             }
         };
         
         std::unordered_map<ConnectionLocator, std::unordered_map<std::string, std::unique_ptr<OneRedisSubscription>>> subscriptions_;
 
-        class OneRedisSender {
-        private:
-            redisContext *ctx_;
-            std::mutex mutex_;
-        public:
-            OneRedisSender(ConnectionLocator const &locator)
-                : ctx_(nullptr), mutex_()
-            {
-                ctx_ = redisConnect(locator.host().c_str(), locator.port());
-                RedisComponentImpl::auth(locator, ctx_);
-            }
-            ~OneRedisSender() {
-                if (ctx_ && !ctx_->err) {
-                    redisFree(ctx_);
-                }
-            }
-            void publish(basic::ByteDataWithTopic &&data) {
-                std::lock_guard<std::mutex> _(mutex_);
-                redisReply *r = (redisReply *) redisCommand(
-                    ctx_
-                    , "PUBLISH %s %b"
-                    , data.topic.c_str()
-                    , data.content.c_str()
-                    , data.content.length()
-                ); 
-                if (r != nullptr) {
-                    freeReplyObject((void *) r);
-                }
-            }
-        };
-
-        std::unordered_map<ConnectionLocator, std::unique_ptr<OneRedisSender>> senders_;
-
         class OneRedisRPCClientConnection {
         private:
-            redisContext *ctx_;
             std::string rpcTopic_;
             std::string myCommunicationID_;
             struct OneClientInfo {
@@ -246,127 +990,114 @@ namespace dev { namespace cd606 { namespace tm { namespace transport { namespace
             std::unordered_map<uint32_t, std::unordered_set<std::string>> clientToIDMap_;
             std::unordered_map<std::string, uint32_t> idToClientMap_;
             std::mutex clientsMutex_;
-            std::thread th_;
-            std::atomic<bool> running_;
-            OneRedisSender *sender_;
-            void run() {
-                struct redisReply *reply = nullptr;
-                try {
-                    while (running_) {
-                        struct timeval tv = { 0, 1000 };
-                        if (redisSetTimeout(ctx_, tv) != REDIS_OK) {
-                            break;
-                        }
-                        int r = redisGetReply(ctx_, (void **) &reply);
-                        if (r != REDIS_OK) {
-                            if (ctx_->err == REDIS_ERR_EOF) {
-                                break;
-                            }
-                            if (ctx_->err == REDIS_ERR_IO && errno == EAGAIN) {
-                                ctx_->err = 0;
-                                continue;
-                            }
-                            if (ctx_->err == 0) {
-                                if (reply != nullptr) {
-                                    freeReplyObject((void *) &reply);
-                                }
-                            }
-                            continue;
-                        }
-                        if (!running_) {
-                            break;
-                        }
-                        if (reply == nullptr) {
-                            continue;
-                        }
-                        if (reply->type != REDIS_REPLY_ARRAY || reply->elements != 3) {
-                            freeReplyObject((void *) reply);
-                            continue;
-                        }
-                        if (reply->element[0]->type != REDIS_REPLY_STRING
-                            ||
-                            std::string(reply->element[0]->str, reply->element[0]->len) != "message") {
-                            freeReplyObject((void *) reply);
-                            continue;
-                        }
-                        std::string topic(reply->element[1]->str, reply->element[1]->len);
-                        if (topic != myCommunicationID_) {
-                            freeReplyObject((void *) reply);
-                            continue;
-                        }
-
-                        auto parseRes = basic::bytedata_utils::RunCBORDeserializer<std::tuple<bool,basic::ByteDataWithID>>::apply(std::string_view {reply->element[2]->str, reply->element[2]->len}, 0);
-                        if (!parseRes || std::get<1>(*parseRes) != reply->element[2]->len) {
-                            freeReplyObject((void *) reply);
-                            continue;
-                        }
-
-                        freeReplyObject((void *) reply);    
-
-                        if (!running_) {
-                            break;
-                        }             
-
-                        {
-                            std::lock_guard<std::mutex> _(clientsMutex_);
-                            std::string theID = std::get<1>(std::get<0>(*parseRes)).id;
-                            auto iter = idToClientMap_.find(theID);
-                            if (iter != idToClientMap_.end()) {
-                                auto iter1 = clients_.find(iter->second);
-                                if (iter1 != clients_.end()) {
-                                    if (iter1->second.wireToUserHook_) {
-                                        auto d = (iter1->second.wireToUserHook_->hook)(basic::ByteDataView {std::string_view(std::get<1>(std::get<0>(*parseRes)).content)});
-                                        if (d) {
-                                            iter1->second.callback_(std::get<0>(std::get<0>(*parseRes)), {std::move(std::get<1>(std::get<0>(*parseRes)).id), std::move(d->content)});
-                                        }
-                                    } else {
-                                        iter1->second.callback_(std::get<0>(std::get<0>(*parseRes)), std::move(std::get<1>(std::get<0>(*parseRes))));
-                                    }
-                                }
-                                if (std::get<0>(std::get<0>(*parseRes))) {
-                                    clientToIDMap_[iter->second].erase(theID);
-                                    idToClientMap_.erase(iter);
-                                }
+            OneRedisServer *server_;
+            bool subscribed_;
+            //with the locator property "rpc_batch=true", the requests that
+            //are sent before the event loop gets to them go out as one
+            //message, the server then also batches its replies to this
+            //client. Since older servers drop batches, the client first
+            //sends an empty batch as a probe and sends single requests
+            //until a server acknowledges it (so all the servers on the
+            //topic must understand batches).
+            bool batchRequests_;
+            std::atomic<bool> batchingAcknowledged_;
+            std::chrono::steady_clock::time_point lastBatchingProbe_;
+            std::mutex requestQueueMutex_;
+            std::vector<basic::ByteDataWithID> requestQueue_;
+            bool requestFlushScheduled_;
+            void sendBatchingProbe() {
+                auto encodedData = basic::bytedata_utils::RunSerializer<basic::CBOR<std::vector<basic::ByteDataWithID>>>::apply({});
+                auto encodedDataAndTopic = basic::bytedata_utils::RunSerializer<basic::CBOR<basic::ByteDataWithTopic>>::apply({myCommunicationID_, std::move(encodedData)});
+                server_->publish(basic::ByteDataWithTopic {rpcTopic_, std::move(encodedDataAndTopic)});
+            }
+            void handleReply(bool isFinal, basic::ByteDataWithID &&data) {
+                auto iter = idToClientMap_.find(data.id);
+                if (iter != idToClientMap_.end()) {
+                    std::string theID = data.id;
+                    auto iter1 = clients_.find(iter->second);
+                    if (iter1 != clients_.end()) {
+                        if (iter1->second.wireToUserHook_) {
+                            auto d = (iter1->second.wireToUserHook_->hook)(basic::ByteDataView {std::string_view(data.content)});
+                            if (d) {
+                                iter1->second.callback_(isFinal, {std::move(data.id), std::move(d->content)});
                             }
+                        } else {
+                            iter1->second.callback_(isFinal, std::move(data));
                         }
                     }
-                } catch (...) {}
+                    if (isFinal) {
+                        clientToIDMap_[iter->second].erase(theID);
+                        idToClientMap_.erase(iter);
+                    }
+                }
+            }
+            void handleMessage(std::string_view const &content) {
+                auto parseRes = basic::bytedata_utils::RunCBORDeserializer<std::tuple<bool,basic::ByteDataWithID>>::apply(content, 0);
+                if (parseRes && std::get<1>(*parseRes) == content.length()) {
+                    std::lock_guard<std::mutex> _(clientsMutex_);
+                    handleReply(std::get<0>(std::get<0>(*parseRes)), std::move(std::get<1>(std::get<0>(*parseRes))));
+                    return;
+                }
+                auto batchParseRes = basic::bytedata_utils::RunCBORDeserializer<std::vector<std::tuple<bool,basic::ByteDataWithID>>>::apply(content, 0);
+                if (!batchParseRes || std::get<1>(*batchParseRes) != content.length()) {
+                    return;
+                }
+                //the empty batch is the server's answer to the probe
+                if (std::get<0>(*batchParseRes).empty()) {
+                    batchingAcknowledged_ = true;
+                    return;
+                }
+                std::lock_guard<std::mutex> _(clientsMutex_);
+                for (auto &x : std::get<0>(*batchParseRes)) {
+                    handleReply(std::get<0>(x), std::move(std::get<1>(x)));
+                }
+            }
+            void flushRequests() {
+                std::vector<basic::ByteDataWithID> q;
+                {
+                    std::lock_guard<std::mutex> _(requestQueueMutex_);
+                    std::swap(q, requestQueue_);
+                    requestFlushScheduled_ = false;
+                }
+                if (q.empty()) {
+                    return;
+                }
+                std::string encodedData;
+                if (q.size() == 1) {
+                    encodedData = basic::bytedata_utils::RunSerializer<basic::CBOR<basic::ByteDataWithID>>::apply({std::move(q[0])});
+                } else {
+                    encodedData = basic::bytedata_utils::RunSerializer<basic::CBOR<std::vector<basic::ByteDataWithID>>>::apply({std::move(q)});
+                }
+                auto encodedDataAndTopic = basic::bytedata_utils::RunSerializer<basic::CBOR<basic::ByteDataWithTopic>>::apply({myCommunicationID_, std::move(encodedData)});
+                server_->publish(basic::ByteDataWithTopic {rpcTopic_, std::move(encodedDataAndTopic)});
             }
         public:
-            OneRedisRPCClientConnection(ConnectionLocator const &locator, std::string const &myCommunicationID, OneRedisSender *sender)
-                : ctx_(nullptr)
-                , rpcTopic_(locator.identifier())
+            OneRedisRPCClientConnection(ConnectionLocator const &locator, std::string const &myCommunicationID, OneRedisServer *server)
+                : rpcTopic_(locator.identifier())
                 , myCommunicationID_(myCommunicationID)
                 , clientCounter_(0)
                 , clients_()
                 , clientToIDMap_()
                 , idToClientMap_()
                 , clientsMutex_()
-                , th_()
-                , running_(true)
-                , sender_(sender)
+                , server_(server)
+                , subscribed_(true)
+                , batchRequests_(locator.query("rpc_batch", "false") == "true")
+                , batchingAcknowledged_(false)
+                , lastBatchingProbe_(std::chrono::steady_clock::now())
+                , requestQueueMutex_()
+                , requestQueue_()
+                , requestFlushScheduled_(false)
             {
-                ctx_ = redisConnect(locator.host().c_str(), locator.port());
-                if (ctx_ != nullptr) {
-                    RedisComponentImpl::auth(locator, ctx_);
-                    redisReply *r = (redisReply *) redisCommand(ctx_, "SUBSCRIBE %s", myCommunicationID_.c_str());
-                    freeReplyObject((void *) r);
-                    th_ = std::thread(&OneRedisRPCClientConnection::run, this);
-                    th_.detach();
+                server_->subscribe(false, myCommunicationID_, [this](std::string &&, std::string_view const &content) {
+                    handleMessage(content);
+                });
+                if (batchRequests_) {
+                    sendBatchingProbe();
                 }
             }
             ~OneRedisRPCClientConnection() {
-                running_ = false;
-                try {
-                    if (th_.joinable()) {
-                        th_.join();
-                    }
-                } catch (std::system_error const &) {
-                }
-                //std::cerr << this << ": redis rpc client really exiting\n";
-                if (ctx_ && !ctx_->err) {
-                    redisFree(ctx_);
-                }
+                unsubscribe();
             }
             uint32_t addClient(std::function<void(bool, basic::ByteDataWithID &&)> callback, std::optional<WireToUserHook> wireToUserHook) {
                 std::lock_guard<std::mutex> _(clientsMutex_);
@@ -386,20 +1117,9 @@ namespace dev { namespace cd606 { namespace tm { namespace transport { namespace
                 return clients_.size();
             }
             void unsubscribe() {
-                //std::cerr << this << ": rpc client unsubscribe\n";
-                running_ = false;
-                try {
-                    if (th_.joinable()) {
-                        th_.join();
-                    }
-                } catch (std::system_error const &) {
-                }
-                //std::cerr << this << ": unsubscribing on server level\n";
-                if (ctx_ && !ctx_->err) {
-                    redisReply *r = (redisReply *) redisCommand(ctx_, "UNSUBSCRIBE %s", myCommunicationID_.c_str());
-                    if (r) {
-                        freeReplyObject((void *) r);
-                    }
+                if (subscribed_) {
+                    subscribed_ = false;
+                    server_->unsubscribe(false, myCommunicationID_);
                 }
             }
             void sendRequest(uint32_t clientNumber, basic::ByteDataWithID &&data) {
@@ -408,12 +1128,44 @@ namespace dev { namespace cd606 { namespace tm { namespace transport { namespace
                     clientToIDMap_[clientNumber].insert(data.id);
                     idToClientMap_[data.id] = clientNumber;
                 }
+                if (batchRequests_ && !batchingAcknowledged_) {
+                    //the server may not have been there for the last probe
+                    bool needProbe = false;
+                    {
+                        std::lock_guard<std::mutex> _(requestQueueMutex_);
+                        auto now = std::chrono::steady_clock::now();
+                        if (now >= lastBatchingProbe_+std::chrono::seconds(10)) {
+                            lastBatchingProbe_ = now;
+                            needProbe = true;
+                        }
+                    }
+                    if (needProbe) {
+                        sendBatchingProbe();
+                    }
+                }
+                if (batchRequests_ && batchingAcknowledged_) {
+                    bool needFlush = false;
+                    {
+                        std::lock_guard<std::mutex> _(requestQueueMutex_);
+                        requestQueue_.push_back(std::move(data));
+                        if (!requestFlushScheduled_) {
+                            requestFlushScheduled_ = true;
+                            needFlush = true;
+                        }
+                    }
+                    if (needFlush) {
+                        server_->post([this]() {
+                            flushRequests();
+                        });
+                    }
+                    return;
+                }
                 auto encodedData = basic::bytedata_utils::RunSerializer<basic::CBOR<basic::ByteDataWithID>>::apply({std::move(data)});
                 auto encodedDataAndTopic = basic::bytedata_utils::RunSerializer<basic::CBOR<basic::ByteDataWithTopic>>::apply({myCommunicationID_, std::move(encodedData)});
-                sender_->publish(basic::ByteDataWithTopic {rpcTopic_, std::move(encodedDataAndTopic)});       
+                server_->publish(basic::ByteDataWithTopic {rpcTopic_, std::move(encodedDataAndTopic)});       
             }
             std::thread::native_handle_type getThreadHandle() {
-                return th_.native_handle();
+                return server_->getThreadHandle();
             }
         };
 
@@ -421,120 +1173,103 @@ namespace dev { namespace cd606 { namespace tm { namespace transport { namespace
 
         class OneRedisRPCServerConnection {
         private:
-            redisContext *ctx_;
             std::string rpcTopic_;
             std::function<void(basic::ByteDataWithID &&)> callback_;
             std::optional<WireToUserHook> wireToUserHook_;
-            std::unordered_map<std::string, std::string> replyTopicMap_;
-            std::thread th_;
+            //requests that came in a batch get their replies batched, one
+            //message per client for the replies that are sent before the
+            //event loop gets to them, so what is kept per client lives only
+            //as long as its requests are outstanding
+            struct ReplyTarget {
+                std::string topic;
+                bool batched;
+            };
+            std::unordered_map<std::string, ReplyTarget> replyTopicMap_;
             std::mutex mutex_;
-            OneRedisSender *sender_;
-            std::atomic<bool> running_;
-            void run() {
-                struct redisReply *reply = nullptr;
-                while (running_) {
-                    struct timeval tv = { 0, 1000 };
-                    if (redisSetTimeout(ctx_, tv) != REDIS_OK) {
-                        break;
-                    }
-                    int r = redisGetReply(ctx_, (void **) &reply);
-                    if (r != REDIS_OK) {
-                        if (ctx_->err == REDIS_ERR_EOF) {
-                            break;
-                        }
-                        if (ctx_->err == REDIS_ERR_IO && errno == EAGAIN) {
-                            ctx_->err = 0;
-                            continue;
-                        }
-                        if (ctx_->err == 0) {
-                            if (reply != nullptr) {
-                                freeReplyObject((void *) &reply);
-                            }
-                        }
-                        continue;
-                    }
-                    if (!running_) {
-                        break;
-                    }
-                    if (reply == nullptr) {
-                        continue;
-                    }
-                    if (reply->type != REDIS_REPLY_ARRAY || reply->elements != 3) {
-                        freeReplyObject((void *) reply);
-                        continue;
-                    }
-                    if (reply->element[0]->type != REDIS_REPLY_STRING
-                        ||
-                        std::string(reply->element[0]->str, reply->element[0]->len) != "message") {
-                        freeReplyObject((void *) reply);
-                        continue;
-                    }
-                    std::string topic(reply->element[1]->str, reply->element[1]->len);
-                    if (topic != rpcTopic_) {
-                        freeReplyObject((void *) reply);
-                        continue;
-                    }
-
-                    auto parseRes = basic::bytedata_utils::RunCBORDeserializer<basic::ByteDataWithTopic>::apply(std::string_view {reply->element[2]->str, reply->element[2]->len}, 0);
-                    if (!parseRes || std::get<1>(*parseRes) != reply->element[2]->len) {
-                        freeReplyObject((void *) reply);
-                        continue;
-                    }
-                    freeReplyObject((void *) reply);
-                    auto innerParseRes = basic::bytedata_utils::RunCBORDeserializer<basic::ByteDataWithID>::apply(std::string_view {std::get<0>(*parseRes).content}, 0);
-                    if (!innerParseRes || std::get<1>(*innerParseRes) != std::get<0>(*parseRes).content.length()) {
-                        continue;
-                    }
-                    if (!running_) {
-                        break;
+            OneRedisServer *server_;
+            std::unordered_map<std::string, std::vector<std::tuple<bool,basic::ByteDataWithID>>> replyQueue_;
+            bool replyFlushScheduled_;
+            void handleRequest(basic::ByteDataWithID &&data) {
+                if (wireToUserHook_) {
+                    auto d = (wireToUserHook_->hook)(basic::ByteDataView {std::string_view(data.content)});
+                    if (d) {
+                        callback_({std::move(data.id), std::move(d->content)});
                     }
+                } else {
+                    callback_(std::move(data));
+                }
+            }
+            void handleMessage(std::string_view const &content) {
+                auto parseRes = basic::bytedata_utils::RunCBORDeserializer<basic::ByteDataWithTopic>::apply(content, 0);
+                if (!parseRes || std::get<1>(*parseRes) != content.length()) {
+                    return;
+                }
+                auto const &replyTopic = std::get<0>(*parseRes).topic;
+                std::string_view inner {std::get<0>(*parseRes).content};
+                auto innerParseRes = basic::bytedata_utils::RunCBORDeserializer<basic::ByteDataWithID>::apply(inner, 0);
+                if (innerParseRes && std::get<1>(*innerParseRes) == inner.length()) {
                     {
                         std::lock_guard<std::mutex> _(mutex_);
-                        replyTopicMap_[std::get<0>(*innerParseRes).id] = std::get<0>(*parseRes).topic;
+                        replyTopicMap_[std::get<0>(*innerParseRes).id] = {replyTopic, false};
                     }
-                    if (wireToUserHook_) {
-                        auto d = (wireToUserHook_->hook)(basic::ByteDataView {std::string_view(std::get<0>(*innerParseRes).content)});
-                        if (d) {
-                            callback_({std::move(std::get<0>(*innerParseRes).id), std::move(d->content)});
-                        }
+                    handleRequest(std::move(std::get<0>(*innerParseRes)));
+                    return;
+                }
+                auto batchParseRes = basic::bytedata_utils::RunCBORDeserializer<std::vector<basic::ByteDataWithID>>::apply(inner, 0);
+                if (!batchParseRes || std::get<1>(*batchParseRes) != inner.length()) {
+                    return;
+                }
+                //an empty batch is a client asking whether batches are
+                //understood
+                if (std::get<0>(*batchParseRes).empty()) {
+                    auto encodedData = basic::bytedata_utils::RunSerializer<basic::CBOR<std::vector<std::tuple<bool,basic::ByteDataWithID>>>>::apply({});
+                    server_->publish(basic::ByteDataWithTopic {replyTopic, std::move(encodedData)});
+                    return;
+                }
+                {
+                    std::lock_guard<std::mutex> _(mutex_);
+                    for (auto const &x : std::get<0>(*batchParseRes)) {
+                        replyTopicMap_[x.id] = {replyTopic, true};
+                    }
+                }
+                for (auto &x : std::get<0>(*batchParseRes)) {
+                    handleRequest(std::move(x));
+                }
+            }
+            void flushReplies() {
+                std::unordered_map<std::string, std::vector<std::tuple<bool,basic::ByteDataWithID>>> q;
+                {
+                    std::lock_guard<std::mutex> _(mutex_);
+                    std::swap(q, replyQueue_);
+                    replyFlushScheduled_ = false;
+                }
+                for (auto &item : q) {
+                    std::string encodedData;
+                    if (item.second.size() == 1) {
+                        encodedData = basic::bytedata_utils::RunSerializer<basic::CBOR<std::tuple<bool,basic::ByteDataWithID>>>::apply({std::move(item.second[0])});
                     } else {
-                        callback_(std::move(std::get<0>(*innerParseRes)));
+                        encodedData = basic::bytedata_utils::RunSerializer<basic::CBOR<std::vector<std::tuple<bool,basic::ByteDataWithID>>>>::apply({std::move(item.second)});
                     }
+                    server_->publish(basic::ByteDataWithTopic {item.first, std::move(encodedData)});
                 }
             }
         public:
-            OneRedisRPCServerConnection(ConnectionLocator const &locator, std::function<void(basic::ByteDataWithID &&)> callback, std::optional<WireToUserHook> wireToUserHook, OneRedisSender *sender)
-                : ctx_(nullptr)
-                , rpcTopic_(locator.identifier())
+            OneRedisRPCServerConnection(ConnectionLocator const &locator, std::function<void(basic::ByteDataWithID &&)> callback, std::optional<WireToUserHook> wireToUserHook, OneRedisServer *server)
+                : rpcTopic_(locator.identifier())
                 , callback_(callback)
                 , wireToUserHook_(wireToUserHook)
-                , th_()
+                , replyTopicMap_()
                 , mutex_()
-                , sender_(sender)
-                , running_(true)
+                , server_(server)
+                , replyQueue_()
+                , replyFlushScheduled_(false)
             {
-                ctx_ = redisConnect(locator.host().c_str(), locator.port());
-                if (ctx_ != nullptr) {
-                    RedisComponentImpl::auth(locator, ctx_);
-                    redisReply *r = (redisReply *) redisCommand(ctx_, "SUBSCRIBE %s", rpcTopic_.c_str());
-                    freeReplyObject((void *) r);
-                    th_ = std::thread(&OneRedisRPCServerConnection::run, this);
-                    th_.detach();
-                }
+                server_->subscribe(false, rpcTopic_, [this](std::string &&, std::string_view const &content) {
+                    handleMessage(content);
+                });
             }
             ~OneRedisRPCServerConnection() {
-                running_ = false;
-                try {
-                    th_.join();
-                } catch (std::system_error const &) {
-                }
-                if (ctx_ && !ctx_->err) {
-                    redisReply *r = (redisReply *) redisCommand(ctx_, "UNSUBSCRIBE %s", rpcTopic_.c_str());
-                    if (r) {
-                        freeReplyObject((void *) r);
-                    }
-                    redisFree(ctx_);
-                }
+                server_->unsubscribe(false, rpcTopic_);
             }
             void sendReply(bool isFinal, basic::ByteDataWithID &&data) {
                 std::string replyTopic;
@@ -544,16 +1279,27 @@ namespace dev { namespace cd606 { namespace tm { namespace transport { namespace
                     if (iter == replyTopicMap_.end()) {
                         return;
                     }
-                    replyTopic = iter->second;
+                    replyTopic = iter->second.topic;
+                    bool batched = iter->second.batched;
                     if (isFinal) {
                         replyTopicMap_.erase(iter);
                     }
+                    if (batched) {
+                        replyQueue_[replyTopic].push_back({isFinal, std::move(data)});
+                        if (!replyFlushScheduled_) {
+                            replyFlushScheduled_ = true;
+                            server_->post([this]() {
+                                flushReplies();
+                            });
+                        }
+                        return;
+                    }
                 }
                 auto encodedData = basic::bytedata_utils::RunSerializer<basic::CBOR<std::tuple<bool,basic::ByteDataWithID>>>::apply({{isFinal, std::move(data)}});
-                sender_->publish(basic::ByteDataWithTopic {replyTopic, std::move(encodedData)});           
+                server_->publish(basic::ByteDataWithTopic {replyTopic, std::move(encodedData)});           
             }
             std::thread::native_handle_type getThreadHandle() {
-                return th_.native_handle();
+                return server_->getThreadHandle();
             }
         };
         std::unordered_map<ConnectionLocator, std::unique_ptr<OneRedisRPCServerConnection>> rpcServerConnections_;
@@ -564,76 +1310,149 @@ namespace dev { namespace cd606 { namespace tm { namespace transport { namespace
         std::unordered_map<uint32_t, OneRedisSubscription *> idToSubscriptionMap_;
         std::mutex idMutex_;
 
+        //Locators share a server connection (and its event loop thread)
+        //only if they agree on everything the connection is set up with:
+        //the host, the port, the credentials and the threading properties
+        static ConnectionLocator serverKey(ConnectionLocator const &d) {
+            return TransportThreadingConfig::threadingPropertiesOf(
+                ConnectionLocator {d.host(), d.port(), d.userName(), d.password()}
+                , d
+            );
+        }
+        OneRedisServer *getOrStartServerNoLock(ConnectionLocator const &d) {
+            auto key = serverKey(d);
+            auto iter = servers_.find(key);
+            if (iter == servers_.end()) {
+                iter = servers_.insert({key, std::make_unique<OneRedisServer>(d)}).first;
+            }
+            return iter->second.get();
+        }
+        //The subscription and RPC connection constructors wait for the
+        //event loop (for the subscription confirmations), and callbacks on
+        //the loop may be waiting for mutex_, so they are constructed
+        //without holding it
         OneRedisSubscription *getOrStartSubscription(ConnectionLocator const &d, std::string const &topic) {
-            ConnectionLocator hostAndPort {d.host(), d.port()};
-            std::lock_guard<std::mutex> _(mutex_);
-            auto subscriptionIter = subscriptions_.find(hostAndPort);
-            if (subscriptionIter == subscriptions_.end()) {
-                subscriptionIter = subscriptions_.insert({hostAndPort, std::unordered_map<std::string, std::unique_ptr<OneRedisSubscription>> {}}).first;
+            auto serverLocator = serverKey(d);
+            auto key = OneRedisSubscription::subscriptionKey(d, topic);
+            OneRedisServer *server;
+            {
+                std::lock_guard<std::mutex> _(mutex_);
+                auto subscriptionIter = subscriptions_.find(serverLocator);
+                if (subscriptionIter != subscriptions_.end()) {
+                    auto innerIter = subscriptionIter->second.find(key);
+                    if (innerIter != subscriptionIter->second.end()) {
+                        return innerIter->second.get();
+                    }
+                }
+                server = getOrStartServerNoLock(d);
             }
-            auto innerIter = subscriptionIter->second.find(topic);
-            if (innerIter == subscriptionIter->second.end()) {
-                innerIter = subscriptionIter->second.insert({topic, std::make_unique<OneRedisSubscription>(d, topic)}).first;
+            auto newSubscription = std::make_unique<OneRedisSubscription>(d, topic, key, server);
+            OneRedisSubscription *ret;
+            {
+                std::lock_guard<std::mutex> _(mutex_);
+                auto &inner = subscriptions_[serverLocator];
+                auto innerIter = inner.find(key);
+                if (innerIter == inner.end()) {
+                    innerIter = inner.insert({key, std::move(newSubscription)}).first;
+                }
+                ret = innerIter->second.get();
             }
-            return innerIter->second.get();
+            //if another thread got there first, ours is dropped here
+            return ret;
         }
         void potentiallyStopSubscription(OneRedisSubscription *p) {
-            //std::cerr << "potentially stopping " << p << '\n';
-            std::lock_guard<std::mutex> _(mutex_);
-            if (p->checkWhetherNeedsToStop()) {
-                //std::cerr << p << ": is being stopped\n";
-                p->unsubscribe();
-                //std::cerr << p << " is being removed from subscriptionn map '" << p->locator().toPrintFormat() << "'\n";
-                ConnectionLocator hostAndPort {p->locator().host(), p->locator().port()};
-                subscriptions_.erase(hostAndPort);
-                //std::cerr << subscriptions_.size() << '\n';
+            //the unsubscription waits for the event loop, which may itself
+            //be waiting for mutex_ in a callback, so it is done after the
+            //lock is released
+            std::unique_ptr<OneRedisSubscription> toStop;
+            {
+                std::lock_guard<std::mutex> _(mutex_);
+                if (!p->checkWhetherNeedsToStop()) {
+                    return;
+                }
+                auto iter = subscriptions_.find(serverKey(p->locator()));
+                if (iter == subscriptions_.end()) {
+                    return;
+                }
+                auto innerIter = iter->second.find(p->key());
+                if (innerIter == iter->second.end()) {
+                    return;
+                }
+                toStop = std::move(innerIter->second);
+                iter->second.erase(innerIter);
+                if (iter->second.empty()) {
+                    subscriptions_.erase(iter);
+                }
             }
+            toStop->unsubscribe();
         }
-        OneRedisSender *getOrStartSender(ConnectionLocator const &d) {
+        OneRedisServer *getOrStartServer(ConnectionLocator const &d) {
             std::lock_guard<std::mutex> _(mutex_);
-            return getOrStartSenderNoLock(d);
-        }
-        OneRedisSender *getOrStartSenderNoLock(ConnectionLocator const &d) {
-            ConnectionLocator hostAndPort {d.host(), d.port()};
-            auto senderIter = senders_.find(hostAndPort);
-            if (senderIter == senders_.end()) {
-                senderIter = senders_.insert({hostAndPort, std::make_unique<OneRedisSender>(d)}).first;
-            }
-            return senderIter->second.get();
+            return getOrStartServerNoLock(d);
         }
         OneRedisRPCClientConnection *createRpcClientConnection(ConnectionLocator const &l, std::function<std::string()> clientCommunicationIDCreator) {
-            std::lock_guard<std::mutex> _(mutex_);
-            auto iter = rpcClientConnections_.find(l);
-            if (iter == rpcClientConnections_.end()) {
-                iter = rpcClientConnections_.insert(
-                    {l, std::make_unique<OneRedisRPCClientConnection>(l, clientCommunicationIDCreator(), getOrStartSenderNoLock(l))}
-                ).first;
+            OneRedisServer *server;
+            {
+                std::lock_guard<std::mutex> _(mutex_);
+                auto iter = rpcClientConnections_.find(l);
+                if (iter != rpcClientConnections_.end()) {
+                    return iter->second.get();
+                }
+                server = getOrStartServerNoLock(l);
             }
-            return iter->second.get();
+            auto conn = std::make_unique<OneRedisRPCClientConnection>(l, clientCommunicationIDCreator(), server);
+            OneRedisRPCClientConnection *ret;
+            {
+                std::lock_guard<std::mutex> _(mutex_);
+                ret = rpcClientConnections_.insert({l, std::move(conn)}).first->second.get();
+            }
+            return ret;
         }
         OneRedisRPCServerConnection *createRpcServerConnection(ConnectionLocator const &l, std::function<void(basic::ByteDataWithID &&)> handler, std::optional<WireToUserHook> wireToUserHook) {
+            OneRedisServer *server;
+            {
+                std::lock_guard<std::mutex> _(mutex_);
+                if (rpcServerConnections_.find(l) != rpcServerConnections_.end()) {
+                    throw RedisComponentException("Cannot create duplicate RPC server connection for "+l.toSerializationFormat());
+                }
+                server = getOrStartServerNoLock(l);
+            }
+            auto conn = std::make_unique<OneRedisRPCServerConnection>(l, handler, wireToUserHook, server);
             std::lock_guard<std::mutex> _(mutex_);
-            auto iter = rpcServerConnections_.find(l);
-            if (iter != rpcServerConnections_.end()) {
+            auto res = rpcServerConnections_.insert({l, nullptr});
+            if (!res.second) {
+                //conn unsubscribes on the loop, which must not wait for
+                //mutex_, this is only reached on concurrent duplicates
                 throw RedisComponentException("Cannot create duplicate RPC server connection for "+l.toSerializationFormat());
             }
-            iter = rpcServerConnections_.insert(
-                {l, std::make_unique<OneRedisRPCServerConnection>(l, handler, wireToUserHook, getOrStartSenderNoLock(l))}
-            ).first;
-            return iter->second.get();
+            res.first->second = std::move(conn);
+            return res.first->second.get();
         }
     public:
         RedisComponentImpl() 
-            : subscriptions_(), senders_(), rpcClientConnections_(), rpcServerConnections_(), mutex_()
+            : servers_(), subscriptions_(), rpcClientConnections_(), rpcServerConnections_(), mutex_()
             , counter_(0), idToSubscriptionMap_(), idMutex_()
         { 
         }
         ~RedisComponentImpl() {
-            std::lock_guard<std::mutex> _(mutex_);
-            subscriptions_.clear();
-            senders_.clear();
-            rpcClientConnections_.clear();
-            rpcServerConnections_.clear();
+            //the subscriptions and connections unsubscribe on the event
+            //loops when destroyed, so they are taken out under the lock
+            //and destroyed after it is released
+            decltype(subscriptions_) subscriptions;
+            decltype(rpcClientConnections_) rpcClientConnections;
+            decltype(rpcServerConnections_) rpcServerConnections;
+            decltype(servers_) servers;
+            {
+                std::lock_guard<std::mutex> _(mutex_);
+                std::swap(subscriptions, subscriptions_);
+                std::swap(rpcClientConnections, rpcClientConnections_);
+                std::swap(rpcServerConnections, rpcServerConnections_);
+                std::swap(servers, servers_);
+            }
+            subscriptions.clear();
+            rpcClientConnections.clear();
+            rpcServerConnections.clear();
+            servers.clear();
         }
         uint32_t addSubscriptionClient(ConnectionLocator const &locator,
             std::string const &topic,
@@ -665,12 +1484,37 @@ namespace dev { namespace cd606 { namespace tm { namespace transport { namespace
             }
         }
         std::function<void(basic::ByteDataWithTopic &&)> getPublisher(ConnectionLocator const &locator, std::optional<UserToWireHook> userToWireHook) {
-            auto *p = getOrStartSender(locator);
+            auto *p = getOrStartServer(locator);
+            if (OneRedisSubscription::isStream(locator)) {
+                //the stream is trimmed to about max_length entries
+                std::string streamKey = locator.identifier();
+                if (streamKey == "") {
+                    throw RedisComponentException("Redis stream publisher needs the stream key as identifier in "+locator.toSerializationFormat());
+                }
+                std::size_t maxLength = std::stoul(locator.query("max_length", "1000000"));
+                if (userToWireHook) {
+                    auto hook = userToWireHook->hook;
+                    return [p,hook,streamKey,maxLength](basic::ByteDataWithTopic &&data) {
+                        auto w = byte_data_hook_utils::tryUserToWireHook(hook, basic::ByteData {std::move(data.content)});
+                        if (!w) {
+                            return;
+                        }
+                        p->addToStream(streamKey, maxLength, {std::move(data.topic), std::move(w->content)});
+                    };
+                } else {
+                    return [p,streamKey,maxLength](basic::ByteDataWithTopic &&data) {
+                        p->addToStream(streamKey, maxLength, std::move(data));
+                    };
+                }
+            }
             if (userToWireHook) {
                 auto hook = userToWireHook->hook;
                 return [p,hook](basic::ByteDataWithTopic &&data) {
-                    auto w = hook(basic::ByteData {std::move(data.content)});
-                    p->publish({std::move(data.topic), std::move(w.content)});
+                    auto w = byte_data_hook_utils::tryUserToWireHook(hook, basic::ByteData {std::move(data.content)});
+                    if (!w) {
+                        return;
+                    }
+                    p->publish({std::move(data.topic), std::move(w->content)});
                 };
             } else {
                 return [p](basic::ByteDataWithTopic &&data) {
@@ -707,14 +1551,20 @@ namespace dev { namespace cd606 { namespace tm { namespace transport { namespace
             }
         }
         void removeRPCClient(ConnectionLocator const &locator, uint32_t clientNumber) {
-            std::lock_guard<std::mutex> _(mutex_);
-            auto iter = rpcClientConnections_.find(locator);
-            if (iter != rpcClientConnections_.end()) {
-                if (iter->second->removeClient(clientNumber) == 0) {
-                    iter->second->unsubscribe();
-                    rpcClientConnections_.erase(iter);
+            std::unique_ptr<OneRedisRPCClientConnection> toStop;
+            {
+                std::lock_guard<std::mutex> _(mutex_);
+                auto iter = rpcClientConnections_.find(locator);
+                if (iter != rpcClientConnections_.end()) {
+                    if (iter->second->removeClient(clientNumber) == 0) {
+                        toStop = std::move(iter->second);
+                        rpcClientConnections_.erase(iter);
+                    }
                 }
             }
+            if (toStop) {
+                toStop->unsubscribe();
+            }
         }
         std::function<void(bool, basic::ByteDataWithID &&)> setRPCServer(ConnectionLocator const &locator,
             std::function<void(basic::ByteDataWithID &&)> server,
@@ -729,8 +1579,11 @@ namespace dev { namespace cd606 { namespace tm { namespace transport { namespace
             if (hookPair && hookPair->userToWire) {
                 auto hook = hookPair->userToWire->hook;
                 return [conn,hook](bool isFinal, basic::ByteDataWithID &&data) {
-                    auto x = hook(basic::ByteData {std::move(data.content)});
-                    conn->sendReply(isFinal, {data.id, std::move(x.content)});
+                    auto x = byte_data_hook_utils::tryUserToWireHookForReply(hook, isFinal, basic::ByteData {std::move(data.content)});
+                    if (!x) {
+                        return;
+                    }
+                    conn->sendReply(isFinal, {data.id, std::move(x->content)});
                 };
             } else {
                 return [conn](bool isFinal, basic::ByteDataWithID &&data) {
@@ -778,7 +1631,8 @@ namespace dev { namespace cd606 { namespace tm { namespace transport { namespace
                         std::function<void(bool, basic::ByteDataWithID &&)> client,
                         std::optional<ByteDataHookPair> hookPair,
                         uint32_t *clientNumberOutput) {
-        return impl_->setRPCClient(locator, clientCommunicationIDCreator, client, hookPair, clientNumberOutput);
+        auto metrics = transportRPCChannelMetrics(dynamic_cast<TransportMetricsComponent *>(this), "redis", locator);
+        return countRPCSend(metrics, impl_->setRPCClient(locator, clientCommunicationIDCreator, countRPCReceive(metrics, client), hookPair, clientNumberOutput));
     }
     void RedisComponent::redis_removeRPCClient(ConnectionLocator const &locator, uint32_t clientNumber) {
         impl_->removeRPCClient(locator, clientNumber);
@@ -786,7 +1640,8 @@ namespace dev { namespace cd606 { namespace tm { namespace transport { namespace
     std::function<void(bool, basic::ByteDataWithID &&)> RedisComponent::redis_setRPCServer(ConnectionLocator const &locator,
                     std::function<void(basic::ByteDataWithID &&)> server,
                     std::optional<ByteDataHookPair> hookPair) {
-        return impl_->setRPCServer(locator, server, hookPair);
+        auto metrics = transportRPCChannelMetrics(dynamic_cast<TransportMetricsComponent *>(this), "redis", locator);
+        return countRPCSend(metrics, impl_->setRPCServer(locator, countRPCReceive(metrics, server), hookPair));
     }
     std::unordered_map<ConnectionLocator, std::thread::native_handle_type> RedisComponent::redis_threadHandles() {
         return impl_->threadHandles();
@@ -0,0 +1,560 @@
+#include <mutex>
+#include <chrono>
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <unordered_map>
+#include <unordered_set>
+#include <atomic>
+#include <iostream>
+
+#include <tm_kit/transport/security/SessionKeyHelper.hpp>
+
+#include <sodium/core.h>
+#include <sodium/crypto_kx.h>
+#include <sodium/crypto_generichash.h>
+#include <sodium/randombytes.h>
+#include <sodium/utils.h>
+
+namespace dev { namespace cd606 { namespace tm { namespace transport { namespace security {
+    namespace {
+        //Wire format of the client-to-server messages:
+        //  HELLO : tag | signed CBOR {"session","ephemeral","counter","timestamp","data"}
+        //          (the counter is shared with the MAC messages of the
+        //          session, the timestamp is in milliseconds since epoch)
+        //  MAC   : tag | session ID | counter (8 bytes, little endian) | MAC | data
+        //Wire format of the server-to-client messages:
+        //  PLAIN : tag | data
+        //  ACK   : tag | count (1 byte) | count * (session ID | server ephemeral key) | data
+        constexpr char PlainTag = 0x00;
+        constexpr char HelloTag = 0x01;
+        constexpr char MACTag = 0x02;
+        constexpr char AckTag = 0x03;
+
+        constexpr std::size_t SessionIDLength = SessionKeyHelper::SessionIDLength;
+        constexpr std::size_t MACLength = SessionKeyHelper::MACLength;
+        constexpr std::size_t CounterLength = 8;
+        constexpr std::size_t MACHeaderLength = 1+SessionIDLength+CounterLength+MACLength;
+        constexpr std::size_t AckEntryLength = SessionIDLength+crypto_kx_PUBLICKEYBYTES;
+
+        using SessionID = std::array<unsigned char, SessionIDLength>;
+        using KXPublicKey = std::array<unsigned char, crypto_kx_PUBLICKEYBYTES>;
+        using KXSecretKey = std::array<unsigned char, crypto_kx_SECRETKEYBYTES>;
+        using SessionKey = std::array<unsigned char, crypto_kx_SESSIONKEYBYTES>;
+
+        inline void initSodium() {
+            if (sodium_init() < 0) {
+                throw std::runtime_error("SessionKeyHelper: libsodium cannot be initialized");
+            }
+        }
+        inline void encodeCounter(uint64_t counter, unsigned char *p) {
+            for (std::size_t ii=0; ii<CounterLength; ++ii) {
+                p[ii] = static_cast<unsigned char>((counter >> (8*ii)) & 0xff);
+            }
+        }
+        inline uint64_t decodeCounter(unsigned char const *p) {
+            uint64_t counter = 0;
+            for (std::size_t ii=0; ii<CounterLength; ++ii) {
+                counter |= (static_cast<uint64_t>(p[ii]) << (8*ii));
+            }
+            return counter;
+        }
+        //the MAC covers the session ID and the counter as well as the data
+        inline void computeMAC(
+            SessionKey const &key
+            , unsigned char const *sessionAndCounter
+            , unsigned char const *data, std::size_t dataLen
+            , unsigned char *mac
+        ) {
+            crypto_generichash_state state;
+            crypto_generichash_init(&state, key.data(), key.size(), MACLength);
+            crypto_generichash_update(&state, sessionAndCounter, SessionIDLength+CounterLength);
+            crypto_generichash_update(&state, data, dataLen);
+            crypto_generichash_final(&state, mac, MACLength);
+        }
+    }
+
+    class SessionKeyClientImpl {
+    private:
+        //one per server connection
+        struct Session {
+            SessionID sessionID;
+            KXPublicKey ephemeralPublicKey;
+            KXSecretKey ephemeralSecretKey;
+            std::optional<SessionKey> key;
+            uint64_t counter;
+            std::size_t unanswered;
+            std::chrono::steady_clock::time_point firstUnanswered;
+            std::chrono::steady_clock::time_point sessionStart;
+
+            Session() : sessionID(), ephemeralPublicKey(), ephemeralSecretKey(), key(std::nullopt), counter(0), unanswered(0), firstUnanswered(), sessionStart() {
+                start();
+            }
+            ~Session() {
+                sodium_memzero(ephemeralSecretKey.data(), ephemeralSecretKey.size());
+            }
+            void start() {
+                randombytes_buf(sessionID.data(), sessionID.size());
+                crypto_kx_keypair(ephemeralPublicKey.data(), ephemeralSecretKey.data());
+                key = std::nullopt;
+                counter = 0;
+                unanswered = 0;
+                sessionStart = std::chrono::steady_clock::now();
+            }
+        };
+
+        SignatureHelper::Signer signer_;
+        SessionKeyHelper::ClientOptions options_;
+        std::mutex mutex_;
+        std::unordered_map<std::string, Session> sessions_;
+
+        basic::ByteData hello(Session &session, basic::ByteData &&data) {
+            auto timestamp = static_cast<int64_t>(std::chrono::duration_cast<std::chrono::milliseconds>(
+                std::chrono::system_clock::now().time_since_epoch()
+            ).count());
+            std::tuple<basic::ByteData, basic::ByteData, uint64_t, int64_t, basic::ByteData const *> t {
+                basic::ByteData {std::string(reinterpret_cast<char const *>(session.sessionID.data()), session.sessionID.size())}
+                , basic::ByteData {std::string(reinterpret_cast<char const *>(session.ephemeralPublicKey.data()), session.ephemeralPublicKey.size())}
+                , ++session.counter
+                , timestamp
+                , &data
+            };
+            auto inner = basic::bytedata_utils::RunCBORSerializerWithNameList<
+                std::tuple<basic::ByteData, basic::ByteData, uint64_t, int64_t, basic::ByteData const *>
+                , 5
+            >::apply(t, {"session", "ephemeral", "counter", "timestamp", "data"});
+            basic::ByteData innerData {std::string(reinterpret_cast<char const *>(inner.data()), inner.size())};
+            auto signedData = (
+                options_.tagWithKeyID
+                ?
+                signer_.signWithKeyID(std::move(innerData))
+                :
+                signer_.sign(std::move(innerData))
+            );
+            std::string ret;
+            ret.reserve(1+signedData.content.length());
+            ret.push_back(HelloTag);
+            ret.append(signedData.content);
+            return basic::ByteData {std::move(ret)};
+        }
+        basic::ByteData withMAC(Session &session, basic::ByteData &&data) {
+            std::string ret;
+            ret.resize(MACHeaderLength);
+            ret.reserve(MACHeaderLength+data.content.length());
+            auto *p = reinterpret_cast<unsigned char *>(ret.data());
+            p[0] = static_cast<unsigned char>(MACTag);
+            std::memcpy(p+1, session.sessionID.data(), SessionIDLength);
+            encodeCounter(++session.counter, p+1+SessionIDLength);
+            computeMAC(
+                *session.key
+                , p+1
+                , reinterpret_cast<unsigned char const *>(data.content.data()), data.content.length()
+                , p+1+SessionIDLength+CounterLength
+            );
+            ret.append(data.content);
+            return basic::ByteData {std::move(ret)};
+        }
+        bool sessionNeedsRenewal(Session const &session, std::chrono::steady_clock::time_point now) const {
+            if (now-session.sessionStart > options_.sessionLifetime) {
+                return true;
+            }
+            if (session.unanswered == 0) {
+                return false;
+            }
+            if (options_.unansweredTimeout.count() > 0 && now-session.firstUnanswered > options_.unansweredTimeout) {
+                return true;
+            }
+            return (options_.maxUnansweredRequests > 0 && session.unanswered >= options_.maxUnansweredRequests);
+        }
+    public:
+        SessionKeyClientImpl(SignatureHelper::PrivateKey const &privateKey, SessionKeyHelper::ClientOptions const &options)
+            : signer_(privateKey), options_(options), mutex_(), sessions_()
+        {
+            initSodium();
+        }
+        ~SessionKeyClientImpl() {}
+        basic::ByteData wrapOutgoing(std::string const &connection, basic::ByteData &&data) {
+            std::lock_guard<std::mutex> _(mutex_);
+            auto &session = sessions_[connection];
+            auto now = std::chrono::steady_clock::now();
+            if (session.key && sessionNeedsRenewal(session, now)) {
+                session.start();
+            }
+            if (session.unanswered++ == 0) {
+                session.firstUnanswered = now;
+            }
+            if (session.key) {
+                return withMAC(session, std::move(data));
+            } else {
+                return hello(session, std::move(data));
+            }
+        }
+        std::optional<basic::ByteData> unwrapIncoming(std::string const &connection, basic::ByteData &&data) {
+            if (data.content.empty()) {
+                return std::nullopt;
+            }
+            if (data.content[0] == PlainTag) {
+                {
+                    std::lock_guard<std::mutex> _(mutex_);
+                    auto iter = sessions_.find(connection);
+                    if (iter != sessions_.end()) {
+                        iter->second.unanswered = 0;
+                    }
+                }
+                data.content.erase(0, 1);
+                return std::move(data);
+            }
+            if (data.content[0] != AckTag || data.content.length() < 2) {
+                return std::nullopt;
+            }
+            auto const *p = reinterpret_cast<unsigned char const *>(data.content.data());
+            std::size_t count = p[1];
+            std::size_t headerLen = 2+count*AckEntryLength;
+            if (data.content.length() < headerLen) {
+                return std::nullopt;
+            }
+            {
+                std::lock_guard<std::mutex> _(mutex_);
+                auto iter = sessions_.find(connection);
+                if (iter != sessions_.end()) {
+                    auto &session = iter->second;
+                    session.unanswered = 0;
+                    if (!session.key) {
+                        for (std::size_t ii=0; ii<count; ++ii) {
+                            auto const *entry = p+2+ii*AckEntryLength;
+                            if (std::memcmp(entry, session.sessionID.data(), SessionIDLength) != 0) {
+                                continue;
+                            }
+                            SessionKey rx, tx;
+                            if (crypto_kx_client_session_keys(
+                                rx.data(), tx.data()
+                                , session.ephemeralPublicKey.data(), session.ephemeralSecretKey.data()
+                                , entry+SessionIDLength
+                            ) == 0) {
+                                session.key = tx;
+                                session.sessionStart = std::chrono::steady_clock::now();
+                            }
+                            break;
+                        }
+                    }
+                }
+            }
+            data.content.erase(0, headerLen);
+            return std::move(data);
+        }
+    };
+
+    SessionKeyHelper::Client::Client() : impl_() {}
+    SessionKeyHelper::Client::Client(SignatureHelper::PrivateKey const &privateKey)
+        : impl_(std::make_unique<SessionKeyClientImpl>(privateKey, SessionKeyHelper::ClientOptions {}))
+        {}
+    SessionKeyHelper::Client::Client(SignatureHelper::PrivateKey const &privateKey, SessionKeyHelper::ClientOptions const &options)
+        : impl_(std::make_unique<SessionKeyClientImpl>(privateKey, options))
+        {}
+    SessionKeyHelper::Client::~Client() {}
+    SessionKeyHelper::Client::Client(SessionKeyHelper::Client &&) = default;
+    SessionKeyHelper::Client &SessionKeyHelper::Client::operator=(SessionKeyHelper::Client &&) = default;
+    basic::ByteData SessionKeyHelper::Client::wrapOutgoing(basic::ByteData &&data) {
+        return wrapOutgoing("", std::move(data));
+    }
+    std::optional<basic::ByteData> SessionKeyHelper::Client::unwrapIncoming(basic::ByteData &&data) {
+        return unwrapIncoming("", std::move(data));
+    }
+    basic::ByteData SessionKeyHelper::Client::wrapOutgoing(std::string const &connection, basic::ByteData &&data) {
+        if (impl_) {
+            return impl_->wrapOutgoing(connection, std::move(data));
+        } else {
+            return std::move(data);
+        }
+    }
+    std::optional<basic::ByteData> SessionKeyHelper::Client::unwrapIncoming(std::string const &connection, basic::ByteData &&data) {
+        if (impl_) {
+            return impl_->unwrapIncoming(connection, std::move(data));
+        } else {
+            return std::move(data);
+        }
+    }
+
+    class SessionKeyServerImpl {
+    private:
+        struct Session {
+            std::string identity;
+            SessionKey key;
+            KXPublicKey clientEphemeralPublicKey;
+            KXPublicKey serverEphemeralPublicKey;
+            bool confirmed;
+            //replay protection: highest counter seen, and a bitmap of
+            //the 64 counters up to and including it
+            uint64_t highestCounter;
+            uint64_t window;
+            std::chrono::steady_clock::time_point lastSeen;
+        };
+
+        SignatureHelper::Verifier verifier_;
+        SessionKeyHelper::ServerOptions options_;
+        std::mutex mutex_;
+        std::unordered_map<std::string, Session> sessions_;
+        //sessions whose key has not been confirmed by a MAC'ed request,
+        //keyed by identity, the replies to that identity carry the acks
+        std::unordered_map<std::string, std::unordered_set<std::string>> pendingAcks_;
+        //MAC'ed requests for sessions this server does not have
+        std::atomic<uint64_t> unknownSessionRequests_;
+        std::chrono::steady_clock::time_point lastUnknownSessionLog_;
+        uint64_t unknownSessionRequestsAtLastLog_;
+
+        //called with mutex_ held, logs at most once every 10 seconds
+        void reportUnknownSession() {
+            auto count = ++unknownSessionRequests_;
+            auto now = std::chrono::steady_clock::now();
+            if (now < lastUnknownSessionLog_+std::chrono::seconds(10) && unknownSessionRequestsAtLastLog_ > 0) {
+                return;
+            }
+            std::cerr << "[SessionKeyHelper::Server] dropped " << (count-unknownSessionRequestsAtLastLog_)
+                << " MAC'ed request(s) for unknown sessions (" << count << " in total), "
+                << "the session may have expired, or the handshake went to another server on the same queue\n";
+            lastUnknownSessionLog_ = now;
+            unknownSessionRequestsAtLastLog_ = count;
+        }
+
+        void pruneIdleSessions(std::chrono::steady_clock::time_point now) {
+            for (auto iter = sessions_.begin(); iter != sessions_.end(); ) {
+                if (now-iter->second.lastSeen > options_.sessionIdleTimeout) {
+                    removePendingAck(iter->second.identity, iter->first);
+                    iter = sessions_.erase(iter);
+                } else {
+                    ++iter;
+                }
+            }
+        }
+        void removePendingAck(std::string const &identity, std::string const &sessionID) {
+            auto iter = pendingAcks_.find(identity);
+            if (iter == pendingAcks_.end()) {
+                return;
+            }
+            iter->second.erase(sessionID);
+            if (iter->second.empty()) {
+                pendingAcks_.erase(iter);
+            }
+        }
+        static bool acceptCounter(Session &session, uint64_t counter) {
+            if (counter == 0) {
+                return false;
+            }
+            if (counter > session.highestCounter) {
+                uint64_t shift = counter-session.highestCounter;
+                session.window = ((shift >= 64)?0:(session.window << shift)) | 1;
+                session.highestCounter = counter;
+                return true;
+            }
+            uint64_t diff = session.highestCounter-counter;
+            if (diff >= 64) {
+                return false;
+            }
+            uint64_t bit = (static_cast<uint64_t>(1) << diff);
+            if ((session.window & bit) != 0) {
+                return false;
+            }
+            session.window |= bit;
+            return true;
+        }
+        std::optional<std::tuple<std::string,basic::ByteData>> handleHello(basic::ByteData &&data) {
+            auto verifyRes = verifier_.verify(basic::ByteDataView {std::string_view(data.content).substr(1)});
+            if (!verifyRes) {
+                return std::nullopt;
+            }
+            auto &identity = std::get<0>(*verifyRes);
+            auto const &inner = std::get<1>(*verifyRes);
+            auto res = basic::bytedata_utils::RunCBORDeserializerWithNameList<
+                std::tuple<basic::ByteData, basic::ByteData, uint64_t, int64_t, basic::ByteData>
+                , 5
+            >::apply(inner.content, 0, {"session", "ephemeral", "counter", "timestamp", "data"});
+            if (!res) {
+                return std::nullopt;
+            }
+            if (std::get<1>(*res) != inner.content.length()) {
+                return std::nullopt;
+            }
+            auto &parsed = std::get<0>(*res);
+            auto const &sessionID = std::get<0>(parsed).content;
+            auto const &clientEphemeral = std::get<1>(parsed).content;
+            auto counter = std::get<2>(parsed);
+            auto timestamp = std::get<3>(parsed);
+            if (sessionID.length() != SessionIDLength || clientEphemeral.length() != crypto_kx_PUBLICKEYBYTES) {
+                return std::nullopt;
+            }
+            //a hello that is replayed while its session is still known is
+            //caught by the counter, and one that is replayed after the
+            //session has been dropped is caught by its age
+            auto age = std::chrono::system_clock::now().time_since_epoch()-std::chrono::milliseconds(timestamp);
+            if (age > options_.helloMaxAge || age < -options_.helloMaxAge) {
+                return std::nullopt;
+            }
+            auto now = std::chrono::steady_clock::now();
+            {
+                std::lock_guard<std::mutex> _(mutex_);
+                auto iter = sessions_.find(sessionID);
+                if (iter != sessions_.end()) {
+                    //a repeated hello (the client may send several before
+                    //the ack comes back) keeps the existing session
+                    if (
+                        iter->second.identity != identity
+                        ||
+                        std::memcmp(iter->second.clientEphemeralPublicKey.data(), clientEphemeral.data(), crypto_kx_PUBLICKEYBYTES) != 0
+                        ||
+                        !acceptCounter(iter->second, counter)
+                    ) {
+                        return std::nullopt;
+                    }
+                    iter->second.lastSeen = now;
+                } else {
+                    pruneIdleSessions(now);
+                    Session session;
+                    session.identity = identity;
+                    std::memcpy(session.clientEphemeralPublicKey.data(), clientEphemeral.data(), crypto_kx_PUBLICKEYBYTES);
+                    KXSecretKey serverEphemeralSecretKey;
+                    crypto_kx_keypair(session.serverEphemeralPublicKey.data(), serverEphemeralSecretKey.data());
+                    SessionKey tx;
+                    int kxRes = crypto_kx_server_session_keys(
+                        session.key.data(), tx.data()
+                        , session.serverEphemeralPublicKey.data(), serverEphemeralSecretKey.data()
+                        , session.clientEphemeralPublicKey.data()
+                    );
+                    sodium_memzero(serverEphemeralSecretKey.data(), serverEphemeralSecretKey.size());
+                    if (kxRes != 0) {
+                        return std::nullopt;
+                    }
+                    session.confirmed = false;
+                    session.highestCounter = 0;
+                    session.window = 0;
+                    session.lastSeen = now;
+                    if (!acceptCounter(session, counter)) {
+                        return std::nullopt;
+                    }
+                    sessions_.insert({sessionID, std::move(session)});
+                    pendingAcks_[identity].insert(sessionID);
+                }
+            }
+            return std::tuple<std::string,basic::ByteData> {std::move(identity), std::move(std::get<2>(parsed))};
+        }
+        std::optional<std::tuple<std::string,basic::ByteData>> handleMAC(basic::ByteData &&data) {
+            if (data.content.length() < MACHeaderLength) {
+                return std::nullopt;
+            }
+            auto const *p = reinterpret_cast<unsigned char const *>(data.content.data());
+            std::string identity;
+            {
+                std::lock_guard<std::mutex> _(mutex_);
+                auto iter = sessions_.find(data.content.substr(1, SessionIDLength));
+                if (iter == sessions_.end()) {
+                    reportUnknownSession();
+                    return std::nullopt;
+                }
+                auto &session = iter->second;
+                std::array<unsigned char, MACLength> mac;
+                computeMAC(
+                    session.key
+                    , p+1
+                    , p+MACHeaderLength, data.content.length()-MACHeaderLength
+                    , mac.data()
+                );
+                if (sodium_memcmp(mac.data(), p+1+SessionIDLength+CounterLength, MACLength) != 0) {
+                    return std::nullopt;
+                }
+                if (!acceptCounter(session, decodeCounter(p+1+SessionIDLength))) {
+                    return std::nullopt;
+                }
+                if (!session.confirmed) {
+                    session.confirmed = true;
+                    removePendingAck(session.identity, iter->first);
+                }
+                session.lastSeen = std::chrono::steady_clock::now();
+                identity = session.identity;
+            }
+            data.content.erase(0, MACHeaderLength);
+            return std::tuple<std::string,basic::ByteData> {std::move(identity), std::move(data)};
+        }
+    public:
+        SessionKeyServerImpl(SessionKeyHelper::ServerOptions const &options)
+            : verifier_(), options_(options), mutex_(), sessions_(), pendingAcks_()
+            , unknownSessionRequests_(0), lastUnknownSessionLog_(), unknownSessionRequestsAtLastLog_(0)
+        {
+            initSodium();
+        }
+        ~SessionKeyServerImpl() {}
+        void addKey(std::string const &name, SignatureHelper::PublicKey const &publicKey) {
+            verifier_.addKey(name, publicKey);
+        }
+        void addKeys(SignatureHelper::PublicKeyMap const &keys) {
+            verifier_.addKeys(keys);
+        }
+        std::optional<std::tuple<std::string,basic::ByteData>> unwrapIncoming(basic::ByteData &&data) {
+            if (data.content.empty()) {
+                return std::nullopt;
+            }
+            switch (data.content[0]) {
+            case HelloTag:
+                return handleHello(std::move(data));
+            case MACTag:
+                return handleMAC(std::move(data));
+            default:
+                return std::nullopt;
+            }
+        }
+        uint64_t unknownSessionRequests() const {
+            return unknownSessionRequests_.load();
+        }
+        basic::ByteData wrapOutgoing(std::string const &identity, basic::ByteData &&data) {
+            std::string ret;
+            {
+                std::lock_guard<std::mutex> _(mutex_);
+                auto iter = pendingAcks_.find(identity);
+                if (iter != pendingAcks_.end()) {
+                    std::size_t count = std::min<std::size_t>(iter->second.size(), 255);
+                    ret.reserve(2+count*AckEntryLength+data.content.length());
+                    ret.push_back(AckTag);
+                    ret.push_back(static_cast<char>(count));
+                    std::size_t ii = 0;
+                    for (auto const &sessionID : iter->second) {
+                        if (ii++ >= count) {
+                            break;
+                        }
+                        auto const &session = sessions_.at(sessionID);
+                        ret.append(sessionID);
+                        ret.append(reinterpret_cast<char const *>(session.serverEphemeralPublicKey.data()), session.serverEphemeralPublicKey.size());
+                    }
+                }
+            }
+            if (ret.empty()) {
+                ret.reserve(1+data.content.length());
+                ret.push_back(PlainTag);
+            }
+            ret.append(data.content);
+            return basic::ByteData {std::move(ret)};
+        }
+    };
+
+    SessionKeyHelper::Server::Server()
+        : impl_(std::make_unique<SessionKeyServerImpl>(SessionKeyHelper::ServerOptions {}))
+        {}
+    SessionKeyHelper::Server::Server(SessionKeyHelper::ServerOptions const &options)
+        : impl_(std::make_unique<SessionKeyServerImpl>(options))
+        {}
+    SessionKeyHelper::Server::~Server() {}
+    SessionKeyHelper::Server::Server(SessionKeyHelper::Server &&) = default;
+    SessionKeyHelper::Server &SessionKeyHelper::Server::operator=(SessionKeyHelper::Server &&) = default;
+    void SessionKeyHelper::Server::addKey(std::string const &name, SignatureHelper::PublicKey const &publicKey) {
+        impl_->addKey(name, publicKey);
+    }
+    void SessionKeyHelper::Server::addKeys(SignatureHelper::PublicKeyMap const &keys) {
+        impl_->addKeys(keys);
+    }
+    std::optional<std::tuple<std::string,basic::ByteData>> SessionKeyHelper::Server::unwrapIncoming(basic::ByteData &&data) {
+        return impl_->unwrapIncoming(std::move(data));
+    }
+    basic::ByteData SessionKeyHelper::Server::wrapOutgoing(std::string const &identity, basic::ByteData &&data) {
+        return impl_->wrapOutgoing(identity, std::move(data));
+    }
+    uint64_t SessionKeyHelper::Server::unknownSessionRequests() const {
+        return impl_->unknownSessionRequests();
+    }
+} } } } }
@@ -1,16 +1,45 @@
 #include <mutex>
+#include <atomic>
 #include <cstring>
+#include <stdexcept>
 #include <unordered_map>
 
 #include <tm_kit/transport/security/SignatureHelper.hpp>
 
+#include <sodium/crypto_generichash.h>
+
 namespace dev { namespace cd606 { namespace tm { namespace transport { namespace security {
+    namespace {
+        inline std::string keyIDString(SignatureHelper::KeyID const &keyID) {
+            return std::string(reinterpret_cast<char const *>(keyID.data()), keyID.size());
+        }
+    }
+
+    SignatureHelper::KeyID SignatureHelper::keyIDForPublicKey(SignatureHelper::PublicKey const &publicKey) {
+        static_assert(SignatureHelper::KeyIDLength >= crypto_generichash_BYTES_MIN && SignatureHelper::KeyIDLength <= crypto_generichash_BYTES_MAX);
+        SignatureHelper::KeyID ret;
+        if (crypto_generichash(
+            ret.data(), ret.size()
+            , publicKey.data(), publicKey.size()
+            , nullptr, 0
+        ) != 0) {
+            throw std::runtime_error("SignatureHelper: cannot compute the key ID of a public key");
+        }
+        return ret;
+    }
+
     class SignerImpl {
     private:
         std::array<unsigned char, crypto_sign_SECRETKEYBYTES> privateKey_;
+        std::string keyID_;
     public:
         SignerImpl(std::array<unsigned char, crypto_sign_SECRETKEYBYTES> const &privateKey) : 
-            privateKey_(privateKey) {}
+            privateKey_(privateKey), keyID_() 
+        {
+            SignatureHelper::PublicKey publicKey;
+            crypto_sign_ed25519_sk_to_pk(publicKey.data(), privateKey_.data());
+            keyID_ = keyIDString(SignatureHelper::keyIDForPublicKey(publicKey));
+        }
         ~SignerImpl() {}
         basic::ByteData sign(basic::ByteData &&data) {       
             std::array<unsigned char, crypto_sign_BYTES> signature;
@@ -44,6 +73,22 @@ namespace dev { namespace cd606 { namespace tm { namespace transport { namespace
             >::apply(t, {"name", "signature", "data"});
             return basic::ByteData {std::string(reinterpret_cast<char const *>(res.data()), res.size())};
         }
+        basic::ByteData signWithKeyID(basic::ByteData &&data) {       
+            std::array<unsigned char, crypto_sign_BYTES> signature;
+            crypto_sign_detached(
+                signature.data()
+                , 0
+                , reinterpret_cast<unsigned char const *>(data.content.c_str())
+                , data.content.length()
+                , privateKey_.data()
+            );
+            std::tuple<basic::ByteData, basic::ByteData, basic::ByteData const *> t {basic::ByteData {keyID_}, basic::ByteData {std::string(reinterpret_cast<char const *>(signature.data()), signature.size())}, &data};
+            auto res = basic::bytedata_utils::RunCBORSerializerWithNameList<
+                std::tuple<basic::ByteData, basic::ByteData, basic::ByteData const *>
+                , 3
+            >::apply(t, {"key", "signature", "data"});
+            return basic::ByteData {std::string(reinterpret_cast<char const *>(res.data()), res.size())};
+        }
     };
     
     SignatureHelper::Signer::Signer() : impl_() {}
@@ -67,19 +112,77 @@ namespace dev { namespace cd606 { namespace tm { namespace transport { namespace
             return std::move(data);
         }
     }
+    basic::ByteData SignatureHelper::Signer::signWithKeyID(basic::ByteData &&data) {
+        if (impl_) {
+            return impl_->signWithKeyID(std::move(data));
+        } else {
+            return std::move(data);
+        }
+    }
 
     class VerifierImpl {
     private:
-        std::unordered_map<std::string, std::array<unsigned char, crypto_sign_PUBLICKEYBYTES>> publicKeys_;
-        std::mutex mutex_;
-    public:
-        VerifierImpl() : publicKeys_(), mutex_() {}
-        ~VerifierImpl() {}
-        void addKey(std::string const &name, std::array<unsigned char, crypto_sign_PUBLICKEYBYTES> const &publicKey) {
-            std::lock_guard<std::mutex> _(mutex_);
-            publicKeys_.insert({name, publicKey});
+        using PublicKey = std::array<unsigned char, crypto_sign_PUBLICKEYBYTES>;
+        //The key set is read on every verification and written only when 
+        //keys are added, so the readers take an immutable snapshot and the 
+        //writers copy-and-swap it under the writer mutex
+        struct KeySet {
+            std::unordered_map<std::string, PublicKey> byName;
+            std::unordered_map<std::string, std::vector<std::tuple<std::string, PublicKey>>> byKeyID;
+        };
+        std::shared_ptr<KeySet const> keySet_;
+        std::mutex writerMutex_;
+
+        std::shared_ptr<KeySet const> snapshot() const {
+            return std::atomic_load_explicit(&keySet_, std::memory_order_acquire);
         }
-        std::optional<std::tuple<std::string,basic::ByteData>> verify(basic::ByteDataView const &data) {       
+        static void addKeyToSet(KeySet &keySet, std::string const &name, PublicKey const &publicKey) {
+            if (keySet.byName.insert({name, publicKey}).second) {
+                keySet.byKeyID[keyIDString(SignatureHelper::keyIDForPublicKey(publicKey))].push_back({name, publicKey});
+            }
+        }
+        static bool isKeyedEnvelope(basic::ByteDataView const &data) {
+            //the keyed envelope is a 3-entry CBOR map while the plain 
+            //envelope is a 2-entry CBOR map, so the first byte tells 
+            //them apart
+            return (!data.content.empty() && static_cast<unsigned char>(data.content[0]) == 0xA3);
+        }
+        static std::optional<std::tuple<std::string,basic::ByteData>> verifyKeyed(KeySet const &keySet, basic::ByteDataView const &data) {
+            auto res = basic::bytedata_utils::RunCBORDeserializerWithNameList<
+                std::tuple<basic::ByteData, basic::ByteData, basic::ByteData>
+                , 3
+            >::apply(data.content, 0, {"key", "signature", "data"});
+            if (!res) {
+                return std::nullopt;
+            }
+            if (std::get<1>(*res) != data.content.length()) {
+                return std::nullopt;
+            }
+            auto &dataWithKeyAndSignature = std::get<0>(*res);
+            auto const &keyID = std::get<0>(dataWithKeyAndSignature);
+            auto const &signature = std::get<1>(dataWithKeyAndSignature);
+            auto &signedData = std::get<2>(dataWithKeyAndSignature);
+            if (signature.content.length() != crypto_sign_BYTES) {
+                return std::nullopt;
+            }
+            auto iter = keySet.byKeyID.find(keyID.content);
+            if (iter == keySet.byKeyID.end()) {
+                return std::nullopt;
+            }
+
+            auto const *p = reinterpret_cast<const unsigned char *>(signedData.content.c_str());
+            auto const *q = reinterpret_cast<const unsigned char *>(signature.content.c_str());
+            std::size_t l = signedData.content.length();
+            //there is normally only one candidate, more than one only
+            //happens on a key ID collision
+            for (auto const &item : iter->second) {
+                if (crypto_sign_verify_detached(q, p, l, std::get<1>(item).data()) == 0) {
+                    return std::tuple<std::string, basic::ByteData> {std::get<0>(item), std::move(signedData)};
+                }
+            }
+            return std::nullopt;
+        }
+        static std::optional<std::tuple<std::string,basic::ByteData>> verifyPlain(KeySet const &keySet, basic::ByteDataView const &data) {
             auto res = basic::bytedata_utils::RunCBORDeserializerWithNameList<
                 std::tuple<basic::ByteData, basic::ByteData>
                 , 2
@@ -90,39 +193,60 @@ namespace dev { namespace cd606 { namespace tm { namespace transport { namespace
             if (std::get<1>(*res) != data.content.length()) {
                 return std::nullopt;
             }
-            auto const &dataWithSignature = std::get<0>(*res);
+            auto &dataWithSignature = std::get<0>(*res);
             auto const &signature = std::get<0>(dataWithSignature);
             auto &signedData = std::get<1>(dataWithSignature);
             if (signature.content.length() != crypto_sign_BYTES) {
                 return std::nullopt;
             }
 
-            bool result = false;
-            
             auto const *p = reinterpret_cast<const unsigned char *>(signedData.content.c_str());
             auto const *q = reinterpret_cast<const unsigned char *>(signature.content.c_str());
             std::size_t l = signedData.content.length();
-            std::string name;
-            {
-                std::lock_guard<std::mutex> _(mutex_);
-                for (auto const &item : publicKeys_) {
-                    result = 
-                        result ||
-                        (
-                            crypto_sign_verify_detached(q, p, l, item.second.data()) == 0
-                        );
-                    if (result) {
-                        name = item.first;
-                        break;
-                    }
+            for (auto const &item : keySet.byName) {
+                if (crypto_sign_verify_detached(q, p, l, item.second.data()) == 0) {
+                    return std::tuple<std::string, basic::ByteData> {item.first, std::move(signedData)};
                 }
             }
-            if (result) {
-                return std::tuple<std::string, basic::ByteData> {std::move(name), std::move(signedData)};
+            return std::nullopt;
+        }
+        static std::optional<std::tuple<std::string,basic::ByteData>> verifyWithKeySet(KeySet const &keySet, basic::ByteDataView const &data) {
+            if (isKeyedEnvelope(data)) {
+                return verifyKeyed(keySet, data);
             } else {
-                return std::nullopt;
+                return verifyPlain(keySet, data);
             }
         }
+    public:
+        VerifierImpl() : keySet_(std::make_shared<KeySet const>()), writerMutex_() {}
+        ~VerifierImpl() {}
+        void addKey(std::string const &name, PublicKey const &publicKey) {
+            std::lock_guard<std::mutex> _(writerMutex_);
+            auto newSet = std::make_shared<KeySet>(*snapshot());
+            addKeyToSet(*newSet, name, publicKey);
+            std::atomic_store_explicit(&keySet_, std::shared_ptr<KeySet const>(std::move(newSet)), std::memory_order_release);
+        }
+        void addKeys(SignatureHelper::PublicKeyMap const &keys) {
+            std::lock_guard<std::mutex> _(writerMutex_);
+            auto newSet = std::make_shared<KeySet>(*snapshot());
+            for (auto const &k : keys) {
+                addKeyToSet(*newSet, k.first, k.second);
+            }
+            std::atomic_store_explicit(&keySet_, std::shared_ptr<KeySet const>(std::move(newSet)), std::memory_order_release);
+        }
+        std::optional<std::tuple<std::string,basic::ByteData>> verify(basic::ByteDataView const &data) {       
+            auto keySet = snapshot();
+            return verifyWithKeySet(*keySet, data);
+        }
+        std::vector<std::optional<std::tuple<std::string,basic::ByteData>>> verifyBatch(std::vector<basic::ByteDataView> const &data) {
+            auto keySet = snapshot();
+            std::vector<std::optional<std::tuple<std::string,basic::ByteData>>> ret;
+            ret.reserve(data.size());
+            for (auto const &d : data) {
+                ret.push_back(verifyWithKeySet(*keySet, d));
+            }
+            return ret;
+        }
         std::optional<basic::ByteData> verifyDataTaggedWithName(basic::ByteDataView const &data) {       
             auto res = basic::bytedata_utils::RunCBORDeserializerWithNameList<
                 std::tuple<std::string, basic::ByteData, basic::ByteData>
@@ -134,7 +258,7 @@ namespace dev { namespace cd606 { namespace tm { namespace transport { namespace
             if (std::get<1>(*res) != data.content.length()) {
                 return std::nullopt;
             }
-            auto const &dataWithNameAndSignature = std::get<0>(*res);
+            auto &dataWithNameAndSignature = std::get<0>(*res);
             auto const &name = std::get<0>(dataWithNameAndSignature);
             auto const &signature = std::get<1>(dataWithNameAndSignature);
             auto &signedData = std::get<2>(dataWithNameAndSignature);
@@ -142,19 +266,15 @@ namespace dev { namespace cd606 { namespace tm { namespace transport { namespace
                 return std::nullopt;
             }
 
+            auto keySet = snapshot();
+            auto iter = keySet->byName.find(name);
+            if (iter == keySet->byName.end()) {
+                return std::nullopt;
+            }
             auto const *p = reinterpret_cast<const unsigned char *>(signedData.content.c_str());
             auto const *q = reinterpret_cast<const unsigned char *>(signature.content.c_str());
             std::size_t l = signedData.content.length();
-            bool result = false;
-            {
-                std::lock_guard<std::mutex> _(mutex_);
-                auto iter = publicKeys_.find(name);
-                if (iter == publicKeys_.end()) {
-                    return std::nullopt;
-                }
-                result = (crypto_sign_verify_detached(q, p, l, iter->second.data()) == 0);
-            }
-            if (result) {
+            if (crypto_sign_verify_detached(q, p, l, iter->second.data()) == 0) {
                 return std::move(signedData);
             } else {
                 return std::nullopt;
@@ -170,9 +290,7 @@ namespace dev { namespace cd606 { namespace tm { namespace transport { namespace
         impl_->addKey(name,publicKey);
     }
     void SignatureHelper::Verifier::addKeys(SignatureHelper::PublicKeyMap const &keys) {
-        for (auto const &k : keys) {
-            impl_->addKey(k.first, k.second);
-        }
+        impl_->addKeys(keys);
     }
     std::optional<std::tuple<std::string,basic::ByteData>> SignatureHelper::Verifier::verify(basic::ByteDataView const &data) {
         return impl_->verify(data);
@@ -180,6 +298,9 @@ namespace dev { namespace cd606 { namespace tm { namespace transport { namespace
     std::optional<basic::ByteData> SignatureHelper::Verifier::verifyDataTaggedWithName(basic::ByteDataView const &data) {
         return impl_->verifyDataTaggedWithName(data);
     }
+    std::vector<std::optional<std::tuple<std::string,basic::ByteData>>> SignatureHelper::Verifier::verifyBatch(std::vector<basic::ByteDataView> const &data) {
+        return impl_->verifyBatch(data);
+    }
 } } } } }
 
 
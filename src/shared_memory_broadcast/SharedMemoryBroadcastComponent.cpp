@@ -19,6 +19,8 @@
 #include <boost/date_time/posix_time/posix_time.hpp>
 
 #include <tm_kit/transport/shared_memory_broadcast/SharedMemoryBroadcastComponent.hpp>
+#include <tm_kit/transport/TransportThreading.hpp>
+#include <tm_kit/transport/SharedMemorySegment.hpp>
 
 namespace dev { namespace cd606 { namespace tm { namespace transport { namespace shared_memory_broadcast {
         
@@ -61,7 +63,9 @@ namespace dev { namespace cd606 { namespace tm { namespace transport { namespace
 #else
             boost::interprocess::managed_shared_memory mem_;
 #endif
+            SharedMemorySegmentLayout segmentLayout_;
             bool busyLoop_;
+            TransportThreadingConfig threading_;
             ConnectionLocator locator_;
             std::string recordIDInSharedMem_;
             SharedMemoryBroadcastClientListItem *clientListHead_;
@@ -128,6 +132,7 @@ namespace dev { namespace cd606 { namespace tm { namespace transport { namespace
                 }
             }
             void run() {
+                threading_.applyToCurrentThread(locator_.toPrintFormat());
                 std::size_t dataSize = 0;
                 char *data = nullptr;
                 boost::interprocess::interprocess_mutex m;
@@ -209,14 +214,16 @@ namespace dev { namespace cd606 { namespace tm { namespace transport { namespace
                 }
             }
         public:
-            OneSharedMemoryBroadcastSubscription(ConnectionLocator const &locator, std::size_t memSize, bool busyLoop) 
+            OneSharedMemoryBroadcastSubscription(ConnectionLocator const &locator, std::size_t memSize, TransportThreadingConfig const &threading, SharedMemorySegmentOptions const &segmentOptions) 
                 : 
                     mem_(
                         boost::interprocess::open_or_create
                         , locator.identifier().c_str()
                         , memSize
                     )
-                    , busyLoop_(busyLoop)
+                    , segmentLayout_(prepareSharedMemorySegment(mem_.get_address(), mem_.get_size(), segmentOptions))
+                    , busyLoop_(threading.busyLoop)
+                    , threading_(threading)
                     , locator_(locator)
                     , recordIDInSharedMem_(boost::lexical_cast<std::string>(boost::uuids::random_generator()()))
                     , clientListHead_(
@@ -374,6 +381,9 @@ namespace dev { namespace cd606 { namespace tm { namespace transport { namespace
             std::thread::native_handle_type getThreadHandle() {
                 return th_.native_handle();
             }
+            SharedMemorySegmentLayout const &segmentLayout() const {
+                return segmentLayout_;
+            }
         };
         std::unordered_map<ConnectionLocator, std::unique_ptr<OneSharedMemoryBroadcastSubscription>> subscriptions_;
         
@@ -384,6 +394,7 @@ namespace dev { namespace cd606 { namespace tm { namespace transport { namespace
 #else
             boost::interprocess::managed_shared_memory mem_;
 #endif
+            SharedMemorySegmentLayout segmentLayout_;
             ConnectionLocator locator_;
             SharedMemoryBroadcastClientListItem *clientListHead_;
 
@@ -420,13 +431,14 @@ namespace dev { namespace cd606 { namespace tm { namespace transport { namespace
                 }
             }
         public:
-            OneSharedMemoryBroadcastSender(ConnectionLocator const &locator, std::size_t memSize)
+            OneSharedMemoryBroadcastSender(ConnectionLocator const &locator, std::size_t memSize, SharedMemorySegmentOptions const &segmentOptions)
                 : 
                     mem_(
                         boost::interprocess::open_or_create
                         , locator.identifier().c_str()
                         , memSize
                     )
+                    , segmentLayout_(prepareSharedMemorySegment(mem_.get_address(), mem_.get_size(), segmentOptions))
                     , locator_(locator)
                     , clientListHead_(
                         mem_.find_or_construct<SharedMemoryBroadcastClientListItem>
@@ -436,6 +448,9 @@ namespace dev { namespace cd606 { namespace tm { namespace transport { namespace
             }
             ~OneSharedMemoryBroadcastSender() {
             }
+            SharedMemorySegmentLayout const &segmentLayout() const {
+                return segmentLayout_;
+            }
             void publish(basic::ByteDataWithTopic &&data) {
                 auto *p = clientListHead_;
                 if (p->next.load() == 0) {
@@ -574,8 +589,7 @@ namespace dev { namespace cd606 { namespace tm { namespace transport { namespace
             auto iter = subscriptions_.find(idOnly);
             if (iter == subscriptions_.end()) {
                 auto memSize = std::stoul(d.query("size", std::to_string(4*1024*1024*1024UL)));
-                bool busyLoop = (d.query("busyLoop", "false") == "true");
-                iter = subscriptions_.insert({idOnly, std::make_unique<OneSharedMemoryBroadcastSubscription>(idOnly, memSize, busyLoop)}).first;
+                iter = subscriptions_.insert({idOnly, std::make_unique<OneSharedMemoryBroadcastSubscription>(idOnly, memSize, TransportThreadingConfig::fromLocator(d), SharedMemorySegmentOptions::fromLocator(d))}).first;
             }
             return iter->second.get();
         }
@@ -591,7 +605,7 @@ namespace dev { namespace cd606 { namespace tm { namespace transport { namespace
             auto iter = senders_.find(idOnly);
             if (iter == senders_.end()) {
                 auto memSize = std::stoul(d.query("size", std::to_string(4*1024*1024*1024UL)));
-                iter = senders_.insert({idOnly, std::make_unique<OneSharedMemoryBroadcastSender>(idOnly, memSize)}).first;
+                iter = senders_.insert({idOnly, std::make_unique<OneSharedMemoryBroadcastSender>(idOnly, memSize, SharedMemorySegmentOptions::fromLocator(d))}).first;
             }
             return iter->second.get();
         }
@@ -640,8 +654,11 @@ namespace dev { namespace cd606 { namespace tm { namespace transport { namespace
             if (userToWireHook) {
                 auto hook = userToWireHook->hook;
                 return [p,hook](basic::ByteDataWithTopic &&data) {
-                    auto w = hook(basic::ByteData {std::move(data.content)});
-                    p->publish({std::move(data.topic), std::move(w.content)});
+                    auto w = byte_data_hook_utils::tryUserToWireHook(hook, basic::ByteData {std::move(data.content)});
+                    if (!w) {
+                        return;
+                    }
+                    p->publish({std::move(data.topic), std::move(w->content)});
                 };
             } else {
                 return [p](basic::ByteDataWithTopic &&data) {
@@ -657,6 +674,22 @@ namespace dev { namespace cd606 { namespace tm { namespace transport { namespace
             }
             return retVal;
         }
+        std::unordered_map<ConnectionLocator, SharedMemorySegmentLayout> subscriptionSegmentLayouts() {
+            std::unordered_map<ConnectionLocator, SharedMemorySegmentLayout> retVal;
+            std::lock_guard<std::mutex> _(mutex_);
+            for (auto &item : subscriptions_) {
+                retVal[item.first] = item.second->segmentLayout();
+            }
+            return retVal;
+        }
+        std::unordered_map<ConnectionLocator, SharedMemorySegmentLayout> publisherSegmentLayouts() {
+            std::unordered_map<ConnectionLocator, SharedMemorySegmentLayout> retVal;
+            std::lock_guard<std::mutex> _(mutex_);
+            for (auto &item : senders_) {
+                retVal[item.first] = item.second->segmentLayout();
+            }
+            return retVal;
+        }
     };
 
     SharedMemoryBroadcastComponent::SharedMemoryBroadcastComponent() : impl_(std::make_unique<SharedMemoryBroadcastComponentImpl>()) {}
@@ -682,4 +715,10 @@ namespace dev { namespace cd606 { namespace tm { namespace transport { namespace
     std::unordered_map<ConnectionLocator, std::thread::native_handle_type> SharedMemoryBroadcastComponent::shared_memory_broadcast_threadHandles() {
         return impl_->threadHandles();
     }
+    std::unordered_map<ConnectionLocator, SharedMemorySegmentLayout> SharedMemoryBroadcastComponent::shared_memory_broadcast_subscriptionSegmentLayouts() {
+        return impl_->subscriptionSegmentLayouts();
+    }
+    std::unordered_map<ConnectionLocator, SharedMemorySegmentLayout> SharedMemoryBroadcastComponent::shared_memory_broadcast_publisherSegmentLayouts() {
+        return impl_->publisherSegmentLayouts();
+    }
 } } } } }
\ No newline at end of file
@@ -6,6 +6,7 @@
 #include <boost/bind/bind.hpp>
 
 #include <tm_kit/transport/singlecast/SinglecastComponent.hpp>
+#include <tm_kit/transport/TransportThreading.hpp>
 
 namespace dev { namespace cd606 { namespace tm { namespace transport { namespace singlecast {
     
@@ -28,6 +29,9 @@ namespace dev { namespace cd606 { namespace tm { namespace transport { namespace
         private:
             SinglecastComponentTopicEncodingChoice encodingChoice_;
             ConnectionLocator locator_;
+            //owned here and declared before the socket, so that the socket
+            //goes away first
+            std::unique_ptr<boost::asio::io_service> service_;
             boost::asio::ip::udp::socket sock_;
             boost::asio::ip::udp::endpoint senderPoint_;
             std::array<char, 16*1024*1024> buffer_;
@@ -43,6 +47,7 @@ namespace dev { namespace cd606 { namespace tm { namespace transport { namespace
             std::mutex mutex_;
 
             std::atomic<bool> running_;
+            std::thread th_;
 
             inline void callClient(ClientCB const &c, basic::ByteDataWithTopic &&d) {
                 if (c.hook) {
@@ -114,19 +119,20 @@ namespace dev { namespace cd606 { namespace tm { namespace transport { namespace
                 }
             }
         public:
-            OneSinglecastSubscription(SinglecastComponentTopicEncodingChoice encodingChoice, boost::asio::io_service *service, ConnectionLocator const &locator) 
-                : encodingChoice_(encodingChoice), locator_(locator), sock_(*service), senderPoint_(), buffer_()
+            OneSinglecastSubscription(SinglecastComponentTopicEncodingChoice encodingChoice, ConnectionLocator const &locator, TransportThreadingConfig const &threading) 
+                : encodingChoice_(encodingChoice), locator_(locator), service_(std::make_unique<boost::asio::io_service>()), sock_(*service_), senderPoint_(), buffer_()
                 , noFilterClients_(), stringMatchClients_(), regexMatchClients_()
                 , thHandle_()
-                , mutex_(), running_(true)
+                , mutex_(), running_(true), th_()
             {
-                boost::asio::ip::udp::resolver resolver(*service);
+                boost::asio::ip::udp::resolver resolver(*service_);
 
                 {
                     boost::asio::ip::udp::resolver::query query("0.0.0.0", std::to_string(locator.port()));
                     boost::asio::ip::udp::endpoint listenPoint = resolver.resolve(query)->endpoint();
                     sock_.open(listenPoint.protocol());
                     sock_.set_option(boost::asio::ip::udp::socket::receive_buffer_size(16*1024*1024));
+                    threading.applyToSocket(static_cast<std::intptr_t>(sock_.native_handle()), locator.toPrintFormat());
                     sock_.bind(listenPoint);
                 }
 
@@ -138,11 +144,38 @@ namespace dev { namespace cd606 { namespace tm { namespace transport { namespace
                                 , boost::asio::placeholders::error
                                 , boost::asio::placeholders::bytes_transferred)
                 );
+
+                th_ = std::thread([this,threading]() {
+                    threading.applyToCurrentThread(locator_.toPrintFormat());
+                    boost::asio::io_service::work work(*service_);
+                    if (threading.busyLoop) {
+                        while (running_) {
+                            service_->poll();
+                        }
+                    } else {
+                        service_->run();
+                    }
+                });
+                thHandle_ = th_.native_handle();
             }
+            //must not be called on the subscription's own thread, see
+            //isOnOwnThread
             ~OneSinglecastSubscription() {
+                //the thread is stopped and joined before the socket is
+                //closed, so no handler runs on this object afterwards
                 running_ = false;
+                service_->stop();
+                try {
+                    if (th_.joinable()) {
+                        th_.join();
+                    }
+                } catch (std::system_error const &) {
+                }
                 sock_.close();
             }
+            bool isOnOwnThread() const {
+                return (std::this_thread::get_id() == th_.get_id());
+            }
             ConnectionLocator const &locator() const {
                 return locator_;
             }
@@ -206,10 +239,6 @@ namespace dev { namespace cd606 { namespace tm { namespace transport { namespace
                     return false;
                 }
             }
-            void setThreadHandle(std::thread::native_handle_type h) {
-                std::lock_guard<std::mutex> _(mutex_);
-                thHandle_ = h;
-            }
             std::optional<std::thread::native_handle_type> getThreadHandle() {
                 std::lock_guard<std::mutex> _(mutex_);
                 return thHandle_;
@@ -275,21 +304,27 @@ namespace dev { namespace cd606 { namespace tm { namespace transport { namespace
             auto iter = subscriptions_.find(hostAndPort);
             if (iter == subscriptions_.end()) {
                 auto choice = parseEncodingChoice(d.query("envelop", "cbor"));
-                std::unique_ptr<boost::asio::io_service> svc = std::make_unique<boost::asio::io_service>();
-                iter = subscriptions_.insert({hostAndPort, std::make_unique<OneSinglecastSubscription>(choice, svc.get(), hostAndPort)}).first;
-                std::thread th([svc=std::move(svc)] {
-                    boost::asio::io_service::work work(*svc);
-                    svc->run();
-                });
-                th.detach();
-                iter->second->setThreadHandle(th.native_handle());
+                iter = subscriptions_.insert({hostAndPort, std::make_unique<OneSinglecastSubscription>(choice, hostAndPort, TransportThreadingConfig::fromLocator(d))}).first;
             }
             return iter->second.get();
         }
+        //the subscription is destroyed without holding mutex_, since that
+        //waits for its thread, and if this is called on that thread (by a
+        //client removing itself), on another thread
         void potentiallyStopSubscription(OneSinglecastSubscription *p) {
-            std::lock_guard<std::mutex> _(mutex_);
-            if (p->checkWhetherNeedsToStop()) {
-                subscriptions_.erase(p->locator());
+            std::unique_ptr<OneSinglecastSubscription> toStop;
+            {
+                std::lock_guard<std::mutex> _(mutex_);
+                if (p->checkWhetherNeedsToStop()) {
+                    auto iter = subscriptions_.find(p->locator());
+                    if (iter != subscriptions_.end()) {
+                        toStop = std::move(iter->second);
+                        subscriptions_.erase(iter);
+                    }
+                }
+            }
+            if (toStop && toStop->isOnOwnThread()) {
+                std::thread([toStop=std::move(toStop)]() {}).detach();
             }
         }
         OneSinglecastSender *getOrStartSender(ConnectionLocator const &d) {
@@ -317,12 +352,14 @@ namespace dev { namespace cd606 { namespace tm { namespace transport { namespace
         }
         ~SinglecastComponentImpl() {
             bool b;
+            decltype(subscriptions_) subscriptions;
             {
                 std::lock_guard<std::mutex> _(mutex_);
-                subscriptions_.clear();
+                std::swap(subscriptions, subscriptions_);
                 senders_.clear();
                 b = senderThreadStarted_;
             }
+            subscriptions.clear();
             if (b) {
                 senderService_.stop();
                 try {
@@ -365,8 +402,11 @@ namespace dev { namespace cd606 { namespace tm { namespace transport { namespace
             if (userToWireHook) {
                 auto hook = userToWireHook->hook;
                 return [p,hook](basic::ByteDataWithTopic &&data) {
-                    auto w = hook(basic::ByteData {std::move(data.content)});
-                    p->publish({std::move(data.topic), std::move(w.content)});
+                    auto w = byte_data_hook_utils::tryUserToWireHook(hook, basic::ByteData {std::move(data.content)});
+                    if (!w) {
+                        return;
+                    }
+                    p->publish({std::move(data.topic), std::move(w->content)});
                 };
             } else {
                 return [p](basic::ByteDataWithTopic &&data) {
@@ -7,6 +7,8 @@
 #include <boost/endian/conversion.hpp>
 
 #include <tm_kit/transport/socket_rpc/SocketRPCComponent.hpp>
+#include <tm_kit/transport/TransportThreading.hpp>
+#include <tm_kit/transport/TransportMetricsComponent.hpp>
 
 namespace dev { namespace cd606 { namespace tm { namespace transport { namespace socket_rpc {
 
@@ -188,6 +190,7 @@ namespace dev { namespace cd606 { namespace tm { namespace transport { namespace
                 remotePoint_ = resolver.resolve(query)->endpoint();
                 sock_.open(remotePoint_.protocol());
                 sock_.set_option(boost::asio::ip::tcp::socket::receive_buffer_size(8192));
+                TransportThreadingConfig::fromLocator(locator).applyToSocket(static_cast<std::intptr_t>(sock_.native_handle()), locator.toPrintFormat());
                 sock_.async_connect(
                     remotePoint_
                     , boost::bind(
@@ -239,6 +242,7 @@ namespace dev { namespace cd606 { namespace tm { namespace transport { namespace
                         delete this;
                     } else {
                         new OneConnection(parent_);
+                        parent_->threading_.applyToSocket(static_cast<std::intptr_t>(sock_.native_handle()), parent_->locator_.toPrintFormat());
                         boost::asio::async_read(
                             sock_
                             , boost::asio::buffer(buffer_.data(), sizeof(uint32_t))
@@ -370,6 +374,7 @@ namespace dev { namespace cd606 { namespace tm { namespace transport { namespace
             std::unordered_map<std::string, OneConnection *> replySocketMap_;
             std::unordered_map<OneConnection *, std::unordered_set<std::string>> reverseReplySocketMap_;
             boost::asio::ip::tcp::acceptor acceptor_;
+            TransportThreadingConfig threading_;
             std::mutex mutex_;
 
             void registerConnection(std::string const &id, OneConnection *conn) {
@@ -396,6 +401,7 @@ namespace dev { namespace cd606 { namespace tm { namespace transport { namespace
                 , replySocketMap_()
                 , reverseReplySocketMap_()
                 , acceptor_(*service)
+                , threading_(TransportThreadingConfig::fromLocator(locator))
                 , mutex_()
             {
                 boost::asio::ip::tcp::resolver resolver(*service_);
@@ -519,8 +525,11 @@ namespace dev { namespace cd606 { namespace tm { namespace transport { namespace
             if (hookPair && hookPair->userToWire) {
                 auto hook = hookPair->userToWire->hook;
                 return [conn,hook](bool isFinal, basic::ByteDataWithID &&data) {
-                    auto x = hook(basic::ByteData {std::move(data.content)});
-                    conn->sendReply(isFinal, {data.id, std::move(x.content)});
+                    auto x = byte_data_hook_utils::tryUserToWireHookForReply(hook, isFinal, basic::ByteData {std::move(data.content)});
+                    if (!x) {
+                        return;
+                    }
+                    conn->sendReply(isFinal, {data.id, std::move(x->content)});
                 };
             } else {
                 return [conn](bool isFinal, basic::ByteDataWithID &&data) {
@@ -540,7 +549,8 @@ namespace dev { namespace cd606 { namespace tm { namespace transport { namespace
     std::function<void(basic::ByteDataWithID &&)> SocketRPCComponent::socket_rpc_setRPCClient(ConnectionLocator const &locator,
                         std::function<void(bool, basic::ByteDataWithID &&)> client,
                         std::optional<ByteDataHookPair> hookPair) {
-        return impl_->setRPCClient(locator, client, hookPair);
+        auto metrics = transportRPCChannelMetrics(dynamic_cast<TransportMetricsComponent *>(this), "socket_rpc", locator);
+        return countRPCSend(metrics, impl_->setRPCClient(locator, countRPCReceive(metrics, client), hookPair));
     }
     void SocketRPCComponent::socket_rpc_removeRPCClient(ConnectionLocator const &locator) {
         impl_->removeRPCClient(locator);
@@ -548,7 +558,8 @@ namespace dev { namespace cd606 { namespace tm { namespace transport { namespace
     std::function<void(bool, basic::ByteDataWithID &&)> SocketRPCComponent::socket_rpc_setRPCServer(ConnectionLocator const &locator,
                     std::function<void(basic::ByteDataWithID &&)> server,
                     std::optional<ByteDataHookPair> hookPair) {
-        return impl_->setRPCServer(locator, server, hookPair);
+        auto metrics = transportRPCChannelMetrics(dynamic_cast<TransportMetricsComponent *>(this), "socket_rpc", locator);
+        return countRPCSend(metrics, impl_->setRPCServer(locator, countRPCReceive(metrics, server), hookPair));
     }
     std::thread::native_handle_type SocketRPCComponent::socket_rpc_threadHandle() {
         return impl_->threadHandle();
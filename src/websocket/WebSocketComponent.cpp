@@ -1,5 +1,7 @@
 #include <tm_kit/transport/websocket/WebSocketComponent.hpp>
 #include <tm_kit/transport/TLSConfigurationComponent.hpp>
+#include <tm_kit/transport/TransportThreading.hpp>
+#include <tm_kit/transport/TransportMetricsComponent.hpp>
 
 #include <tm_kit/basic/ByteData.hpp>
 #include <tm_kit/basic/LoggingComponentBase.hpp>
@@ -197,8 +199,16 @@ namespace dev { namespace cd606 { namespace tm { namespace transport { namespace
             void run() {
                 running_ = true;
                 th_ = std::thread([this]() {                   
+                    auto threading = TransportThreadingConfig::fromLocator(locator_);
+                    threading.applyToCurrentThread(locator_.toPrintFormat());
                     boost::asio::io_context::work work(svc_);
-                    svc_.run();
+                    if (threading.busyLoop) {
+                        while (!svc_.stopped()) {
+                            svc_.poll();
+                        }
+                    } else {
+                        svc_.run();
+                    }
                 });
                 th_.detach();
                 if (stream_.index() == 2) {
@@ -1123,8 +1133,16 @@ namespace dev { namespace cd606 { namespace tm { namespace transport { namespace
             void run() {
                 running_ = true;
                 th_ = std::thread([this]() {                   
+                    auto threading = TransportThreadingConfig::fromLocator(locator_);
+                    threading.applyToCurrentThread(locator_.toPrintFormat());
                     boost::asio::io_context::work work(svc_);
-                    svc_.run();
+                    if (threading.busyLoop) {
+                        while (!svc_.stopped()) {
+                            svc_.poll();
+                        }
+                    } else {
+                        svc_.run();
+                    }
                 });
                 th_.detach();
                 if (stream_.index() == 2) {
@@ -1932,8 +1950,11 @@ namespace dev { namespace cd606 { namespace tm { namespace transport { namespace
             if (userToWireHook) {
                 auto hook = userToWireHook->hook;
                 return [targetPath,p,hook](basic::ByteDataWithTopic &&data) {
-                    auto x = hook(basic::ByteData {std::move(data.content)});
-                    p->publish(targetPath, {std::move(data.topic), std::move(x.content)});
+                    auto x = byte_data_hook_utils::tryUserToWireHook(hook, basic::ByteData {std::move(data.content)});
+                    if (!x) {
+                        return;
+                    }
+                    p->publish(targetPath, {std::move(data.topic), std::move(x->content)});
                 };
             } else {
                 return [targetPath,p](basic::ByteDataWithTopic &&data) {
@@ -2046,8 +2067,11 @@ namespace dev { namespace cd606 { namespace tm { namespace transport { namespace
             if (hookPair && hookPair->userToWire) {
                 auto hook = hookPair->userToWire->hook;
                 return [targetPath,p,hook](bool isFinal, basic::ByteDataWithID &&data) {
-                    auto x = hook(basic::ByteData {std::move(data.content)});
-                    p->sendReply(targetPath, isFinal, {data.id, std::move(x.content)});
+                    auto x = byte_data_hook_utils::tryUserToWireHookForReply(hook, isFinal, basic::ByteData {std::move(data.content)});
+                    if (!x) {
+                        return;
+                    }
+                    p->sendReply(targetPath, isFinal, {data.id, std::move(x->content)});
                 };
             } else {
                 return [targetPath,p](bool isFinal, basic::ByteDataWithID &&data) {
@@ -2157,7 +2181,8 @@ namespace dev { namespace cd606 { namespace tm { namespace transport { namespace
                     std::function<void(bool, basic::ByteDataWithID &&)> client,
                     std::optional<ByteDataHookPair> hookPair,
                     uint32_t *clientNumberOutput) {
-        return impl_->websocket_setRPCClient(locator, client, hookPair, clientNumberOutput, dynamic_cast<TLSClientConfigurationComponent *>(this));
+        auto metrics = transportRPCChannelMetrics(dynamic_cast<TransportMetricsComponent *>(this), "websocket", locator);
+        return countRPCSend(metrics, impl_->websocket_setRPCClient(locator, countRPCReceive(metrics, client), hookPair, clientNumberOutput, dynamic_cast<TLSClientConfigurationComponent *>(this)));
     }
     void WebSocketComponent::websocket_removeRPCClient(ConnectionLocator const &locator, uint32_t clientNumber) {
         impl_->websocket_removeRPCClient(locator, clientNumber);
@@ -2167,7 +2192,8 @@ namespace dev { namespace cd606 { namespace tm { namespace transport { namespace
         std::function<void(basic::ByteDataWithID &&)> server,
         std::optional<ByteDataHookPair> hookPair
     ) {
-        return impl_->websocket_setRPCServer(locator, server, hookPair, dynamic_cast<TLSServerConfigurationComponent *>(this));    
+        auto metrics = transportRPCChannelMetrics(dynamic_cast<TransportMetricsComponent *>(this), "websocket", locator);
+        return countRPCSend(metrics, impl_->websocket_setRPCServer(locator, countRPCReceive(metrics, server), hookPair, dynamic_cast<TLSServerConfigurationComponent *>(this)));
     }
     void WebSocketComponent::finalizeEnvironment() {
         impl_->finalizeEnvironment();
@@ -12,6 +12,7 @@
 #endif
 
 #include <tm_kit/transport/zeromq/ZeroMQComponent.hpp>
+#include <tm_kit/transport/TransportThreading.hpp>
 
 namespace dev { namespace cd606 { namespace tm { namespace transport { namespace zeromq {
     class ZeroMQComponentImpl {
@@ -43,9 +44,11 @@ namespace dev { namespace cd606 { namespace tm { namespace transport { namespace
                 }
             }
 
-            void run(ConnectionLocator const &locator, zmq::context_t *p_ctx) {
+            void run(ConnectionLocator const &locator, zmq::context_t *p_ctx, TransportThreadingConfig const &threading) {
+                threading.applyToCurrentThread(locator.toPrintFormat());
                 zmq::socket_t sock(*p_ctx, zmq::socket_type::sub);
                 sock.set(zmq::sockopt::rcvtimeo, 1000);
+                auto recvFlags = (threading.busyLoop?zmq::recv_flags::dontwait:zmq::recv_flags::none);
 
                 std::ostringstream oss;
                 if (locator.host() == "inproc" || locator.host() == "ipc") {
@@ -59,6 +62,7 @@ namespace dev { namespace cd606 { namespace tm { namespace transport { namespace
                 while (running_) {
                     auto res = sock.recv(
                         zmq::mutable_buffer(buffer_.data(), 16*1024*1024)
+                        , recvFlags
                     );
                     
                     if (!running_) {
@@ -101,12 +105,12 @@ namespace dev { namespace cd606 { namespace tm { namespace transport { namespace
                 sock.close();
             }
         public:
-            OneZeroMQSubscription(ConnectionLocator const &locator, zmq::context_t *p_ctx) 
+            OneZeroMQSubscription(ConnectionLocator const &locator, zmq::context_t *p_ctx, TransportThreadingConfig const &threading) 
                 : locator_(locator), buffer_()
                 , noFilterClients_(), stringMatchClients_(), regexMatchClients_()
                 , mutex_(), th_(), running_(true)
             {
-                th_ = std::thread(&OneZeroMQSubscription::run, this, locator, p_ctx);
+                th_ = std::thread(&OneZeroMQSubscription::run, this, locator, p_ctx, threading);
             }
             ~OneZeroMQSubscription() {
                 running_ = false;
@@ -233,7 +237,7 @@ namespace dev { namespace cd606 { namespace tm { namespace transport { namespace
             std::lock_guard<std::mutex> _(mutex_);
             auto iter = subscriptions_.find(hostAndPortAndIdentifier);
             if (iter == subscriptions_.end()) {
-                iter = subscriptions_.insert({hostAndPortAndIdentifier, std::make_unique<OneZeroMQSubscription>(hostAndPortAndIdentifier, &ctx_)}).first;
+                iter = subscriptions_.insert({hostAndPortAndIdentifier, std::make_unique<OneZeroMQSubscription>(hostAndPortAndIdentifier, &ctx_, TransportThreadingConfig::fromLocator(d))}).first;
             }
             return iter->second.get();
         }
@@ -297,8 +301,11 @@ namespace dev { namespace cd606 { namespace tm { namespace transport { namespace
             if (userToWireHook) {
                 auto hook = userToWireHook->hook;
                 return [p,hook](basic::ByteDataWithTopic &&data) {
-                    auto w = hook(basic::ByteData {std::move(data.content)});
-                    p->publish({std::move(data.topic), std::move(w.content)});
+                    auto w = byte_data_hook_utils::tryUserToWireHook(hook, basic::ByteData {std::move(data.content)});
+                    if (!w) {
+                        return;
+                    }
+                    p->publish({std::move(data.topic), std::move(w->content)});
                 };
             } else {
                 return [p](basic::ByteDataWithTopic &&data) {
@@ -3,6 +3,7 @@
 
 #include <tm_kit/basic/ByteData.hpp>
 #include <tm_kit/basic/WrapFacilitioidConnectorForSerialization.hpp>
+#include <tm_kit/transport/ConnectionLocator.hpp>
 #include <type_traits>
 
 namespace dev { namespace cd606 { namespace tm { namespace transport {
@@ -18,6 +19,15 @@ namespace dev { namespace cd606 { namespace tm { namespace transport {
     public:
         virtual basic::ByteData attach_identity(basic::ByteData &&d) = 0;
         virtual std::optional<basic::ByteData> process_incoming_data(basic::ByteData &&d) = 0;
+        //The facilities call these with the locator of the server that the
+        //request goes to (or the reply comes from), attachers that keep
+        //state per server override them
+        virtual basic::ByteData attach_identity_for(ConnectionLocator const &, basic::ByteData &&d) {
+            return attach_identity(std::move(d));
+        }
+        virtual std::optional<basic::ByteData> process_incoming_data_from(ConnectionLocator const &, basic::ByteData &&d) {
+            return process_incoming_data(std::move(d));
+        }
         virtual ~ClientSideAbstractIdentityAttacherComponent() {}
     };
 
@@ -1,8 +1,15 @@
 #ifndef TM_KIT_TRANSPORT_BYTE_DATA_HOOK_HPP_
 #define TM_KIT_TRANSPORT_BYTE_DATA_HOOK_HPP_
 
+#include <atomic>
+#include <cstdint>
 #include <functional>
 #include <optional>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <cstring>
+#include <memory>
 #include <tm_kit/basic/ByteData.hpp>
 
 namespace dev { namespace cd606 { namespace tm { namespace transport {
@@ -17,6 +24,46 @@ namespace dev { namespace cd606 { namespace tm { namespace transport {
         std::optional<UserToWireHook> userToWire;
         std::optional<WireToUserHook> wireToUser;
     };
+
+    //A user-to-wire hook that cannot transform its input throws this. The
+    //broadcast publishers of the transports drop such a message (and count
+    //it, see rejectedUserToWireMessageCount), and the RPC repliers send a
+    //rejected final reply without content, so that the client's call still
+    //ends. Elsewhere (RPC requests, the shared chains) it goes up to the
+    //caller.
+    class UserToWireHookRejected : public std::runtime_error {
+    public:
+        UserToWireHookRejected() : std::runtime_error("user-to-wire hook rejected the message") {}
+    };
+
+    namespace byte_data_hook_utils {
+        inline std::atomic<uint64_t> &rejectedUserToWireMessageCounter() {
+            static std::atomic<uint64_t> counter {0};
+            return counter;
+        }
+        //for the publishers: std::nullopt means the message is to be dropped
+        inline std::optional<basic::ByteData> tryUserToWireHook(std::function<basic::ByteData(basic::ByteData &&)> const &hook, basic::ByteData &&data) {
+            try {
+                return hook(std::move(data));
+            } catch (UserToWireHookRejected const &) {
+                rejectedUserToWireMessageCounter().fetch_add(1, std::memory_order_relaxed);
+                return std::nullopt;
+            }
+        }
+        //for the RPC repliers
+        inline std::optional<basic::ByteData> tryUserToWireHookForReply(std::function<basic::ByteData(basic::ByteData &&)> const &hook, bool isFinal, basic::ByteData &&data) {
+            auto x = tryUserToWireHook(hook, std::move(data));
+            if (!x && isFinal) {
+                return basic::ByteData {};
+            }
+            return x;
+        }
+    }
+    //How many messages the publishers in this process have dropped because
+    //a user-to-wire hook rejected them
+    inline uint64_t rejectedUserToWireMessageCount() {
+        return byte_data_hook_utils::rejectedUserToWireMessageCounter().load(std::memory_order_relaxed);
+    }
     //the order is data flow through h1 first, then h2
     inline UserToWireHook composeUserToWireHook(UserToWireHook h1, UserToWireHook h2) {
         return UserToWireHook { [h1,h2](basic::ByteData &&b) -> basic::ByteData {
@@ -70,6 +117,201 @@ namespace dev { namespace cd606 { namespace tm { namespace transport {
         };
     }
 
+    //The buffered hooks write into a caller-provided output buffer instead
+    //of returning a newly allocated basic::ByteData. 
+    //maxOutputSize gives, for an input size, the output buffer size that 
+    //is enough for the transform (it may be a guess). 
+    //transform writes into (output, outputCapacity) and returns the number
+    //of bytes written, or std::nullopt if the input is rejected. If the
+    //returned size is larger than outputCapacity, nothing has been written,
+    //and the call must be retried with a buffer of at least that size.
+    struct BufferedUserToWireHook {
+        std::function<std::size_t(std::size_t)> maxOutputSize;
+        std::function<std::optional<std::size_t>(basic::ByteDataView const &, char *, std::size_t)> transform;
+    };
+    struct BufferedWireToUserHook {
+        std::function<std::size_t(std::size_t)> maxOutputSize;
+        std::function<std::optional<std::size_t>(basic::ByteDataView const &, char *, std::size_t)> transform;
+    };
+
+    //Scratch space for running buffered hook chains, the two buffers are
+    //used alternately by the stages, and they only grow, so after warming
+    //up, running a chain does not allocate. One HookScratchBuffers must
+    //not be used by two threads at the same time, nor by a chain that is
+    //run from inside another chain using it.
+    struct HookScratchBuffers {
+        //the per-thread scratch of the adapters below gives back buffers
+        //that one large message has grown beyond this
+        static constexpr std::size_t RetainedCapacity = 4*1024*1024;
+
+        std::string buffers[2];
+
+        void shrinkAbove(std::size_t capacity) {
+            for (auto &b : buffers) {
+                if (b.capacity() > capacity) {
+                    std::string().swap(b);
+                }
+            }
+        }
+    };
+
+    namespace byte_data_hook_utils {
+        template <class Hook>
+        inline std::optional<basic::ByteDataView> runBufferedHook(Hook const &hook, basic::ByteDataView const &input, std::string &output) {
+            std::size_t needed = hook.maxOutputSize(input.content.length());
+            if (output.size() < needed) {
+                output.resize(needed);
+            }
+            auto written = hook.transform(input, output.data(), output.size());
+            if (!written) {
+                return std::nullopt;
+            }
+            if (*written > output.size()) {
+                output.resize(*written);
+                written = hook.transform(input, output.data(), output.size());
+                if (!written || *written > output.size()) {
+                    return std::nullopt;
+                }
+            }
+            return basic::ByteDataView {std::string_view(output.data(), *written)};
+        }
+        //the stages ping-pong between the two scratch buffers, the returned
+        //view points into one of them (or is the input if there is no stage)
+        template <class Hook>
+        inline std::optional<basic::ByteDataView> runBufferedHookChain(std::vector<Hook> const &hooks, basic::ByteDataView const &input, HookScratchBuffers &scratch) {
+            basic::ByteDataView current = input;
+            std::size_t ii = 0;
+            for (auto const &h : hooks) {
+                auto res = runBufferedHook(h, current, scratch.buffers[(ii++)%2]);
+                if (!res) {
+                    return std::nullopt;
+                }
+                current = *res;
+            }
+            return current;
+        }
+        inline std::size_t guessLegacyOutputSize(std::size_t inputSize) {
+            return inputSize+256;
+        }
+        //The adapters below share per-thread scratch, a chain that runs
+        //while another one is running on the same thread (a stage that
+        //itself publishes or decodes, say) gets the next one down
+        class ThreadScratchLease {
+        private:
+            std::size_t depth_;
+            static std::vector<std::unique_ptr<HookScratchBuffers>> &pool() {
+                thread_local std::vector<std::unique_ptr<HookScratchBuffers>> p;
+                return p;
+            }
+            static std::size_t &currentDepth() {
+                thread_local std::size_t d = 0;
+                return d;
+            }
+        public:
+            ThreadScratchLease() : depth_(currentDepth()++) {
+                auto &p = pool();
+                if (p.size() <= depth_) {
+                    p.push_back(std::make_unique<HookScratchBuffers>());
+                }
+            }
+            ~ThreadScratchLease() {
+                scratch().shrinkAbove(HookScratchBuffers::RetainedCapacity);
+                --currentDepth();
+            }
+            ThreadScratchLease(ThreadScratchLease const &) = delete;
+            ThreadScratchLease &operator=(ThreadScratchLease const &) = delete;
+            HookScratchBuffers &scratch() {
+                return *(pool()[depth_]);
+            }
+        };
+        //A std::function hook's output that did not fit is kept (per
+        //thread) for the retry with a larger buffer, so that the hook does
+        //not run twice on the same input
+        struct LegacyOutputCache {
+            void const *adapter = nullptr;
+            char const *input = nullptr;
+            std::size_t inputLength = 0;
+            std::optional<basic::ByteData> output;
+
+            static LegacyOutputCache &current() {
+                thread_local LegacyOutputCache c;
+                return c;
+            }
+        };
+        template <class F>
+        inline std::optional<std::size_t> runLegacyHook(void const *adapter, basic::ByteDataView const &input, char *output, std::size_t outputCapacity, F const &f) {
+            auto &cache = LegacyOutputCache::current();
+            std::optional<basic::ByteData> res;
+            if (cache.adapter == adapter && cache.input == input.content.data() && cache.inputLength == input.content.length()) {
+                res = std::move(cache.output);
+            } else {
+                res = f();
+            }
+            cache.adapter = nullptr;
+            cache.output = std::nullopt;
+            if (!res) {
+                return std::nullopt;
+            }
+            std::size_t len = res->content.length();
+            if (len > outputCapacity) {
+                cache.adapter = adapter;
+                cache.input = input.content.data();
+                cache.inputLength = input.content.length();
+                cache.output = std::move(res);
+            } else {
+                std::memcpy(output, res->content.data(), len);
+            }
+            return len;
+        }
+    }
+
+    //The std::function hooks can be adapted to the buffered interface (they
+    //still allocate internally, so this is only for mixing old and new hooks),
+    //and buffered hook chains can be adapted back into std::function hooks 
+    //that allocate only the final output, so that they can be passed to any 
+    //transport that takes ByteDataHookPair
+    inline BufferedUserToWireHook bufferedUserToWireHook(UserToWireHook h) {
+        auto tag = std::make_shared<char>(0);
+        return BufferedUserToWireHook {
+            &byte_data_hook_utils::guessLegacyOutputSize
+            , [h,tag](basic::ByteDataView const &input, char *output, std::size_t outputCapacity) -> std::optional<std::size_t> {
+                return byte_data_hook_utils::runLegacyHook(tag.get(), input, output, outputCapacity, [&h,&input]() -> std::optional<basic::ByteData> {
+                    return h.hook(basic::ByteData {std::string(input.content)});
+                });
+            }
+        };
+    }
+    inline BufferedWireToUserHook bufferedWireToUserHook(WireToUserHook h) {
+        auto tag = std::make_shared<char>(0);
+        return BufferedWireToUserHook {
+            &byte_data_hook_utils::guessLegacyOutputSize
+            , [h,tag](basic::ByteDataView const &input, char *output, std::size_t outputCapacity) -> std::optional<std::size_t> {
+                return byte_data_hook_utils::runLegacyHook(tag.get(), input, output, outputCapacity, [&h,&input]() {
+                    return h.hook(input);
+                });
+            }
+        };
+    }
+    inline UserToWireHook userToWireHookFromBufferedChain(std::vector<BufferedUserToWireHook> hooks) {
+        return UserToWireHook { [hooks](basic::ByteData &&b) -> basic::ByteData {
+            byte_data_hook_utils::ThreadScratchLease lease;
+            auto res = byte_data_hook_utils::runBufferedHookChain(hooks, basic::byteDataView(b), lease.scratch());
+            if (!res) {
+                throw UserToWireHookRejected();
+            }
+            return basic::ByteData {std::string(res->content)};
+        } };
+    }
+    inline WireToUserHook wireToUserHookFromBufferedChain(std::vector<BufferedWireToUserHook> hooks) {
+        return WireToUserHook { [hooks](basic::ByteDataView const &b) -> std::optional<basic::ByteData> {
+            byte_data_hook_utils::ThreadScratchLease lease;
+            auto res = byte_data_hook_utils::runBufferedHookChain(hooks, b, lease.scratch());
+            if (!res) {
+                return std::nullopt;
+            }
+            return basic::ByteData {std::string(res->content)};
+        } };
+    }
 
 } } } }
 
@@ -0,0 +1,51 @@
+#ifndef TM_KIT_TRANSPORT_CONFLATING_DELIVERY_HPP_
+#define TM_KIT_TRANSPORT_CONFLATING_DELIVERY_HPP_
+
+#include <tm_kit/basic/ByteData.hpp>
+#include <tm_kit/transport/ConnectionLocator.hpp>
+#include <tm_kit/transport/TransportMetricsComponent.hpp>
+
+#include <memory>
+#include <functional>
+#include <chrono>
+
+namespace dev { namespace cd606 { namespace tm { namespace transport {
+
+    class ConflatingDeliveryImpl;
+
+    //Keeps one slot per topic between a transport's receiving thread and
+    //the importer, so a message overwrites the undelivered one of its
+    //topic. A delivery thread hands the dirty slots over in the order they
+    //became dirty, then waits conflate_interval_ms (DefaultInterval if not
+    //given). With 0 the graph's queue is not bounded, which only suits the
+    //synchronous runners. Enabled by the locator property conflate=true.
+    class ConflatingDelivery {
+    private:
+        std::unique_ptr<ConflatingDeliveryImpl> impl_;
+    public:
+        static bool enabledFor(ConnectionLocator const &locator) {
+            return (locator.query("conflate", "false") == "true");
+        }
+        static constexpr std::chrono::milliseconds DefaultInterval {10};
+        static std::chrono::milliseconds intervalFor(ConnectionLocator const &locator);
+
+        ConflatingDelivery(std::function<void(basic::ByteDataWithTopic &&)> const &deliver, std::chrono::milliseconds interval=DefaultInterval, std::shared_ptr<TransportChannelMetrics> const &metrics=nullptr);
+        ConflatingDelivery(ConflatingDelivery const &) = delete;
+        ConflatingDelivery &operator=(ConflatingDelivery const &) = delete;
+        //slots that have not been delivered yet are discarded
+        ~ConflatingDelivery();
+
+        void push(basic::ByteDataWithTopic &&data);
+    };
+
+    //Returns null unless the locator has conflate=true
+    inline std::unique_ptr<ConflatingDelivery> conflatingDeliveryFor(ConnectionLocator const &locator, std::function<void(basic::ByteDataWithTopic &&)> const &deliver, std::shared_ptr<TransportChannelMetrics> const &metrics) {
+        if (!ConflatingDelivery::enabledFor(locator)) {
+            return nullptr;
+        }
+        return std::make_unique<ConflatingDelivery>(deliver, ConflatingDelivery::intervalFor(locator), metrics);
+    }
+
+} } } }
+
+#endif
@@ -0,0 +1,398 @@
+#ifndef TM_KIT_TRANSPORT_ETCD_WATCH_MULTIPLEXER_HPP_
+#define TM_KIT_TRANSPORT_ETCD_WATCH_MULTIPLEXER_HPP_
+
+#include <grpcpp/grpcpp.h>
+#ifdef _MSC_VER
+#undef DELETE
+#endif
+#include <libetcd/rpc.grpc.pb.h>
+#include <libetcd/kv.pb.h>
+
+#include <memory>
+#include <functional>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <deque>
+#include <unordered_map>
+#include <map>
+#include <string>
+#include <optional>
+#include <system_error>
+#include <cstdint>
+#include <chrono>
+#include <algorithm>
+
+namespace dev { namespace cd606 { namespace tm { namespace transport {
+
+    //Carries any number of etcd watches over one channel and one
+    //bidirectional Watch stream, with one thread blocking on the completion
+    //queue. Each watch gets the responses (events, or the cancellation) for
+    //its own watch ID, on the multiplexer thread, so the callbacks should
+    //not block for long.
+    //
+    //Since etcd answers the create requests on a stream in the order they
+    //are sent, the watch IDs assigned by the server are matched to the
+    //registrations in that order.
+    //
+    //If the stream fails, it is re-opened after a second and the watches
+    //are created again from the revision after the last one they have
+    //seen, so the callbacks see neither gaps nor repeats. A watch that the
+    //server refuses to create (for example because its start revision has
+    //been compacted) is removed, and its callback gets the canceled
+    //response.
+    class EtcdWatchMultiplexer {
+    public:
+        using Callback = std::function<void(etcdserverpb::WatchResponse const &)>;
+    private:
+        enum Tag : intptr_t {
+            StreamStarted = 1
+            , WriteDone = 2
+            , ReadDone = 3
+            , Finished = 4
+        };
+        struct Registration {
+            std::string key;
+            std::string rangeEnd;
+            //moved past what has been delivered, for re-creating the watch
+            //on a new stream
+            int64_t startRevision;
+            Callback callback;
+            std::optional<int64_t> watchID;
+        };
+
+        std::shared_ptr<grpc::ChannelInterface> channel_;
+        std::unique_ptr<etcdserverpb::Watch::Stub> stub_;
+        grpc::CompletionQueue queue_;
+        //there is no deadline on the stream, since it is shared by all
+        //watches, a new context is needed each time the stream is opened
+        std::unique_ptr<grpc::ClientContext> ctx_;
+        std::unique_ptr<
+            grpc::ClientAsyncReaderWriter<etcdserverpb::WatchRequest, etcdserverpb::WatchResponse>
+        > stream_;
+        etcdserverpb::WatchResponse response_;
+        grpc::Status finishStatus_;
+
+        std::mutex mutex_;
+        uint64_t handleCounter_;
+        std::unordered_map<uint64_t, Registration> registrations_;
+        std::unordered_map<int64_t, uint64_t> watchIDToHandle_;
+        //handles whose create requests have been written but not answered
+        std::deque<uint64_t> pendingCreates_;
+        //a gRPC stream allows only one outstanding write
+        std::deque<etcdserverpb::WatchRequest> writeQueue_;
+        etcdserverpb::WatchRequest currentWrite_;
+        bool started_;
+        bool writing_;
+        bool broken_;
+        bool stopping_;
+        std::condition_variable stopCond_;
+        //the watch whose callback is running, so that removeWatch can wait
+        //for it to finish
+        uint64_t dispatchingHandle_;
+        std::condition_variable dispatchCond_;
+
+        std::thread th_;
+
+        //must be called with mutex_ held
+        void writeNextNoLock() {
+            if (!started_ || writing_ || broken_ || writeQueue_.empty()) {
+                return;
+            }
+            currentWrite_ = std::move(writeQueue_.front());
+            writeQueue_.pop_front();
+            writing_ = true;
+            stream_->Write(currentWrite_, reinterpret_cast<void *>(Tag::WriteDone));
+        }
+        void enqueueCreateNoLock(uint64_t handle, Registration const &reg) {
+            etcdserverpb::WatchRequest req;
+            auto *r = req.mutable_create_request();
+            r->set_key(reg.key);
+            if (reg.rangeEnd != "") {
+                r->set_range_end(reg.rangeEnd);
+            }
+            if (reg.startRevision > 0) {
+                r->set_start_revision(reg.startRevision);
+            }
+            writeQueue_.push_back(std::move(req));
+            pendingCreates_.push_back(handle);
+            writeNextNoLock();
+        }
+        void enqueueCancelNoLock(int64_t watchID) {
+            etcdserverpb::WatchRequest req;
+            req.mutable_cancel_request()->set_watch_id(watchID);
+            writeQueue_.push_back(std::move(req));
+            writeNextNoLock();
+        }
+        void handleResponse() {
+            Callback cb;
+            {
+                std::lock_guard<std::mutex> _(mutex_);
+                auto watchID = response_.watch_id();
+                if (response_.created()) {
+                    if (pendingCreates_.empty()) {
+                        return;
+                    }
+                    auto handle = pendingCreates_.front();
+                    pendingCreates_.pop_front();
+                    auto iter = registrations_.find(handle);
+                    if (iter == registrations_.end()) {
+                        //removed before the server got to it
+                        if (!response_.canceled()) {
+                            enqueueCancelNoLock(watchID);
+                        }
+                        return;
+                    }
+                    if (response_.canceled()) {
+                        //the creation failed, there is no watch ID to keep
+                        cb = iter->second.callback;
+                        dispatchingHandle_ = handle;
+                        registrations_.erase(iter);
+                    } else {
+                        iter->second.watchID = watchID;
+                        watchIDToHandle_[watchID] = handle;
+                        if (iter->second.startRevision <= 0) {
+                            iter->second.startRevision = response_.header().revision()+1;
+                        }
+                        if (response_.events_size() == 0) {
+                            return;
+                        }
+                    }
+                }
+                if (!cb) {
+                    auto iter = watchIDToHandle_.find(watchID);
+                    if (iter == watchIDToHandle_.end()) {
+                        return;
+                    }
+                    auto regIter = registrations_.find(iter->second);
+                    if (regIter == registrations_.end()) {
+                        return;
+                    }
+                    cb = regIter->second.callback;
+                    dispatchingHandle_ = regIter->first;
+                    if (response_.canceled()) {
+                        registrations_.erase(regIter);
+                        watchIDToHandle_.erase(iter);
+                    } else if (response_.events_size() > 0) {
+                        regIter->second.startRevision = std::max(
+                            regIter->second.startRevision
+                            , response_.events(response_.events_size()-1).kv().mod_revision()+1
+                        );
+                    }
+                }
+            }
+            //called without the lock so that the callback can add or
+            //remove watches
+            if (cb) {
+                cb(response_);
+            }
+            {
+                std::lock_guard<std::mutex> _(mutex_);
+                dispatchingHandle_ = 0;
+            }
+            dispatchCond_.notify_all();
+        }
+        //on the multiplexer thread after the old stream has finished, returns
+        //false if the multiplexer is being destroyed
+        bool reopenStream() {
+            std::unique_lock<std::mutex> lock(mutex_);
+            stopCond_.wait_for(lock, std::chrono::seconds(1), [this]() {
+                return stopping_;
+            });
+            if (stopping_) {
+                return false;
+            }
+            started_ = false;
+            writing_ = false;
+            broken_ = false;
+            writeQueue_.clear();
+            pendingCreates_.clear();
+            watchIDToHandle_.clear();
+            //the old stream refers to the old context
+            stream_.reset();
+            ctx_ = std::make_unique<grpc::ClientContext>();
+            stream_ = stub_->AsyncWatch(ctx_.get(), &queue_, reinterpret_cast<void *>(Tag::StreamStarted));
+            //the writes wait for the stream to start
+            for (auto &item : registrations_) {
+                item.second.watchID = std::nullopt;
+                enqueueCreateNoLock(item.first, item.second);
+            }
+            return true;
+        }
+        void run() {
+            void *tag;
+            bool ok;
+            while (queue_.Next(&tag, &ok)) {
+                switch (reinterpret_cast<intptr_t>(tag)) {
+                case Tag::StreamStarted:
+                    if (!ok) {
+                        {
+                            std::lock_guard<std::mutex> _(mutex_);
+                            broken_ = true;
+                        }
+                        stream_->Finish(&finishStatus_, reinterpret_cast<void *>(Tag::Finished));
+                        break;
+                    }
+                    {
+                        std::lock_guard<std::mutex> _(mutex_);
+                        started_ = true;
+                        writeNextNoLock();
+                    }
+                    stream_->Read(&response_, reinterpret_cast<void *>(Tag::ReadDone));
+                    break;
+                case Tag::WriteDone:
+                    {
+                        std::lock_guard<std::mutex> _(mutex_);
+                        writing_ = false;
+                        if (!ok) {
+                            broken_ = true;
+                        } else {
+                            writeNextNoLock();
+                        }
+                    }
+                    break;
+                case Tag::ReadDone:
+                    if (!ok) {
+                        {
+                            std::lock_guard<std::mutex> _(mutex_);
+                            broken_ = true;
+                        }
+                        stream_->Finish(&finishStatus_, reinterpret_cast<void *>(Tag::Finished));
+                        break;
+                    }
+                    handleResponse();
+                    stream_->Read(&response_, reinterpret_cast<void *>(Tag::ReadDone));
+                    break;
+                case Tag::Finished:
+                    if (!reopenStream()) {
+                        queue_.Shutdown();
+                    }
+                    break;
+                default:
+                    break;
+                }
+            }
+        }
+
+        template <class Key>
+        static std::shared_ptr<EtcdWatchMultiplexer> fromRegistry(Key const &key, std::function<std::shared_ptr<grpc::ChannelInterface>()> const &channelCreator) {
+            static std::mutex registryMutex;
+            static std::map<Key, std::weak_ptr<EtcdWatchMultiplexer>> registry;
+            std::lock_guard<std::mutex> _(registryMutex);
+            auto iter = registry.find(key);
+            if (iter != registry.end()) {
+                auto p = iter->second.lock();
+                if (p) {
+                    return p;
+                }
+            }
+            auto p = std::make_shared<EtcdWatchMultiplexer>(channelCreator());
+            registry[key] = p;
+            return p;
+        }
+    public:
+        EtcdWatchMultiplexer(std::shared_ptr<grpc::ChannelInterface> const &channel)
+            : channel_(channel)
+            , stub_(etcdserverpb::Watch::NewStub(channel_))
+            , queue_()
+            , ctx_(std::make_unique<grpc::ClientContext>())
+            , stream_()
+            , response_()
+            , finishStatus_()
+            , mutex_()
+            , handleCounter_(0)
+            , registrations_()
+            , watchIDToHandle_()
+            , pendingCreates_()
+            , writeQueue_()
+            , currentWrite_()
+            , started_(false)
+            , writing_(false)
+            , broken_(false)
+            , stopping_(false)
+            , stopCond_()
+            , dispatchingHandle_(0)
+            , dispatchCond_()
+            , th_()
+        {
+            stream_ = stub_->AsyncWatch(ctx_.get(), &queue_, reinterpret_cast<void *>(Tag::StreamStarted));
+            th_ = std::thread(&EtcdWatchMultiplexer::run, this);
+        }
+        ~EtcdWatchMultiplexer() {
+            //makes all outstanding operations fail, which leads to Finish
+            //and then, since the stream is not re-opened, to the shutdown
+            //of the queue
+            {
+                std::lock_guard<std::mutex> _(mutex_);
+                stopping_ = true;
+                ctx_->TryCancel();
+            }
+            stopCond_.notify_all();
+            try {
+                if (th_.joinable()) {
+                    th_.join();
+                }
+            } catch (std::system_error const &) {
+            }
+        }
+        EtcdWatchMultiplexer(EtcdWatchMultiplexer const &) = delete;
+        EtcdWatchMultiplexer &operator=(EtcdWatchMultiplexer const &) = delete;
+
+        //one multiplexer per endpoint (or per channel) in the process, shared
+        //by everyone who asks while it is alive
+        static std::shared_ptr<EtcdWatchMultiplexer> forEndpoint(std::string const &addr="127.0.0.1:2379") {
+            return fromRegistry<std::string>(addr, [addr]() {
+                return grpc::CreateChannel(addr, grpc::InsecureChannelCredentials());
+            });
+        }
+        static std::shared_ptr<EtcdWatchMultiplexer> forChannel(std::shared_ptr<grpc::ChannelInterface> const &channel) {
+            return fromRegistry<grpc::ChannelInterface *>(channel.get(), [channel]() {
+                return channel;
+            });
+        }
+
+        std::shared_ptr<grpc::ChannelInterface> channel() const {
+            return channel_;
+        }
+        //rangeEnd is as in etcd (empty means the single key), startRevision
+        //0 means from now on. Returns the handle for removeWatch.
+        uint64_t addWatch(std::string const &key, std::string const &rangeEnd, Callback callback, int64_t startRevision=0) {
+            std::lock_guard<std::mutex> _(mutex_);
+            auto handle = ++handleCounter_;
+            auto iter = registrations_.insert({handle, Registration {
+                key, rangeEnd, startRevision, std::move(callback), std::nullopt
+            }}).first;
+            enqueueCreateNoLock(handle, iter->second);
+            return handle;
+        }
+        //when this returns, the callback is not running and will not be
+        //called again (unless this is called from the callback itself)
+        void removeWatch(uint64_t handle) {
+            std::unique_lock<std::mutex> lock(mutex_);
+            if (std::this_thread::get_id() != th_.get_id()) {
+                dispatchCond_.wait(lock, [this,handle]() {
+                    return dispatchingHandle_ != handle;
+                });
+            }
+            auto iter = registrations_.find(handle);
+            if (iter == registrations_.end()) {
+                return;
+            }
+            if (iter->second.watchID) {
+                watchIDToHandle_.erase(*(iter->second.watchID));
+                enqueueCancelNoLock(*(iter->second.watchID));
+            }
+            //if the creation is still pending, the cancel is sent when the
+            //watch ID arrives
+            registrations_.erase(iter);
+        }
+        //false while the stream is down, until it has been re-opened
+        bool isHealthy() {
+            std::lock_guard<std::mutex> _(mutex_);
+            return !broken_;
+        }
+    };
+
+} } } }
+
+#endif
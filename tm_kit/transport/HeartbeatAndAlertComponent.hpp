@@ -21,6 +21,7 @@
 #include <tm_kit/transport/redis/RedisComponent.hpp>
 #include <tm_kit/transport/nng/NNGComponent.hpp>
 #include <tm_kit/transport/singlecast/SinglecastComponent.hpp>
+#include <tm_kit/transport/inproc/InprocComponent.hpp>
 #include <tm_kit/transport/shared_memory_broadcast/SharedMemoryBroadcastComponent.hpp>
 #include <tm_kit/transport/websocket/WebSocketComponent.hpp>
 #include <tm_kit/transport/AbstractHookFactoryComponent.hpp>
@@ -46,6 +47,16 @@ namespace dev { namespace cd606 { namespace tm { namespace transport {
         void addFacilityChannel(std::string const &name, std::string const &channel);
         void setStatus(std::string const &itemDescription, HeartbeatMessage::Status status, std::string const &info="");
         void sendAlert(std::string const &alertTopic, infra::LogLevel level, std::string const &message);
+        //If everyNPeriods is larger than 1, only one in every everyNPeriods 
+        //heartbeats is a full heartbeat, and the others are delta heartbeats
+        //that only carry the entries changed since the last full one (see
+        //HeartbeatMessage and HeartbeatDeltaApplier). The default is 1 (all
+        //heartbeats are full). The heartbeat-directed listeners of this
+        //library merge the deltas, and the one-shot heartbeat lookups wait
+        //for a full heartbeat. Receivers that do not handle delta
+        //heartbeats will only see the full ones, so their ttl must be
+        //longer than everyNPeriods heartbeat periods.
+        void setFullHeartbeatInterval(std::size_t everyNPeriods);
         void publishHeartbeat(std::string const &heartbeatTopic);
         void addExtraHeartbeatHandler(std::function<void(HeartbeatMessage &&)> handler);
         template <class T>
@@ -221,6 +232,22 @@ namespace dev { namespace cd606 { namespace tm { namespace transport {
             });
         }
     };
+    template <class Env>
+    class HeartbeatAndAlertComponentInitializer<Env, inproc::InprocComponent> {
+    public:
+        void operator()(Env *env, std::string const &identity, ConnectionLocator const &locator, std::optional<UserToWireHook> hook=std::nullopt) {
+            auto realHook = hook;
+            if (!realHook) {
+                realHook = DefaultHookFactory<Env>::template outgoingHook<HeartbeatMessage>(env);
+            }
+            env->HeartbeatAndAlertComponent::assignIdentity(HeartbeatAndAlertComponent {
+                static_cast<basic::real_time_clock::ClockComponent *>(env)
+                , identity
+                , static_cast<inproc::InprocComponent *>(env)
+                    ->inproc_getPublisher(locator, realHook)
+            });
+        }
+    };
 
     template <class Env>
     inline void initializeHeartbeatAndAlertComponent(
@@ -303,6 +330,15 @@ namespace dev { namespace cd606 { namespace tm { namespace transport {
                 throw std::runtime_error("initializeHeartbeatAndAlertComponent: connection type Singlecast not supported in environment");
             }
             break;
+        case MultiTransportBroadcastListenerConnectionType::Inproc:
+            if constexpr (std::is_convertible_v<Env *, inproc::InprocComponent *>) {
+                HeartbeatAndAlertComponentInitializer<Env, inproc::InprocComponent>()(
+                    env, identity, locator, hook
+                );
+            } else {
+                throw std::runtime_error("initializeHeartbeatAndAlertComponent: connection type Inproc not supported in environment");
+            }
+            break;
         default:
             throw std::runtime_error("initializeHeartbeatAndAlertComponent: bad connection type");
             break;
@@ -355,6 +391,7 @@ namespace dev { namespace cd606 { namespace tm { namespace transport {
         std::chrono::system_clock::duration period;
         std::string overallStatusEntry = "";
         std::chrono::system_clock::duration finishAfter = std::chrono::hours(24);
+        std::size_t fullHeartbeatInterval = 1;
     };
 
     template <class R>
@@ -377,6 +414,9 @@ namespace dev { namespace cd606 { namespace tm { namespace transport {
                     , param.channelDescriptor
                     , std::nullopt 
                 );
+                if (param.fullHeartbeatInterval > 1) {
+                    r.environment()->HeartbeatAndAlertComponent::setFullHeartbeatInterval(param.fullHeartbeatInterval);
+                }
                 if (param.overallStatusEntry != "") {
                     r.environment()->HeartbeatAndAlertComponent::setStatus(param.overallStatusEntry, HeartbeatMessage::Status::Good);
                 }
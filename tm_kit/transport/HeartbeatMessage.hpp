@@ -5,6 +5,7 @@
 #include <chrono>
 #include <map>
 #include <unordered_set>
+#include <unordered_map>
 #include <regex>
 #include <optional>
 
@@ -32,6 +33,13 @@ namespace dev { namespace cd606 { namespace tm { namespace transport {
         std::map<std::string,std::vector<std::string>> broadcastChannels_;
         std::map<std::string,std::string> facilityChannels_;
         std::map<std::string, OneItemStatus> details_;
+        //only present in delta heartbeats, the base is identified by the
+        //timestamp (in microseconds) of the full heartbeat
+        struct DeltaInfo {
+            int64_t version;
+            int64_t baseTimestamp;
+        };
+        std::optional<DeltaInfo> deltaInfo_;
     public:
         HeartbeatMessage() = default;
         HeartbeatMessage(
@@ -49,6 +57,7 @@ namespace dev { namespace cd606 { namespace tm { namespace transport {
             , broadcastChannels_(std::move(broadcastChannels))
             , facilityChannels_(std::move(facilityChannels))
             , details_(details)
+            , deltaInfo_(std::nullopt)
         {
         }
         HeartbeatMessage(HeartbeatMessage const &) = default;
@@ -80,11 +89,50 @@ namespace dev { namespace cd606 { namespace tm { namespace transport {
         std::map<std::string,std::string> const &facilityChannels() const {
             return facilityChannels_;
         }
+        //A delta heartbeat only carries the channels and details that have
+        //changed since the full heartbeat it is based on. Since deltas are 
+        //always relative to the last full heartbeat (not to the previous 
+        //delta), a lost delta does not affect the later ones.
+        //A full heartbeat is serialized exactly as before, so receivers 
+        //that do not know about deltas still get all the full heartbeats.
+        void markAsDelta(int64_t version, std::chrono::system_clock::time_point baseTime);
+        bool isDelta() const {
+            return deltaInfo_.has_value();
+        }
+        std::optional<int64_t> deltaVersion() const {
+            if (deltaInfo_) {
+                return deltaInfo_->version;
+            }
+            return std::nullopt;
+        }
+        bool isDeltaBasedOn(std::chrono::system_clock::time_point fullHeartbeatTime) const;
+        //Since a delta carries every change since its base, it can be merged 
+        //either into the base or into the result of merging an earlier delta
+        //with the same base
+        void mergeDelta(HeartbeatMessage const &delta);
+
         std::optional<HeartbeatMessage::OneItemStatus> status(std::string const &entry) const;
         std::unordered_set<std::string> allEntries() const;
         std::unordered_set<std::string> allEntriesRE(std::regex const &re) const;
     };
 
+    //Keeps the last full heartbeat of each sender and turns every incoming
+    //heartbeat (full or delta) into a full one. Deltas that arrive before
+    //their base, or after a newer delta, are dropped.
+    class HeartbeatDeltaApplier {
+    private:
+        struct SenderState {
+            std::chrono::system_clock::time_point baseTime;
+            HeartbeatMessage current;
+            int64_t lastVersion;
+        };
+        std::unordered_map<std::string, SenderState> senders_;
+    public:
+        HeartbeatDeltaApplier() : senders_() {}
+        std::optional<HeartbeatMessage> apply(HeartbeatMessage &&msg);
+        void removeSender(std::string const &uuidStr);
+    };
+
 } } } }
 
 #endif
\ No newline at end of file
@@ -96,6 +96,15 @@ namespace dev { namespace cd606 { namespace tm { namespace transport {
                     } catch (ConnectionLocatorParseError const &) {
                         return std::nullopt;
                     }
+                } else if (boost::starts_with(s, "inproc://")) {
+                    try {
+                        return std::tuple<MultiTransportRemoteFacilityConnectionType, ConnectionLocator> {
+                            MultiTransportRemoteFacilityConnectionType::Inproc
+                            , ConnectionLocator::parse(s.substr(std::string("inproc://").length()))
+                        };
+                    } catch (ConnectionLocatorParseError const &) {
+                        return std::nullopt;
+                    }
                 } else if (boost::starts_with(s, "grpc_interop://")) {
                     try {
                         return std::tuple<MultiTransportRemoteFacilityConnectionType, ConnectionLocator> {
@@ -161,6 +170,18 @@ namespace dev { namespace cd606 { namespace tm { namespace transport {
             }
             auto uuidStr = h.uuidStr();
             auto iter = serverInfos_.find(uuidStr);
+            //A delta heartbeat only carries the changed entries, so it can
+            //only refresh a server that has been set up from a full heartbeat 
+            //(the facility locators are taken from the first good heartbeat
+            //and are not re-scanned afterwards)
+            if (h.isDelta()) {
+                if (iter == serverInfos_.end() || !iter->second.good_) {
+                    output.clear();
+                    return;
+                }
+                iter->second.lastGoodTime_ = std::chrono::system_clock::now();
+                return;
+            }
             if (iter == serverInfos_.end()) {
                 iter = serverInfos_.insert({uuidStr, OneServerInfo{}}).first;
             }
@@ -0,0 +1,114 @@
+#ifndef TM_KIT_TRANSPORT_LATENCY_STAMPING_HPP_
+#define TM_KIT_TRANSPORT_LATENCY_STAMPING_HPP_
+
+#include <tm_kit/basic/ByteData.hpp>
+#include <tm_kit/transport/ByteDataHook.hpp>
+#include <tm_kit/transport/ConnectionLocator.hpp>
+#include <tm_kit/transport/TransportMetricsComponent.hpp>
+
+#include <memory>
+#include <optional>
+#include <tuple>
+#include <chrono>
+#include <cstdint>
+
+namespace dev { namespace cd606 { namespace tm { namespace transport {
+
+    //Latency stamping puts a small envelope around each message on the
+    //wire: a marker, a random ID of the sending hook, a sequence number and
+    //the send time (system clock, in nanoseconds since the epoch). Since it
+    //is done with hooks, it works for both ByteDataWithTopic and
+    //ByteDataWithID (RPC) traffic, without changing the message types.
+    //
+    //The receiving side strips the envelope (messages without one are
+    //passed through as they are), and records into the channel's
+    //TransportChannelMetrics:
+    //  - the one-way latency (receive time minus send time)
+    //  - gaps in the sequence numbers of each sender (with topic filtering,
+    //    a receiver that only sees part of a sender's messages will see
+    //    gaps that are not losses)
+    //
+    //The one-way latency is only meaningful if the two hosts' clocks are
+    //synchronized (e.g. same PTP or NTP domain). For each sender, the
+    //receiver keeps the minimum of the raw latency over a sliding window,
+    //and if that is negative, the clocks must be off by at least that much,
+    //so it is taken as the clock offset estimate and subtracted. (An offset
+    //in the other direction cannot be told apart from transit time without
+    //a return path, so it is not corrected.)
+    //
+    //The stamping is enabled per channel with the locator property
+    //latency_stamp=true, which must be set on both sides. The broadcast
+    //importers, exporters and listeners, and the RPC facilities of
+    //rabbitmq, redis, socket_rpc and websocket, apply it automatically. The
+    //hooks can also be composed into any hook chain directly.
+    struct LatencyStamp {
+        uint64_t senderID;
+        uint64_t sequence;
+        int64_t sendTimeNanos;
+    };
+
+    class LatencyStampingHelper {
+    public:
+        static constexpr std::size_t HeaderSize = 28;
+        static constexpr std::chrono::seconds DefaultOffsetWindow {10};
+
+        static bool enabledFor(ConnectionLocator const &locator) {
+            return (locator.query("latency_stamp", "false") == "true");
+        }
+        static int64_t nowNanos() {
+            return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::system_clock::now().time_since_epoch()
+            ).count();
+        }
+        static basic::ByteData stamp(basic::ByteData &&data, LatencyStamp const &s);
+        //returns std::nullopt if the data does not carry a stamp
+        static std::optional<std::tuple<LatencyStamp, basic::ByteDataView>> parse(basic::ByteDataView const &data);
+
+        //every call creates a new sender with its own ID and sequence
+        static UserToWireHook outgoingHook();
+        //metrics may be null, in which case the stamp is only stripped
+        static WireToUserHook incomingHook(std::shared_ptr<TransportChannelMetrics> const &metrics, std::chrono::system_clock::duration offsetWindow=DefaultOffsetWindow);
+
+        //the stamping is the outermost layer on the wire, so it is added
+        //after the given outgoing hook and removed before the given incoming
+        //hook
+        static std::optional<UserToWireHook> addToOutgoingHook(std::optional<UserToWireHook> const &hook) {
+            return composeUserToWireHook(hook, std::optional<UserToWireHook> {outgoingHook()});
+        }
+        static std::optional<WireToUserHook> addToIncomingHook(std::shared_ptr<TransportChannelMetrics> const &metrics, std::optional<WireToUserHook> const &hook) {
+            return composeWireToUserHook(std::optional<WireToUserHook> {incomingHook(metrics)}, hook);
+        }
+        static ByteDataHookPair addToHookPair(std::shared_ptr<TransportChannelMetrics> const &metrics, std::optional<ByteDataHookPair> const &hooks) {
+            return ByteDataHookPair {
+                addToOutgoingHook(hooks?hooks->userToWire:std::nullopt)
+                , addToIncomingHook(metrics, hooks?hooks->wireToUser:std::nullopt)
+            };
+        }
+    };
+
+    //These return the given hooks unchanged unless the locator has
+    //latency_stamp=true.
+    inline std::optional<UserToWireHook> latencyStampedOutgoingHook(ConnectionLocator const &locator, std::optional<UserToWireHook> const &hook) {
+        if (!LatencyStampingHelper::enabledFor(locator)) {
+            return hook;
+        }
+        return LatencyStampingHelper::addToOutgoingHook(hook);
+    }
+    template <class Env>
+    inline std::optional<WireToUserHook> latencyStampedIncomingHook(Env *env, std::string const &transport, ConnectionLocator const &locator, std::optional<WireToUserHook> const &hook) {
+        if (!LatencyStampingHelper::enabledFor(locator)) {
+            return hook;
+        }
+        return LatencyStampingHelper::addToIncomingHook(transportChannelMetrics(env, transport, locator), hook);
+    }
+    template <class Env>
+    inline std::optional<ByteDataHookPair> latencyStampedHookPair(Env *env, std::string const &transport, ConnectionLocator const &locator, std::optional<ByteDataHookPair> const &hooks) {
+        if (!LatencyStampingHelper::enabledFor(locator)) {
+            return hooks;
+        }
+        return LatencyStampingHelper::addToHookPair(transportChannelMetrics(env, transport, locator), hooks);
+    }
+
+} } } }
+
+#endif
@@ -0,0 +1,85 @@
+#ifndef TM_KIT_TRANSPORT_LAZILY_DECODED_DATA_HPP_
+#define TM_KIT_TRANSPORT_LAZILY_DECODED_DATA_HPP_
+
+#include <tm_kit/basic/ByteData.hpp>
+#include <tm_kit/transport/TransportMetricsComponent.hpp>
+
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+
+namespace dev { namespace cd606 { namespace tm { namespace transport {
+
+    //What the lazily decoding importers publish: the topic and the bytes as
+    //they came in, and the T is only deserialized when value() is called
+    //for the first time. Copies share the bytes and the decoded value, so
+    //with several consumers the decoding still happens at most once, on
+    //whichever thread asks first.
+    template <class T>
+    class LazilyDecodedDataWithTopic {
+    private:
+        struct State {
+            std::string bytes;
+            std::shared_ptr<TransportChannelMetrics> metrics;
+            std::once_flag once;
+            std::optional<T> value;
+
+            State(std::string &&b, std::shared_ptr<TransportChannelMetrics> const &m)
+                : bytes(std::move(b)), metrics(m), once(), value(std::nullopt)
+            {}
+            State(T &&v)
+                : bytes(), metrics(), once(), value(std::move(v))
+            {
+                std::call_once(once, []() {});
+            }
+            void decode() {
+                T t;
+                if (basic::bytedata_utils::RunDeserializer<T>::applyInPlace(t, bytes)) {
+                    value = std::move(t);
+                } else if (metrics) {
+                    metrics->recordDecodeFailure();
+                }
+            }
+        };
+        std::string topic_;
+        std::shared_ptr<State> state_;
+    public:
+        LazilyDecodedDataWithTopic() : topic_(), state_() {}
+        //decoding failures are counted in metrics, which may be null
+        LazilyDecodedDataWithTopic(basic::ByteDataWithTopic &&data, std::shared_ptr<TransportChannelMetrics> const &metrics=nullptr)
+            : topic_(std::move(data.topic)), state_(std::make_shared<State>(std::move(data.content), metrics))
+        {}
+        //for transports that can hand over the object itself (inproc)
+        LazilyDecodedDataWithTopic(std::string &&topic, T &&value)
+            : topic_(std::move(topic)), state_(std::make_shared<State>(std::move(value)))
+        {}
+
+        std::string const &topic() const {
+            return topic_;
+        }
+        //empty if the value came over as an object
+        std::string const &bytes() const {
+            static std::string const empty;
+            return state_?state_->bytes:empty;
+        }
+        //null if the bytes cannot be decoded as T
+        T const *value() const {
+            if (!state_) {
+                return nullptr;
+            }
+            std::call_once(state_->once, &State::decode, state_.get());
+            return state_->value?&(*(state_->value)):nullptr;
+        }
+        std::optional<basic::TypedDataWithTopic<T>> toTypedData() const {
+            auto const *v = value();
+            if (!v) {
+                return std::nullopt;
+            }
+            return basic::TypedDataWithTopic<T> {topic_, *v};
+        }
+    };
+
+} } } }
+
+#endif
@@ -15,10 +15,13 @@
 #include <tm_kit/transport/socket_rpc/SocketRPCComponent.hpp>
 #include <tm_kit/transport/shared_memory_broadcast/SharedMemoryBroadcastComponent.hpp>
 #include <tm_kit/transport/AbstractHookFactoryComponent.hpp>
+#include <tm_kit/transport/TransportMetricsComponent.hpp>
+#include <tm_kit/transport/LatencyStamping.hpp>
 #include <tm_kit/transport/grpc_interop/GrpcInteropComponent.hpp>
 #include <tm_kit/transport/json_rest/JsonRESTComponent.hpp>
 #include <tm_kit/transport/websocket/WebSocketComponent.hpp>
 #include <tm_kit/transport/singlecast/SinglecastComponent.hpp>
+#include <tm_kit/transport/inproc/InprocComponent.hpp>
 
 #include <type_traits>
 #include <regex>
@@ -39,6 +42,7 @@ namespace dev { namespace cd606 { namespace tm { namespace transport {
         , json_rest::JsonRESTComponent
         , web_socket::WebSocketComponent
         , singlecast::SinglecastComponent
+        , inproc::InprocComponent
     >;
 
     template <class Env>
@@ -90,8 +94,9 @@ namespace dev { namespace cd606 { namespace tm { namespace transport {
         , SharedMemoryBroadcast
         , WebSocket
         , Singlecast
+        , Inproc
     };
-    inline const std::array<std::string,8> MULTI_TRANSPORT_SUBSCRIBER_CONNECTION_TYPE_STR = {
+    inline const std::array<std::string,9> MULTI_TRANSPORT_SUBSCRIBER_CONNECTION_TYPE_STR = {
         "multicast"
         , "rabbitmq"
         , "redis"
@@ -100,6 +105,7 @@ namespace dev { namespace cd606 { namespace tm { namespace transport {
         , "shared_memory_broadcast"
         , "websocket"
         , "singlecast"
+        , "inproc"
     };
     inline auto parseMultiTransportBroadcastChannel(std::string const &s) 
         -> std::optional<std::tuple<MultiTransportBroadcastListenerConnectionType, ConnectionLocator>>
@@ -334,6 +340,8 @@ namespace dev { namespace cd606 { namespace tm { namespace transport {
                         restartInfo_.insert({x, {x.connectionType, -1}});
                         return;
                     }
+                    auto const &transportName = MULTI_TRANSPORT_SUBSCRIBER_CONNECTION_TYPE_STR[static_cast<int>(x.connectionType)];
+                    auto metrics = transportChannelMetrics(env, transportName, x.connectionLocator);
                     switch (x.connectionType) {
                     case MultiTransportBroadcastListenerConnectionType::Multicast:
                         if constexpr (std::is_convertible_v<Env *, multicast::MulticastComponent *>) {
@@ -345,15 +353,20 @@ namespace dev { namespace cd606 { namespace tm { namespace transport {
                             auto res = component->multicast_addSubscriptionClient(
                                 x.connectionLocator
                                 , MultiTransportBroadcastListenerTopicHelper<multicast::MulticastComponent>::parseTopic(x.topicDescription)
-                                , [this,env](basic::ByteDataWithTopic &&d) {
+                                , [this,env,metrics](basic::ByteDataWithTopic &&d) {
                                     TM_INFRA_IMPORTER_TRACER_WITH_SUFFIX(env, ":data");
+                                    if (metrics) {
+                                        metrics->recordInbound(d.content.length());
+                                    }
                                     T t;
                                     auto tRes = basic::bytedata_utils::RunDeserializer<T>::applyInPlace(t, d.content);
                                     if (tRes) {
                                         this->ImporterParent::publish(M::template pureInnerData<basic::TypedDataWithTopic<T>>(env, {std::move(d.topic), std::move(t)}));
+                                    } else if (metrics) {
+                                        metrics->recordDecodeFailure();
                                     }
                                 }
-                                , actualHook
+                                , latencyStampedIncomingHook(env, transportName, x.connectionLocator, actualHook)
                             );
                             {
                                 std::lock_guard<std::mutex> _(subscriptionsMutex_);
@@ -395,15 +408,20 @@ namespace dev { namespace cd606 { namespace tm { namespace transport {
                             auto res = component->rabbitmq_addExchangeSubscriptionClient(
                                 x.connectionLocator
                                 , x.topicDescription
-                                , [this,env](basic::ByteDataWithTopic &&d) {
+                                , [this,env,metrics](basic::ByteDataWithTopic &&d) {
                                     TM_INFRA_IMPORTER_TRACER_WITH_SUFFIX(env, ":data");
+                                    if (metrics) {
+                                        metrics->recordInbound(d.content.length());
+                                    }
                                     T t;
                                     auto tRes = basic::bytedata_utils::RunDeserializer<T>::applyInPlace(t, d.content);
                                     if (tRes) {
                                         this->ImporterParent::publish(M::template pureInnerData<basic::TypedDataWithTopic<T>>(env, {std::move(d.topic), std::move(t)}));
+                                    } else if (metrics) {
+                                        metrics->recordDecodeFailure();
                                     }
                                 }
-                                , actualHook
+                                , latencyStampedIncomingHook(env, transportName, x.connectionLocator, actualHook)
                             );
                             {
                                 std::lock_guard<std::mutex> _(subscriptionsMutex_);
@@ -445,15 +463,20 @@ namespace dev { namespace cd606 { namespace tm { namespace transport {
                             auto res = component->redis_addSubscriptionClient(
                                 x.connectionLocator
                                 , MultiTransportBroadcastListenerRedisTopicHelper::redisTopicHelper(x.topicDescription)
-                                , [this,env](basic::ByteDataWithTopic &&d) {
+                                , [this,env,metrics](basic::ByteDataWithTopic &&d) {
                                     TM_INFRA_IMPORTER_TRACER_WITH_SUFFIX(env, ":data");
+                                    if (metrics) {
+                                        metrics->recordInbound(d.content.length());
+                                    }
                                     T t;
                                     auto tRes = basic::bytedata_utils::RunDeserializer<T>::applyInPlace(t, d.content);
                                     if (tRes) {
                                         this->ImporterParent::publish(M::template pureInnerData<basic::TypedDataWithTopic<T>>(env, {std::move(d.topic), std::move(t)}));
+                                    } else if (metrics) {
+                                        metrics->recordDecodeFailure();
                                     }
                                 }
-                                , actualHook
+                                , latencyStampedIncomingHook(env, transportName, x.connectionLocator, actualHook)
                             );
                             {
                                 std::lock_guard<std::mutex> _(subscriptionsMutex_);
@@ -495,15 +518,20 @@ namespace dev { namespace cd606 { namespace tm { namespace transport {
                             auto res = component->zeroMQ_addSubscriptionClient(
                                 x.connectionLocator
                                 , MultiTransportBroadcastListenerTopicHelper<zeromq::ZeroMQComponent>::parseTopic(x.topicDescription)
-                                , [this,env](basic::ByteDataWithTopic &&d) {
+                                , [this,env,metrics](basic::ByteDataWithTopic &&d) {
                                     TM_INFRA_IMPORTER_TRACER_WITH_SUFFIX(env, ":data");
+                                    if (metrics) {
+                                        metrics->recordInbound(d.content.length());
+                                    }
                                     T t;
                                     auto tRes = basic::bytedata_utils::RunDeserializer<T>::applyInPlace(t, d.content);
                                     if (tRes) {
                                         this->ImporterParent::publish(M::template pureInnerData<basic::TypedDataWithTopic<T>>(env, {std::move(d.topic), std::move(t)}));
+                                    } else if (metrics) {
+                                        metrics->recordDecodeFailure();
                                     }
                                 }
-                                , actualHook
+                                , latencyStampedIncomingHook(env, transportName, x.connectionLocator, actualHook)
                             );
                             {
                                 std::lock_guard<std::mutex> _(subscriptionsMutex_);
@@ -545,15 +573,20 @@ namespace dev { namespace cd606 { namespace tm { namespace transport {
                             auto res = component->nng_addSubscriptionClient(
                                 x.connectionLocator
                                 , MultiTransportBroadcastListenerTopicHelper<nng::NNGComponent>::parseTopic(x.topicDescription)
-                                , [this,env](basic::ByteDataWithTopic &&d) {
+                                , [this,env,metrics](basic::ByteDataWithTopic &&d) {
                                     TM_INFRA_IMPORTER_TRACER_WITH_SUFFIX(env, ":data");
+                                    if (metrics) {
+                                        metrics->recordInbound(d.content.length());
+                                    }
                                     T t;
                                     auto tRes = basic::bytedata_utils::RunDeserializer<T>::applyInPlace(t, d.content);
                                     if (tRes) {
                                         this->ImporterParent::publish(M::template pureInnerData<basic::TypedDataWithTopic<T>>(env, {std::move(d.topic), std::move(t)}));
+                                    } else if (metrics) {
+                                        metrics->recordDecodeFailure();
                                     }
                                 }
-                                , actualHook
+                                , latencyStampedIncomingHook(env, transportName, x.connectionLocator, actualHook)
                             );
                             {
                                 std::lock_guard<std::mutex> _(subscriptionsMutex_);
@@ -595,15 +628,20 @@ namespace dev { namespace cd606 { namespace tm { namespace transport {
                             auto res = component->shared_memory_broadcast_addSubscriptionClient(
                                 x.connectionLocator
                                 , MultiTransportBroadcastListenerTopicHelper<shared_memory_broadcast::SharedMemoryBroadcastComponent>::parseTopic(x.topicDescription)
-                                , [this,env](basic::ByteDataWithTopic &&d) {
+                                , [this,env,metrics](basic::ByteDataWithTopic &&d) {
                                     TM_INFRA_IMPORTER_TRACER_WITH_SUFFIX(env, ":data");
+                                    if (metrics) {
+                                        metrics->recordInbound(d.content.length());
+                                    }
                                     T t;
                                     auto tRes = basic::bytedata_utils::RunDeserializer<T>::applyInPlace(t, d.content);
                                     if (tRes) {
                                         this->ImporterParent::publish(M::template pureInnerData<basic::TypedDataWithTopic<T>>(env, {std::move(d.topic), std::move(t)}));
+                                    } else if (metrics) {
+                                        metrics->recordDecodeFailure();
                                     }
                                 }
-                                , actualHook
+                                , latencyStampedIncomingHook(env, transportName, x.connectionLocator, actualHook)
                             );
                             {
                                 std::lock_guard<std::mutex> _(subscriptionsMutex_);
@@ -645,15 +683,20 @@ namespace dev { namespace cd606 { namespace tm { namespace transport {
                             auto res = component->websocket_addSubscriptionClient(
                                 x.connectionLocator
                                 , MultiTransportBroadcastListenerTopicHelper<web_socket::WebSocketComponent>::parseTopic(x.topicDescription)
-                                , [this,env](basic::ByteDataWithTopic &&d) {
+                                , [this,env,metrics](basic::ByteDataWithTopic &&d) {
                                     TM_INFRA_IMPORTER_TRACER_WITH_SUFFIX(env, ":data");
+                                    if (metrics) {
+                                        metrics->recordInbound(d.content.length());
+                                    }
                                     T t;
                                     auto tRes = basic::bytedata_utils::RunDeserializer<T>::applyInPlace(t, d.content);
                                     if (tRes) {
                                         this->ImporterParent::publish(M::template pureInnerData<basic::TypedDataWithTopic<T>>(env, {std::move(d.topic), std::move(t)}));
+                                    } else if (metrics) {
+                                        metrics->recordDecodeFailure();
                                     }
                                 }
-                                , actualHook
+                                , latencyStampedIncomingHook(env, transportName, x.connectionLocator, actualHook)
                             );
                             {
                                 std::lock_guard<std::mutex> _(subscriptionsMutex_);
@@ -695,15 +738,20 @@ namespace dev { namespace cd606 { namespace tm { namespace transport {
                             auto res = component->singlecast_addSubscriptionClient(
                                 x.connectionLocator
                                 , MultiTransportBroadcastListenerTopicHelper<singlecast::SinglecastComponent>::parseTopic(x.topicDescription)
-                                , [this,env](basic::ByteDataWithTopic &&d) {
+                                , [this,env,metrics](basic::ByteDataWithTopic &&d) {
                                     TM_INFRA_IMPORTER_TRACER_WITH_SUFFIX(env, ":data");
+                                    if (metrics) {
+                                        metrics->recordInbound(d.content.length());
+                                    }
                                     T t;
                                     auto tRes = basic::bytedata_utils::RunDeserializer<T>::applyInPlace(t, d.content);
                                     if (tRes) {
                                         this->ImporterParent::publish(M::template pureInnerData<basic::TypedDataWithTopic<T>>(env, {std::move(d.topic), std::move(t)}));
+                                    } else if (metrics) {
+                                        metrics->recordDecodeFailure();
                                     }
                                 }
-                                , actualHook
+                                , latencyStampedIncomingHook(env, transportName, x.connectionLocator, actualHook)
                             );
                             {
                                 std::lock_guard<std::mutex> _(subscriptionsMutex_);
@@ -735,6 +783,60 @@ namespace dev { namespace cd606 { namespace tm { namespace transport {
                             );
                         }
                         break;
+                    case MultiTransportBroadcastListenerConnectionType::Inproc:
+                        if constexpr (std::is_convertible_v<Env *, inproc::InprocComponent *>) {
+                            auto *component = static_cast<inproc::InprocComponent *>(env);
+                            auto actualHook = wireToUserHook_;
+                            if (!actualHook) {
+                                actualHook = DefaultHookFactory<Env>::template incomingHook<T>(env);
+                            }
+                            auto res = component->template inproc_addTypedSubscriptionClient<T>(
+                                x.connectionLocator
+                                , MultiTransportBroadcastListenerTopicHelper<inproc::InprocComponent>::parseTopic(x.topicDescription)
+                                , [this,env,metrics](basic::TypedDataWithTopic<T> &&d) {
+                                    TM_INFRA_IMPORTER_TRACER_WITH_SUFFIX(env, ":data");
+                                    if (metrics) {
+                                        metrics->recordInbound(0);
+                                    }
+                                    this->ImporterParent::publish(M::template pureInnerData<basic::TypedDataWithTopic<T>>(env, std::move(d)));
+                                }
+                                , latencyStampedIncomingHook(env, transportName, x.connectionLocator, actualHook)
+                                , [metrics]() {
+                                    if (metrics) {
+                                        metrics->recordDecodeFailure();
+                                    }
+                                }
+                            );
+                            {
+                                std::lock_guard<std::mutex> _(subscriptionsMutex_);
+                                subscriptions_.insert({{x.connectionType, res}, x});
+                            }
+                            this->FacilityParent::publish(
+                                env
+                                , typename M::template Key<MultiTransportBroadcastListenerOutput> {
+                                    id
+                                    , MultiTransportBroadcastListenerOutput { {
+                                        MultiTransportBroadcastListenerAddSubscriptionResponse {res}
+                                    } }
+                                }
+                                , true
+                            );
+                        } else {
+                            std::ostringstream errOss;
+                            errOss << "[MultiTransportBroadcastListner::actuallyHandle] trying to set up inproc channel " << x.connectionLocator << " but inproc is unsupported in the environment";
+                            env->log(infra::LogLevel::Warning, errOss.str());
+                            this->FacilityParent::publish(
+                                env
+                                , typename M::template Key<MultiTransportBroadcastListenerOutput> {
+                                    id
+                                    , MultiTransportBroadcastListenerOutput { {
+                                        MultiTransportBroadcastListenerAddSubscriptionResponse {0}
+                                    } }
+                                }
+                                , true
+                            );
+                        }
+                        break;
                     default:
                         this->FacilityParent::publish(
                             env
@@ -841,6 +943,16 @@ namespace dev { namespace cd606 { namespace tm { namespace transport {
                             }
                         }
                         break;
+                    case MultiTransportBroadcastListenerConnectionType::Inproc:
+                        if constexpr (std::is_convertible_v<Env *, inproc::InprocComponent *>) {
+                            static_cast<inproc::InprocComponent *>(env)
+                                ->inproc_removeSubscriptionClient(x.subscriptionID);
+                            {
+                                std::lock_guard<std::mutex> _(subscriptionsMutex_);
+                                subscriptions_.erase({x.connectionType, x.subscriptionID});
+                            }
+                        }
+                        break;
                     default:
                         break;
                     }
@@ -906,6 +1018,12 @@ namespace dev { namespace cd606 { namespace tm { namespace transport {
                                     ->singlecast_removeSubscriptionClient(std::get<1>(x.first));
                             }
                             break;
+                        case MultiTransportBroadcastListenerConnectionType::Inproc:
+                            if constexpr (std::is_convertible_v<Env *, inproc::InprocComponent *>) {
+                                static_cast<inproc::InprocComponent *>(env)
+                                    ->inproc_removeSubscriptionClient(std::get<1>(x.first));
+                            }
+                            break;
                         default:
                             break;
                         }
@@ -11,6 +11,7 @@
 #include <tm_kit/transport/shared_memory_broadcast/SharedMemoryBroadcastImporterExporter.hpp>
 #include <tm_kit/transport/websocket/WebSocketImporterExporter.hpp>
 #include <tm_kit/transport/singlecast/SinglecastImporterExporter.hpp>
+#include <tm_kit/transport/inproc/InprocImporterExporter.hpp>
 
 #include <tm_kit/basic/CommonFlowUtils.hpp>
 #include <tm_kit/basic/AppRunnerUtils.hpp>
@@ -222,6 +223,18 @@ namespace dev { namespace cd606 { namespace tm { namespace transport {
                             r.environment()->log(infra::LogLevel::Warning, "[MultiTransportBroadcastListenerManagingUtils::setupBroadcastListeners_internal] Trying to create singlecast publisher with channel spec '"+spec.channel+"', but singlecast is unsupported in the environment");
                         }
                         break;
+                    case MultiTransportBroadcastListenerConnectionType::Inproc:
+                        if constexpr (std::is_convertible_v<Env *, inproc::InprocComponent *>) {
+                            sub = inproc::InprocImporterExporter<Env>::template createTypedImporter<FirstInputType>(
+                                std::get<1>(*parsedSpec)
+                                , MultiTransportBroadcastListenerTopicHelper<inproc::InprocComponent>::parseTopic(getTopic_internal(std::get<0>(*parsedSpec), spec.topicDescription))
+                                , hookFactory(spec.name)
+                            );
+                            r.registerImporter(prefix+"/"+spec.name, sub);
+                        } else {
+                            r.environment()->log(infra::LogLevel::Warning, "[MultiTransportBroadcastListenerManagingUtils::setupBroadcastListeners_internal] Trying to create inproc publisher with channel spec '"+spec.channel+"', but inproc is unsupported in the environment");
+                        }
+                        break;
                     default:
                         r.environment()->log(infra::LogLevel::Warning, "[MultiTransportBroadcastListenerManagingUtils::setupBroadcastListeners_internal] Trying to create unknown-protocol publisher with channel spec '"+spec.channel+"'");
                         break;
@@ -584,6 +597,19 @@ namespace dev { namespace cd606 { namespace tm { namespace transport {
                     throw std::runtime_error("[MultiTransportBroadcastListenerManagingUtils::oneByteDataBroadcastListener] Trying to create singlecast publisher with channel spec '"+channelSpec+"', but singlecast is unsupported in the environment");
                 }
                 break;
+            case MultiTransportBroadcastListenerConnectionType::Inproc:
+                if constexpr (std::is_convertible_v<Env *, inproc::InprocComponent *>) {
+                    auto sub = inproc::InprocImporterExporter<Env>::createImporter(
+                        std::get<1>(*parsed)
+                        , MultiTransportBroadcastListenerTopicHelper<inproc::InprocComponent>::parseTopic(getTopic_internal(std::get<0>(*parsed), topicDescription))
+                        , hook
+                    );
+                    r.registerImporter(name, sub);
+                    return r.importItem(sub);
+                } else {
+                    throw std::runtime_error("[MultiTransportBroadcastListenerManagingUtils::oneByteDataBroadcastListener] Trying to create inproc publisher with channel spec '"+channelSpec+"', but inproc is unsupported in the environment");
+                }
+                break;
             default:
                 throw std::runtime_error("[MultiTransportBroadcastListenerManagingUtils::oneByteDataBroadcastListener] Trying to create unknown-protocol publisher with channel spec '"+channelSpec+"'");
                 break;
@@ -593,21 +619,29 @@ namespace dev { namespace cd606 { namespace tm { namespace transport {
         class AddSubscriptionCreator {
         private:
             std::unordered_set<std::string> seenLocators_;
+            //the senders may send delta heartbeats, which are merged
+            //into their last full heartbeat before being looked at
+            HeartbeatDeltaApplier deltaApplier_;
             std::mutex mutex_;
             std::regex serverNameRE_;
             std::string lookupName_;
             std::string topic_;
         public:
-            AddSubscriptionCreator(std::regex const &serverNameRE, std::string const &lookupName, std::string const &topic) : seenLocators_(), mutex_(), serverNameRE_(serverNameRE), lookupName_(lookupName), topic_(topic) {}
+            AddSubscriptionCreator(std::regex const &serverNameRE, std::string const &lookupName, std::string const &topic) : seenLocators_(), deltaApplier_(), mutex_(), serverNameRE_(serverNameRE), lookupName_(lookupName), topic_(topic) {}
             AddSubscriptionCreator(AddSubscriptionCreator &&c)
-                : seenLocators_(std::move(c.seenLocators_)), mutex_(), serverNameRE_(std::move(c.serverNameRE_)), lookupName_(std::move(c.lookupName_)), topic_(std::move(c.topic_)) {}
+                : seenLocators_(std::move(c.seenLocators_)), deltaApplier_(std::move(c.deltaApplier_)), mutex_(), serverNameRE_(std::move(c.serverNameRE_)), lookupName_(std::move(c.lookupName_)), topic_(std::move(c.topic_)) {}
         private:
-            std::vector<MultiTransportBroadcastListenerInput> handleHeartbeat(HeartbeatMessage const &msg) {
+            std::vector<MultiTransportBroadcastListenerInput> handleHeartbeat(HeartbeatMessage &&incoming) {
                 std::vector<MultiTransportBroadcastListenerInput> ret;
-                if (!std::regex_match(msg.senderDescription(), serverNameRE_)) {
+                if (!std::regex_match(incoming.senderDescription(), serverNameRE_)) {
                     return ret;
                 }
                 std::lock_guard<std::mutex> _(mutex_);
+                auto full = deltaApplier_.apply(std::move(incoming));
+                if (!full) {
+                    return ret;
+                }
+                auto const &msg = *full;
                 auto iter = msg.broadcastChannels().find(lookupName_);
                 if (iter != msg.broadcastChannels().end() && !iter->second.empty()) {
                     for (auto const &c : iter->second) {
@@ -630,10 +664,10 @@ namespace dev { namespace cd606 { namespace tm { namespace transport {
             }
         public:
             std::vector<MultiTransportBroadcastListenerInput> operator()(HeartbeatMessage &&msg) {
-                return handleHeartbeat(msg);
+                return handleHeartbeat(std::move(msg));
             }
             std::vector<MultiTransportBroadcastListenerInput> operator()(std::shared_ptr<HeartbeatMessage const> &&msg) {
-                return handleHeartbeat(*msg);
+                return handleHeartbeat(HeartbeatMessage {*msg});
             }
         };
     public:
@@ -859,6 +893,18 @@ namespace dev { namespace cd606 { namespace tm { namespace transport {
                     throw std::runtime_error("[MultiTransportBroadcastListenerManagingUtils::fetchFirstUpdateAndDisconnect] Trying to create singlecast publisher with channel spec '"+channelSpec+"', but singlecast is unsupported in the environment");
                 }
                 break;
+            case MultiTransportBroadcastListenerConnectionType::Inproc:
+                if constexpr (std::is_convertible_v<Env *, inproc::InprocComponent *>) {
+                    return inproc::InprocImporterExporter<Env>::fetchFirstUpdateAndDisconnect(
+                        env
+                        , std::get<1>(*parsed)
+                        , MultiTransportBroadcastListenerTopicHelper<inproc::InprocComponent>::parseTopic(getTopic_internal(std::get<0>(*parsed), topicDescription))
+                        , hook
+                    );
+                } else {
+                    throw std::runtime_error("[MultiTransportBroadcastListenerManagingUtils::fetchFirstUpdateAndDisconnect] Trying to create inproc publisher with channel spec '"+channelSpec+"', but inproc is unsupported in the environment");
+                }
+                break;
             default:
                 throw std::runtime_error("[MultiTransportBroadcastListenerManagingUtils::fetchFirstUpdateAndDisconnect] Trying to create unknown-protocol publisher with channel spec '"+channelSpec+"'");
                 break;
@@ -983,6 +1029,19 @@ namespace dev { namespace cd606 { namespace tm { namespace transport {
                     throw std::runtime_error("[MultiTransportBroadcastListenerManagingUtils::fetchTypedFirstUpdateAndDisconnect] Trying to create singlecast publisher with channel spec '"+channelSpec+"', but singlecast is unsupported in the environment");
                 }
                 break;
+            case MultiTransportBroadcastListenerConnectionType::Inproc:
+                if constexpr (std::is_convertible_v<Env *, inproc::InprocComponent *>) {
+                    return inproc::InprocImporterExporter<Env>::template fetchTypedFirstUpdateAndDisconnect<T>(
+                        env
+                        , std::get<1>(*parsed)
+                        , MultiTransportBroadcastListenerTopicHelper<inproc::InprocComponent>::parseTopic(getTopic_internal(std::get<0>(*parsed), topicDescription))
+                        , predicate
+                        , hook
+                    );
+                } else {
+                    throw std::runtime_error("[MultiTransportBroadcastListenerManagingUtils::fetchTypedFirstUpdateAndDisconnect] Trying to create inproc publisher with channel spec '"+channelSpec+"', but inproc is unsupported in the environment");
+                }
+                break;
             default:
                 throw std::runtime_error("[MultiTransportBroadcastListenerManagingUtils::fetchTypedFirstUpdateAndDisconnect] Trying to create unknown-protocol publisher with channel spec '"+channelSpec+"'");
                 break;
@@ -1003,6 +1062,11 @@ namespace dev { namespace cd606 { namespace tm { namespace transport {
                     , heartbeatChannelSpec
                     , heartbeatTopicDescription
                     , [heartbeatSenderNameRE,furtherPredicates](HeartbeatMessage const &m) {
+                        //a delta heartbeat only has what changed, so the
+                        //callers get the next full one
+                        if (m.isDelta()) {
+                            return false;
+                        }
                         if (furtherPredicates) {
                             return std::regex_match(
                                 m.senderDescription()
@@ -1033,6 +1097,11 @@ namespace dev { namespace cd606 { namespace tm { namespace transport {
                     , heartbeatChannelSpec
                     , heartbeatTopicDescription
                     , [heartbeatSenderNameRE,furtherPredicates](HeartbeatMessage const &m) {
+                        //a delta heartbeat only has what changed, so the
+                        //callers get the next full one
+                        if (m.isDelta()) {
+                            return false;
+                        }
                         if (furtherPredicates) {
                             return std::regex_match(
                                 m.senderDescription()
@@ -132,6 +132,17 @@ namespace dev { namespace cd606 { namespace tm { namespace transport {
                         r.environment()->log(infra::LogLevel::Warning, "[MultiTransportBroadcastListenerManagingUtils (Synchronous Runner)::oneBroadcastListenerWithTopic] Trying to create singlecast publisher with channel spec '"+spec.channel+"', but singlecast is unsupported in the environment");
                     }
                     break;
+                case MultiTransportBroadcastListenerConnectionType::Inproc:
+                    if constexpr (std::is_convertible_v<Env *, inproc::InprocComponent *>) {
+                        sub = inproc::InprocImporterExporter<Env>::template createTypedImporter<DataType>(
+                            std::get<1>(*parsedSpec)
+                            , MultiTransportBroadcastListenerTopicHelper<inproc::InprocComponent>::parseTopic(getTopic_internal(std::get<0>(*parsedSpec), spec.topicDescription))
+                            , hookFactory(spec.name)
+                        );
+                    } else {
+                        r.environment()->log(infra::LogLevel::Warning, "[MultiTransportBroadcastListenerManagingUtils (Synchronous Runner)::oneBroadcastListenerWithTopic] Trying to create inproc publisher with channel spec '"+spec.channel+"', but inproc is unsupported in the environment");
+                    }
+                    break;
                 default:
                     r.environment()->log(infra::LogLevel::Warning, "[MultiTransportBroadcastListenerManagingUtils (Synchronous Runner)::oneBroadcastListenerWithTopic] Trying to create unknown-protocol publisher with channel spec '"+spec.channel+"'");
                     break;
@@ -338,6 +349,18 @@ namespace dev { namespace cd606 { namespace tm { namespace transport {
                     throw std::runtime_error("[MultiTransportBroadcastListenerManagingUtils (Synchronous Runner)::oneByteDataBroadcastListener] Trying to create singlecast publisher with channel spec '"+channelSpec+"', but singlecast is unsupported in the environment");
                 }
                 break;
+            case MultiTransportBroadcastListenerConnectionType::Inproc:
+                if constexpr (std::is_convertible_v<Env *, inproc::InprocComponent *>) {
+                    auto sub = inproc::InprocImporterExporter<Env>::createImporter(
+                        std::get<1>(*parsed)
+                        , MultiTransportBroadcastListenerTopicHelper<inproc::InprocComponent>::parseTopic(getTopic_internal(std::get<0>(*parsed), topicDescription))
+                        , hook
+                    );
+                    return sub;
+                } else {
+                    throw std::runtime_error("[MultiTransportBroadcastListenerManagingUtils (Synchronous Runner)::oneByteDataBroadcastListener] Trying to create inproc publisher with channel spec '"+channelSpec+"', but inproc is unsupported in the environment");
+                }
+                break;
             default:
                 throw std::runtime_error("[MultiTransportBroadcastListenerManagingUtils (Synchronous Runner)::oneByteDataBroadcastListener] Trying to create unknown-protocol publisher with channel spec '"+channelSpec+"'");
                 break;
@@ -361,6 +384,11 @@ namespace dev { namespace cd606 { namespace tm { namespace transport {
             auto heartbeatMsg = r.importItemUntil(
                 importer 
                 , [serverNameRE,broadcastSourceLookupName](typename M::template InnerData<basic::TypedDataWithTopic<HeartbeatMessage>> const &h) {
+                    //only full heartbeats are looked at, see
+                    //HeartbeatMessage::isDelta
+                    if (h.timedData.value.content.isDelta()) {
+                        return false;
+                    }
                     if (!std::regex_match(h.timedData.value.content.senderDescription(), serverNameRE)) {
                         return false;
                     }
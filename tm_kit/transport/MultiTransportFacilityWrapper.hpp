@@ -2,6 +2,7 @@
 #define TM_KIT_TRANSPORT_MULTI_TRANSPORT_FACILITY_WRAPPER_HPP_
 
 #include <tm_kit/transport/MultiTransportRemoteFacility.hpp>
+#include <tm_kit/transport/LatencyStamping.hpp>
 #include <tm_kit/transport/grpc_interop/GrpcServerFacility.hpp>
 #include <tm_kit/transport/json_rest/JsonRESTFacilityWrapper.hpp>
 #include <tm_kit/transport/websocket/WebSocketServerFacility.hpp>
@@ -18,6 +19,35 @@ namespace dev { namespace cd606 { namespace tm { namespace transport {
     private:
         using M = typename R::AppType;
         using Env = typename R::EnvironmentType;
+
+        //the default hooks are supplied here, since the transport wrappers
+        //only supply them when no hooks are given
+        template <class A, class B>
+        static std::optional<ByteDataHookPair> latencyStampedServerHooks(
+            R &runner
+            , MultiTransportRemoteFacilityConnectionType rpcConnType
+            , ConnectionLocator const &rpcQueueLocator
+            , std::optional<ByteDataHookPair> const &hooks
+        ) {
+            if (!LatencyStampingHelper::enabledFor(rpcQueueLocator)) {
+                return hooks;
+            }
+            switch (rpcConnType) {
+            case MultiTransportRemoteFacilityConnectionType::RabbitMQ:
+            case MultiTransportRemoteFacilityConnectionType::Redis:
+            case MultiTransportRemoteFacilityConnectionType::SocketRPC:
+            case MultiTransportRemoteFacilityConnectionType::Inproc:
+            case MultiTransportRemoteFacilityConnectionType::WebSocket:
+                return latencyStampedHookPair(
+                    runner.environment()
+                    , MULTI_TRANSPORT_REMOTE_FACILITY_CONNECTION_TYPE_STR[static_cast<int>(rpcConnType)]
+                    , rpcQueueLocator
+                    , DefaultHookFactory<Env>::template supplyFacilityHookPair_ServerSide<A,B>(runner.environment(), hooks)
+                );
+            default:
+                return hooks;
+            }
+        }
     public:
         template <class A, class B>
         static auto addIdentity(
@@ -115,6 +145,7 @@ namespace dev { namespace cd606 { namespace tm { namespace transport {
             , std::string const &wrapperItemsNamePrefix
             , std::optional<ByteDataHookPair> hooks = std::nullopt
         ) {
+            hooks = latencyStampedServerHooks<A,B>(runner, rpcConnType, rpcQueueLocator, hooks);
             switch (rpcConnType) {
             case MultiTransportRemoteFacilityConnectionType::RabbitMQ:
                 if constexpr (std::is_convertible_v<Env *, rabbitmq::RabbitMQComponent *>) {
@@ -167,6 +198,23 @@ namespace dev { namespace cd606 { namespace tm { namespace transport {
                     throw std::runtime_error(errOss.str());
                 }
                 break;
+            case MultiTransportRemoteFacilityConnectionType::Inproc:
+                if constexpr (std::is_convertible_v<Env *, inproc::InprocComponent *>) {
+                    if constexpr (Option == MultiTransportFacilityWrapperOption::NoReply) {
+                        inproc::InprocOnOrderFacility<Env>::template wrapOnOrderFacilityWithoutReply<A,B>(
+                            runner, toBeWrapped, rpcQueueLocator, wrapperItemsNamePrefix, hooks
+                        );
+                    } else {
+                        inproc::InprocOnOrderFacility<Env>::template wrapOnOrderFacility<A,B>(
+                            runner, toBeWrapped, rpcQueueLocator, wrapperItemsNamePrefix, hooks
+                        );
+                    }
+                } else {
+                    std::ostringstream errOss;
+                    errOss << "[MultiTransportFacilityWrapper::wrap(onOrderFacility)] trying to wrap a facility with inproc channel '" << rpcQueueLocator << "', but inproc is unsupported in the environment";
+                    throw std::runtime_error(errOss.str());
+                }
+                break;
             case MultiTransportRemoteFacilityConnectionType::GrpcInterop:
                 if constexpr (std::is_convertible_v<Env *, grpc_interop::GrpcInteropComponent *>) {
                     if constexpr (DetermineServerSideIdentityForRequest<Env, A>::HasIdentity) {
@@ -331,6 +379,7 @@ namespace dev { namespace cd606 { namespace tm { namespace transport {
             , std::string const &wrapperItemsNamePrefix
             , std::optional<ByteDataHookPair> hooks = std::nullopt
         ) {
+            hooks = latencyStampedServerHooks<A,B>(runner, rpcConnType, rpcQueueLocator, hooks);
             switch (rpcConnType) {
             case MultiTransportRemoteFacilityConnectionType::RabbitMQ:
                 if constexpr (std::is_convertible_v<Env *, rabbitmq::RabbitMQComponent *>) {
@@ -383,6 +432,23 @@ namespace dev { namespace cd606 { namespace tm { namespace transport {
                     throw std::runtime_error(errOss.str());
                 }
                 break;
+            case MultiTransportRemoteFacilityConnectionType::Inproc:
+                if constexpr (std::is_convertible_v<Env *, inproc::InprocComponent *>) {
+                    if constexpr (Option == MultiTransportFacilityWrapperOption::NoReply) {
+                        inproc::InprocOnOrderFacility<Env>::template wrapLocalOnOrderFacilityWithoutReply<A,B,C>(
+                            runner, toBeWrapped, rpcQueueLocator, wrapperItemsNamePrefix, hooks
+                        );
+                    } else {
+                        inproc::InprocOnOrderFacility<Env>::template wrapLocalOnOrderFacility<A,B,C>(
+                            runner, toBeWrapped, rpcQueueLocator, wrapperItemsNamePrefix, hooks
+                        );
+                    }
+                } else {
+                    std::ostringstream errOss;
+                    errOss << "[MultiTransportFacilityWrapper::wrap(localOnOrderFacility)] trying to wrap a facility with inproc channel '" << rpcQueueLocator << "', but inproc is unsupported in the environment";
+                    throw std::runtime_error(errOss.str());
+                }
+                break;
             case MultiTransportRemoteFacilityConnectionType::GrpcInterop:
                 if constexpr (std::is_convertible_v<Env *, grpc_interop::GrpcInteropComponent *>) {
                     if constexpr (DetermineServerSideIdentityForRequest<Env, A>::HasIdentity) {
@@ -551,6 +617,7 @@ namespace dev { namespace cd606 { namespace tm { namespace transport {
             , std::string const &wrapperItemsNamePrefix
             , std::optional<ByteDataHookPair> hooks = std::nullopt
         ) {
+            hooks = latencyStampedServerHooks<A,B>(runner, rpcConnType, rpcQueueLocator, hooks);
             switch (rpcConnType) {
             case MultiTransportRemoteFacilityConnectionType::RabbitMQ:
                 if constexpr (std::is_convertible_v<Env *, rabbitmq::RabbitMQComponent *>) {
@@ -603,6 +670,23 @@ namespace dev { namespace cd606 { namespace tm { namespace transport {
                     throw std::runtime_error(errOss.str());
                 }
                 break;
+            case MultiTransportRemoteFacilityConnectionType::Inproc:
+                if constexpr (std::is_convertible_v<Env *, inproc::InprocComponent *>) {
+                    if constexpr (Option == MultiTransportFacilityWrapperOption::NoReply) {
+                        inproc::InprocOnOrderFacility<Env>::template wrapOnOrderFacilityWithExternalEffectsWithoutReply<A,B,C>(
+                            runner, toBeWrapped, rpcQueueLocator, wrapperItemsNamePrefix, hooks
+                        );
+                    } else {
+                        inproc::InprocOnOrderFacility<Env>::template wrapOnOrderFacilityWithExternalEffects<A,B,C>(
+                            runner, toBeWrapped, rpcQueueLocator, wrapperItemsNamePrefix, hooks
+                        );
+                    }
+                } else {
+                    std::ostringstream errOss;
+                    errOss << "[MultiTransportFacilityWrapper::wrap(onOrderFacilityWithExternalEffects)] trying to wrap a facility with inproc channel '" << rpcQueueLocator << "', but inproc is unsupported in the environment";
+                    throw std::runtime_error(errOss.str());
+                }
+                break;
             case MultiTransportRemoteFacilityConnectionType::GrpcInterop:
                 if constexpr (std::is_convertible_v<Env *, grpc_interop::GrpcInteropComponent *>) {
                     if constexpr (DetermineServerSideIdentityForRequest<Env, A>::HasIdentity) {
@@ -772,6 +856,7 @@ namespace dev { namespace cd606 { namespace tm { namespace transport {
             , std::string const &wrapperItemsNamePrefix
             , std::optional<ByteDataHookPair> hooks = std::nullopt
         ) {
+            hooks = latencyStampedServerHooks<A,B>(runner, rpcConnType, rpcQueueLocator, hooks);
             switch (rpcConnType) {
             case MultiTransportRemoteFacilityConnectionType::RabbitMQ:
                 if constexpr (std::is_convertible_v<Env *, rabbitmq::RabbitMQComponent *>) {
@@ -824,6 +909,23 @@ namespace dev { namespace cd606 { namespace tm { namespace transport {
                     throw std::runtime_error(errOss.str());
                 }
                 break;
+            case MultiTransportRemoteFacilityConnectionType::Inproc:
+                if constexpr (std::is_convertible_v<Env *, inproc::InprocComponent *>) {
+                    if constexpr (Option == MultiTransportFacilityWrapperOption::NoReply) {
+                        inproc::InprocOnOrderFacility<Env>::template wrapVIEOnOrderFacilityWithoutReply<A,B,C,D>(
+                            runner, toBeWrapped, rpcQueueLocator, wrapperItemsNamePrefix, hooks
+                        );
+                    } else {
+                        inproc::InprocOnOrderFacility<Env>::template wrapVIEOnOrderFacility<A,B,C,D>(
+                            runner, toBeWrapped, rpcQueueLocator, wrapperItemsNamePrefix, hooks
+                        );
+                    }
+                } else {
+                    std::ostringstream errOss;
+                    errOss << "[MultiTransportFacilityWrapper::wrap(vieOnOrderFacility)] trying to wrap a facility with inproc channel '" << rpcQueueLocator << "', but inproc is unsupported in the environment";
+                    throw std::runtime_error(errOss.str());
+                }
+                break;
             case MultiTransportRemoteFacilityConnectionType::GrpcInterop:
                 if constexpr (std::is_convertible_v<Env *, grpc_interop::GrpcInteropComponent *>) {
                     if constexpr (DetermineServerSideIdentityForRequest<Env, A>::HasIdentity) {
@@ -996,6 +1098,7 @@ namespace dev { namespace cd606 { namespace tm { namespace transport {
             , std::string const &wrapperItemsNamePrefix
             , std::optional<ByteDataHookPair> hooks = std::nullopt
         ) {
+            hooks = latencyStampedServerHooks<A,B>(runner, rpcConnType, rpcQueueLocator, hooks);
             switch (rpcConnType) {
             case MultiTransportRemoteFacilityConnectionType::RabbitMQ:
                 if constexpr (std::is_convertible_v<Env *, rabbitmq::RabbitMQComponent *>) {
@@ -1048,6 +1151,23 @@ namespace dev { namespace cd606 { namespace tm { namespace transport {
                     throw std::runtime_error(errOss.str());
                 }
                 break;
+            case MultiTransportRemoteFacilityConnectionType::Inproc:
+                if constexpr (std::is_convertible_v<Env *, inproc::InprocComponent *>) {
+                    if constexpr (Option == MultiTransportFacilityWrapperOption::NoReply) {
+                        inproc::InprocOnOrderFacility<Env>::template wrapFacilitioidConnectorWithoutReply<A,B>(
+                            runner, registeredNameForFacilitioid, toBeWrapped, rpcQueueLocator, wrapperItemsNamePrefix, hooks
+                        );
+                    } else {
+                        inproc::InprocOnOrderFacility<Env>::template wrapFacilitioidConnector<A,B>(
+                            runner, registeredNameForFacilitioid, toBeWrapped, rpcQueueLocator, wrapperItemsNamePrefix, hooks
+                        );
+                    }
+                } else {
+                    std::ostringstream errOss;
+                    errOss << "[MultiTransportFacilityWrapper::wrap(FacilitioidConnector)] trying to wrap a facility with inproc channel '" << rpcQueueLocator << "', but inproc is unsupported in the environment";
+                    throw std::runtime_error(errOss.str());
+                }
+                break;
             case MultiTransportRemoteFacilityConnectionType::GrpcInterop:
                 if constexpr (std::is_convertible_v<Env *, grpc_interop::GrpcInteropComponent *>) {
                     if constexpr (DetermineServerSideIdentityForRequest<Env, A>::HasIdentity) {
@@ -15,12 +15,15 @@
 #include <tm_kit/transport/socket_rpc/SocketRPCComponent.hpp>
 #include <tm_kit/transport/singlecast/SinglecastComponent.hpp>
 #include <tm_kit/transport/socket_rpc/SocketRPCOnOrderFacility.hpp>
+#include <tm_kit/transport/inproc/InprocComponent.hpp>
+#include <tm_kit/transport/inproc/InprocOnOrderFacility.hpp>
 #include <tm_kit/transport/grpc_interop/GrpcInteropComponent.hpp>
 #include <tm_kit/transport/grpc_interop/GrpcClientFacility.hpp>
 #include <tm_kit/transport/json_rest/JsonRESTClientFacility.hpp>
 #include <tm_kit/transport/websocket/WebSocketClientFacility.hpp>
 #include <tm_kit/transport/AbstractIdentityCheckerComponent.hpp>
 #include <tm_kit/transport/MultiTransportBroadcastListenerManagingUtils.hpp>
+#include <tm_kit/transport/LatencyStamping.hpp>
 
 #include <type_traits>
 #include <regex>
@@ -43,14 +46,16 @@ namespace dev { namespace cd606 { namespace tm { namespace transport {
         , GrpcInterop
         , JsonREST
         , WebSocket
+        , Inproc
     };
-    inline const std::array<std::string,6> MULTI_TRANSPORT_REMOTE_FACILITY_CONNECTION_TYPE_STR = {
+    inline const std::array<std::string,7> MULTI_TRANSPORT_REMOTE_FACILITY_CONNECTION_TYPE_STR = {
         "rabbitmq"
         , "redis"
         , "socket_rpc"
         , "grpc_interop"
         , "json_rest"
         , "websocket"
+        , "inproc"
     };
 
     inline auto parseMultiTransportRemoteFacilityChannel(std::string const &s) 
@@ -186,7 +191,7 @@ namespace dev { namespace cd606 { namespace tm { namespace transport {
                         uint32_t clientNumber = 0;
                         auto rawReq = component->rabbitmq_setRPCQueueClient(
                             locator
-                            , [this,env](bool isFinal, basic::ByteDataWithID &&data) {
+                            , [this,env,locator](bool isFinal, basic::ByteDataWithID &&data) {
                                 if constexpr (std::is_same_v<Identity, void>) {
                                     Output o;
                                     auto result = basic::bytedata_utils::RunDeserializer<Output>::applyInPlace(o, data.content);
@@ -202,8 +207,9 @@ namespace dev { namespace cd606 { namespace tm { namespace transport {
                                         , isFinal
                                     );
                                 } else {
-                                    auto processRes = static_cast<typename DetermineClientSideIdentityForRequest<Env, A>::ComponentType *>(env)->process_incoming_data(
-                                        basic::ByteData {std::move(data.content)}
+                                    auto processRes = static_cast<typename DetermineClientSideIdentityForRequest<Env, A>::ComponentType *>(env)->process_incoming_data_from(
+                                        locator
+                                        , basic::ByteData {std::move(data.content)}
                                     );
                                     if (processRes) {
                                         Output o;
@@ -222,7 +228,7 @@ namespace dev { namespace cd606 { namespace tm { namespace transport {
                                     }
                                 }
                             }
-                            , DefaultHookFactory<Env>::template supplyFacilityHookPair_ClientSide<A,B>(env, hookPairFactory_(description, locator))
+                            , latencyStampedHookPair(env, "rabbitmq", locator, DefaultHookFactory<Env>::template supplyFacilityHookPair_ClientSide<A,B>(env, hookPairFactory_(description, locator)))
                             , &clientNumber
                         );
                         RequestSender req;
@@ -237,10 +243,10 @@ namespace dev { namespace cd606 { namespace tm { namespace transport {
                             static_assert(std::is_convertible_v<Env *, typename DetermineClientSideIdentityForRequest<Env, A>::ComponentType *>
                                         , "the client side identity attacher must be present");
                             auto *attacher = static_cast<typename DetermineClientSideIdentityForRequest<Env, A>::ComponentType *>(env);
-                            req = [attacher,rawReq](std::string const &id, A &&data) {
+                            req = [attacher,rawReq,locator](std::string const &id, A &&data) {
                                 rawReq(basic::ByteDataWithID {
                                     id
-                                    , attacher->attach_identity({basic::SerializationActions<M>::template serializeFunc<A>(std::move(data))}).content
+                                    , attacher->attach_identity_for(locator, {basic::SerializationActions<M>::template serializeFunc<A>(std::move(data))}).content
                                 });
                             };
                         }
@@ -281,7 +287,7 @@ namespace dev { namespace cd606 { namespace tm { namespace transport {
                             , [env]() {
                                 return Env::id_to_string(env->new_id());
                             }
-                            , [this,env](bool isFinal, basic::ByteDataWithID &&data) {
+                            , [this,env,locator](bool isFinal, basic::ByteDataWithID &&data) {
                                 if constexpr (std::is_same_v<Identity, void>) {
                                     Output o;
                                     auto result = basic::bytedata_utils::RunDeserializer<Output>::applyInPlace(o, data.content);
@@ -297,8 +303,9 @@ namespace dev { namespace cd606 { namespace tm { namespace transport {
                                         , isFinal
                                     );
                                 } else {
-                                    auto processRes = static_cast<typename DetermineClientSideIdentityForRequest<Env, A>::ComponentType *>(env)->process_incoming_data(
-                                        basic::ByteData {std::move(data.content)}
+                                    auto processRes = static_cast<typename DetermineClientSideIdentityForRequest<Env, A>::ComponentType *>(env)->process_incoming_data_from(
+                                        locator
+                                        , basic::ByteData {std::move(data.content)}
                                     );
                                     if (processRes) {
                                         Output o;
@@ -317,7 +324,7 @@ namespace dev { namespace cd606 { namespace tm { namespace transport {
                                     }
                                 }
                             }
-                            , DefaultHookFactory<Env>::template supplyFacilityHookPair_ClientSide<A,B>(env, hookPairFactory_(description, locator))
+                            , latencyStampedHookPair(env, "redis", locator, DefaultHookFactory<Env>::template supplyFacilityHookPair_ClientSide<A,B>(env, hookPairFactory_(description, locator)))
                             , &clientNumber
                         );
                         RequestSender req;
@@ -332,10 +339,10 @@ namespace dev { namespace cd606 { namespace tm { namespace transport {
                             static_assert(std::is_convertible_v<Env *, typename DetermineClientSideIdentityForRequest<Env, A>::ComponentType *>
                                         , "the client side identity attacher must be present");
                             auto *attacher = static_cast<typename DetermineClientSideIdentityForRequest<Env, A>::ComponentType *>(env);
-                            req = [attacher,rawReq](std::string const &id, A &&data) {
+                            req = [attacher,rawReq,locator](std::string const &id, A &&data) {
                                 rawReq(basic::ByteDataWithID {
                                     id
-                                    , attacher->attach_identity({basic::SerializationActions<M>::template serializeFunc<A>(std::move(data))}).content
+                                    , attacher->attach_identity_for(locator, {basic::SerializationActions<M>::template serializeFunc<A>(std::move(data))}).content
                                 });
                             };
                         }
@@ -372,7 +379,7 @@ namespace dev { namespace cd606 { namespace tm { namespace transport {
                     try {
                         auto rawReq = component->socket_rpc_setRPCClient(
                             locator
-                            , [this,env](bool isFinal, basic::ByteDataWithID &&data) {
+                            , [this,env,locator](bool isFinal, basic::ByteDataWithID &&data) {
                                 if constexpr (std::is_same_v<Identity, void>) {
                                     Output o;
                                     auto result = basic::bytedata_utils::RunDeserializer<Output>::applyInPlace(o, data.content);
@@ -388,8 +395,9 @@ namespace dev { namespace cd606 { namespace tm { namespace transport {
                                         , isFinal
                                     );
                                 } else {
-                                    auto processRes = static_cast<typename DetermineClientSideIdentityForRequest<Env, A>::ComponentType *>(env)->process_incoming_data(
-                                        basic::ByteData {std::move(data.content)}
+                                    auto processRes = static_cast<typename DetermineClientSideIdentityForRequest<Env, A>::ComponentType *>(env)->process_incoming_data_from(
+                                        locator
+                                        , basic::ByteData {std::move(data.content)}
                                     );
                                     if (processRes) {
                                         Output o;
@@ -408,7 +416,7 @@ namespace dev { namespace cd606 { namespace tm { namespace transport {
                                     }
                                 }
                             }
-                            , DefaultHookFactory<Env>::template supplyFacilityHookPair_ClientSide<A,B>(env, hookPairFactory_(description, locator))
+                            , latencyStampedHookPair(env, "socket_rpc", locator, DefaultHookFactory<Env>::template supplyFacilityHookPair_ClientSide<A,B>(env, hookPairFactory_(description, locator)))
                         );
                         RequestSender req;
                         if constexpr (std::is_same_v<Identity,void>) {
@@ -422,10 +430,10 @@ namespace dev { namespace cd606 { namespace tm { namespace transport {
                             static_assert(std::is_convertible_v<Env *, typename DetermineClientSideIdentityForRequest<Env, A>::ComponentType *>
                                         , "the client side identity attacher must be present");
                             auto *attacher = static_cast<typename DetermineClientSideIdentityForRequest<Env, A>::ComponentType *>(env);
-                            req = [attacher,rawReq](std::string const &id, A &&data) {
+                            req = [attacher,rawReq,locator](std::string const &id, A &&data) {
                                 rawReq(basic::ByteDataWithID {
                                     id
-                                    , attacher->attach_identity({basic::SerializationActions<M>::template serializeFunc<A>(std::move(data))}).content
+                                    , attacher->attach_identity_for(locator, {basic::SerializationActions<M>::template serializeFunc<A>(std::move(data))}).content
                                 });
                             };
                         }
@@ -455,6 +463,105 @@ namespace dev { namespace cd606 { namespace tm { namespace transport {
                 }
                 return {newSize, true};
                 break;
+            case MultiTransportRemoteFacilityConnectionType::Inproc:
+                if constexpr (std::is_convertible_v<Env *, inproc::InprocComponent *>) {
+                    auto *component = static_cast<inproc::InprocComponent *>(env);
+                    try {
+                        auto rawReq = component->inproc_setRPCClient(
+                            locator
+                            , [this,env,locator](bool isFinal, basic::ByteDataWithID &&data) {
+                                if constexpr (std::is_same_v<Identity, void>) {
+                                    Output o;
+                                    auto result = basic::bytedata_utils::RunDeserializer<Output>::applyInPlace(o, data.content);
+                                    if (!result) {
+                                        return;
+                                    }
+                                    this->FacilityParent::publish(
+                                        env
+                                        , typename M::template Key<Output> {
+                                            Env::id_from_string(data.id)
+                                            , std::move(o)
+                                        }
+                                        , isFinal
+                                    );
+                                } else {
+                                    auto processRes = static_cast<typename DetermineClientSideIdentityForRequest<Env, A>::ComponentType *>(env)->process_incoming_data_from(
+                                        locator
+                                        , basic::ByteData {std::move(data.content)}
+                                    );
+                                    if (processRes) {
+                                        Output o;
+                                        auto result = basic::bytedata_utils::RunDeserializer<Output>::applyInPlace(o, processRes->content);
+                                        if (!result) {
+                                            return;
+                                        }
+                                        this->FacilityParent::publish(
+                                            env
+                                            , typename M::template Key<Output> {
+                                                Env::id_from_string(data.id)
+                                                , std::move(o)
+                                            }
+                                            , isFinal
+                                        );
+                                    }
+                                }
+                            }
+                            , latencyStampedHookPair(env, "inproc", locator, DefaultHookFactory<Env>::template supplyFacilityHookPair_ClientSide<A,B>(env, hookPairFactory_(description, locator)))
+                        );
+                        //the requester throws if the inproc server has gone
+                        RequestSender req;
+                        if constexpr (std::is_same_v<Identity,void>) {
+                            req = [env,rawReq](std::string const &id, A &&data) {
+                                try {
+                                    rawReq(basic::ByteDataWithID {
+                                        id 
+                                        , basic::SerializationActions<M>::template serializeFunc<A>(std::move(data))
+                                    });
+                                } catch (inproc::InprocComponentException const &ex) {
+                                    env->log(infra::LogLevel::Warning, std::string("[MultiTransportRemoteFacility] ")+ex.what());
+                                }
+                            };
+                        } else {
+                            static_assert(std::is_convertible_v<Env *, typename DetermineClientSideIdentityForRequest<Env, A>::ComponentType *>
+                                        , "the client side identity attacher must be present");
+                            auto *attacher = static_cast<typename DetermineClientSideIdentityForRequest<Env, A>::ComponentType *>(env);
+                            req = [env,attacher,rawReq,locator](std::string const &id, A &&data) {
+                                try {
+                                    rawReq(basic::ByteDataWithID {
+                                        id
+                                        , attacher->attach_identity_for(locator, {basic::SerializationActions<M>::template serializeFunc<A>(std::move(data))}).content
+                                    });
+                                } catch (inproc::InprocComponentException const &ex) {
+                                    env->log(infra::LogLevel::Warning, std::string("[MultiTransportRemoteFacility] ")+ex.what());
+                                }
+                            };
+                        }
+                        {
+                            std::lock_guard<std::mutex> _(mutex_);
+                            underlyingSenders_.push_back({locator, std::make_unique<RequestSender>(std::move(req))});
+                            if constexpr (DispatchStrategy == MultiTransportRemoteFacilityDispatchStrategy::Designated) {
+                                senderMap_.insert({locator, std::get<1>(underlyingSenders_.back()).get()});
+                            }
+                            newSize = underlyingSenders_.size();
+                        }
+                        std::ostringstream oss;
+                        oss << "[MultiTransportRemoteFacility::registerFacility] Registered inproc facility for "
+                            << locator;
+                        env->log(infra::LogLevel::Info, oss.str());
+                    } catch (inproc::InprocComponentException const &ex) {
+                        std::ostringstream oss;
+                        oss << "[MultiTransportRemoteFacility::registerFacility] Error registering inproc facility for "
+                            << locator
+                            << ": " << ex.what();
+                        env->log(infra::LogLevel::Error, oss.str());
+                    }
+                } else {
+                    std::ostringstream errOss;
+                    errOss << "[MultiTransportRemoteFacility::registerFacility] Trying to set up inproc facility for " << locator << ", but inproc is unsupported in the environment";
+                    env->log(infra::LogLevel::Warning, errOss.str());
+                }
+                return {newSize, true};
+                break;
             case MultiTransportRemoteFacilityConnectionType::GrpcInterop:
                 if constexpr (std::is_convertible_v<Env *, grpc_interop::GrpcInteropComponent *>) {
                     if constexpr (std::is_same_v<Identity, void> || std::is_same_v<Identity, std::string>) {
@@ -720,7 +827,7 @@ namespace dev { namespace cd606 { namespace tm { namespace transport {
                         uint32_t clientNumber = 0;
                         auto rawReq = component->websocket_setRPCClient(
                             locator
-                            , [this,env](bool isFinal, basic::ByteDataWithID &&data) {
+                            , [this,env,locator](bool isFinal, basic::ByteDataWithID &&data) {
                                 if constexpr (std::is_same_v<Identity, void>) {
                                     Output o;
                                     auto result = basic::bytedata_utils::RunDeserializer<Output>::applyInPlace(o, data.content);
@@ -736,8 +843,9 @@ namespace dev { namespace cd606 { namespace tm { namespace transport {
                                         , isFinal
                                     );
                                 } else {
-                                    auto processRes = static_cast<typename DetermineClientSideIdentityForRequest<Env, A>::ComponentType *>(env)->process_incoming_data(
-                                        basic::ByteData {std::move(data.content)}
+                                    auto processRes = static_cast<typename DetermineClientSideIdentityForRequest<Env, A>::ComponentType *>(env)->process_incoming_data_from(
+                                        locator
+                                        , basic::ByteData {std::move(data.content)}
                                     );
                                     if (processRes) {
                                         Output o;
@@ -756,7 +864,7 @@ namespace dev { namespace cd606 { namespace tm { namespace transport {
                                     }
                                 }
                             }
-                            , DefaultHookFactory<Env>::template supplyFacilityHookPair_ClientSide<A,B>(env, hookPairFactory_(description, locator))
+                            , latencyStampedHookPair(env, "websocket", locator, DefaultHookFactory<Env>::template supplyFacilityHookPair_ClientSide<A,B>(env, hookPairFactory_(description, locator)))
                             , &clientNumber
                         );
                         RequestSender req;
@@ -771,10 +879,10 @@ namespace dev { namespace cd606 { namespace tm { namespace transport {
                             static_assert(std::is_convertible_v<Env *, typename DetermineClientSideIdentityForRequest<Env, A>::ComponentType *>
                                         , "the client side identity attacher must be present");
                             auto *attacher = static_cast<typename DetermineClientSideIdentityForRequest<Env, A>::ComponentType *>(env);
-                            req = [attacher,rawReq](std::string const &id, A &&data) {
+                            req = [attacher,rawReq,locator](std::string const &id, A &&data) {
                                 rawReq(basic::ByteDataWithID {
                                     id
-                                    , attacher->attach_identity({basic::SerializationActions<M>::template serializeFunc<A>(std::move(data))}).content
+                                    , attacher->attach_identity_for(locator, {basic::SerializationActions<M>::template serializeFunc<A>(std::move(data))}).content
                                 });
                             };
                         }
@@ -915,6 +1023,34 @@ namespace dev { namespace cd606 { namespace tm { namespace transport {
                 }
                 return {newSize, true};
                 break;
+            case MultiTransportRemoteFacilityConnectionType::Inproc:
+                if constexpr (std::is_convertible_v<Env *, inproc::InprocComponent *>) {
+                    auto *component = static_cast<inproc::InprocComponent *>(env);
+                    component->inproc_removeRPCClient(locator);
+                    {
+                        std::lock_guard<std::mutex> _(mutex_);
+                        if constexpr (DispatchStrategy == MultiTransportRemoteFacilityDispatchStrategy::Designated) {
+                            senderMap_.erase(locator);
+                        }
+                        underlyingSenders_.erase(
+                            std::remove_if(
+                                underlyingSenders_.begin()
+                                , underlyingSenders_.end()
+                                , [&locator](auto const &x) {
+                                    return (std::get<0>(x) == locator);
+                                }
+                            )
+                            , underlyingSenders_.end()
+                        );
+                        newSize = underlyingSenders_.size();
+                    }
+                    std::ostringstream oss;
+                    oss << "[MultiTransportRemoteFacility::deregisterFacility] De-registered inproc facility for "
+                        << locator;
+                    env->log(infra::LogLevel::Info, oss.str());
+                }
+                return {newSize, true};
+                break;
             case MultiTransportRemoteFacilityConnectionType::GrpcInterop:
                 if constexpr (std::is_convertible_v<Env *, grpc_interop::GrpcInteropComponent *>) {
                     auto *component = static_cast<grpc_interop::GrpcInteropComponent *>(env);
@@ -1138,6 +1274,14 @@ namespace dev { namespace cd606 { namespace tm { namespace transport {
                 } else {
                     throw std::runtime_error("OneShotMultiTransportRemoteFacilityCall::call: connection type Socket RPC not supported in environment");
                 }
+            } else if (connType == MultiTransportRemoteFacilityConnectionType::Inproc) {
+                if constexpr (std::is_convertible_v<Env *, inproc::InprocComponent *>) {
+                    return inproc::InprocOnOrderFacility<Env>::template typedOneShotRemoteCall<A,B>(
+                        env, locator, std::move(request), hooks, autoDisconnect
+                    );
+                } else {
+                    throw std::runtime_error("OneShotMultiTransportRemoteFacilityCall::call: connection type inproc not supported in environment");
+                }
             } else if (connType == MultiTransportRemoteFacilityConnectionType::GrpcInterop) {
                 if constexpr (std::is_convertible_v<Env *, grpc_interop::GrpcInteropComponent *>) {
                     if (hooks) {
@@ -1299,6 +1443,14 @@ namespace dev { namespace cd606 { namespace tm { namespace transport {
                 } else {
                     throw std::runtime_error("OneShotMultiTransportRemoteFacilityCall::callNoReply: connection type Socket RPC not supported in environment");
                 }
+            } else if (connType == MultiTransportRemoteFacilityConnectionType::Inproc) {
+                if constexpr (std::is_convertible_v<Env *, inproc::InprocComponent *>) {
+                    inproc::InprocOnOrderFacility<Env>::template typedOneShotRemoteCallNoReply<A,B>(
+                        env, locator, std::move(request), hooks, autoDisconnect
+                    );
+                } else {
+                    throw std::runtime_error("OneShotMultiTransportRemoteFacilityCall::callNoReply: connection type inproc not supported in environment");
+                }
             } else if (connType == MultiTransportRemoteFacilityConnectionType::GrpcInterop) {
                 if constexpr (std::is_convertible_v<Env *, grpc_interop::GrpcInteropComponent *>) {
                     if (hooks) {
@@ -1433,6 +1585,12 @@ namespace dev { namespace cd606 { namespace tm { namespace transport {
                 } else {
                     throw std::runtime_error("OneShotMultiTransportRemoteFacilityCall::removeClient: connection type Socket RPC not supported in environment");
                 }
+            } else if (connType == MultiTransportRemoteFacilityConnectionType::Inproc) {
+                if constexpr (std::is_convertible_v<Env *, inproc::InprocComponent *>) {
+                    env->inproc_removeRPCClient(locator);
+                } else {
+                    throw std::runtime_error("OneShotMultiTransportRemoteFacilityCall::removeClient: connection type inproc not supported in environment");
+                }
             } else if (connType == MultiTransportRemoteFacilityConnectionType::GrpcInterop) {
                 if constexpr (std::is_convertible_v<Env *, grpc_interop::GrpcInteropComponent *>) {
                     env->grpc_interop_removeRPCClient(locator);
@@ -1354,6 +1354,13 @@ namespace dev { namespace cd606 { namespace tm { namespace transport {
                     throw std::runtime_error("[MultiTransportRemoteFacilityManagingUtils::setupSimpleRemoteFacility] trying to set up socket rpc facility for channel spec '"+locator.toPrintFormat()+"', but socket rpc is unsupported in the environment");
                 }
                 break;
+            case MultiTransportRemoteFacilityConnectionType::Inproc:
+                if constexpr(std::is_convertible_v<typename R::EnvironmentType *, inproc::InprocComponent *>) {
+                    return inproc::InprocOnOrderFacility<typename R::EnvironmentType>::template createTypedRPCOnOrderFacility<Request,Result>(locator, hooks);
+                } else {
+                    throw std::runtime_error("[MultiTransportRemoteFacilityManagingUtils::setupSimpleRemoteFacility] trying to set up inproc facility for channel spec '"+locator.toPrintFormat()+"', but inproc is unsupported in the environment");
+                }
+                break;
             case MultiTransportRemoteFacilityConnectionType::GrpcInterop:
                 if constexpr(std::is_convertible_v<typename R::EnvironmentType *, grpc_interop::GrpcInteropComponent *>) {
                     if constexpr(DetermineClientSideIdentityForRequest<typename R::EnvironmentType, Request>::HasIdentity) {
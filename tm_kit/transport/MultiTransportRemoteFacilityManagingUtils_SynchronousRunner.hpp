@@ -54,6 +54,11 @@ namespace dev { namespace cd606 { namespace tm { namespace transport {
             auto heartbeatMsg = r.importItemUntil(
                 heartbeatImporter 
                 , [facilityServerHeartbeatIdentityRE,facilityRegistrationName](typename M::template InnerData<basic::TypedDataWithTopic<HeartbeatMessage>> const &h) {
+                    //only full heartbeats are looked at, see
+                    //HeartbeatMessage::isDelta
+                    if (h.timedData.value.content.isDelta()) {
+                        return false;
+                    }
                     if (!std::regex_match(h.timedData.value.content.senderDescription(), facilityServerHeartbeatIdentityRE)) {
                         return false;
                     }
@@ -0,0 +1,75 @@
+#ifndef TM_KIT_TRANSPORT_RECEIVE_DECODING_HPP_
+#define TM_KIT_TRANSPORT_RECEIVE_DECODING_HPP_
+
+#include <tm_kit/basic/ByteData.hpp>
+#include <tm_kit/transport/TransportMetricsComponent.hpp>
+#include <tm_kit/transport/LazilyDecodedData.hpp>
+#include <tm_kit/transport/AbstractHookFactoryComponent.hpp>
+
+#include <memory>
+#include <optional>
+#include <string>
+
+namespace dev { namespace cd606 { namespace tm { namespace transport {
+
+    //How a broadcast importer turns the received bytes into what it
+    //publishes (Output). Value is the type that an in-process publisher
+    //can hand over as an object (void if there is none), and the default
+    //incoming hook of Value is used when the importer is not given a hook.
+    struct RawReceiveDecoding {
+        using Output = basic::ByteDataWithTopic;
+        using Value = void;
+        template <class Env>
+        static std::optional<WireToUserHook> defaultIncomingHook(Env *) {
+            return std::nullopt;
+        }
+        static std::optional<Output> decode(basic::ByteDataWithTopic &&d, std::shared_ptr<TransportChannelMetrics> const &) {
+            return {std::move(d)};
+        }
+    };
+
+    template <class T>
+    struct TypedReceiveDecoding {
+        using Output = basic::TypedDataWithTopic<T>;
+        using Value = T;
+        template <class Env>
+        static std::optional<WireToUserHook> defaultIncomingHook(Env *env) {
+            return DefaultHookFactory<Env>::template incomingHook<T>(env);
+        }
+        static std::optional<Output> decode(basic::ByteDataWithTopic &&d, std::shared_ptr<TransportChannelMetrics> const &metrics) {
+            T t;
+            auto tRes = basic::bytedata_utils::RunDeserializer<T>::applyInPlace(t, d.content);
+            if (!tRes) {
+                if (metrics) {
+                    metrics->recordDecodeFailure();
+                }
+                return std::nullopt;
+            }
+            return Output {std::move(d.topic), std::move(t)};
+        }
+        static Output fromValue(std::string const &topic, T const &v) {
+            return Output {topic, v};
+        }
+    };
+
+    template <class T>
+    struct LazyReceiveDecoding {
+        using Output = LazilyDecodedDataWithTopic<T>;
+        using Value = T;
+        template <class Env>
+        static std::optional<WireToUserHook> defaultIncomingHook(Env *env) {
+            return DefaultHookFactory<Env>::template incomingHook<T>(env);
+        }
+        //decoding failures are counted when value() is called
+        static std::optional<Output> decode(basic::ByteDataWithTopic &&d, std::shared_ptr<TransportChannelMetrics> const &metrics) {
+            return Output {std::move(d), metrics};
+        }
+        static Output fromValue(std::string const &topic, T const &v) {
+            T t {v};
+            return Output {std::string {topic}, std::move(t)};
+        }
+    };
+
+} } } }
+
+#endif
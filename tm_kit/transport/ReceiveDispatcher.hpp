@@ -0,0 +1,57 @@
+#ifndef TM_KIT_TRANSPORT_RECEIVE_DISPATCHER_HPP_
+#define TM_KIT_TRANSPORT_RECEIVE_DISPATCHER_HPP_
+
+#include <tm_kit/basic/ByteData.hpp>
+#include <tm_kit/transport/ConnectionLocator.hpp>
+#include <tm_kit/transport/TransportMetricsComponent.hpp>
+
+#include <memory>
+#include <functional>
+
+namespace dev { namespace cd606 { namespace tm { namespace transport {
+
+    class ReceiveDispatcherImpl;
+
+    //Moves the importer's work off the receiving thread to worker threads
+    //chosen by the hash of the topic (so each topic stays in order),
+    //through bounded lock-free queues. Locator properties:
+    //  - dispatch_threads=N, 0 (the default) disables it
+    //  - dispatch_queue_size=N, per worker, 4096 by default
+    //  - dispatch_overflow=block|drop, what a full queue does
+    //It is not used together with conflate=true.
+    class ReceiveDispatcher {
+    private:
+        std::unique_ptr<ReceiveDispatcherImpl> impl_;
+    public:
+        enum class OverflowPolicy {
+            Block
+            , Drop
+        };
+        struct Options {
+            std::size_t threadCount = 0;
+            std::size_t queueSize = 4096;
+            OverflowPolicy overflowPolicy = OverflowPolicy::Block;
+        };
+        static Options optionsFor(ConnectionLocator const &locator);
+
+        ReceiveDispatcher(std::function<void(basic::ByteDataWithTopic &&)> const &deliver, Options const &options, std::shared_ptr<TransportChannelMetrics> const &metrics=nullptr);
+        ReceiveDispatcher(ReceiveDispatcher const &) = delete;
+        ReceiveDispatcher &operator=(ReceiveDispatcher const &) = delete;
+        //messages still in the queues are discarded
+        ~ReceiveDispatcher();
+
+        void push(basic::ByteDataWithTopic &&data);
+    };
+
+    //Returns null unless the locator has dispatch_threads set
+    inline std::unique_ptr<ReceiveDispatcher> receiveDispatcherFor(ConnectionLocator const &locator, std::function<void(basic::ByteDataWithTopic &&)> const &deliver, std::shared_ptr<TransportChannelMetrics> const &metrics) {
+        auto options = ReceiveDispatcher::optionsFor(locator);
+        if (options.threadCount == 0) {
+            return nullptr;
+        }
+        return std::make_unique<ReceiveDispatcher>(deliver, options, metrics);
+    }
+
+} } } }
+
+#endif
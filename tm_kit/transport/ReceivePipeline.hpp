@@ -0,0 +1,82 @@
+#ifndef TM_KIT_TRANSPORT_RECEIVE_PIPELINE_HPP_
+#define TM_KIT_TRANSPORT_RECEIVE_PIPELINE_HPP_
+
+#include <tm_kit/infra/LogLevel.hpp>
+#include <tm_kit/basic/ByteData.hpp>
+#include <tm_kit/transport/ConnectionLocator.hpp>
+#include <tm_kit/transport/ByteDataHook.hpp>
+#include <tm_kit/transport/TransportMetricsComponent.hpp>
+#include <tm_kit/transport/LatencyStamping.hpp>
+#include <tm_kit/transport/ConflatingDelivery.hpp>
+#include <tm_kit/transport/ReceiveDispatcher.hpp>
+
+#include <memory>
+#include <functional>
+#include <optional>
+#include <string>
+
+namespace dev { namespace cd606 { namespace tm { namespace transport {
+
+    //What a broadcast importer puts between the transport's receiving
+    //thread and its own delivery: the channel's metrics, the latency
+    //stamping of the incoming hook, and the conflation or dispatching that
+    //the locator asks for.
+    class ReceivePipeline {
+    private:
+        ConnectionLocator locator_;
+        std::shared_ptr<TransportChannelMetrics> metrics_;
+        std::unique_ptr<ConflatingDelivery> conflater_;
+        std::unique_ptr<ReceiveDispatcher> dispatcher_;
+        std::function<void(basic::ByteDataWithTopic &&)> deliver_;
+    public:
+        ReceivePipeline() : locator_(), metrics_(), conflater_(), dispatcher_(), deliver_() {}
+        ReceivePipeline(ReceivePipeline const &) = delete;
+        ReceivePipeline &operator=(ReceivePipeline const &) = delete;
+
+        //only the first call does anything, so that a restarted importer
+        //keeps its pipeline
+        template <class Env>
+        void setup(Env *env, std::string const &transport, ConnectionLocator const &locator, std::function<void(basic::ByteDataWithTopic &&)> const &deliver) {
+            if (deliver_) {
+                return;
+            }
+            locator_ = locator;
+            deliver_ = deliver;
+            metrics_ = transportChannelMetrics(env, transport, locator);
+            conflater_ = conflatingDeliveryFor(locator, deliver_, metrics_);
+            if (!conflater_) {
+                dispatcher_ = receiveDispatcherFor(locator, deliver_, metrics_);
+            } else if (ReceiveDispatcher::optionsFor(locator).threadCount > 0) {
+                env->log(infra::LogLevel::Warning, "[ReceivePipeline] "+transport+" channel "+locator.toPrintFormat()+" has both conflate=true and dispatch_threads, the dispatch threads are not used");
+            }
+        }
+        std::shared_ptr<TransportChannelMetrics> const &metrics() const {
+            return metrics_;
+        }
+        //true if push() hands the message to another thread
+        bool isDecoupled() const {
+            return (conflater_ || dispatcher_);
+        }
+        std::optional<WireToUserHook> incomingHook(std::optional<WireToUserHook> const &hook) const {
+            if (!LatencyStampingHelper::enabledFor(locator_)) {
+                return hook;
+            }
+            return LatencyStampingHelper::addToIncomingHook(metrics_, hook);
+        }
+        void push(basic::ByteDataWithTopic &&d) {
+            if (metrics_) {
+                metrics_->recordInbound(d.content.length());
+            }
+            if (conflater_) {
+                conflater_->push(std::move(d));
+            } else if (dispatcher_) {
+                dispatcher_->push(std::move(d));
+            } else {
+                deliver_(std::move(d));
+            }
+        }
+    };
+
+} } } }
+
+#endif
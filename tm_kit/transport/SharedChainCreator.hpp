@@ -326,13 +326,14 @@ namespace dev { namespace cd606 { namespace tm { namespace transport {
             , std::string const &memoryName
             , std::size_t memorySize
             , bool useNotification
+            , SharedMemorySegmentOptions const &segmentOptions
         ) {
             return getChain<T>(
                 name 
-                , [env,hookPair,memoryName,memorySize,useNotification]() {
+                , [env,hookPair,memoryName,memorySize,useNotification,segmentOptions]() {
                     return new T(memoryName, memorySize, DefaultHookFactory<typename App::EnvironmentType>::template supplyFacilityHookPair_SingleType<typename T::DataType>(
                         env, hookPair
-                    ), useNotification);
+                    ), useNotification, segmentOptions);
                 }
             );
         }
@@ -429,6 +430,7 @@ namespace dev { namespace cd606 { namespace tm { namespace transport {
                         bool dataLockIsNamedMutex = (locator.query("dataLock", "named") == "named");
                         std::string extraDataLockType = locator.query("extraDataLock", "named");
                         bool useNotification = (locator.query("useNotification", "false") == "true");
+                        auto segmentOptions = SharedMemorySegmentOptions::fromLocator(locator);
                         if (useName) {
                             if (dataLockIsNamedMutex) {
                                 if (extraDataLockType == "spin") {
@@ -461,6 +463,7 @@ namespace dev { namespace cd606 { namespace tm { namespace transport {
                                         , memoryName
                                         , memorySize
                                         , useNotification
+                                        , segmentOptions
                                     );
                                     if constexpr (std::is_same_v<typename Action::Result, void>) {
                                         std::move(action).template invoke<std::remove_pointer_t<decltype(chain)>>(env, chain);
@@ -497,6 +500,7 @@ namespace dev { namespace cd606 { namespace tm { namespace transport {
                                         , memoryName
                                         , memorySize
                                         , useNotification
+                                        , segmentOptions
                                     );
                                     if constexpr (std::is_same_v<typename Action::Result, void>) {
                                         std::move(action).template invoke<std::remove_pointer_t<decltype(chain)>>(env, chain);
@@ -533,6 +537,7 @@ namespace dev { namespace cd606 { namespace tm { namespace transport {
                                         , memoryName
                                         , memorySize
                                         , useNotification
+                                        , segmentOptions
                                     );
                                     if constexpr (std::is_same_v<typename Action::Result, void>) {
                                         std::move(action).template invoke<std::remove_pointer_t<decltype(chain)>>(env, chain);
@@ -571,6 +576,7 @@ namespace dev { namespace cd606 { namespace tm { namespace transport {
                                         , memoryName
                                         , memorySize
                                         , useNotification
+                                        , segmentOptions
                                     );
                                     if constexpr (std::is_same_v<typename Action::Result, void>) {
                                         std::move(action).template invoke<std::remove_pointer_t<decltype(chain)>>(env, chain);
@@ -607,6 +613,7 @@ namespace dev { namespace cd606 { namespace tm { namespace transport {
                                         , memoryName
                                         , memorySize
                                         , useNotification
+                                        , segmentOptions
                                     );
                                     if constexpr (std::is_same_v<typename Action::Result, void>) {
                                         std::move(action).template invoke<std::remove_pointer_t<decltype(chain)>>(env, chain);
@@ -643,6 +650,7 @@ namespace dev { namespace cd606 { namespace tm { namespace transport {
                                         , memoryName
                                         , memorySize
                                         , useNotification
+                                        , segmentOptions
                                     );
                                     if constexpr (std::is_same_v<typename Action::Result, void>) {
                                         std::move(action).template invoke<std::remove_pointer_t<decltype(chain)>>(env, chain);
@@ -683,6 +691,7 @@ namespace dev { namespace cd606 { namespace tm { namespace transport {
                                         , memoryName
                                         , memorySize
                                         , useNotification
+                                        , segmentOptions
                                     );
                                     if constexpr (std::is_same_v<typename Action::Result, void>) {
                                         std::move(action).template invoke<std::remove_pointer_t<decltype(chain)>>(env, chain);
@@ -719,6 +728,7 @@ namespace dev { namespace cd606 { namespace tm { namespace transport {
                                         , memoryName
                                         , memorySize
                                         , useNotification
+                                        , segmentOptions
                                     );
                                     if constexpr (std::is_same_v<typename Action::Result, void>) {
                                         std::move(action).template invoke<std::remove_pointer_t<decltype(chain)>>(env, chain);
@@ -755,6 +765,7 @@ namespace dev { namespace cd606 { namespace tm { namespace transport {
                                         , memoryName
                                         , memorySize
                                         , useNotification
+                                        , segmentOptions
                                     );
                                     if constexpr (std::is_same_v<typename Action::Result, void>) {
                                         std::move(action).template invoke<std::remove_pointer_t<decltype(chain)>>(env, chain);
@@ -793,6 +804,7 @@ namespace dev { namespace cd606 { namespace tm { namespace transport {
                                         , memoryName
                                         , memorySize
                                         , useNotification
+                                        , segmentOptions
                                     );
                                     if constexpr (std::is_same_v<typename Action::Result, void>) {
                                         std::move(action).template invoke<std::remove_pointer_t<decltype(chain)>>(env, chain);
@@ -829,6 +841,7 @@ namespace dev { namespace cd606 { namespace tm { namespace transport {
                                         , memoryName
                                         , memorySize
                                         , useNotification
+                                        , segmentOptions
                                     );
                                     if constexpr (std::is_same_v<typename Action::Result, void>) {
                                         std::move(action).template invoke<std::remove_pointer_t<decltype(chain)>>(env, chain);
@@ -865,6 +878,7 @@ namespace dev { namespace cd606 { namespace tm { namespace transport {
                                         , memoryName
                                         , memorySize
                                         , useNotification
+                                        , segmentOptions
                                     );
                                     if constexpr (std::is_same_v<typename Action::Result, void>) {
                                         std::move(action).template invoke<std::remove_pointer_t<decltype(chain)>>(env, chain);
@@ -890,6 +904,7 @@ namespace dev { namespace cd606 { namespace tm { namespace transport {
                         }
                         bool useName = (locator.query("useName", "false") == "true");  
                         bool useNotification = (locator.query("useNotification", "false") == "true");                     
+                        auto segmentOptions = SharedMemorySegmentOptions::fromLocator(locator);
                         if (useName) {
                             using C = lock_free_in_memory_shared_chain::LockFreeInBoostSharedMemoryChain<
                                 ChainData
@@ -914,6 +929,7 @@ namespace dev { namespace cd606 { namespace tm { namespace transport {
                                 , memoryName
                                 , memorySize
                                 , useNotification
+                                , segmentOptions
                             );
                             if constexpr (std::is_same_v<typename Action::Result, void>) {
                                 std::move(action).template invoke<std::remove_pointer_t<decltype(chain)>>(env, chain);
@@ -944,6 +960,7 @@ namespace dev { namespace cd606 { namespace tm { namespace transport {
                                 , memoryName
                                 , memorySize
                                 , useNotification
+                                , segmentOptions
                             );
                             if constexpr (std::is_same_v<typename Action::Result, void>) {
                                 std::move(action).template invoke<std::remove_pointer_t<decltype(chain)>>(env, chain);
@@ -0,0 +1,53 @@
+#ifndef TM_KIT_TRANSPORT_SHARED_MEMORY_SEGMENT_HPP_
+#define TM_KIT_TRANSPORT_SHARED_MEMORY_SEGMENT_HPP_
+
+#include <tm_kit/transport/ConnectionLocator.hpp>
+
+#include <cstddef>
+#include <iostream>
+
+namespace dev { namespace cd606 { namespace tm { namespace transport {
+
+    //How the shared memory segments of shared_memory_broadcast and of the
+    //in-shared-memory chains are prepared when they are opened, from these
+    //locator properties:
+    //  - huge_pages=true: asks for the segment to be backed by transparent
+    //    huge pages (MADV_HUGEPAGE, Linux only), which for shared memory
+    //    needs /sys/kernel/mm/transparent_hugepage/shmem_enabled to be
+    //    "advise" or "always"
+    //  - prefault=true: faults in all the pages of the segment, so that the
+    //    first pass of the publishers through it does not
+    //  - mlock=true: locks the segment in memory (which also faults it in),
+    //    within RLIMIT_MEMLOCK
+    //With prefault or mlock, the whole segment (4GB unless size is given)
+    //is taken from physical memory on open.
+    struct SharedMemorySegmentOptions {
+        bool hugePages = false;
+        bool prefault = false;
+        bool lock = false;
+
+        static SharedMemorySegmentOptions fromLocator(ConnectionLocator const &locator);
+    };
+
+    //What the segment ended up as. hugePageBytes is how much of the segment
+    //the kernel reports as mapped with huge pages right after preparation
+    //(so it is only meaningful with prefault or mlock).
+    struct SharedMemorySegmentLayout {
+        void *address = nullptr;
+        std::size_t size = 0;
+        std::size_t pageSize = 0;
+        bool hugePagesAdvised = false;
+        std::size_t hugePageBytes = 0;
+        bool prefaulted = false;
+        bool locked = false;
+    };
+
+    //Best effort: what fails (or is not supported on the platform) is
+    //reported as not done in the returned layout
+    SharedMemorySegmentLayout prepareSharedMemorySegment(void *address, std::size_t size, SharedMemorySegmentOptions const &options);
+
+    std::ostream &operator<<(std::ostream &os, SharedMemorySegmentLayout const &layout);
+
+} } } }
+
+#endif
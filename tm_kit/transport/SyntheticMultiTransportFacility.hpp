@@ -47,8 +47,14 @@ namespace dev { namespace cd606 { namespace tm { namespace transport {
                 , hookPair?hookPair->wireToUser:std::nullopt
             );
             if constexpr (DetermineClientSideIdentityForRequest<Env, A>::HasIdentity) {
+                //identity attachers may keep state per server (e.g. the
+                //session keys), and the server here is the outgoing channel
+                ConnectionLocator connection {"", 0};
+                if (auto parsed = parseMultiTransportBroadcastChannel(outgoingSpec)) {
+                    connection = std::get<1>(*parsed);
+                }
                 auto addTopic = M::template kleisli<typename M::template Key<A>>(
-                    [outgoingTopic](typename M::template InnerData<typename M::template Key<A>> &&x) -> typename M::template Data<basic::ByteDataWithTopic> {
+                    [outgoingTopic,connection](typename M::template InnerData<typename M::template Key<A>> &&x) -> typename M::template Data<basic::ByteDataWithTopic> {
                         auto ret = basic::WrapFacilitioidConnectorForSerializationHelpers::encodeRawWithTopic<
                             OutgoingProtocolWrapper, typename M::template Key<A>
                         >(
@@ -58,7 +64,7 @@ namespace dev { namespace cd606 { namespace tm { namespace transport {
                         );
                         ret.content = static_cast<
                             typename DetermineClientSideIdentityForRequest<Env, A>::ComponentType *
-                        >(x.environment)->attach_identity(basic::ByteData {std::move(ret.content)}).content;
+                        >(x.environment)->attach_identity_for(connection, basic::ByteData {std::move(ret.content)}).content;
                         return M::template pureInnerData<basic::ByteDataWithTopic>(x.environment, std::move(ret));
                     }
                 );
@@ -71,14 +77,14 @@ namespace dev { namespace cd606 { namespace tm { namespace transport {
                     r, prefix+"/importer", incomingSpec, incomingTopic, incomingHook
                 );
                 auto decode = M::template kleisli<basic::ByteDataWithTopic>(
-                    [](typename M::template InnerData<basic::ByteDataWithTopic> &&x) 
+                    [connection](typename M::template InnerData<basic::ByteDataWithTopic> &&x) 
                         -> typename M::template Data<typename M::template Key<
                             std::conditional_t<MultiCallback, std::tuple<B,bool>, B>
                         >>
                     {
                         auto y = static_cast<
                             typename DetermineClientSideIdentityForRequest<Env, A>::ComponentType *
-                        >(x.environment)->process_incoming_data(basic::ByteData {std::move(x.timedData.value.content)});
+                        >(x.environment)->process_incoming_data_from(connection, basic::ByteData {std::move(x.timedData.value.content)});
                         if (!y) {
                             return std::nullopt;
                         }
@@ -158,10 +164,16 @@ namespace dev { namespace cd606 { namespace tm { namespace transport {
                 , outgoingHook
             );
             if constexpr (DetermineClientSideIdentityForRequest<Env, A>::HasIdentity) {
+                //identity attachers may keep state per server (e.g. the
+                //session keys), and the server here is the outgoing channel
+                ConnectionLocator connection {"", 0};
+                if (auto parsed = parseMultiTransportBroadcastChannel(outgoingSpec)) {
+                    connection = std::get<1>(*parsed);
+                }
                 auto addTopic = M::template kleisli<
                     std::conditional_t<AutoKeyify,A,typename M::template Key<A>>
                 >(
-                    [outgoingTopic](typename M::template InnerData<std::conditional_t<AutoKeyify,A,typename M::template Key<A>>> &&x) -> typename M::template Data<basic::ByteDataWithTopic> {
+                    [outgoingTopic,connection](typename M::template InnerData<std::conditional_t<AutoKeyify,A,typename M::template Key<A>>> &&x) -> typename M::template Data<basic::ByteDataWithTopic> {
                         if constexpr (AutoKeyify) {
                             auto ret = basic::WrapFacilitioidConnectorForSerializationHelpers::encodeRawWithTopic<
                                 OutgoingProtocolWrapper, typename M::template Key<A>
@@ -172,7 +184,7 @@ namespace dev { namespace cd606 { namespace tm { namespace transport {
                             );
                             ret.content = static_cast<
                                 typename DetermineClientSideIdentityForRequest<Env, A>::ComponentType *
-                            >(x.environment)->attach_identity(basic::ByteData {std::move(ret.content)}).content;
+                            >(x.environment)->attach_identity_for(connection, basic::ByteData {std::move(ret.content)}).content;
                             return M::template pureInnerData<basic::ByteDataWithTopic>(x.environment, std::move(ret));
                         } else {
                             auto ret = basic::WrapFacilitioidConnectorForSerializationHelpers::encodeRawWithTopic<
@@ -184,7 +196,7 @@ namespace dev { namespace cd606 { namespace tm { namespace transport {
                             );
                             ret.content = static_cast<
                                 typename DetermineClientSideIdentityForRequest<Env, A>::ComponentType *
-                            >(x.environment)->attach_identity(basic::ByteData {std::move(ret.content)}).content;
+                            >(x.environment)->attach_identity_for(connection, basic::ByteData {std::move(ret.content)}).content;
                             return M::template pureInnerData<basic::ByteDataWithTopic>(x.environment, std::move(ret));
                         }
                     }
@@ -290,7 +302,7 @@ namespace dev { namespace cd606 { namespace tm { namespace transport {
                     r, prefix+"/importer", incomingSpec, incomingTopic, incomingHook
                 );
                 auto decode = M::template kleisli<basic::ByteDataWithTopic>(
-                    [](typename M::template InnerData<basic::ByteDataWithTopic> &&x) -> typename M::template Data<typename M::template Key<A1>> {
+                    [connection](typename M::template InnerData<basic::ByteDataWithTopic> &&x) -> typename M::template Data<typename M::template Key<A1>> {
                         auto y = static_cast<
                             typename DetermineServerSideIdentityForRequest<Env, A>::ComponentType *
                         >(x.environment)->check_identity(basic::ByteData {std::move(x.timedData.value.content)});
@@ -0,0 +1,325 @@
+#ifndef TM_KIT_TRANSPORT_TRANSPORT_METRICS_COMPONENT_HPP_
+#define TM_KIT_TRANSPORT_TRANSPORT_METRICS_COMPONENT_HPP_
+
+#include <tm_kit/transport/ConnectionLocator.hpp>
+#include <tm_kit/basic/ByteData.hpp>
+
+#include <atomic>
+#include <array>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+#include <tuple>
+#include <type_traits>
+#include <cstdint>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+namespace dev { namespace cd606 { namespace tm { namespace transport {
+
+    struct TransportLatencySnapshot {
+        uint64_t count = 0;
+        uint64_t sumNanos = 0;
+        uint64_t minNanos = 0;
+        uint64_t maxNanos = 0;
+        //(inclusive upper bound in nanoseconds, count), only the non-empty
+        //buckets, in increasing order
+        std::vector<std::tuple<uint64_t,uint64_t>> buckets;
+
+        //p is in [0,1], the result is the upper bound of the bucket that
+        //holds the p-th value
+        uint64_t percentileNanos(double p) const;
+    };
+
+    //A log-linear histogram in the style of HdrHistogram: every power of two
+    //is split into 8 sub-buckets, so a recorded value is reported within
+    //12.5% of its actual value, over the whole range of uint64_t nanoseconds.
+    //Recording is lock-free (a few relaxed atomic operations).
+    class TransportLatencyHistogram {
+    public:
+        static constexpr std::size_t SubBucketBits = 3;
+        static constexpr std::size_t SubBucketCount = (1 << SubBucketBits);
+        static constexpr std::size_t BucketCount = (64-SubBucketBits+1)*SubBucketCount;
+    private:
+        std::array<std::atomic<uint64_t>, BucketCount> counts_;
+        std::atomic<uint64_t> count_;
+        std::atomic<uint64_t> sum_;
+        std::atomic<uint64_t> min_;
+        std::atomic<uint64_t> max_;
+
+        static int highestBit(uint64_t v) {
+#ifdef _MSC_VER
+            unsigned long idx;
+            _BitScanReverse64(&idx, v);
+            return static_cast<int>(idx);
+#else
+            return 63-__builtin_clzll(v);
+#endif
+        }
+    public:
+        TransportLatencyHistogram();
+        TransportLatencyHistogram(TransportLatencyHistogram const &) = delete;
+        TransportLatencyHistogram &operator=(TransportLatencyHistogram const &) = delete;
+
+        static std::size_t bucketIndex(uint64_t nanos) {
+            if (nanos < SubBucketCount) {
+                return static_cast<std::size_t>(nanos);
+            }
+            std::size_t shift = static_cast<std::size_t>(highestBit(nanos))-SubBucketBits;
+            return (shift+1)*SubBucketCount+static_cast<std::size_t>((nanos >> shift) & (SubBucketCount-1));
+        }
+        static uint64_t bucketUpperBound(std::size_t index);
+
+        void record(uint64_t nanos) {
+            counts_[bucketIndex(nanos)].fetch_add(1, std::memory_order_relaxed);
+            count_.fetch_add(1, std::memory_order_relaxed);
+            sum_.fetch_add(nanos, std::memory_order_relaxed);
+            auto m = min_.load(std::memory_order_relaxed);
+            while (nanos < m && !min_.compare_exchange_weak(m, nanos, std::memory_order_relaxed)) {
+            }
+            m = max_.load(std::memory_order_relaxed);
+            while (nanos > m && !max_.compare_exchange_weak(m, nanos, std::memory_order_relaxed)) {
+            }
+        }
+        template <class Rep, class Period>
+        void record(std::chrono::duration<Rep,Period> const &d) {
+            auto n = std::chrono::duration_cast<std::chrono::nanoseconds>(d).count();
+            record(static_cast<uint64_t>((n<0)?0:n));
+        }
+        //the snapshot is not atomic as a whole, values recorded while it is
+        //taken may or may not be included
+        TransportLatencySnapshot snapshot() const;
+    };
+
+    struct TransportChannelMetricsSnapshot {
+        std::string transport;
+        ConnectionLocator locator;
+        uint64_t messagesIn = 0;
+        uint64_t bytesIn = 0;
+        uint64_t messagesOut = 0;
+        uint64_t bytesOut = 0;
+        uint64_t drops = 0;
+        uint64_t decodeFailures = 0;
+        //messages overwritten by a later one on the same topic before they
+        //were delivered (see ConflatingDelivery.hpp)
+        uint64_t conflated = 0;
+        //messages that had to wait for room in a full dispatch queue (see
+        //ReceiveDispatcher.hpp)
+        uint64_t backpressure = 0;
+        int64_t queueDepth = 0;
+        //time spent inside the transport's publish call
+        TransportLatencySnapshot sendLatency;
+        //only filled for channels with latency stamping (see
+        //LatencyStamping.hpp)
+        uint64_t sequenceGaps = 0;
+        int64_t estimatedClockOffsetNanos = 0;
+        TransportLatencySnapshot oneWayLatency;
+    };
+
+    //The counters of one channel. They are striped over cache-line-sized
+    //slots, and each thread always updates the same slot, so that the
+    //receiving and the publishing threads of a busy channel do not fight
+    //over one cache line. Reading sums up the slots.
+    class TransportChannelMetrics {
+    public:
+        static constexpr std::size_t StripeCount = 8;
+    private:
+        struct alignas(64) Stripe {
+            std::atomic<uint64_t> messagesIn {0};
+            std::atomic<uint64_t> bytesIn {0};
+            std::atomic<uint64_t> messagesOut {0};
+            std::atomic<uint64_t> bytesOut {0};
+            std::atomic<uint64_t> drops {0};
+            std::atomic<uint64_t> decodeFailures {0};
+            std::atomic<uint64_t> conflated {0};
+            std::atomic<uint64_t> backpressure {0};
+            std::atomic<uint64_t> sequenceGaps {0};
+        };
+        std::string transport_;
+        ConnectionLocator locator_;
+        std::array<Stripe, StripeCount> stripes_;
+        std::atomic<int64_t> queueDepth_;
+        TransportLatencyHistogram sendLatency_;
+        std::atomic<int64_t> estimatedClockOffset_;
+        TransportLatencyHistogram oneWayLatency_;
+        std::atomic<uint64_t> reportedBadCount_;
+
+        static std::size_t nextStripe();
+        static Stripe &stripeFor(std::array<Stripe, StripeCount> &stripes) {
+            static thread_local std::size_t idx = nextStripe();
+            return stripes[idx];
+        }
+    public:
+        TransportChannelMetrics(std::string const &transport, ConnectionLocator const &locator);
+        TransportChannelMetrics(TransportChannelMetrics const &) = delete;
+        TransportChannelMetrics &operator=(TransportChannelMetrics const &) = delete;
+
+        std::string const &transport() const {
+            return transport_;
+        }
+        ConnectionLocator const &locator() const {
+            return locator_;
+        }
+        void recordInbound(std::size_t bytes) {
+            auto &s = stripeFor(stripes_);
+            s.messagesIn.fetch_add(1, std::memory_order_relaxed);
+            s.bytesIn.fetch_add(bytes, std::memory_order_relaxed);
+        }
+        void recordOutbound(std::size_t bytes) {
+            auto &s = stripeFor(stripes_);
+            s.messagesOut.fetch_add(1, std::memory_order_relaxed);
+            s.bytesOut.fetch_add(bytes, std::memory_order_relaxed);
+        }
+        void recordDrop() {
+            stripeFor(stripes_).drops.fetch_add(1, std::memory_order_relaxed);
+        }
+        void recordDecodeFailure() {
+            stripeFor(stripes_).decodeFailures.fetch_add(1, std::memory_order_relaxed);
+        }
+        void recordConflated() {
+            stripeFor(stripes_).conflated.fetch_add(1, std::memory_order_relaxed);
+        }
+        void recordBackpressure() {
+            stripeFor(stripes_).backpressure.fetch_add(1, std::memory_order_relaxed);
+        }
+        void setQueueDepth(int64_t depth) {
+            queueDepth_.store(depth, std::memory_order_relaxed);
+        }
+        void addQueueDepth(int64_t delta) {
+            queueDepth_.fetch_add(delta, std::memory_order_relaxed);
+        }
+        TransportLatencyHistogram &sendLatency() {
+            return sendLatency_;
+        }
+        void recordSequenceGap(uint64_t missing) {
+            stripeFor(stripes_).sequenceGaps.fetch_add(missing, std::memory_order_relaxed);
+        }
+        //drops plus decode failures as of the last heartbeat report, the
+        //previous value is returned
+        uint64_t exchangeReportedBadCount(uint64_t badCount) {
+            return reportedBadCount_.exchange(badCount, std::memory_order_relaxed);
+        }
+        void setEstimatedClockOffset(int64_t nanos) {
+            estimatedClockOffset_.store(nanos, std::memory_order_relaxed);
+        }
+        TransportLatencyHistogram &oneWayLatency() {
+            return oneWayLatency_;
+        }
+        TransportChannelMetricsSnapshot snapshot() const;
+    };
+
+    //Counts one outgoing message, and the time until the scope ends as its
+    //send latency. Does nothing if the metrics pointer is null.
+    class TransportMetricsSendScope {
+    private:
+        TransportChannelMetrics *metrics_;
+        std::chrono::steady_clock::time_point start_;
+    public:
+        TransportMetricsSendScope(TransportChannelMetrics *metrics, std::size_t bytes)
+            : metrics_(metrics), start_()
+        {
+            if (metrics_) {
+                metrics_->recordOutbound(bytes);
+                start_ = std::chrono::steady_clock::now();
+            }
+        }
+        ~TransportMetricsSendScope() {
+            if (metrics_) {
+                metrics_->sendLatency().record(std::chrono::steady_clock::now()-start_);
+            }
+        }
+        TransportMetricsSendScope(TransportMetricsSendScope const &) = delete;
+        TransportMetricsSendScope &operator=(TransportMetricsSendScope const &) = delete;
+    };
+
+    class TransportMetricsComponentImpl;
+
+    //Holds the metrics of all channels in the environment, keyed by the
+    //transport name (as in the channel descriptors, e.g. "redis") and the
+    //connection locator (without the password). The importers and exporters
+    //of the transports look this component up in the environment and update
+    //the channels they use, so it costs nothing when it is not there.
+    class TransportMetricsComponent {
+    private:
+        std::unique_ptr<TransportMetricsComponentImpl> impl_;
+    public:
+        TransportMetricsComponent();
+        TransportMetricsComponent(TransportMetricsComponent const &) = delete;
+        TransportMetricsComponent &operator=(TransportMetricsComponent const &) = delete;
+        TransportMetricsComponent(TransportMetricsComponent &&);
+        TransportMetricsComponent &operator=(TransportMetricsComponent &&);
+        virtual ~TransportMetricsComponent();
+
+        //the same object is returned for the same transport and locator
+        std::shared_ptr<TransportChannelMetrics> transportMetrics_channel(std::string const &transport, ConnectionLocator const &locator);
+        std::vector<TransportChannelMetricsSnapshot> transportMetrics_snapshot() const;
+        //Prometheus text exposition format, the latency histograms are in
+        //seconds
+        std::string transportMetrics_prometheusText() const;
+        std::string transportMetrics_json() const;
+    };
+
+    template <class Env>
+    inline std::shared_ptr<TransportChannelMetrics> transportChannelMetrics(Env *env, std::string const &transport, ConnectionLocator const &locator) {
+        if constexpr (std::is_convertible_v<Env *, TransportMetricsComponent *>) {
+            return static_cast<TransportMetricsComponent *>(env)->transportMetrics_channel(transport, locator);
+        } else {
+            return nullptr;
+        }
+    }
+
+    //The RPC clients and servers of the transports count on the channel
+    //"<transport>_rpc" of their locator: the client sends requests and
+    //receives replies, the server the other way round. The components find
+    //the metrics component with a cross-cast from themselves, and the
+    //functions are returned unchanged when it is not there.
+    inline std::shared_ptr<TransportChannelMetrics> transportRPCChannelMetrics(TransportMetricsComponent *component, std::string const &transport, ConnectionLocator const &locator) {
+        if (!component) {
+            return nullptr;
+        }
+        return component->transportMetrics_channel(transport+"_rpc", locator);
+    }
+    inline std::function<void(basic::ByteDataWithID &&)> countRPCSend(std::shared_ptr<TransportChannelMetrics> const &metrics, std::function<void(basic::ByteDataWithID &&)> f) {
+        if (!metrics) {
+            return f;
+        }
+        return [metrics,f=std::move(f)](basic::ByteDataWithID &&data) {
+            TransportMetricsSendScope _(metrics.get(), data.content.length());
+            f(std::move(data));
+        };
+    }
+    inline std::function<void(bool, basic::ByteDataWithID &&)> countRPCSend(std::shared_ptr<TransportChannelMetrics> const &metrics, std::function<void(bool, basic::ByteDataWithID &&)> f) {
+        if (!metrics) {
+            return f;
+        }
+        return [metrics,f=std::move(f)](bool isFinal, basic::ByteDataWithID &&data) {
+            TransportMetricsSendScope _(metrics.get(), data.content.length());
+            f(isFinal, std::move(data));
+        };
+    }
+    inline std::function<void(basic::ByteDataWithID &&)> countRPCReceive(std::shared_ptr<TransportChannelMetrics> const &metrics, std::function<void(basic::ByteDataWithID &&)> f) {
+        if (!metrics) {
+            return f;
+        }
+        return [metrics,f=std::move(f)](basic::ByteDataWithID &&data) {
+            metrics->recordInbound(data.content.length());
+            f(std::move(data));
+        };
+    }
+    inline std::function<void(bool, basic::ByteDataWithID &&)> countRPCReceive(std::shared_ptr<TransportChannelMetrics> const &metrics, std::function<void(bool, basic::ByteDataWithID &&)> f) {
+        if (!metrics) {
+            return f;
+        }
+        return [metrics,f=std::move(f)](bool isFinal, basic::ByteDataWithID &&data) {
+            metrics->recordInbound(data.content.length());
+            f(isFinal, std::move(data));
+        };
+    }
+
+} } } }
+
+#endif
@@ -0,0 +1,107 @@
+#ifndef TM_KIT_TRANSPORT_TRANSPORT_METRICS_REPORTING_HPP_
+#define TM_KIT_TRANSPORT_TRANSPORT_METRICS_REPORTING_HPP_
+
+#include <tm_kit/transport/TransportMetricsComponent.hpp>
+#include <tm_kit/transport/HeartbeatAndAlertComponent.hpp>
+#include <tm_kit/transport/json_rest/JsonRESTComponent.hpp>
+
+#include <tm_kit/basic/VoidStruct.hpp>
+#include <tm_kit/basic/real_time_clock/ClockImporter.hpp>
+
+#include <nlohmann/json.hpp>
+
+#include <sstream>
+#include <type_traits>
+
+namespace dev { namespace cd606 { namespace tm { namespace transport {
+
+    //Puts one heartbeat status entry per channel, named
+    //"transport_metrics <transport>://<locator>". The entry is Warning if
+    //the channel has dropped or failed to decode anything since the last
+    //report.
+    template <class Env>
+    inline void reportTransportMetricsToHeartbeat(Env *env) {
+        static_assert(
+            std::is_convertible_v<Env *, TransportMetricsComponent *>
+            && std::is_convertible_v<Env *, HeartbeatAndAlertComponent *>
+            , "reportTransportMetricsToHeartbeat needs both TransportMetricsComponent and HeartbeatAndAlertComponent"
+        );
+        auto *metrics = static_cast<TransportMetricsComponent *>(env);
+        auto snapshots = metrics->transportMetrics_snapshot();
+        for (auto const &s : snapshots) {
+            std::string name = "transport_metrics "+s.transport+"://"+s.locator.toSerializationFormat();
+            std::ostringstream oss;
+            oss << "in=" << s.messagesIn << "/" << s.bytesIn << "B"
+                << ",out=" << s.messagesOut << "/" << s.bytesOut << "B"
+                << ",drops=" << s.drops
+                << ",decode_failures=" << s.decodeFailures
+                << ",conflated=" << s.conflated
+                << ",backpressure=" << s.backpressure
+                << ",queue_depth=" << s.queueDepth
+                << ",send_p50_ns=" << s.sendLatency.percentileNanos(0.5)
+                << ",send_p99_ns=" << s.sendLatency.percentileNanos(0.99);
+            auto badCount = s.drops+s.decodeFailures;
+            //the last reported count is kept on the channel, so that each
+            //environment compares against its own previous report
+            auto last = metrics->transportMetrics_channel(s.transport, s.locator)->exchangeReportedBadCount(badCount);
+            auto status = (badCount > last)?HeartbeatMessage::Status::Warning:HeartbeatMessage::Status::Good;
+            static_cast<HeartbeatAndAlertComponent *>(env)->setStatus(name, status, oss.str());
+        }
+    }
+
+    //Updates the heartbeat entries periodically, this should be done at the
+    //same period as (or a shorter one than) the heartbeat itself.
+    template <class R
+        , std::enable_if_t<
+            std::is_base_of_v<TransportMetricsComponent, typename R::EnvironmentType>
+            && std::is_base_of_v<HeartbeatAndAlertComponent, typename R::EnvironmentType>
+            && std::is_base_of_v<basic::real_time_clock::ClockComponent, typename R::EnvironmentType>
+            , int> = 0
+    >
+    void attachTransportMetricsToHeartbeat(R &r, std::chrono::system_clock::duration period, std::chrono::system_clock::duration furthestPoint=std::chrono::hours(24)) {
+        auto nowTp = r.environment()->now();
+        auto importer = basic::real_time_clock::ClockImporter<typename R::EnvironmentType>
+            ::template createRecurringClockConstImporter<basic::VoidStruct>(
+            nowTp+std::chrono::milliseconds(250)
+            , nowTp+furthestPoint
+            , period
+            , basic::VoidStruct {}
+        );
+        r.registerImporter("__transport_metrics_clock_importer", importer);
+        auto report = R::AppType::template simpleExporter<basic::VoidStruct>(
+            [](typename R::AppType::template InnerData<basic::VoidStruct> &&d) {
+                reportTransportMetricsToHeartbeat(d.environment);
+            }
+        );
+        r.registerExporter("__transport_metrics_report", report);
+        r.exportItem(report, r.importItem(importer));
+    }
+
+    //Serves the metrics at the given JSON REST locator. The reply is the
+    //JSON array from transportMetrics_json(), or, if the query has
+    //format=prometheus, the Prometheus text as a JSON string.
+    template <class Env>
+    inline void registerTransportMetricsRESTHandler(Env *env, ConnectionLocator const &locator) {
+        static_assert(
+            std::is_convertible_v<Env *, TransportMetricsComponent *>
+            && std::is_convertible_v<Env *, json_rest::JsonRESTComponent *>
+            , "registerTransportMetricsRESTHandler needs both TransportMetricsComponent and JsonRESTComponent"
+        );
+        auto *metrics = static_cast<TransportMetricsComponent *>(env);
+        static_cast<json_rest::JsonRESTComponent *>(env)->registerHandler(
+            locator
+            , [metrics](std::string const &/*login*/, std::string const &/*data*/, std::unordered_map<std::string, std::vector<std::string>> const &queryMap, std::function<void(std::string const &)> const &callback) {
+                auto iter = queryMap.find("format");
+                if (iter != queryMap.end() && !iter->second.empty() && iter->second.front() == "prometheus") {
+                    callback(nlohmann::json(metrics->transportMetrics_prometheusText()).dump());
+                } else {
+                    callback(metrics->transportMetrics_json());
+                }
+                return true;
+            }
+        );
+    }
+
+} } } }
+
+#endif
@@ -0,0 +1,61 @@
+#ifndef TM_KIT_TRANSPORT_TRANSPORT_THREADING_HPP_
+#define TM_KIT_TRANSPORT_TRANSPORT_THREADING_HPP_
+
+#include <tm_kit/transport/ConnectionLocator.hpp>
+
+#include <vector>
+#include <string>
+#include <optional>
+#include <cstdint>
+
+namespace dev { namespace cd606 { namespace tm { namespace transport {
+
+    //How a transport's receiving thread should run, from these locator
+    //properties:
+    //  - cpu_affinity=2, or 2-5, or 1;3;8-11: the CPUs the thread may run on
+    //  - thread_priority=N: real-time (SCHED_FIFO) priority, 1 to 99, which
+    //    usually needs CAP_SYS_NICE
+    //  - busyLoop=true: the thread spins on the socket instead of blocking
+    //    (the same property shared_memory_broadcast already had)
+    //  - busy_poll=N: SO_BUSY_POLL in microseconds on the sockets the
+    //    component opens (Linux only)
+    //
+    //multicast, singlecast, zeromq, nng and shared_memory_broadcast apply
+    //them when they create the receiving thread of a channel, so it is the
+    //locator of the first subscription to the channel that counts. redis
+    //applies them to the event loop thread of a server, including busy_poll
+    //on its connections, and locators with different settings (or
+    //credentials) get different servers. websocket applies cpu_affinity, thread_priority
+    //and busyLoop to the thread of each subscriber and RPC client
+    //connection, but not busy_poll; publishers and RPC servers are
+    //configured by port only, so they are left alone. socket_rpc runs all
+    //its connections on one shared thread, so it only applies busy_poll,
+    //to each TCP connection. rabbitmq applies cpu_affinity and
+    //thread_priority to the consuming threads only, since the client
+    //library blocks inside its own calls, so there is nothing to busy loop
+    //on.
+    //
+    //This is done on the thread itself, instead of through the native
+    //handles from *_threadHandles(). The settings are best effort: what the
+    //platform does not support, or the process is not allowed to do, is
+    //skipped, with a line on stderr naming the channel.
+    struct TransportThreadingConfig {
+        std::vector<int> cpus;
+        std::optional<int> priority = std::nullopt;
+        bool busyLoop = false;
+        std::optional<int> busyPollMicros = std::nullopt;
+
+        static TransportThreadingConfig fromLocator(ConnectionLocator const &locator);
+        //the given locator with only the properties above, for components
+        //that share one thread among the locators with the same settings
+        static ConnectionLocator threadingPropertiesOf(ConnectionLocator const &base, ConnectionLocator const &locator);
+
+        //return false (after logging) if any of the settings could not be
+        //applied, channel is only used in the log line
+        bool applyToCurrentThread(std::string const &channel="") const;
+        bool applyToSocket(std::intptr_t nativeSocket, std::string const &channel="") const;
+    };
+
+} } } }
+
+#endif
@@ -0,0 +1,107 @@
+#ifndef TM_KIT_TRANSPORT_COMPLEX_KEY_VALUE_STORE_COMPONENTS_KEY_BASED_QUERY_CACHE_HPP_
+#define TM_KIT_TRANSPORT_COMPLEX_KEY_VALUE_STORE_COMPONENTS_KEY_BASED_QUERY_CACHE_HPP_
+
+#include <tm_kit/basic/StructFieldInfoUtils.hpp>
+#include <tm_kit/basic/transaction/complex_key_value_store/VersionlessDataModel.hpp>
+
+#include <chrono>
+#include <list>
+#include <mutex>
+#include <optional>
+#include <unordered_map>
+
+namespace dev { namespace cd606 { namespace tm { namespace transport { namespace complex_key_value_store_components {
+
+    struct KeyBasedQueryCacheOptions {
+        //the least recently used entry is dropped when the cache grows
+        //beyond this size
+        std::size_t maxSize = 10000;
+        //entries older than this are not returned (and will be reloaded
+        //from the database), if not set, entries only go away through
+        //eviction or invalidation
+        std::optional<std::chrono::steady_clock::duration> ttl = std::nullopt;
+    };
+
+    //A bounded LRU cache of key lookup results. Results that say the key
+    //does not exist are cached as well, so repeated lookups of a missing key
+    //do not reach the database either. The cache is thread-safe and can be
+    //shared by several lookup functions.
+    template <class ItemKey, class ItemData>
+    class KeyBasedQueryCache {
+    public:
+        using Result = basic::transaction::complex_key_value_store::KeyBasedQueryResult<ItemData>;
+    private:
+        using Clock = std::chrono::steady_clock;
+        struct Entry {
+            ItemKey key;
+            Result result;
+            Clock::time_point loadTime;
+        };
+        using EntryList = std::list<Entry>;
+
+        KeyBasedQueryCacheOptions options_;
+        std::mutex mutex_;
+        EntryList entries_;
+        std::unordered_map<ItemKey, typename EntryList::iterator, basic::struct_field_info_utils::StructFieldInfoBasedHash<ItemKey>> index_;
+    public:
+        KeyBasedQueryCache() : options_(), mutex_(), entries_(), index_() {}
+        KeyBasedQueryCache(KeyBasedQueryCacheOptions const &options) : options_(options), mutex_(), entries_(), index_() {
+            if (options_.maxSize == 0) {
+                options_.maxSize = 1;
+            }
+        }
+        KeyBasedQueryCache(KeyBasedQueryCache const &) = delete;
+        KeyBasedQueryCache &operator=(KeyBasedQueryCache const &) = delete;
+
+        std::optional<Result> get(ItemKey const &key) {
+            std::lock_guard<std::mutex> _(mutex_);
+            auto iter = index_.find(key);
+            if (iter == index_.end()) {
+                return std::nullopt;
+            }
+            if (options_.ttl && iter->second->loadTime+*options_.ttl < Clock::now()) {
+                entries_.erase(iter->second);
+                index_.erase(iter);
+                return std::nullopt;
+            }
+            entries_.splice(entries_.begin(), entries_, iter->second);
+            return iter->second->result;
+        }
+        void put(ItemKey const &key, Result const &result) {
+            std::lock_guard<std::mutex> _(mutex_);
+            auto iter = index_.find(key);
+            if (iter != index_.end()) {
+                iter->second->result = result;
+                iter->second->loadTime = Clock::now();
+                entries_.splice(entries_.begin(), entries_, iter->second);
+                return;
+            }
+            entries_.push_front(Entry {key, result, Clock::now()});
+            index_.insert({key, entries_.begin()});
+            while (entries_.size() > options_.maxSize) {
+                index_.erase(entries_.back().key);
+                entries_.pop_back();
+            }
+        }
+        void invalidate(ItemKey const &key) {
+            std::lock_guard<std::mutex> _(mutex_);
+            auto iter = index_.find(key);
+            if (iter != index_.end()) {
+                entries_.erase(iter->second);
+                index_.erase(iter);
+            }
+        }
+        void invalidateAll() {
+            std::lock_guard<std::mutex> _(mutex_);
+            entries_.clear();
+            index_.clear();
+        }
+        std::size_t size() {
+            std::lock_guard<std::mutex> _(mutex_);
+            return entries_.size();
+        }
+    };
+
+}}}}}
+
+#endif
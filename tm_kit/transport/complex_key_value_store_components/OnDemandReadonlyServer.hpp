@@ -5,11 +5,17 @@
 #include <tm_kit/basic/StructFieldInfoUtils.hpp>
 #include <tm_kit/basic/transaction/complex_key_value_store/VersionlessDataModel.hpp>
 #include <tm_kit/transport/db_table_importer_exporter/StructFieldInfoUtils_SociHelper.hpp>
+#include <tm_kit/transport/complex_key_value_store_components/KeyBasedQueryCache.hpp>
 
 #include <soci/soci.h>
 
 #include <iostream>
 #include <sstream>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <stdexcept>
 
 #include <boost/algorithm/string.hpp>
 
@@ -53,52 +59,171 @@ namespace dev { namespace cd606 { namespace tm { namespace transport { namespace
         static void sociBindWhereClause(soci::statement &stmt, ItemKey const &k) {
             sociBindWhereClause_internal<ItemKey, basic::StructFieldInfo<ItemKey>::FIELD_NAMES.size(), 0>(stmt, k);
         }
+    private:
+        //A key lookup statement that is prepared once and re-executed with
+        //the new key values, the where clause is bound to boundKey.
+        template <class ItemKey>
+        struct PreparedKeyLookup {
+            std::shared_ptr<soci::session> session;
+            ItemKey boundKey;
+            soci::row row;
+            std::unique_ptr<soci::statement> stmt;
+
+            void prepare(std::string const &query) {
+                stmt = std::make_unique<soci::statement>(*session);
+                stmt->alloc();
+                stmt->prepare(query);
+                stmt->exchange(soci::into(row));
+                OnDemandReadonlyServer<M>::template sociBindWhereClause<ItemKey>(*stmt, boundKey);
+                stmt->define_and_bind();
+            }
+        };
+        //Each session keeps its own prepared statement, and a lookup
+        //borrows a free session for the duration of the query, so lookups
+        //run concurrently up to the number of sessions.
+        template <class ItemKey>
+        class PreparedKeyLookupPool {
+        private:
+            std::string query_;
+            std::mutex mutex_;
+            std::condition_variable cond_;
+            std::vector<std::unique_ptr<PreparedKeyLookup<ItemKey>>> lookups_;
+            std::vector<std::size_t> free_;
+        public:
+            PreparedKeyLookupPool(std::vector<std::shared_ptr<soci::session>> const &sessions, std::string const &query)
+                : query_(query), mutex_(), cond_(), lookups_(), free_()
+            {
+                //with no session, every lookup would wait forever
+                if (sessions.empty()) {
+                    throw std::runtime_error("[OnDemandReadonlyServer::keyBasedQueryFunc] no database session is given");
+                }
+                for (std::size_t ii=0; ii<sessions.size(); ++ii) {
+                    if (!sessions[ii]) {
+                        throw std::runtime_error("[OnDemandReadonlyServer::keyBasedQueryFunc] a given database session is null");
+                    }
+                    lookups_.push_back(std::make_unique<PreparedKeyLookup<ItemKey>>());
+                    lookups_.back()->session = sessions[ii];
+                    free_.push_back(ii);
+                }
+            }
+            template <class F>
+            auto run(F &&f) {
+                std::size_t idx;
+                {
+                    std::unique_lock<std::mutex> lock(mutex_);
+                    cond_.wait(lock, [this]() {return !free_.empty();});
+                    idx = free_.back();
+                    free_.pop_back();
+                }
+                auto &lookup = *(lookups_[idx]);
+                try {
+                    if (!lookup.stmt) {
+                        lookup.prepare(query_);
+                    }
+                    auto ret = f(lookup);
+                    {
+                        std::lock_guard<std::mutex> _(mutex_);
+                        free_.push_back(idx);
+                    }
+                    cond_.notify_one();
+                    return ret;
+                } catch (...) {
+                    //the statement is prepared again next time, in case
+                    //the failure left it in an unusable state
+                    lookup.stmt.reset();
+                    {
+                        std::lock_guard<std::mutex> _(mutex_);
+                        free_.push_back(idx);
+                    }
+                    cond_.notify_one();
+                    throw;
+                }
+            }
+        };
     public:
+        //If a cache is given, results are first looked up in the cache, and
+        //database results are put into it. Use the cache's invalidate
+        //functions when the table changes.
         template <class ItemKey, class ItemData>
         static auto keyBasedQueryFunc(
-            std::shared_ptr<soci::session> const &session
+            std::vector<std::shared_ptr<soci::session>> const &sessions
             , std::function<std::string(std::string const &)> selectMainPartFromCriteria
+            , std::shared_ptr<KeyBasedQueryCache<ItemKey,ItemData>> const &cache = nullptr
         )
         {
-            using DBDataStorage = basic::transaction::complex_key_value_store::as_collection::Collection<ItemKey,ItemData>;
-            using KF = transport::struct_field_info_utils::db_table_importer_exporter::StructFieldInfoBasedDataFiller<ItemKey>;
             using DF = transport::struct_field_info_utils::db_table_importer_exporter::StructFieldInfoBasedDataFiller<ItemData>;
             auto x = selectMainPartFromCriteria(OnDemandReadonlyServer<M>::template sociWhereClause<ItemKey>());
             if (!boost::starts_with(boost::to_upper_copy(boost::trim_copy(x)), "FROM ")) {
                 x = "FROM "+x;
             }
             std::string query = "SELECT "+DF::commaSeparatedFieldNames()+" "+x;
-            return [query,session](ItemKey &&k) -> basic::transaction::complex_key_value_store::KeyBasedQueryResult<ItemData>
+            auto pool = std::make_shared<PreparedKeyLookupPool<ItemKey>>(sessions, query);
+            return [pool,cache](ItemKey &&k) -> basic::transaction::complex_key_value_store::KeyBasedQueryResult<ItemData>
             {
+                if (cache) {
+                    auto cached = cache->get(k);
+                    if (cached) {
+                        return std::move(*cached);
+                    }
+                }
                 try {
-                    soci::row r;
-                    soci::statement stmt(*session);
-                    stmt.alloc();
-                    stmt.prepare(query);
-                    stmt.exchange(soci::into(r));
-                    OnDemandReadonlyServer<M>::template sociBindWhereClause<ItemKey>(stmt, k);
-                    stmt.define_and_bind();
-                    stmt.execute(false);
-                    if (stmt.fetch()) {
-                        return {DF::retrieveData(r)};
-                    } else {
-                        return {std::nullopt};
+                    auto ret = pool->run([&k](PreparedKeyLookup<ItemKey> &lookup) 
+                        -> basic::transaction::complex_key_value_store::KeyBasedQueryResult<ItemData>
+                    {
+                        lookup.boundKey = k;
+                        lookup.stmt->execute(false);
+                        if (lookup.stmt->fetch()) {
+                            return {DF::retrieveData(lookup.row)};
+                        } else {
+                            return {std::nullopt};
+                        }
+                    });
+                    if (cache) {
+                        cache->put(k, ret);
                     }
+                    return ret;
                 } catch (soci::soci_error const &) {
                     return {std::nullopt};
                 }
             };
         }
+        template <class ItemKey, class ItemData>
+        static auto keyBasedQueryFunc(
+            std::shared_ptr<soci::session> const &session
+            , std::function<std::string(std::string const &)> selectMainPartFromCriteria
+            , std::shared_ptr<KeyBasedQueryCache<ItemKey,ItemData>> const &cache = nullptr
+        )
+        {
+            return keyBasedQueryFunc<ItemKey,ItemData>(
+                std::vector<std::shared_ptr<soci::session>> {session}
+                , selectMainPartFromCriteria
+                , cache
+            );
+        }
 
         template <class ItemKey, class ItemData>
         static auto keyBasedQueryFacility(
             std::shared_ptr<soci::session> const &session
             , std::function<std::string(std::string const &)> selectMainPartFromCriteria
+            , std::shared_ptr<KeyBasedQueryCache<ItemKey,ItemData>> const &cache = nullptr
+        ) -> std::shared_ptr<typename M::template OnOrderFacility<ItemKey, basic::transaction::complex_key_value_store::KeyBasedQueryResult<ItemData>>>
+        {
+            return M::template liftPureOnOrderFacility<ItemKey>(
+                keyBasedQueryFunc<ItemKey,ItemData>(
+                    session, selectMainPartFromCriteria, cache
+                )
+            );
+        }
+        template <class ItemKey, class ItemData>
+        static auto keyBasedQueryFacility(
+            std::vector<std::shared_ptr<soci::session>> const &sessions
+            , std::function<std::string(std::string const &)> selectMainPartFromCriteria
+            , std::shared_ptr<KeyBasedQueryCache<ItemKey,ItemData>> const &cache = nullptr
         ) -> std::shared_ptr<typename M::template OnOrderFacility<ItemKey, basic::transaction::complex_key_value_store::KeyBasedQueryResult<ItemData>>>
         {
             return M::template liftPureOnOrderFacility<ItemKey>(
                 keyBasedQueryFunc<ItemKey,ItemData>(
-                    session, selectMainPartFromCriteria
+                    sessions, selectMainPartFromCriteria, cache
                 )
             );
         }
@@ -10,11 +10,95 @@
 
 #include <iostream>
 #include <sstream>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <optional>
+#include <map>
+#include <tuple>
+#include <ctime>
+#include <limits>
+#include <type_traits>
 
 #include <boost/algorithm/string.hpp>
 
 namespace dev { namespace cd606 { namespace tm { namespace transport { namespace complex_key_value_store_components {
 
+    //How the incremental refresh compares versions and where its overlap
+    //window starts. Numeric versions (e.g. a version number column) and
+    //std::tm (a timestamp column, as soci reads it) are supported.
+    template <class Version, class Enable=void>
+    struct IncrementalRefreshVersionTraits {
+        static constexpr bool IsSupported = false;
+    };
+    template <class Version>
+    struct IncrementalRefreshVersionTraits<Version, std::enable_if_t<std::is_arithmetic_v<Version>>> {
+        static constexpr bool IsSupported = true;
+        using Overlap = Version;
+        static Overlap defaultOverlap() {
+            return Version {};
+        }
+        static bool less(Version a, Version b) {
+            return a < b;
+        }
+        static Version windowStart(Version highWaterMark, Overlap overlap) {
+            if (highWaterMark < std::numeric_limits<Version>::lowest()+overlap) {
+                return std::numeric_limits<Version>::lowest();
+            }
+            return highWaterMark-overlap;
+        }
+    };
+    template <>
+    struct IncrementalRefreshVersionTraits<std::tm, void> {
+        static constexpr bool IsSupported = true;
+        using Overlap = std::chrono::seconds;
+        static Overlap defaultOverlap() {
+            return std::chrono::seconds(60);
+        }
+        //the fields are only compared with each other, so they are taken
+        //as UTC whatever the column's time zone is
+        static std::time_t toTimeT(std::tm t) {
+#ifdef _MSC_VER
+            return _mkgmtime(&t);
+#else
+            return timegm(&t);
+#endif
+        }
+        static bool less(std::tm const &a, std::tm const &b) {
+            return toTimeT(a) < toTimeT(b);
+        }
+        static std::tm windowStart(std::tm const &highWaterMark, Overlap overlap) {
+            std::time_t t = toTimeT(highWaterMark)-static_cast<std::time_t>(overlap.count());
+            std::tm ret {};
+#ifdef _MSC_VER
+            gmtime_s(&ret, &t);
+#else
+            gmtime_r(&t, &ret);
+#endif
+            return ret;
+        }
+    };
+
+    template <class Version>
+    struct IncrementalRefreshOptions {
+        static_assert(IncrementalRefreshVersionTraits<Version>::IsSupported, "IncrementalRefreshOptions: the version must be a numeric type or std::tm");
+        //a column (or column expression) that increases whenever a row
+        //is inserted or updated, such as a version number or an update
+        //timestamp, its values must be readable as Version
+        std::string versionColumn;
+        std::chrono::system_clock::duration pollInterval = std::chrono::seconds(10);
+        //every poll reads again the rows whose version is within this much
+        //of the highest version seen (version units for numeric versions,
+        //a duration for timestamps), so that rows committed out of version
+        //order are not missed. Rows already seen with the same version and
+        //data are not merged again. The rows with the highest version seen
+        //are always read again.
+        typename IncrementalRefreshVersionTraits<Version>::Overlap overlap = IncrementalRefreshVersionTraits<Version>::defaultOverlap();
+        std::function<void(infra::LogLevel, std::string const &)> logger = {};
+    };
+
     template <class M>
     class PreloadAllReadonlyServer {
     private:
@@ -98,6 +182,240 @@ namespace dev { namespace cd606 { namespace tm { namespace transport { namespace
                 }
             );
         }
+
+    private:
+        template <class ItemKey, class ItemData>
+        static std::string selectStatementWithVersion(std::string const &input, std::string const &versionColumn, bool fromWindowStart) {
+            using KF = transport::struct_field_info_utils::db_table_importer_exporter::StructFieldInfoBasedDataFiller<ItemKey>;
+            using DF = transport::struct_field_info_utils::db_table_importer_exporter::StructFieldInfoBasedDataFiller<ItemData>;
+
+            std::string s = boost::trim_copy(input);
+            std::string s1 = boost::to_upper_copy(s);
+            if (boost::starts_with(s1, "SELECT ")) {
+                throw std::runtime_error("[PreloadAllReadonlyServer] incremental refresh needs the select input to be a table name or a FROM clause");
+            }
+            std::ostringstream oss;
+            oss << "SELECT " << KF::commaSeparatedFieldNames() << ", " << DF::commaSeparatedFieldNames() << ", " << versionColumn << " AS tm_refresh_version ";
+            if (!boost::starts_with(s1, "FROM ")) {
+                oss << "FROM ";
+            }
+            oss << s;
+            if (!fromWindowStart) {
+                return oss.str();
+            }
+            //the user's clause may have its own WHERE, GROUP BY or ORDER BY,
+            //so the version condition goes on a wrapping query
+            return "SELECT * FROM ("+oss.str()+") tm_refresh_input WHERE tm_refresh_version >= :window_start ORDER BY tm_refresh_version";
+        }
+        //The refresher keeps the loaded data as an immutable snapshot. A
+        //refresh that finds new rows copies the snapshot, merges the rows
+        //into the copy and swaps it in, so readers never wait for a refresh.
+        //Rows deleted from the table are not noticed, tables that need
+        //deletes to propagate should mark the rows instead.
+        template <class ItemKey, class ItemData, class Version, class Storage>
+        class IncrementalRefresher {
+        private:
+            using KF = transport::struct_field_info_utils::db_table_importer_exporter::StructFieldInfoBasedDataFiller<ItemKey>;
+            using DF = transport::struct_field_info_utils::db_table_importer_exporter::StructFieldInfoBasedDataFiller<ItemData>;
+            using VT = IncrementalRefreshVersionTraits<Version>;
+
+            std::shared_ptr<soci::session> session_;
+            std::string fullQuery_;
+            std::string incrementalQuery_;
+            IncrementalRefreshOptions<Version> options_;
+            std::shared_ptr<Storage const> snapshot_;
+            std::optional<Version> highWaterMark_;
+            //the rows merged within the overlap window, by serialized key,
+            //with their version and serialized data
+            std::map<std::string, std::tuple<Version, std::string>> recentRows_;
+            std::mutex stopMutex_;
+            std::condition_variable stopCond_;
+            bool running_;
+            std::thread thread_;
+
+            void log(infra::LogLevel level, std::string const &s) {
+                if (options_.logger) {
+                    options_.logger(level, s);
+                }
+            }
+            //returns false if the row is the same as one already merged
+            bool recordRow(ItemKey const &key, ItemData const &data, Version const &v) {
+                auto keyStr = basic::bytedata_utils::RunSerializer<ItemKey>::apply(key);
+                auto dataStr = basic::bytedata_utils::RunSerializer<ItemData>::apply(data);
+                auto iter = recentRows_.find(keyStr);
+                if (iter != recentRows_.end()) {
+                    auto const &seenVersion = std::get<0>(iter->second);
+                    if (VT::less(v, seenVersion)) {
+                        return false;
+                    }
+                    if (!VT::less(seenVersion, v) && std::get<1>(iter->second) == dataStr) {
+                        return false;
+                    }
+                }
+                if (!highWaterMark_ || VT::less(*highWaterMark_, v)) {
+                    highWaterMark_ = v;
+                }
+                if (!VT::less(v, VT::windowStart(*highWaterMark_, options_.overlap))) {
+                    recentRows_[keyStr] = {v, std::move(dataStr)};
+                }
+                return true;
+            }
+            void pruneRecentRows() {
+                if (!highWaterMark_) {
+                    return;
+                }
+                auto windowStart = VT::windowStart(*highWaterMark_, options_.overlap);
+                for (auto iter = recentRows_.begin(); iter != recentRows_.end(); ) {
+                    if (VT::less(std::get<0>(iter->second), windowStart)) {
+                        iter = recentRows_.erase(iter);
+                    } else {
+                        ++iter;
+                    }
+                }
+            }
+            void initialLoad() {
+                auto storage = std::make_shared<Storage>();
+                std::size_t count = 0;
+                soci::rowset<soci::row> res = 
+                    session_->prepare << fullQuery_;
+                for (auto const &r : res) {
+                    auto key = KF::retrieveData(r,0);
+                    auto data = DF::retrieveData(r,KF::FieldCount);
+                    recordRow(key, data, r.template get<Version>(KF::FieldCount+DF::FieldCount));
+                    storage->insert_or_assign(std::move(key), std::move(data));
+                    ++count;
+                }
+                pruneRecentRows();
+                std::atomic_store(&snapshot_, std::shared_ptr<Storage const> {storage});
+                std::ostringstream oss;
+                oss << "[PreloadAllReadonlyServer::IncrementalRefresher] loaded " << count << " rows";
+                log(infra::LogLevel::Info, oss.str());
+            }
+            void refresh() {
+                if (!highWaterMark_) {
+                    initialLoad();
+                    return;
+                }
+                Version windowStart = VT::windowStart(*highWaterMark_, options_.overlap);
+                soci::rowset<soci::row> res = 
+                    (session_->prepare << incrementalQuery_, soci::use(windowStart, "window_start"));
+                std::shared_ptr<Storage> storage;
+                std::size_t count = 0;
+                for (auto const &r : res) {
+                    auto key = KF::retrieveData(r,0);
+                    auto data = DF::retrieveData(r,KF::FieldCount);
+                    if (!recordRow(key, data, r.template get<Version>(KF::FieldCount+DF::FieldCount))) {
+                        continue;
+                    }
+                    if (!storage) {
+                        storage = std::make_shared<Storage>(*std::atomic_load(&snapshot_));
+                    }
+                    storage->insert_or_assign(std::move(key), std::move(data));
+                    ++count;
+                }
+                pruneRecentRows();
+                if (!storage) {
+                    return;
+                }
+                std::atomic_store(&snapshot_, std::shared_ptr<Storage const> {storage});
+                std::ostringstream oss;
+                oss << "[PreloadAllReadonlyServer::IncrementalRefresher] merged " << count << " changed rows";
+                log(infra::LogLevel::Info, oss.str());
+            }
+            void run() {
+                while (true) {
+                    {
+                        std::unique_lock<std::mutex> lock(stopMutex_);
+                        stopCond_.wait_for(lock, options_.pollInterval, [this]() {return !running_;});
+                        if (!running_) {
+                            return;
+                        }
+                    }
+                    try {
+                        refresh();
+                    } catch (std::exception const &ex) {
+                        log(infra::LogLevel::Warning, std::string("[PreloadAllReadonlyServer::IncrementalRefresher] refresh failed: ")+ex.what());
+                    }
+                }
+            }
+        public:
+            IncrementalRefresher(std::shared_ptr<soci::session> const &session, std::string const &selectInput, IncrementalRefreshOptions<Version> const &options)
+                : session_(session)
+                , fullQuery_(selectStatementWithVersion<ItemKey,ItemData>(selectInput, options.versionColumn, false))
+                , incrementalQuery_(selectStatementWithVersion<ItemKey,ItemData>(selectInput, options.versionColumn, true))
+                , options_(options)
+                , snapshot_(std::make_shared<Storage const>())
+                , highWaterMark_(std::nullopt)
+                , recentRows_()
+                , stopMutex_()
+                , stopCond_()
+                , running_(true)
+                , thread_()
+            {
+                try {
+                    initialLoad();
+                } catch (std::exception const &ex) {
+                    log(infra::LogLevel::Warning, std::string("[PreloadAllReadonlyServer::IncrementalRefresher] initial load failed, will retry: ")+ex.what());
+                }
+                thread_ = std::thread(&IncrementalRefresher::run, this);
+            }
+            ~IncrementalRefresher() {
+                {
+                    std::lock_guard<std::mutex> _(stopMutex_);
+                    running_ = false;
+                }
+                stopCond_.notify_all();
+                if (thread_.joinable()) {
+                    thread_.join();
+                }
+            }
+            std::shared_ptr<Storage const> snapshot() const {
+                return std::atomic_load(&snapshot_);
+            }
+        };
+    public:
+        //Incremental variants of the two facilities above. The table is
+        //loaded once, then a background thread polls for rows whose version
+        //column is in the overlap window below the highest value seen so
+        //far or above it (see IncrementalRefreshOptions), and merges the
+        //new and changed ones in. The select input must be a table name or
+        //a FROM clause.
+        template <class ItemKey, class ItemData, class Version=long long>
+        static auto incrementallyRefreshedKeyBasedQueryFacility(
+            std::shared_ptr<soci::session> const &session
+            , std::string const &selectInput
+            , IncrementalRefreshOptions<Version> const &options
+        ) -> std::shared_ptr<typename M::template OnOrderFacility<ItemKey, basic::transaction::complex_key_value_store::KeyBasedQueryResult<ItemData>>>
+        {
+            using DBDataStorage = basic::transaction::complex_key_value_store::as_collection::Collection<ItemKey,ItemData>;
+            auto refresher = std::make_shared<IncrementalRefresher<ItemKey,ItemData,Version,DBDataStorage>>(session, selectInput, options);
+            return M::template liftPureOnOrderFacility<ItemKey>(
+                [refresher](ItemKey &&key) -> basic::transaction::complex_key_value_store::KeyBasedQueryResult<ItemData> {
+                    auto storage = refresher->snapshot();
+                    auto iter = storage->find(key);
+                    if (iter == storage->end()) {
+                        return {std::nullopt};
+                    } else {
+                        return {iter->second};
+                    }
+                }
+            );
+        }
+        template <class ItemKey, class ItemData, class QueryType=basic::VoidStruct, class Version=long long>
+        static auto incrementallyRefreshedFullDataQueryFacility(
+            std::shared_ptr<soci::session> const &session
+            , std::string const &selectInput
+            , IncrementalRefreshOptions<Version> const &options
+        ) -> std::shared_ptr<typename M::template OnOrderFacility<QueryType, basic::transaction::complex_key_value_store::FullDataResult<ItemKey,ItemData>>>
+        {
+            using Storage = basic::transaction::complex_key_value_store::FullDataResult<ItemKey,ItemData>;
+            auto refresher = std::make_shared<IncrementalRefresher<ItemKey,ItemData,Version,Storage>>(session, selectInput, options);
+            return M::template liftPureOnOrderFacility<QueryType>(
+                [refresher](QueryType &&) -> Storage {
+                    return *(refresher->snapshot());
+                }
+            );
+        }
     };
 
 }}}}}
@@ -33,19 +33,21 @@ namespace dev { namespace cd606 { namespace tm { namespace transport { namespace
             std::string tableName_;
             std::function<void(std::string)> logger_;
             std::optional<std::string> whereClause_;
+            std::size_t initialLoadProgressInterval_;
             typename basic::transaction::v2::DataStreamEnvComponent<DI>::Callback *cb_;
         public:
-            DSComponent() : session_(), tableName_(), logger_(), whereClause_(std::nullopt) {
+            DSComponent() : session_(), tableName_(), logger_(), whereClause_(std::nullopt), initialLoadProgressInterval_(0) {
             }
-            DSComponent(std::shared_ptr<soci::session> const &session, std::string const &tableName, std::function<void(std::string)> const &logger, std::optional<std::string> const &whereClause) : session_(session), tableName_(tableName), logger_(logger), whereClause_(whereClause) {
+            DSComponent(std::shared_ptr<soci::session> const &session, std::string const &tableName, std::function<void(std::string)> const &logger, std::optional<std::string> const &whereClause, std::size_t initialLoadProgressInterval=0) : session_(session), tableName_(tableName), logger_(logger), whereClause_(whereClause), initialLoadProgressInterval_(initialLoadProgressInterval) {
             }
-            DSComponent(DSComponent &&c) : session_(std::move(c.session_)), tableName_(std::move(c.tableName_)), logger_(std::move(c.logger_)), whereClause_(std::move(c.whereClause_)) {}
+            DSComponent(DSComponent &&c) : session_(std::move(c.session_)), tableName_(std::move(c.tableName_)), logger_(std::move(c.logger_)), whereClause_(std::move(c.whereClause_)), initialLoadProgressInterval_(c.initialLoadProgressInterval_) {}
             DSComponent &operator=(DSComponent &&c) {
                 if (this != &c) {
                     session_ = std::move(c.session_);
                     tableName_ = std::move(c.tableName_);
                     logger_ = std::move(c.logger_);
                     whereClause_ = std::move(c.whereClause_);
+                    initialLoadProgressInterval_ = c.initialLoadProgressInterval_;
                 }
                 return *this;
             }
@@ -63,11 +65,19 @@ namespace dev { namespace cd606 { namespace tm { namespace transport { namespace
                             :
                             ("SELECT "+KF::commaSeparatedFieldNames()+", "+DF::commaSeparatedFieldNames()+" FROM "+tableName_+(whereClause_?(" WHERE "+*whereClause_):std::string{}))
                         );
+                //the whole collection is one update, so the rows go into
+                //it directly as they are fetched, and only progress is
+                //reported along the way
                 for (auto const &r : res) {
                     initialData.insert({
                         KF::retrieveData(r,0)
                         , DF::retrieveData(r, KF::FieldCount)
                     });
+                    if (initialLoadProgressInterval_ > 0 && initialData.size() % initialLoadProgressInterval_ == 0) {
+                        std::ostringstream oss;
+                        oss << "[SingleTableAsCollectionTransactionServer::DSComponent::initialize] loaded " << initialData.size() << " rows so far";
+                        logger_(oss.str());
+                    }
                 }
                 std::ostringstream oss;
                 oss << "[SingleTableAsCollectionTransactionServer::DSComponent::initialize] loaded " << initialData.size() << " rows";
@@ -286,6 +296,7 @@ namespace dev { namespace cd606 { namespace tm { namespace transport { namespace
             , std::string const &tableName
             , std::function<bool(std::string const &)> accountFilter = std::function<bool(std::string const &)>()
             , std::optional<std::string> const &whereClause = std::nullopt
+            , std::size_t initialLoadProgressInterval = 0
         ) {
             env->DSComponent::operator=(DSComponent {
                 session
@@ -294,6 +305,7 @@ namespace dev { namespace cd606 { namespace tm { namespace transport { namespace
                     env->log(infra::LogLevel::Info, s);
                 }
                 , whereClause
+                , initialLoadProgressInterval
             });
             env->THComponent::operator=(THComponent {
                 session
@@ -11,9 +11,48 @@
 
 #include <iostream>
 #include <sstream>
+#include <fstream>
+#include <filesystem>
+#include <algorithm>
+#include <unordered_map>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <cerrno>
+
+#ifdef _MSC_VER
+#include <io.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#include <boost/algorithm/string.hpp>
 
 namespace dev { namespace cd606 { namespace tm { namespace transport { namespace complex_key_value_store_components {
 
+    struct WriteBehindOptions {
+        //the write-ahead log segments are named walPath.0, walPath.1, ...
+        std::filesystem::path walPath;
+        //a flush is started early when this many keys are pending
+        std::size_t maxBatchSize = 1000;
+        std::chrono::system_clock::duration flushInterval = std::chrono::milliseconds(100);
+        //each transaction is synced to disk before it is acknowledged,
+        //turning this off trades the last few acknowledged transactions
+        //on a machine crash for latency
+        bool syncOnAppend = true;
+        //a key that fails to be written this many flushes in a row is
+        //taken out of the write-behind queue, its latest state is appended
+        //to walPath.quarantine and an alert is logged
+        std::size_t maxAttemptsPerKey = 5;
+        //the session used by the background writer, if not set, the
+        //transaction server's session is used, which then must not be
+        //used by anything else while the server runs
+        std::shared_ptr<soci::session> session = nullptr;
+    };
+
     template <class ItemKey, class ItemData>
     class SingleTablePerItemTransactionServer {
     public:
@@ -32,18 +71,20 @@ namespace dev { namespace cd606 { namespace tm { namespace transport { namespace
             std::function<void(std::string)> logger_;
             typename basic::transaction::v2::DataStreamEnvComponent<DI>::Callback *cb_;
             std::optional<std::string> whereClause_;
+            std::size_t initialLoadChunkSize_;
         public:
-            DSComponent() : session_(), tableName_(), logger_(), whereClause_() {
+            DSComponent() : session_(), tableName_(), logger_(), whereClause_(), initialLoadChunkSize_(0) {
             }
-            DSComponent(std::shared_ptr<soci::session> const &session, std::string const &tableName, std::function<void(std::string)> const &logger, std::optional<std::string> const &whereClause) : session_(session), tableName_(tableName), logger_(logger), whereClause_(whereClause) {
+            DSComponent(std::shared_ptr<soci::session> const &session, std::string const &tableName, std::function<void(std::string)> const &logger, std::optional<std::string> const &whereClause, std::size_t initialLoadChunkSize=0) : session_(session), tableName_(tableName), logger_(logger), whereClause_(whereClause), initialLoadChunkSize_(initialLoadChunkSize) {
             }
-            DSComponent(DSComponent &&c) : session_(std::move(c.session_)), tableName_(std::move(c.tableName_)), logger_(std::move(c.logger_)), whereClause_(std::move(whereClause_)) {}
+            DSComponent(DSComponent &&c) : session_(std::move(c.session_)), tableName_(std::move(c.tableName_)), logger_(std::move(c.logger_)), whereClause_(std::move(c.whereClause_)), initialLoadChunkSize_(c.initialLoadChunkSize_) {}
             DSComponent &operator=(DSComponent &&c) {
                 if (this != &c) {
                     session_ = std::move(c.session_);
                     tableName_ = std::move(c.tableName_);
                     logger_ = std::move(c.logger_);
                     whereClause_ = std::move(c.whereClause_);
+                    initialLoadChunkSize_ = c.initialLoadChunkSize_;
                 }
                 return *this;
             }
@@ -60,6 +101,9 @@ namespace dev { namespace cd606 { namespace tm { namespace transport { namespace
                             :
                             ("SELECT "+KF::commaSeparatedFieldNames()+", "+DF::commaSeparatedFieldNames()+" FROM "+tableName_+(whereClause_?(" WHERE "+*whereClause_):std::string{}))
                         );
+                //with a chunk size, the rows are passed on to the callback
+                //one chunk at a time instead of being collected first
+                std::size_t count = 0;
                 for (auto const &r : res) {
                     updates.push_back({
                         typename DI::OneFullUpdateItem {
@@ -68,14 +112,27 @@ namespace dev { namespace cd606 { namespace tm { namespace transport { namespace
                             , DF::retrieveData(r, KF::FieldCount)
                         }
                     });
+                    ++count;
+                    if (initialLoadChunkSize_ > 0 && updates.size() >= initialLoadChunkSize_) {
+                        cb_->onUpdate(typename DI::Update {
+                            basic::ConstType<0> {}
+                            , std::move(updates)
+                        });
+                        updates = std::vector<typename DI::OneUpdateItem> {};
+                        std::ostringstream oss;
+                        oss << "[SingleTablePerItemTransactionServer::DSComponent::initialize] loaded " << count << " rows so far";
+                        logger_(oss.str());
+                    }
                 }
                 std::ostringstream oss;
-                oss << "[SingleTablePerItemTransactionServer::DSComponent::initialize] loaded " << updates.size() << " rows";
+                oss << "[SingleTablePerItemTransactionServer::DSComponent::initialize] loaded " << count << " rows";
                 logger_(oss.str());
-                cb_->onUpdate(typename DI::Update {
-                    basic::ConstType<0> {}
-                    , std::move(updates)
-                });
+                if (!updates.empty() || count == 0) {
+                    cb_->onUpdate(typename DI::Update {
+                        basic::ConstType<0> {}
+                        , std::move(updates)
+                    });
+                }
             }
             typename basic::transaction::v2::DataStreamEnvComponent<DI>::Callback *callback() const {
                 return cb_;
@@ -182,12 +239,409 @@ namespace dev { namespace cd606 { namespace tm { namespace transport { namespace
             static void sociBindData(soci::statement &stmt, ItemData const &d) {
                 sociBindData_internal<basic::StructFieldInfo<ItemData>::FIELD_NAMES.size(), 0>(stmt, d);
             }
+            //In write-behind mode, each transaction is appended to a local
+            //log and acknowledged, and only the latest state of each key
+            //is written to the table by a background thread. The log is
+            //split into segments that are rotated at each flush and removed
+            //once everything in them is committed (or quarantined), so
+            //whatever is left over after a crash is replayed at the next
+            //start.
+            class WriteBehindWriter {
+            private:
+                using Record = std::tuple<ItemKey, std::optional<ItemData>>;
+                using Pending = std::unordered_map<ItemKey, std::optional<ItemData>, basic::struct_field_info_utils::StructFieldInfoBasedHash<ItemKey>>;
+                using FailureCounts = std::unordered_map<ItemKey, std::size_t, basic::struct_field_info_utils::StructFieldInfoBasedHash<ItemKey>>;
+
+                //append-only file that can be synced to disk
+                class LogFile {
+                private:
+                    int fd_;
+                public:
+                    LogFile() : fd_(-1) {}
+                    ~LogFile() {
+                        close();
+                    }
+                    LogFile(LogFile const &) = delete;
+                    LogFile &operator=(LogFile const &) = delete;
+                    bool open(std::string const &path, bool truncate) {
+                        close();
+#ifdef _MSC_VER
+                        fd_ = ::_open(path.c_str(), _O_WRONLY | _O_CREAT | _O_BINARY | (truncate?_O_TRUNC:_O_APPEND), _S_IREAD | _S_IWRITE);
+#else
+                        fd_ = ::open(path.c_str(), O_WRONLY | O_CREAT | (truncate?O_TRUNC:O_APPEND), 0644);
+#endif
+                        return (fd_ >= 0);
+                    }
+                    void close() {
+                        if (fd_ >= 0) {
+#ifdef _MSC_VER
+                            ::_close(fd_);
+#else
+                            ::close(fd_);
+#endif
+                            fd_ = -1;
+                        }
+                    }
+                    bool write(char const *p, std::size_t len) {
+                        while (len > 0) {
+#ifdef _MSC_VER
+                            auto n = ::_write(fd_, p, static_cast<unsigned int>(len));
+#else
+                            auto n = ::write(fd_, p, len);
+                            if (n < 0 && errno == EINTR) {
+                                continue;
+                            }
+#endif
+                            if (n <= 0) {
+                                return false;
+                            }
+                            p += n;
+                            len -= static_cast<std::size_t>(n);
+                        }
+                        return true;
+                    }
+                    bool sync() {
+#ifdef _MSC_VER
+                        return (::_commit(fd_) == 0);
+#elif defined(__APPLE__)
+                        return (::fsync(fd_) == 0);
+#else
+                        return (::fdatasync(fd_) == 0);
+#endif
+                    }
+                };
+
+                std::shared_ptr<soci::session> session_;
+                std::string insertTmpl_;
+                std::string updateTmpl_;
+                std::string deleteTmpl_;
+                WriteBehindOptions options_;
+                std::function<void(std::string)> logger_;
+
+                std::mutex mutex_;
+                std::condition_variable cond_;
+                Pending pending_;
+                FailureCounts failures_;
+                LogFile walFile_;
+                uint64_t currentSegment_;
+                std::vector<uint64_t> closedSegments_;
+                bool running_;
+                std::thread thread_;
+
+                std::string segmentPath(uint64_t seq) const {
+                    return options_.walPath.string()+"."+std::to_string(seq);
+                }
+                std::string quarantinePath() const {
+                    return options_.walPath.string()+".quarantine";
+                }
+                std::vector<uint64_t> existingSegments() const {
+                    std::vector<uint64_t> ret;
+                    auto dir = options_.walPath.parent_path();
+                    if (dir.empty()) {
+                        dir = ".";
+                    }
+                    if (!std::filesystem::exists(dir)) {
+                        return ret;
+                    }
+                    std::string prefix = options_.walPath.filename().string()+".";
+                    for (auto const &entry : std::filesystem::directory_iterator(dir)) {
+                        auto name = entry.path().filename().string();
+                        if (!boost::starts_with(name, prefix)) {
+                            continue;
+                        }
+                        auto suffix = name.substr(prefix.length());
+                        if (suffix.empty() || suffix.find_first_not_of("0123456789") != std::string::npos) {
+                            continue;
+                        }
+                        ret.push_back(std::stoull(suffix));
+                    }
+                    std::sort(ret.begin(), ret.end());
+                    return ret;
+                }
+                static std::string encodeRecord(ItemKey const &key, std::optional<ItemData> const &data) {
+                    std::string payload = basic::bytedata_utils::RunSerializer<Record>::apply(Record {key, data});
+                    uint32_t len = static_cast<uint32_t>(payload.length());
+                    std::string ret;
+                    ret.reserve(4+payload.length());
+                    for (int ii=0; ii<4; ++ii) {
+                        ret.push_back(static_cast<char>((len >> (8*ii)) & 0xff));
+                    }
+                    ret.append(payload);
+                    return ret;
+                }
+                std::size_t replaySegment(uint64_t seq) {
+                    std::ifstream ifs(segmentPath(seq), std::ios::binary);
+                    std::size_t count = 0;
+                    while (ifs) {
+                        char lenBuf[4];
+                        if (!ifs.read(lenBuf, 4)) {
+                            break;
+                        }
+                        uint32_t len = 0;
+                        for (int ii=3; ii>=0; --ii) {
+                            len = (len << 8) | static_cast<uint8_t>(lenBuf[ii]);
+                        }
+                        std::string payload(len, '\0');
+                        if (!ifs.read(payload.data(), len)) {
+                            //a record cut short by a crash, it was never
+                            //acknowledged
+                            break;
+                        }
+                        auto r = basic::bytedata_utils::RunDeserializer<Record>::apply(payload);
+                        if (!r) {
+                            break;
+                        }
+                        pending_[std::get<0>(*r)] = std::move(std::get<1>(*r));
+                        ++count;
+                    }
+                    return count;
+                }
+                void openSegment(uint64_t seq) {
+                    if (!walFile_.open(segmentPath(seq), true)) {
+                        throw std::runtime_error("[SingleTablePerItemTransactionServer::WriteBehindWriter] cannot open write-ahead log segment "+segmentPath(seq));
+                    }
+                }
+                //A key is written with the same UPDATE as the synchronous
+                //path, followed by an insert only if no row was updated, so
+                //the table ends up with the latest state whether or not the
+                //row existed, without database-specific upsert syntax.
+                void writeItems(typename Pending::const_iterator begin, typename Pending::const_iterator end) {
+                    soci::transaction tr(*session_);
+                    ItemKey boundKey;
+                    ItemData boundData;
+                    soci::statement updateStmt(*session_);
+                    updateStmt.alloc();
+                    updateStmt.prepare(updateTmpl_);
+                    sociBindKey(updateStmt, boundKey);
+                    sociBindData(updateStmt, boundData);
+                    updateStmt.define_and_bind();
+                    soci::statement deleteStmt(*session_);
+                    deleteStmt.alloc();
+                    deleteStmt.prepare(deleteTmpl_);
+                    sociBindKey(deleteStmt, boundKey);
+                    deleteStmt.define_and_bind();
+                    soci::statement insertStmt(*session_);
+                    insertStmt.alloc();
+                    insertStmt.prepare(insertTmpl_);
+                    sociBindKey(insertStmt, boundKey);
+                    sociBindData(insertStmt, boundData);
+                    insertStmt.define_and_bind();
+                    for (auto iter = begin; iter != end; ++iter) {
+                        boundKey = iter->first;
+                        if (iter->second) {
+                            boundData = *(iter->second);
+                            updateStmt.execute(true);
+                            if (updateStmt.get_affected_rows() == 0) {
+                                insertStmt.execute(true);
+                            }
+                        } else {
+                            deleteStmt.execute(true);
+                        }
+                    }
+                    tr.commit();
+                }
+                //called with mutex_ held
+                void quarantine(ItemKey const &key, std::optional<ItemData> const &data, std::string const &error) {
+                    LogFile f;
+                    auto rec = encodeRecord(key, data);
+                    bool saved = (f.open(quarantinePath(), false) && f.write(rec.data(), rec.length()) && f.sync());
+                    std::ostringstream oss;
+                    oss << "[SingleTablePerItemTransactionServer::WriteBehindWriter] ALERT: giving up on a key after " << options_.maxAttemptsPerKey << " failed writes (" << error << "), ";
+                    if (saved) {
+                        oss << "its latest state is saved in " << quarantinePath();
+                    } else {
+                        oss << "and it cannot be saved in " << quarantinePath() << ", the transaction is lost";
+                    }
+                    logger_(oss.str());
+                }
+                void flush() {
+                    Pending batch;
+                    std::vector<uint64_t> segments;
+                    {
+                        std::lock_guard<std::mutex> _(mutex_);
+                        if (pending_.empty()) {
+                            return;
+                        }
+                        std::swap(batch, pending_);
+                        walFile_.close();
+                        closedSegments_.push_back(currentSegment_);
+                        ++currentSegment_;
+                        openSegment(currentSegment_);
+                        segments = closedSegments_;
+                    }
+                    std::string batchError;
+                    try {
+                        writeItems(batch.begin(), batch.end());
+                    } catch (std::exception const &ex) {
+                        batchError = ex.what();
+                    }
+                    if (batchError.empty()) {
+                        std::lock_guard<std::mutex> _(mutex_);
+                        for (auto const &item : batch) {
+                            failures_.erase(item.first);
+                        }
+                        removeSegments(segments);
+                        return;
+                    }
+                    //the batch fails as a whole if any key in it fails, so
+                    //the keys are tried one by one to find the bad ones
+                    std::size_t retried = 0;
+                    for (auto iter = batch.begin(); iter != batch.end(); ++iter) {
+                        std::string error;
+                        try {
+                            auto next = iter;
+                            ++next;
+                            writeItems(iter, next);
+                        } catch (std::exception const &ex) {
+                            error = ex.what();
+                        }
+                        std::lock_guard<std::mutex> _(mutex_);
+                        if (error.empty()) {
+                            failures_.erase(iter->first);
+                            continue;
+                        }
+                        if (++failures_[iter->first] >= options_.maxAttemptsPerKey) {
+                            failures_.erase(iter->first);
+                            //unless a newer transaction on the key is
+                            //pending, which gets its own attempts
+                            if (pending_.find(iter->first) == pending_.end()) {
+                                quarantine(iter->first, iter->second, error);
+                            }
+                            continue;
+                        }
+                        //newer transactions on the same key win
+                        pending_.try_emplace(iter->first, std::move(iter->second));
+                        ++retried;
+                    }
+                    std::lock_guard<std::mutex> _(mutex_);
+                    if (retried == 0) {
+                        removeSegments(segments);
+                    } else {
+                        std::ostringstream oss;
+                        oss << "[SingleTablePerItemTransactionServer::WriteBehindWriter] failed to write " << retried << " of " << batch.size() << " keys, will retry: " << batchError;
+                        logger_(oss.str());
+                    }
+                }
+                //called with mutex_ held
+                void removeSegments(std::vector<uint64_t> const &segments) {
+                    for (auto seq : segments) {
+                        std::error_code ec;
+                        std::filesystem::remove(segmentPath(seq), ec);
+                        closedSegments_.erase(std::remove(closedSegments_.begin(), closedSegments_.end(), seq), closedSegments_.end());
+                    }
+                }
+                void run() {
+                    while (true) {
+                        bool stopping;
+                        {
+                            std::unique_lock<std::mutex> lock(mutex_);
+                            cond_.wait_for(lock, options_.flushInterval, [this]() {
+                                return !running_ || pending_.size() >= options_.maxBatchSize;
+                            });
+                            stopping = !running_;
+                        }
+                        flush();
+                        if (stopping) {
+                            return;
+                        }
+                    }
+                }
+            public:
+                WriteBehindWriter(std::shared_ptr<soci::session> const &session, std::string const &insertTmpl, std::string const &updateTmpl, std::string const &deleteTmpl, WriteBehindOptions const &options, std::function<void(std::string)> const &logger)
+                    : session_(options.session?options.session:session)
+                    , insertTmpl_(insertTmpl)
+                    , updateTmpl_(updateTmpl)
+                    , deleteTmpl_(deleteTmpl)
+                    , options_(options)
+                    , logger_(logger)
+                    , mutex_()
+                    , cond_()
+                    , pending_()
+                    , failures_()
+                    , walFile_()
+                    , currentSegment_(0)
+                    , closedSegments_()
+                    , running_(true)
+                    , thread_()
+                {
+                    if (options_.maxAttemptsPerKey == 0) {
+                        options_.maxAttemptsPerKey = 1;
+                    }
+                    auto segments = existingSegments();
+                    std::size_t replayed = 0;
+                    for (auto seq : segments) {
+                        replayed += replaySegment(seq);
+                    }
+                    if (!segments.empty()) {
+                        currentSegment_ = segments.back()+1;
+                        closedSegments_ = segments;
+                        std::ostringstream oss;
+                        oss << "[SingleTablePerItemTransactionServer::WriteBehindWriter] replayed " << replayed << " transactions from " << segments.size() << " write-ahead log segments";
+                        logger_(oss.str());
+                    }
+                    //the replayed transactions must be in the table before
+                    //the data stream component loads it, otherwise it
+                    //would start from stale data, so the start fails if
+                    //they cannot be written (the segments are kept)
+                    if (!pending_.empty()) {
+                        try {
+                            writeItems(pending_.begin(), pending_.end());
+                        } catch (std::exception const &ex) {
+                            throw std::runtime_error(
+                                std::string("[SingleTablePerItemTransactionServer::WriteBehindWriter] cannot write the transactions replayed from the write-ahead log ")
+                                +options_.walPath.string()+".*: "+ex.what()
+                            );
+                        }
+                        pending_.clear();
+                        removeSegments(segments);
+                    }
+                    openSegment(currentSegment_);
+                    thread_ = std::thread(&WriteBehindWriter::run, this);
+                }
+                ~WriteBehindWriter() {
+                    {
+                        std::lock_guard<std::mutex> _(mutex_);
+                        running_ = false;
+                    }
+                    cond_.notify_all();
+                    if (thread_.joinable()) {
+                        thread_.join();
+                    }
+                }
+                void append(ItemKey const &key, std::optional<ItemData> const &data) {
+                    bool notify;
+                    {
+                        std::lock_guard<std::mutex> _(mutex_);
+                        auto rec = encodeRecord(key, data);
+                        if (!walFile_.write(rec.data(), rec.length())) {
+                            throw std::runtime_error("[SingleTablePerItemTransactionServer::WriteBehindWriter] cannot write to write-ahead log");
+                        }
+                        //the transaction is only acknowledged once it is
+                        //on disk
+                        if (options_.syncOnAppend && !walFile_.sync()) {
+                            throw std::runtime_error("[SingleTablePerItemTransactionServer::WriteBehindWriter] cannot sync write-ahead log");
+                        }
+                        pending_[key] = data;
+                        notify = (pending_.size() >= options_.maxBatchSize);
+                    }
+                    if (notify) {
+                        cond_.notify_one();
+                    }
+                }
+            };
+
+            std::shared_ptr<WriteBehindWriter> writeBehind_;
         public:
-            THComponent() : session_(), tableName_(), logger_(), accountFilter_(), dsComponent_(nullptr) {
+            THComponent() : session_(), tableName_(), logger_(), accountFilter_(), dsComponent_(nullptr), writeBehind_() {
             }
-            THComponent(std::shared_ptr<soci::session> const &session, std::string const &tableName, std::function<void(std::string)> const &logger, std::function<bool(std::string const &)> const &accountFilter, DSComponent *dsComponent) : session_(session), tableName_(tableName), logger_(logger), accountFilter_(accountFilter), dsComponent_(dsComponent) {
+            THComponent(std::shared_ptr<soci::session> const &session, std::string const &tableName, std::function<void(std::string)> const &logger, std::function<bool(std::string const &)> const &accountFilter, DSComponent *dsComponent, std::optional<WriteBehindOptions> const &writeBehindOptions=std::nullopt) : session_(session), tableName_(tableName), logger_(logger), accountFilter_(accountFilter), dsComponent_(dsComponent), writeBehind_() {
+                if (writeBehindOptions) {
+                    writeBehind_ = std::make_shared<WriteBehindWriter>(
+                        session, insertTemplate(), updateTemplate(), deleteTemplate(), *writeBehindOptions, logger
+                    );
+                }
             }
-            THComponent(THComponent &&c) : session_(std::move(c.session_)), tableName_(std::move(c.tableName_)), logger_(std::move(c.logger_)), accountFilter_(std::move(c.accountFilter_)), dsComponent_(c.dsComponent_) {}
+            THComponent(THComponent &&c) : session_(std::move(c.session_)), tableName_(std::move(c.tableName_)), logger_(std::move(c.logger_)), accountFilter_(std::move(c.accountFilter_)), dsComponent_(c.dsComponent_), writeBehind_(std::move(c.writeBehind_)) {}
             THComponent &operator=(THComponent &&c) {
                 if (this != &c) {
                     session_ = std::move(c.session_);
@@ -195,6 +649,7 @@ namespace dev { namespace cd606 { namespace tm { namespace transport { namespace
                     logger_ = std::move(c.logger_);
                     accountFilter_ = std::move(c.accountFilter_);
                     dsComponent_ = c.dsComponent_;
+                    writeBehind_ = std::move(c.writeBehind_);
                 }
                 return *this;
             }
@@ -213,6 +668,12 @@ namespace dev { namespace cd606 { namespace tm { namespace transport { namespace
                         return {basic::ConstType<0> {}, basic::transaction::v2::RequestDecision::FailurePermission};
                     }
                 }
+                if (writeBehind_) {
+                    writeBehind_->append(key, data);
+                    typename TI::TransactionResponse resp {basic::ConstType<0> {}, basic::transaction::v2::RequestDecision::Success};
+                    triggerCallback(resp, key, data);
+                    return resp;
+                }
                 if (session_) {
                     soci::statement stmt(*session_);
                     stmt.alloc();
@@ -238,6 +699,12 @@ namespace dev { namespace cd606 { namespace tm { namespace transport { namespace
                         return {basic::ConstType<0> {}, basic::transaction::v2::RequestDecision::FailurePermission};
                     }
                 }
+                if (writeBehind_) {
+                    writeBehind_->append(key, processedUpdate);
+                    typename TI::TransactionResponse resp {basic::ConstType<0> {}, basic::transaction::v2::RequestDecision::Success};
+                    triggerCallback(resp, key, processedUpdate);
+                    return resp;
+                }
                 if (session_) {
                     soci::statement stmt(*session_);
                     stmt.alloc();
@@ -263,6 +730,12 @@ namespace dev { namespace cd606 { namespace tm { namespace transport { namespace
                         return {basic::ConstType<0> {}, basic::transaction::v2::RequestDecision::FailurePermission};
                     }
                 }
+                if (writeBehind_) {
+                    writeBehind_->append(key, std::nullopt);
+                    typename TI::TransactionResponse resp {basic::ConstType<0> {}, basic::transaction::v2::RequestDecision::Success};
+                    triggerCallback(resp, key, std::nullopt);
+                    return resp;
+                }
                 if (session_) {
                     soci::statement stmt(*session_);
                     stmt.alloc();
@@ -293,6 +766,8 @@ namespace dev { namespace cd606 { namespace tm { namespace transport { namespace
             , std::string const &tableName
             , std::function<bool(std::string const &)> accountFilter = std::function<bool(std::string const &)>()
             , std::optional<std::string> const &whereClause = std::nullopt
+            , std::size_t initialLoadChunkSize = 0
+            , std::optional<WriteBehindOptions> const &writeBehindOptions = std::nullopt
         ) {
             env->DSComponent::operator=(DSComponent {
                 session
@@ -301,6 +776,7 @@ namespace dev { namespace cd606 { namespace tm { namespace transport { namespace
                     env->log(infra::LogLevel::Info, s);
                 }
                 , whereClause
+                , initialLoadChunkSize
             });
             env->THComponent::operator=(THComponent {
                 session
@@ -310,6 +786,7 @@ namespace dev { namespace cd606 { namespace tm { namespace transport { namespace
                 }
                 , accountFilter
                 , static_cast<DSComponent *>(env)
+                , writeBehindOptions
             });
         }
 
@@ -0,0 +1,85 @@
+#ifndef TM_KIT_TRANSPORT_COMPRESSION_COMPRESSION_HELPER_HPP_
+#define TM_KIT_TRANSPORT_COMPRESSION_COMPRESSION_HELPER_HPP_
+
+#include <memory>
+#include <cstddef>
+#include <string>
+#include <vector>
+#include <optional>
+#include <tm_kit/basic/ByteData.hpp>
+
+namespace dev { namespace cd606 { namespace tm { namespace transport { namespace compression {
+    class CompressorImpl;
+    class DecompressorImpl;
+
+    enum class CompressionAlgorithm {
+        LZ4
+        , Zstd
+    };
+
+    struct CompressionOptions {
+        CompressionAlgorithm algorithm = CompressionAlgorithm::Zstd;
+        //for zstd, this is the compression level, for LZ4, this is the
+        //acceleration factor
+        int level = 1;
+        //data shorter than this is sent uncompressed
+        std::size_t threshold = 256;
+        //a dictionary trained with CompressionHelper::trainDictionary, only
+        //used with zstd, the receivers must have the same dictionary
+        std::optional<std::string> dictionary = std::nullopt;
+    };
+
+    //Every compressed message starts with a header that describes how it
+    //is compressed (including "not compressed" for short messages), so any
+    //decompressor can read the output of any compressor, as long as it has
+    //the dictionary that the compressor used.
+    class CompressionHelper {
+    public:
+        //the limits protect the receivers from decompression bombs: a
+        //message is rejected if its header claims more than
+        //maxDecompressedSize bytes, or more than maxCompressionRatio times
+        //its compressed length (messages claiming less than
+        //MinRatioCheckedSize are never rejected for the ratio)
+        static constexpr std::size_t DefaultMaxDecompressedSize = 16*1024*1024;
+        static constexpr std::size_t DefaultMaxCompressionRatio = 1024;
+        static constexpr std::size_t MinRatioCheckedSize = 64*1024;
+
+        class Compressor {
+        private:
+            std::unique_ptr<CompressorImpl> impl_;
+        public:
+            Compressor();
+            Compressor(CompressionOptions const &options);
+            ~Compressor();
+            Compressor(Compressor const &) = delete;
+            Compressor &operator=(Compressor const &) = delete;
+            Compressor(Compressor &&);
+            Compressor &operator=(Compressor &&);
+            std::size_t maxOutputSize(std::size_t inputSize) const;
+            std::optional<std::size_t> compress(basic::ByteDataView const &input, char *output, std::size_t outputCapacity) const;
+        };
+
+        class Decompressor {
+        private:
+            std::unique_ptr<DecompressorImpl> impl_;
+        public:
+            Decompressor();
+            Decompressor(std::size_t maxDecompressedSize, std::size_t maxCompressionRatio=DefaultMaxCompressionRatio);
+            ~Decompressor();
+            Decompressor(Decompressor const &) = delete;
+            Decompressor &operator=(Decompressor const &) = delete;
+            Decompressor(Decompressor &&);
+            Decompressor &operator=(Decompressor &&);
+            void addDictionary(std::string const &dictionary);
+            std::size_t maxOutputSize(std::size_t inputSize) const;
+            //if the return value is larger than outputCapacity, nothing
+            //is written and the call should be retried with a buffer of
+            //that size (this is the buffered hook protocol)
+            std::optional<std::size_t> decompress(basic::ByteDataView const &input, char *output, std::size_t outputCapacity) const;
+        };
+
+        static std::string trainDictionary(std::vector<std::string> const &samples, std::size_t dictionarySize);
+    };
+} } } } }
+
+#endif
@@ -0,0 +1,92 @@
+#ifndef TM_KIT_TRANSPORT_COMPRESSION_COMPRESSION_HOOK_FACTORY_COMPONENT_HPP_
+#define TM_KIT_TRANSPORT_COMPRESSION_COMPRESSION_HOOK_FACTORY_COMPONENT_HPP_
+
+#include <tm_kit/transport/AbstractHookFactoryComponent.hpp>
+#include <tm_kit/transport/compression/CompressionHelper.hpp>
+#include <vector>
+
+namespace dev { namespace cd606 { namespace tm { namespace transport { namespace compression {
+
+template <class T>
+class CompressionOutgoingHookFactoryComponent : public AbstractOutgoingHookFactoryComponent<T> {
+private:
+    CompressionOptions options_;
+public:
+    CompressionOutgoingHookFactoryComponent() : options_() {}
+    CompressionOutgoingHookFactoryComponent(CompressionOptions const &options)
+        : options_(options) {}
+    virtual ~CompressionOutgoingHookFactoryComponent() {}
+    BufferedUserToWireHook bufferedOutgoingHook() {
+        auto compressor = std::make_shared<CompressionHelper::Compressor>(options_);
+        return BufferedUserToWireHook {
+            [compressor](std::size_t inputSize) {
+                return compressor->maxOutputSize(inputSize);
+            }
+            , [compressor](basic::ByteDataView const &input, char *output, std::size_t outputCapacity) {
+                return compressor->compress(input, output, outputCapacity);
+            }
+        };
+    }
+    virtual std::optional<UserToWireHook> defaultHook() override final {
+        return userToWireHookFromBufferedChain({bufferedOutgoingHook()});
+    }
+};
+
+template <class T>
+class CompressionIncomingHookFactoryComponent : public AbstractIncomingHookFactoryComponent<T> {
+private:
+    std::vector<std::string> dictionaries_;
+    std::size_t maxDecompressedSize_;
+    std::size_t maxCompressionRatio_;
+public:
+    CompressionIncomingHookFactoryComponent()
+        : dictionaries_(), maxDecompressedSize_(CompressionHelper::DefaultMaxDecompressedSize), maxCompressionRatio_(CompressionHelper::DefaultMaxCompressionRatio) {}
+    CompressionIncomingHookFactoryComponent(std::vector<std::string> const &dictionaries, std::size_t maxDecompressedSize=CompressionHelper::DefaultMaxDecompressedSize, std::size_t maxCompressionRatio=CompressionHelper::DefaultMaxCompressionRatio)
+        : dictionaries_(dictionaries), maxDecompressedSize_(maxDecompressedSize), maxCompressionRatio_(maxCompressionRatio) {}
+    virtual ~CompressionIncomingHookFactoryComponent() {}
+    BufferedWireToUserHook bufferedIncomingHook() {
+        auto decompressor = std::make_shared<CompressionHelper::Decompressor>(maxDecompressedSize_, maxCompressionRatio_);
+        for (auto const &d : dictionaries_) {
+            decompressor->addDictionary(d);
+        }
+        return BufferedWireToUserHook {
+            [decompressor](std::size_t inputSize) {
+                return decompressor->maxOutputSize(inputSize);
+            }
+            , [decompressor](basic::ByteDataView const &input, char *output, std::size_t outputCapacity) {
+                return decompressor->decompress(input, output, outputCapacity);
+            }
+        };
+    }
+    virtual std::optional<WireToUserHook> defaultHook() override final {
+        return wireToUserHookFromBufferedChain({bufferedIncomingHook()});
+    }
+};
+
+//The combined component supplies both directions for T. Since the
+//decompression side reads the header of each message, senders with
+//different algorithms (or without compression for short messages) can
+//talk to the same receivers. If a dictionary is used, it must be given to
+//both sides.
+template <class T>
+class CompressionHookFactoryComponent
+    : public CompressionOutgoingHookFactoryComponent<T>
+    , public CompressionIncomingHookFactoryComponent<T>
+{
+public:
+    CompressionHookFactoryComponent()
+        : CompressionOutgoingHookFactoryComponent<T>()
+        , CompressionIncomingHookFactoryComponent<T>()
+    {}
+    CompressionHookFactoryComponent(CompressionOptions const &options)
+        : CompressionOutgoingHookFactoryComponent<T>(options)
+        , CompressionIncomingHookFactoryComponent<T>(
+            options.dictionary?std::vector<std::string> {*options.dictionary}:std::vector<std::string> {}
+        )
+    {}
+    virtual ~CompressionHookFactoryComponent() {}
+};
+
+} } } } }
+
+#endif
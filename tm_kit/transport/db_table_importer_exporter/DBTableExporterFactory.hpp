@@ -9,8 +9,23 @@
 
 #include <iostream>
 #include <sstream>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
 
 namespace dev { namespace cd606 { namespace tm { namespace transport { namespace db_table_importer_exporter {
+    struct MicroBatchExporterOptions {
+        //a flush is done as soon as this many rows are queued
+        std::size_t maxBatchSize = 1000;
+        //rows are never kept in the queue for longer than this
+        std::chrono::system_clock::duration maxLinger = std::chrono::milliseconds(100);
+        //when the queue holds this many rows, the exporter blocks
+        //until the writer thread catches up
+        std::size_t maxQueueSize = 100000;
+    };
+
     template <class M>
     class DBTableExporterFactory {
     private:
@@ -268,6 +283,151 @@ namespace dev { namespace cd606 { namespace tm { namespace transport { namespace
                 d();
             }
         }
+    private:
+        //The writer thread owns the session while it is running, so the
+        //session must not be used by anything else at the same time.
+        template <class T>
+        class MicroBatchWriter {
+        private:
+            std::shared_ptr<soci::session> session_;
+            std::string insertStmt_;
+            MicroBatchExporterOptions options_;
+            typename M::EnvironmentType *env_;
+
+            std::mutex mutex_;
+            std::condition_variable notEmptyCond_;
+            std::condition_variable notFullCond_;
+            std::vector<T> queue_;
+            bool running_;
+            std::thread thread_;
+
+            void writeBatch(std::vector<T> const &batch) {
+                std::vector<std::function<void()>> deletors;
+                try {
+                    soci::transaction tr(*session_);
+                    soci::statement stmt(*session_);
+                    stmt.alloc();
+                    stmt.prepare(insertStmt_);
+                    sociBindFieldsBatch(stmt, batch, deletors);
+                    stmt.define_and_bind();
+                    stmt.execute(true);
+                    tr.commit();
+                } catch (std::exception const &ex) {
+                    if (env_) {
+                        std::ostringstream oss;
+                        oss << "[DBTableExporterFactory::MicroBatchWriter] Failed to write batch of " << batch.size() << " rows: " << ex.what();
+                        env_->log(infra::LogLevel::Error, oss.str());
+                    }
+                }
+                for (auto const &d : deletors) {
+                    d();
+                }
+            }
+            void run() {
+                std::vector<T> batch;
+                batch.reserve(options_.maxBatchSize);
+                while (true) {
+                    {
+                        std::unique_lock<std::mutex> lock(mutex_);
+                        notEmptyCond_.wait(lock, [this]() {
+                            return !running_ || !queue_.empty();
+                        });
+                        if (queue_.empty()) {
+                            return;
+                        }
+                        //linger for the rest of the batch unless we are
+                        //shutting down
+                        notEmptyCond_.wait_for(lock, options_.maxLinger, [this]() {
+                            return !running_ || queue_.size() >= options_.maxBatchSize;
+                        });
+                        if (queue_.size() <= options_.maxBatchSize) {
+                            std::swap(batch, queue_);
+                        } else {
+                            batch.insert(
+                                batch.end()
+                                , std::make_move_iterator(queue_.begin())
+                                , std::make_move_iterator(queue_.begin()+options_.maxBatchSize)
+                            );
+                            queue_.erase(queue_.begin(), queue_.begin()+options_.maxBatchSize);
+                        }
+                    }
+                    notFullCond_.notify_all();
+                    writeBatch(batch);
+                    batch.clear();
+                }
+            }
+        public:
+            MicroBatchWriter(std::shared_ptr<soci::session> const &session, std::string const &tableName, MicroBatchExporterOptions const &options)
+                : session_(session)
+                , insertStmt_(insertTemplate<T>(session, tableName))
+                , options_(options)
+                , env_(nullptr)
+                , mutex_()
+                , notEmptyCond_()
+                , notFullCond_()
+                , queue_()
+                , running_(true)
+                , thread_()
+            {
+                if (options_.maxBatchSize == 0) {
+                    options_.maxBatchSize = 1;
+                }
+                if (options_.maxQueueSize < options_.maxBatchSize) {
+                    options_.maxQueueSize = options_.maxBatchSize;
+                }
+                queue_.reserve(options_.maxBatchSize);
+                thread_ = std::thread(&MicroBatchWriter::run, this);
+            }
+            ~MicroBatchWriter() {
+                {
+                    std::lock_guard<std::mutex> _(mutex_);
+                    running_ = false;
+                }
+                notEmptyCond_.notify_all();
+                notFullCond_.notify_all();
+                if (thread_.joinable()) {
+                    thread_.join();
+                }
+            }
+            void push(typename M::EnvironmentType *env, T &&data) {
+                bool notify = false;
+                {
+                    std::unique_lock<std::mutex> lock(mutex_);
+                    if (!env_) {
+                        env_ = env;
+                    }
+                    notFullCond_.wait(lock, [this]() {
+                        return !running_ || queue_.size() < options_.maxQueueSize;
+                    });
+                    if (!running_) {
+                        return;
+                    }
+                    queue_.push_back(std::move(data));
+                    notify = (queue_.size() == 1 || queue_.size() >= options_.maxBatchSize);
+                }
+                if (notify) {
+                    notEmptyCond_.notify_one();
+                }
+            }
+        };
+    public:
+        //The micro-batch exporter queues the rows and writes them on its
+        //own thread, each flush being one bulk-bound insert inside one
+        //transaction. Rows still in the queue are flushed when the exporter
+        //is destroyed.
+        template <class T, typename = std::enable_if_t<basic::StructFieldInfo<T>::HasGeneratedStructFieldInfo>>
+        static auto createMicroBatchExporter(std::shared_ptr<soci::session> const &session, std::string const &tableName, MicroBatchExporterOptions const &options = MicroBatchExporterOptions {})
+            -> std::shared_ptr<typename M::template Exporter<T>>
+        {
+            auto writer = std::make_shared<MicroBatchWriter<T>>(session, tableName, options);
+            return M::template simpleExporter<T>(
+                [writer](
+                    typename M::template InnerData<T> &&data
+                ) {
+                    writer->push(data.environment, std::move(data.timedData.value));
+                }
+            );
+        }
     private:
         template <class T, int FieldCount, int FieldIndex>
         static void bindQueryFields_internal(soci::statement &stmt, T const &data, std::vector<std::function<void()>> &deletors) {
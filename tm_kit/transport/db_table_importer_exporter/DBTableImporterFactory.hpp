@@ -9,6 +9,10 @@
 
 #include <soci/soci.h>
 
+#include <vector>
+#include <memory>
+#include <functional>
+
 namespace dev { namespace cd606 { namespace tm { namespace transport { namespace db_table_importer_exporter {
     template <class M>
     class DBTableImporterFactory {
@@ -71,6 +75,95 @@ namespace dev { namespace cd606 { namespace tm { namespace transport { namespace
                 return getTableData_internal<T, transport::struct_field_info_utils::db_table_importer_exporter::StructFieldInfoBasedDataFiller<T>>(session, importerInput);
             }
         }
+    private:
+        template <class T>
+        struct StreamingImportState {
+            std::unique_ptr<soci::rowset<soci::row>> rowset;
+            soci::rowset<soci::row>::const_iterator iter;
+            std::size_t count = 0;
+            bool started = false;
+        };
+    public:
+        //Reads the query result in chunks of chunkSize rows, calling
+        //onChunk for each chunk as soon as it is read, so only one chunk
+        //is held in memory at a time. Returns the total number of rows.
+        template <class T, typename = std::enable_if_t<basic::StructFieldInfo<T>::HasGeneratedStructFieldInfo>>
+        static std::size_t forEachChunkOfTableData(std::shared_ptr<soci::session> const &session, std::string const &importerInput, std::size_t chunkSize, std::function<void(std::vector<T> &&)> const &onChunk)
+        {
+            using DF = transport::struct_field_info_utils::db_table_importer_exporter::StructFieldInfoBasedDataFiller<T>;
+            if (chunkSize == 0) {
+                chunkSize = 1;
+            }
+            std::size_t count = 0;
+            std::vector<T> chunk;
+            chunk.reserve(chunkSize);
+            soci::rowset<soci::row> queryRes = 
+                session->prepare << selectStatement<T>(session, importerInput);
+            for (auto const &r : queryRes) {
+                chunk.push_back(DF::retrieveData(r,0));
+                ++count;
+                if (chunk.size() >= chunkSize) {
+                    onChunk(std::move(chunk));
+                    chunk = std::vector<T> {};
+                    chunk.reserve(chunkSize);
+                }
+            }
+            if (!chunk.empty()) {
+                onChunk(std::move(chunk));
+            }
+            return count;
+        }
+        //The streaming importer emits the table in chunks of chunkSize rows,
+        //the last chunk (which may be empty) is marked as final. The
+        //progress callback, if given, gets the number of rows read so far
+        //after each chunk.
+        template <class T, typename = std::enable_if_t<basic::StructFieldInfo<T>::HasGeneratedStructFieldInfo>>
+        static auto createStreamingImporter(std::shared_ptr<soci::session> const &session, std::string const &importerInput, std::size_t chunkSize, std::function<void(std::size_t)> const &progressCallback = std::function<void(std::size_t)>())
+            -> std::shared_ptr<typename M::template Importer<std::vector<T>>>
+        {
+            auto state = std::make_shared<StreamingImportState<T>>();
+            if (chunkSize == 0) {
+                chunkSize = 1;
+            }
+            return M::template uniformSimpleImporter<std::vector<T>>(
+                [session,importerInput,chunkSize,progressCallback,state](
+                    typename M::EnvironmentType *env
+                ) -> std::tuple<bool, typename M::template Data<std::vector<T>>> {
+                    using DF = transport::struct_field_info_utils::db_table_importer_exporter::StructFieldInfoBasedDataFiller<T>;
+                    if (!state->started) {
+                        state->started = true;
+                        state->rowset = std::make_unique<soci::rowset<soci::row>>(
+                            session->prepare << selectStatement<T>(session, importerInput)
+                        );
+                        state->iter = state->rowset->begin();
+                    }
+                    std::vector<T> value;
+                    value.reserve(chunkSize);
+                    for (; state->iter != state->rowset->end() && value.size() < chunkSize; ++(state->iter)) {
+                        value.push_back(DF::retrieveData(*(state->iter),0));
+                    }
+                    state->count += value.size();
+                    bool isFinal = (state->iter == state->rowset->end());
+                    if (progressCallback) {
+                        progressCallback(state->count);
+                    }
+                    if (isFinal) {
+                        state->rowset.reset();
+                    }
+                    return {
+                        !isFinal
+                        , typename M::template InnerData<std::vector<T>> {
+                            env
+                            , {
+                                env->resolveTime()
+                                , std::move(value)
+                                , isFinal
+                            }
+                        }
+                    };
+                }
+            );
+        }
     private:
         template <class FirstT, class... RemainingTs>
         static constexpr bool allHaveGeneratedStructFieldInfo() {
@@ -7,6 +7,7 @@
 #include <tm_kit/basic/SerializationHelperMacros.hpp>
 
 #include <tm_kit/transport/ByteDataHook.hpp>
+#include <tm_kit/transport/EtcdWatchMultiplexer.hpp>
 
 #ifdef _MSC_VER
 #include <winsock2.h>
@@ -143,8 +144,10 @@ namespace dev { namespace cd606 { namespace tm { namespace transport { namespace
         std::shared_ptr<grpc::ChannelInterface> channel_;
         std::unique_ptr<etcdserverpb::KV::Stub> stub_;
         std::atomic<int64_t> latestModRevision_;
-        std::atomic<bool> watchThreadRunning_;
-        std::thread watchThread_;
+        std::shared_ptr<EtcdWatchMultiplexer> watchMultiplexer_;
+        std::optional<uint64_t> watchHandle_;
+        std::mutex watchMutex_;
+        bool watchStopped_;
 
         std::condition_variable notificationCond_;
 
@@ -153,53 +156,23 @@ namespace dev { namespace cd606 { namespace tm { namespace transport { namespace
 
         std::optional<ByteDataHookPair> hookPair_;
 
-        void runWatchThread() {
-            watchThreadRunning_ = true;
-
-            etcdserverpb::WatchRequest req;
-            auto *r = req.mutable_create_request();
-            r->set_key(configuration_.chainPrefix+":");
-            r->set_range_end(configuration_.chainPrefix+";");
-
-            etcdserverpb::WatchResponse watchResponse;
-            grpc::CompletionQueue queue;
-            void *tag;
-            bool ok; 
-
-            auto watchStub = etcdserverpb::Watch::NewStub(channel_);
-            grpc::ClientContext watchCtx;
-            watchCtx.set_deadline(std::chrono::system_clock::now()+std::chrono::hours(24));
-        
-            std::shared_ptr<
-                grpc::ClientAsyncReaderWriter<etcdserverpb::WatchRequest, etcdserverpb::WatchResponse>
-            > watchStream { watchStub->AsyncWatch(&watchCtx, &queue, (void *)1) };
-
-            while (watchThreadRunning_) {
-                auto status = queue.AsyncNext(&tag, &ok, std::chrono::system_clock::now()+std::chrono::milliseconds(1));
-                if (!watchThreadRunning_) {
-                    break;
-                }
-                if (status == grpc::CompletionQueue::SHUTDOWN) {
-                    watchThreadRunning_ = false;
-                    break;
-                }
-                if (status == grpc::CompletionQueue::TIMEOUT) {
-                    continue;
-                }
-                if (!ok) {
-                    watchThreadRunning_ = false;
-                    break;
-                }
-                auto tagNum = reinterpret_cast<intptr_t>(tag);
-                switch (tagNum) {
-                case 1:
-                    watchStream->Write(req, (void *)2);
-                    watchStream->Read(&watchResponse, (void *)3);
-                    break;
-                case 2:
-                    watchStream->WritesDone((void *)4);
-                    break;
-                case 3:
+        void startWatch() {
+            std::lock_guard<std::mutex> _(watchMutex_);
+            startWatchNoLock(0);
+        }
+        void startWatchNoLock(int64_t startRevision) {
+            //the watch shares the stream of the etcd channel with every
+            //other watch on it
+            if (!watchMultiplexer_) {
+                watchMultiplexer_ = EtcdWatchMultiplexer::forChannel(channel_);
+            }
+            watchHandle_ = watchMultiplexer_->addWatch(
+                configuration_.chainPrefix+":", configuration_.chainPrefix+";"
+                , [this](etcdserverpb::WatchResponse const &watchResponse) {
+                    if (watchResponse.canceled()) {
+                        restartWatch(watchResponse);
+                        return;
+                    }
                     if (watchResponse.events_size() > 0) {
                         latestModRevision_.store(watchResponse.header().revision(), std::memory_order_release);
                         if (updateTriggerFunc_) {
@@ -207,12 +180,44 @@ namespace dev { namespace cd606 { namespace tm { namespace transport { namespace
                         }
                         notificationCond_.notify_all();
                     }
-                    watchStream->Read(&watchResponse, (void *)3);  
-                    break;
-                default:
-                    break;
                 }
+                , startRevision
+            );
+        }
+        //the multiplexer has dropped the watch (for example because the
+        //revision it was to resume from has been compacted), so the
+        //chain's revision is read again, the watch is re-added from there
+        //and the readers are woken up to catch up with whatever was missed.
+        //Everything after the new watch is added is done under watchMutex_
+        //so that the destructor does not return in the middle of it.
+        void restartWatch(etcdserverpb::WatchResponse const &watchResponse) {
+            std::cerr << "[EtcdChain::restartWatch] watch on " << configuration_.chainPrefix
+                << " canceled (compact revision " << watchResponse.compact_revision()
+                << ", reason '" << watchResponse.cancel_reason() << "'), re-reading and watching again\n";
+            etcdserverpb::RangeRequest range;
+            range.set_key(configuration_.chainPrefix+":");
+            range.set_range_end(configuration_.chainPrefix+";");
+            range.set_count_only(true);
+            etcdserverpb::RangeResponse rangeResp;
+            grpc::ClientContext rangeCtx;
+            rangeCtx.set_deadline(std::chrono::system_clock::now()+std::chrono::seconds(10));
+            int64_t startRevision = 0;
+            if (stub_->Range(&rangeCtx, range, &rangeResp).ok()) {
+                latestModRevision_.store(rangeResp.header().revision(), std::memory_order_release);
+                startRevision = rangeResp.header().revision()+1;
+            } else {
+                std::cerr << "[EtcdChain::restartWatch] cannot read the revision of " << configuration_.chainPrefix << ", watching from now on\n";
+                latestModRevision_.store(0, std::memory_order_release);
             }
+            std::lock_guard<std::mutex> _(watchMutex_);
+            if (watchStopped_) {
+                return;
+            }
+            startWatchNoLock(startRevision);
+            if (updateTriggerFunc_) {
+                updateTriggerFunc_();
+            }
+            notificationCond_.notify_all();
         }
 
         std::optional<ChainRedisStorage<T>> parseRedisData(redisReply *r) {
@@ -286,7 +291,7 @@ namespace dev { namespace cd606 { namespace tm { namespace transport { namespace
             , updateTriggerFunc_()
             , channel_(config.etcdChannel?config.etcdChannel:(EtcdChainConfiguration().InsecureEtcdServerAddr().etcdChannel))
             , stub_(etcdserverpb::KV::NewStub(channel_))
-            , latestModRevision_(0), watchThreadRunning_(false), watchThread_()
+            , latestModRevision_(0), watchMultiplexer_(), watchHandle_(), watchMutex_(), watchStopped_(false)
             , notificationCond_()
             , redisCtx_(nullptr), redisMutex_()
             , hookPair_(hookPair)
@@ -295,8 +300,7 @@ namespace dev { namespace cd606 { namespace tm { namespace transport { namespace
                 std::cerr << "[EtcdChain::EtcdChain] WARNING!!! When there is a user-to-wire hook, it is strongly recommended to save data on separate storage.\n";
             }
             if (configuration_.useWatchThread) {
-                watchThread_ = std::thread(&EtcdChain::runWatchThread, this);
-                watchThread_.detach();
+                startWatch();
             }
             if (configuration_.duplicateFromRedis || configuration_.automaticallyDuplicateToRedis) {
                 auto idx = configuration_.redisServerAddr.find(':');
@@ -318,11 +322,14 @@ namespace dev { namespace cd606 { namespace tm { namespace transport { namespace
             }
         }
         ~EtcdChain() {
-            if (watchThreadRunning_) {
-                watchThreadRunning_ = false;
-                if (watchThread_.joinable()) {
-                    watchThread_.join();
-                }
+            std::optional<uint64_t> watchHandle;
+            {
+                std::lock_guard<std::mutex> _(watchMutex_);
+                watchStopped_ = true;
+                watchHandle = watchHandle_;
+            }
+            if (watchMultiplexer_ && watchHandle) {
+                watchMultiplexer_->removeWatch(*watchHandle);
             }
             if (configuration_.duplicateFromRedis) {
                 std::lock_guard<std::mutex> _(redisMutex_);
@@ -0,0 +1,180 @@
+#ifndef TM_KIT_TRANSPORT_INPROC_INPROC_COMPONENT_HPP_
+#define TM_KIT_TRANSPORT_INPROC_INPROC_COMPONENT_HPP_
+
+#include <memory>
+#include <functional>
+#include <optional>
+#include <regex>
+#include <variant>
+#include <string>
+#include <typeindex>
+#include <stdexcept>
+
+#include <tm_kit/infra/WithTimeData.hpp>
+#include <tm_kit/basic/ByteData.hpp>
+#include <tm_kit/transport/ConnectionLocator.hpp>
+#include <tm_kit/transport/ByteDataHook.hpp>
+
+namespace dev { namespace cd606 { namespace tm { namespace transport { namespace inproc {
+
+    //One message on an inproc broadcast channel. A typed publisher hands
+    //over the object itself, and the bytes are only produced (once) if
+    //some subscriber on the channel wants bytes or a different type.
+    class InprocMessage {
+    private:
+        std::string topic_;
+        std::type_index type_;
+        std::shared_ptr<void const> value_;
+        mutable bool serialized_;
+        mutable std::optional<std::string> bytes_;
+        std::function<std::optional<std::string>()> serializer_;
+    public:
+        //from a byte publisher, the publisher's hook is already applied
+        InprocMessage(std::string &&topic, std::string &&bytes)
+            : topic_(std::move(topic)), type_(typeid(void)), value_(), serialized_(true), bytes_(std::move(bytes)), serializer_()
+        {}
+        //from a typed publisher, the serializer must apply the publisher's
+        //hook as well, and returns std::nullopt if the hook rejects it
+        InprocMessage(std::string &&topic, std::type_index type, std::shared_ptr<void const> &&value, std::function<std::optional<std::string>()> &&serializer)
+            : topic_(std::move(topic)), type_(type), value_(std::move(value)), serialized_(false), bytes_(std::nullopt), serializer_(std::move(serializer))
+        {}
+        std::string const &topic() const {
+            return topic_;
+        }
+        template <class T>
+        T const *typedValue() const {
+            if (value_ && type_ == std::type_index(typeid(T))) {
+                return static_cast<T const *>(value_.get());
+            }
+            return nullptr;
+        }
+        //nullptr if there are no bytes for the message (the typed
+        //publisher's hook rejected it), such a message is dropped
+        std::string const *bytes() const {
+            if (!serialized_) {
+                bytes_ = serializer_();
+                serialized_ = true;
+            }
+            return (bytes_?&(*bytes_):nullptr);
+        }
+    };
+
+    class InprocComponentImpl;
+
+    class InprocComponentException : public std::runtime_error {
+    public:
+        InprocComponentException(std::string const &info) : std::runtime_error(info) {}
+    };
+
+    //The channels live in the process, not in the component, so that
+    //graphs with different environments in the same process can talk to
+    //each other. Host, port and identifier in the locator name the channel,
+    //e.g. "inproc://md_feed" or "inproc://127.0.0.1:1234:::md_feed".
+    //
+    //Delivery happens on the publishing thread, straight into the
+    //subscribers' callbacks (for importers, that is the graph's own queue),
+    //and the publishing path takes no lock. Typed publishers and typed
+    //subscribers of the same type skip serialization and the byte hooks
+    //altogether, every other combination goes through the bytes with the
+    //hooks applied on both ends.
+    class InprocComponent {
+    private:
+        std::unique_ptr<InprocComponentImpl> impl_;
+    public:
+        InprocComponent();
+        virtual ~InprocComponent();
+        InprocComponent(InprocComponent &&);
+        InprocComponent &operator=(InprocComponent &&);
+
+        struct NoTopicSelection {};
+        using TopicSelection = std::variant<NoTopicSelection, std::string, std::regex>;
+
+        uint32_t inproc_addMessageSubscriptionClient(ConnectionLocator const &locator,
+                        TopicSelection const &topic,
+                        std::function<void(InprocMessage const &)> client);
+        std::function<void(InprocMessage &&)> inproc_getMessagePublisher(ConnectionLocator const &locator);
+
+        uint32_t inproc_addSubscriptionClient(ConnectionLocator const &locator,
+                        TopicSelection const &topic,
+                        std::function<void(basic::ByteDataWithTopic &&)> client,
+                        std::optional<WireToUserHook> wireToUserHook = std::nullopt);
+        void inproc_removeSubscriptionClient(uint32_t id);
+        std::function<void(basic::ByteDataWithTopic &&)> inproc_getPublisher(ConnectionLocator const &locator, std::optional<UserToWireHook> userToWireHook = std::nullopt);
+
+        template <class T>
+        uint32_t inproc_addTypedSubscriptionClient(ConnectionLocator const &locator,
+                        TopicSelection const &topic,
+                        std::function<void(basic::TypedDataWithTopic<T> &&)> client,
+                        std::optional<WireToUserHook> wireToUserHook = std::nullopt,
+                        std::function<void()> onDecodeFailure = std::function<void()>()) {
+            return inproc_addMessageSubscriptionClient(
+                locator
+                , topic
+                , [client,wireToUserHook,onDecodeFailure](InprocMessage const &m) {
+                    if (auto const *v = m.template typedValue<T>()) {
+                        client({m.topic(), *v});
+                        return;
+                    }
+                    auto const *bytes = m.bytes();
+                    if (!bytes) {
+                        return;
+                    }
+                    std::optional<basic::ByteData> b;
+                    if (wireToUserHook) {
+                        b = (wireToUserHook->hook)(basic::ByteDataView {std::string_view(*bytes)});
+                        if (!b) {
+                            return;
+                        }
+                    }
+                    T t;
+                    auto tRes = basic::bytedata_utils::RunDeserializer<T>::applyInPlace(t, b?b->content:*bytes);
+                    if (tRes) {
+                        client({m.topic(), std::move(t)});
+                    } else if (onDecodeFailure) {
+                        onDecodeFailure();
+                    }
+                }
+            );
+        }
+        template <class T>
+        std::function<void(basic::TypedDataWithTopic<T> &&)> inproc_getTypedPublisher(ConnectionLocator const &locator, std::optional<UserToWireHook> userToWireHook = std::nullopt) {
+            auto p = inproc_getMessagePublisher(locator);
+            return [p,userToWireHook](basic::TypedDataWithTopic<T> &&data) {
+                auto v = std::make_shared<T const>(std::move(data.content));
+                p(InprocMessage {
+                    std::move(data.topic)
+                    , std::type_index(typeid(T))
+                    , std::shared_ptr<void const> {v}
+                    , [v,userToWireHook]() -> std::optional<std::string> {
+                        auto s = basic::bytedata_utils::RunSerializer<T>::apply(*v);
+                        if (userToWireHook) {
+                            auto x = byte_data_hook_utils::tryUserToWireHook(userToWireHook->hook, basic::ByteData {std::move(s)});
+                            if (!x) {
+                                return std::nullopt;
+                            }
+                            return std::move(x->content);
+                        }
+                        return s;
+                    }
+                });
+            };
+        }
+
+        //The RPC side works on bytes like socket_rpc does, so identities
+        //and hooks behave the same as on the network transports. The
+        //requester throws InprocComponentException if there is no server
+        //on the channel, instead of leaving the client waiting for a reply
+        //that never comes. For the same reason, the requests still in
+        //flight when the server goes away get an empty final reply.
+        std::function<void(basic::ByteDataWithID &&)> inproc_setRPCClient(ConnectionLocator const &locator,
+                        std::function<void(bool, basic::ByteDataWithID &&)> client,
+                        std::optional<ByteDataHookPair> hookPair = std::nullopt); //the return value is the requester
+        void inproc_removeRPCClient(ConnectionLocator const &locator);
+        std::function<void(bool, basic::ByteDataWithID &&)> inproc_setRPCServer(ConnectionLocator const &locator,
+                        std::function<void(basic::ByteDataWithID &&)> server,
+                        std::optional<ByteDataHookPair> hookPair = std::nullopt); //the return value is the replier, where bool means whether it is the final reply
+    };
+
+} } } } }
+
+#endif
@@ -0,0 +1,277 @@
+#ifndef TM_KIT_TRANSPORT_INPROC_INPROC_IMPORTER_EXPORTER_HPP_
+#define TM_KIT_TRANSPORT_INPROC_INPROC_IMPORTER_EXPORTER_HPP_
+
+#include <type_traits>
+
+#include <boost/lexical_cast.hpp>
+
+#include <tm_kit/infra/RealTimeApp.hpp>
+#include <tm_kit/infra/TraceNodesComponent.hpp>
+#include <tm_kit/basic/ByteData.hpp>
+#include <tm_kit/transport/inproc/InprocComponent.hpp>
+#include <tm_kit/transport/HeartbeatAndAlertComponent.hpp>
+#include <tm_kit/transport/TransportMetricsComponent.hpp>
+#include <tm_kit/transport/LatencyStamping.hpp>
+#include <tm_kit/transport/ReceivePipeline.hpp>
+#include <tm_kit/transport/LazilyDecodedData.hpp>
+#include <tm_kit/transport/ReceiveDecoding.hpp>
+#include <tm_kit/transport/AbstractHookFactoryComponent.hpp>
+
+namespace dev { namespace cd606 { namespace tm { namespace transport { namespace inproc {
+
+    template <class Env, std::enable_if_t<std::is_base_of_v<InprocComponent, Env>, int> = 0>
+    class InprocImporterExporter {
+    public:
+        using M = infra::RealTimeApp<Env>;
+    private:
+        template <class Decoding>
+        static std::shared_ptr<typename M::template Importer<typename Decoding::Output>> createImporterWithDecoding(ConnectionLocator const &locator, std::variant<InprocComponent::NoTopicSelection, std::string, std::regex> const &topic, std::optional<WireToUserHook> wireToUserHook) {
+            using Output = typename Decoding::Output;
+            using Value = typename Decoding::Value;
+            class LocalI final : public M::template AbstractImporter<Output>, public virtual infra::IControllableNode<Env> {
+            private:
+                ConnectionLocator locator_;
+                std::variant<InprocComponent::NoTopicSelection, std::string, std::regex> topic_;
+                std::optional<WireToUserHook> wireToUserHook_;
+                std::optional<uint32_t> client_;
+                std::mutex mutex_;
+                ReceivePipeline pipeline_;
+
+                void deliver(Env *env, basic::ByteDataWithTopic &&d) {
+                    auto o = Decoding::decode(std::move(d), pipeline_.metrics());
+                    if (o) {
+                        this->publish(M::template pureInnerData<Output>(env, std::move(*o)));
+                    }
+                }
+            public:
+                LocalI(ConnectionLocator const &locator, std::variant<InprocComponent::NoTopicSelection, std::string, std::regex> const &topic, std::optional<WireToUserHook> wireToUserHook)
+                    : locator_(locator), topic_(topic), wireToUserHook_(wireToUserHook), client_(std::nullopt), mutex_(), pipeline_()
+                {
+                }
+                virtual void start(Env *env) override final {
+                    std::lock_guard<std::mutex> _(mutex_);
+                    pipeline_.setup(env, "inproc", locator_, [this,env](basic::ByteDataWithTopic &&d) {
+                        deliver(env, std::move(d));
+                    });
+                    if (!wireToUserHook_) {
+                        wireToUserHook_ = Decoding::defaultIncomingHook(env);
+                    }
+                    if (client_) {
+                        return;
+                    }
+                    if constexpr (!std::is_void_v<Value>) {
+                        if (!pipeline_.isDecoupled()) {
+                            //an object of the same type comes over as it
+                            //is, anything else is kept as bytes; the byte
+                            //count is not known for objects, so only the
+                            //message count is kept
+                            auto hook = pipeline_.incomingHook(wireToUserHook_);
+                            client_ = env->inproc_addMessageSubscriptionClient(
+                                locator_
+                                , topic_
+                                , [this,env,hook](InprocMessage const &m) {
+                                    TM_INFRA_IMPORTER_TRACER(env);
+                                    if (auto const &metrics = pipeline_.metrics()) {
+                                        metrics->recordInbound(0);
+                                    }
+                                    if (auto const *v = m.template typedValue<Value>()) {
+                                        this->publish(M::template pureInnerData<Output>(env, Decoding::fromValue(m.topic(), *v)));
+                                    } else if (auto const *bytes = m.bytes()) {
+                                        if (hook) {
+                                            auto b = (hook->hook)(basic::ByteDataView {std::string_view(*bytes)});
+                                            if (b) {
+                                                deliver(env, {m.topic(), std::move(b->content)});
+                                            }
+                                        } else {
+                                            deliver(env, {m.topic(), *bytes});
+                                        }
+                                    }
+                                }
+                            );
+                            return;
+                        }
+                    }
+                    //conflation and dispatching hold bytes, so that the
+                    //decoding happens later (or never, for the skipped
+                    //values)
+                    client_ = env->inproc_addSubscriptionClient(
+                        locator_
+                        , topic_
+                        , [this,env](basic::ByteDataWithTopic &&d) {
+                            TM_INFRA_IMPORTER_TRACER(env);
+                            pipeline_.push(std::move(d));
+                        }
+                        , pipeline_.incomingHook(wireToUserHook_)
+                    );
+                }
+                virtual void control(Env *env, std::string const &command, std::vector<std::string> const &/*params*/) override final {
+                    std::thread th([this,env,command]() {
+                        if (command == "stop") {
+                            std::lock_guard<std::mutex> _(mutex_);
+                            if (client_) {
+                                env->inproc_removeSubscriptionClient(*client_);
+                                client_ = std::nullopt;
+                            }
+                        } else if (command == "restart") {
+                            start(env);
+                        }
+                    });
+                    th.detach();
+                }
+            };
+            return M::importer(new LocalI(locator, topic, wireToUserHook));
+        }
+    public:
+        static std::shared_ptr<typename M::template Importer<basic::ByteDataWithTopic>> createImporter(ConnectionLocator const &locator, std::variant<InprocComponent::NoTopicSelection, std::string, std::regex> const &topic=InprocComponent::NoTopicSelection(), std::optional<WireToUserHook> wireToUserHook=std::nullopt) {
+            return createImporterWithDecoding<RawReceiveDecoding>(locator, topic, wireToUserHook);
+        }
+        template <class T>
+        static std::shared_ptr<typename M::template Importer<basic::TypedDataWithTopic<T>>> createTypedImporter(ConnectionLocator const &locator, std::variant<InprocComponent::NoTopicSelection, std::string, std::regex> const &topic=InprocComponent::NoTopicSelection(), std::optional<WireToUserHook> wireToUserHook=std::nullopt) {
+            return createImporterWithDecoding<TypedReceiveDecoding<T>>(locator, topic, wireToUserHook);
+        }
+        template <class T>
+        static std::shared_ptr<typename M::template Importer<LazilyDecodedDataWithTopic<T>>> createLazilyDecodedImporter(ConnectionLocator const &locator, std::variant<InprocComponent::NoTopicSelection, std::string, std::regex> const &topic=InprocComponent::NoTopicSelection(), std::optional<WireToUserHook> wireToUserHook=std::nullopt) {
+            return createImporterWithDecoding<LazyReceiveDecoding<T>>(locator, topic, wireToUserHook);
+        }
+        static std::shared_ptr<typename M::template Exporter<basic::ByteDataWithTopic>> createExporter(ConnectionLocator const &locator, std::optional<UserToWireHook> userToWireHook=std::nullopt, std::string const &heartbeatName = "") {
+            class LocalE final : public M::template AbstractExporter<basic::ByteDataWithTopic> {
+            private:
+                ConnectionLocator locator_;
+                Env *env_;
+                std::function<void(basic::ByteDataWithTopic &&)> publisher_;
+                std::optional<UserToWireHook> userToWireHook_;
+                std::string heartbeatName_;
+                std::shared_ptr<TransportChannelMetrics> metrics_;
+            public:
+                LocalE(ConnectionLocator const &locator, std::optional<UserToWireHook> userToWireHook, std::string const &heartbeatName)
+                    : locator_(locator), env_(nullptr), publisher_(), userToWireHook_(userToWireHook), heartbeatName_(heartbeatName), metrics_()
+                {  
+                }
+                virtual void start(Env *env) override final {
+                    env_ = env;
+                    metrics_ = transportChannelMetrics(env, "inproc", locator_);
+                    publisher_ = env->inproc_getPublisher(locator_, latencyStampedOutgoingHook(locator_, userToWireHook_));
+                    if constexpr (std::is_convertible_v<
+                        Env *
+                        , HeartbeatAndAlertComponent *
+                    >) {
+                        static_cast<HeartbeatAndAlertComponent *>(env)->addBroadcastChannel(
+                            heartbeatName_
+                            , std::string("inproc://")+locator_.toSerializationFormat()
+                        );
+                    }
+                }
+                virtual void handle(typename M::template InnerData<basic::ByteDataWithTopic> &&data) override final {
+                    if (env_) {
+                        TM_INFRA_EXPORTER_TRACER(env_);
+                        TransportMetricsSendScope metricsScope(metrics_.get(), data.timedData.value.content.length());
+                        publisher_(std::move(data.timedData.value));
+                    }
+                }
+            };
+            return M::exporter(new LocalE(locator, userToWireHook, heartbeatName));
+        }
+        template <class T>
+        static std::shared_ptr<typename M::template Exporter<basic::TypedDataWithTopic<T>>> createTypedExporter(ConnectionLocator const &locator, std::optional<UserToWireHook> userToWireHook=std::nullopt, std::string const &heartbeatName = "") {
+            class LocalE final : public M::template AbstractExporter<basic::TypedDataWithTopic<T>> {
+            private:
+                ConnectionLocator locator_;
+                Env *env_;
+                std::function<void(basic::TypedDataWithTopic<T> &&)> publisher_;
+                std::optional<UserToWireHook> userToWireHook_;
+                std::string heartbeatName_;
+                std::shared_ptr<TransportChannelMetrics> metrics_;
+            public:
+                LocalE(ConnectionLocator const &locator, std::optional<UserToWireHook> userToWireHook, std::string const &heartbeatName)
+                    : locator_(locator), env_(nullptr), publisher_(), userToWireHook_(userToWireHook), heartbeatName_(heartbeatName), metrics_()
+                {
+                }
+                virtual void start(Env *env) override final {
+                    env_ = env;
+                    metrics_ = transportChannelMetrics(env, "inproc", locator_);
+                    if (!userToWireHook_) {
+                        userToWireHook_ = DefaultHookFactory<Env>::template outgoingHook<T>(env);
+                    }
+                    publisher_ = env->template inproc_getTypedPublisher<T>(locator_, latencyStampedOutgoingHook(locator_, userToWireHook_));
+                    if constexpr (std::is_convertible_v<
+                        Env *
+                        , HeartbeatAndAlertComponent *
+                    >) {
+                        static_cast<HeartbeatAndAlertComponent *>(env)->addBroadcastChannel(
+                            heartbeatName_
+                            , std::string("inproc://")+locator_.toSerializationFormat()
+                        );
+                    }
+                }
+                virtual void handle(typename M::template InnerData<basic::TypedDataWithTopic<T>> &&data) override final {
+                    if (env_) {
+                        TM_INFRA_EXPORTER_TRACER(env_);
+                        TransportMetricsSendScope metricsScope(metrics_.get(), 0);
+                        publisher_(std::move(data.timedData.value));
+                    }
+                }
+            };
+            return M::exporter(new LocalE(locator, userToWireHook, heartbeatName));
+        }
+        static std::future<basic::ByteDataWithTopic> fetchFirstUpdateAndDisconnect(Env *env, ConnectionLocator const &locator, std::variant<InprocComponent::NoTopicSelection, std::string, std::regex> const &topic, std::optional<WireToUserHook> hook = std::nullopt) {
+            std::shared_ptr<std::promise<basic::ByteDataWithTopic>> ret = std::make_shared<std::promise<basic::ByteDataWithTopic>>();
+            std::shared_ptr<std::atomic<uint32_t>> id = std::make_shared<std::atomic<uint32_t>>();
+                
+            bool done = false;
+            *id = env->inproc_addSubscriptionClient(
+                locator
+                , topic 
+                , [env, ret, id, done](basic::ByteDataWithTopic &&d) mutable {
+                    if (!done) {
+                        done = true;
+                        std::thread([env, ret, id, d = std::move(d)]() {
+                            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+                            env->inproc_removeSubscriptionClient(*id);
+                            try {
+                                ret->set_value_at_thread_exit(std::move(d));
+                            } catch (std::future_error const &) {
+                            }
+                        }).detach();
+                    }
+                }
+                , latencyStampedIncomingHook(env, "inproc", locator, hook)
+            );
+            return ret->get_future();
+        }
+        template <class T>
+        static std::future<basic::TypedDataWithTopic<T>> fetchTypedFirstUpdateAndDisconnect(Env *env, ConnectionLocator const &locator, std::variant<InprocComponent::NoTopicSelection, std::string, std::regex> const &topic, std::function<bool(T const &)> predicate = std::function<bool(T const &)>(), std::optional<WireToUserHook> hook = std::nullopt) {
+            std::shared_ptr<std::promise<basic::TypedDataWithTopic<T>>> ret = std::make_shared<std::promise<basic::TypedDataWithTopic<T>>>();
+            std::shared_ptr<std::atomic<uint32_t>> id = std::make_shared<std::atomic<uint32_t>>();
+                
+            bool done = false;
+            *id = env->template inproc_addTypedSubscriptionClient<T>(
+                locator
+                , topic 
+                , [env, ret, id, predicate, done](basic::TypedDataWithTopic<T> &&d) mutable {
+                    if (!done && (!predicate || predicate(d.content))) {
+                        basic::TypedDataWithTopic<T> res = std::move(d);
+                        done = true;
+                        std::thread([env, ret, id, res = std::move(res)]() mutable {
+                            try {
+                                std::this_thread::sleep_for(std::chrono::milliseconds(10));
+                                env->inproc_removeSubscriptionClient(*id);
+                                ret->set_value_at_thread_exit(std::move(res));
+                            } catch (std::future_error const &) {
+                            } catch (std::exception const &) {
+                                try {
+                                    ret->set_exception_at_thread_exit(std::current_exception());
+                                } catch (std::future_error const &) {
+                                }
+                            }
+                        }).detach();
+                    }
+                }
+                , latencyStampedIncomingHook(env, "inproc", locator, DefaultHookFactory<Env>::template supplyIncomingHook<T>(env, hook))
+            );
+            return ret->get_future();
+        }
+    };
+
+} } } } }
+
+#endif
\ No newline at end of file
@@ -5,6 +5,7 @@
 #include <tm_kit/basic/simple_shared_chain/ChainWriter.hpp>
 #include <tm_kit/basic/ByteData.hpp>
 #include <tm_kit/transport/ByteDataHook.hpp>
+#include <tm_kit/transport/SharedMemorySegment.hpp>
 #include <atomic>
 #include <ctime>
 
@@ -327,6 +328,7 @@ namespace dev { namespace cd606 { namespace tm { namespace transport { namespace
 #else
         boost::interprocess::managed_shared_memory mem_;
 #endif
+        SharedMemorySegmentLayout segmentLayout_;
         IPCMutexWrapper<EDPS> mutex_;
         BoostSharedMemoryStorageItem<T, ForceSeparate> *head_;
         std::optional<ByteDataHookPair> hookPair_;
@@ -428,12 +430,13 @@ namespace dev { namespace cd606 { namespace tm { namespace transport { namespace
             };
         }
     public:
-        LockFreeInBoostSharedMemoryChain(std::string const &name, std::size_t sharedMemorySize, std::optional<ByteDataHookPair> hookPair=std::nullopt, bool useNotification=false) :
+        LockFreeInBoostSharedMemoryChain(std::string const &name, std::size_t sharedMemorySize, std::optional<ByteDataHookPair> hookPair=std::nullopt, bool useNotification=false, SharedMemorySegmentOptions const &segmentOptions=SharedMemorySegmentOptions {}) :
             mem_(
                 boost::interprocess::open_or_create
                 , name.c_str()
                 , sharedMemorySize
             )
+            , segmentLayout_(prepareSharedMemorySegment(mem_.get_address(), mem_.get_size(), segmentOptions))
             , mutex_(name, "extra_data", &mem_)
             , head_(nullptr)
             , hookPair_(ForceSeparate?hookPair:std::nullopt)
@@ -450,6 +453,9 @@ namespace dev { namespace cd606 { namespace tm { namespace transport { namespace
                 notificationCond_ = mem_.find_or_construct<boost::interprocess::interprocess_condition>(boost::interprocess::unique_instance)();
             }
         }
+        SharedMemorySegmentLayout const &segmentLayout() const {
+            return segmentLayout_;
+        }
         ItemType head(void *) {
             return fromIDAndPtr("", head_);
         }
@@ -835,6 +841,7 @@ namespace dev { namespace cd606 { namespace tm { namespace transport { namespace
 #else
         boost::interprocess::managed_shared_memory mem_;
 #endif
+        SharedMemorySegmentLayout segmentLayout_;
         IPCMutexWrapper<EDPS> mutex_;
         BoostSharedMemoryStorageItem<T, ForceSeparate> *head_;
         std::optional<ByteDataHookPair> hookPair_;
@@ -935,12 +942,13 @@ namespace dev { namespace cd606 { namespace tm { namespace transport { namespace
             }
         }
     public:
-        LockFreeInBoostSharedMemoryChain(std::string const &name, std::size_t sharedMemorySize, std::optional<ByteDataHookPair> hookPair=std::nullopt, bool useNotification=false) :
+        LockFreeInBoostSharedMemoryChain(std::string const &name, std::size_t sharedMemorySize, std::optional<ByteDataHookPair> hookPair=std::nullopt, bool useNotification=false, SharedMemorySegmentOptions const &segmentOptions=SharedMemorySegmentOptions {}) :
             mem_(
                 boost::interprocess::open_or_create
                 , name.c_str()
                 , sharedMemorySize
             )
+            , segmentLayout_(prepareSharedMemorySegment(mem_.get_address(), mem_.get_size(), segmentOptions))
             , mutex_(name, "extra_data", &mem_)
             , head_(nullptr)
             , hookPair_(ForceSeparate?hookPair:std::nullopt)
@@ -957,6 +965,9 @@ namespace dev { namespace cd606 { namespace tm { namespace transport { namespace
                 notificationCond_ = mem_.find_or_construct<boost::interprocess::interprocess_condition>(boost::interprocess::unique_instance)();
             }
         }
+        SharedMemorySegmentLayout const &segmentLayout() const {
+            return segmentLayout_;
+        }
         ItemType head(void *) {
             return fromPtr(
                 head_
@@ -10,6 +10,11 @@
 #include <tm_kit/basic/ByteData.hpp>
 #include <tm_kit/transport/multicast/MulticastComponent.hpp>
 #include <tm_kit/transport/HeartbeatAndAlertComponent.hpp>
+#include <tm_kit/transport/TransportMetricsComponent.hpp>
+#include <tm_kit/transport/LatencyStamping.hpp>
+#include <tm_kit/transport/ReceivePipeline.hpp>
+#include <tm_kit/transport/LazilyDecodedData.hpp>
+#include <tm_kit/transport/ReceiveDecoding.hpp>
 #include <tm_kit/transport/AbstractHookFactoryComponent.hpp>
 
 namespace dev { namespace cd606 { namespace tm { namespace transport { namespace multicast {
@@ -18,82 +23,47 @@ namespace dev { namespace cd606 { namespace tm { namespace transport { namespace
     class MulticastImporterExporter {
     public:
         using M = infra::RealTimeApp<Env>;
-        static std::shared_ptr<typename M::template Importer<basic::ByteDataWithTopic>> createImporter(ConnectionLocator const &locator, std::variant<MulticastComponent::NoTopicSelection, std::string, std::regex> const &topic=MulticastComponent::NoTopicSelection(), std::optional<WireToUserHook> wireToUserHook=std::nullopt) {
-            class LocalI final : public M::template AbstractImporter<basic::ByteDataWithTopic>, public virtual infra::IControllableNode<Env> {
+    private:
+        template <class Decoding>
+        static std::shared_ptr<typename M::template Importer<typename Decoding::Output>> createImporterWithDecoding(ConnectionLocator const &locator, std::variant<MulticastComponent::NoTopicSelection, std::string, std::regex> const &topic, std::optional<WireToUserHook> wireToUserHook) {
+            using Output = typename Decoding::Output;
+            class LocalI final : public M::template AbstractImporter<Output>, public virtual infra::IControllableNode<Env> {
             private:
                 ConnectionLocator locator_;
                 std::variant<MulticastComponent::NoTopicSelection, std::string, std::regex> topic_;
                 std::optional<WireToUserHook> wireToUserHook_;
                 std::optional<uint32_t> client_;
                 std::mutex mutex_;
-            public:
-                LocalI(ConnectionLocator const &locator, std::variant<MulticastComponent::NoTopicSelection, std::string, std::regex> const &topic, std::optional<WireToUserHook> wireToUserHook)
-                    : locator_(locator), topic_(topic), wireToUserHook_(wireToUserHook), client_(std::nullopt), mutex_()
-                {
-                }
-                virtual void start(Env *env) override final {
-                    std::lock_guard<std::mutex> _(mutex_);
-                    if (!client_) {
-                        client_ = env->multicast_addSubscriptionClient(
-                            locator_
-                            , topic_
-                            , [this,env](basic::ByteDataWithTopic &&d) {
-                                TM_INFRA_IMPORTER_TRACER(env);
-                                this->publish(M::template pureInnerData<basic::ByteDataWithTopic>(env, std::move(d)));
-                            }
-                            , wireToUserHook_
-                        );
+                ReceivePipeline pipeline_;
+
+                void deliver(Env *env, basic::ByteDataWithTopic &&d) {
+                    auto o = Decoding::decode(std::move(d), pipeline_.metrics());
+                    if (o) {
+                        this->publish(M::template pureInnerData<Output>(env, std::move(*o)));
                     }
                 }
-                virtual void control(Env *env, std::string const &command, std::vector<std::string> const &params) override final {
-                    std::thread th([this,env,command]() {
-                        if (command == "stop") {
-                            std::lock_guard<std::mutex> _(mutex_);
-                            if (client_) {
-                                env->multicast_removeSubscriptionClient(*client_);
-                                client_ = std::nullopt;
-                            }
-                        } else if (command == "restart") {
-                            start(env);
-                        }
-                    });
-                    th.detach();
-                }
-            };
-            return M::importer(new LocalI(locator, topic, wireToUserHook));
-        }
-        template <class T>
-        static std::shared_ptr<typename M::template Importer<basic::TypedDataWithTopic<T>>> createTypedImporter(ConnectionLocator const &locator, std::variant<MulticastComponent::NoTopicSelection, std::string, std::regex> const &topic=MulticastComponent::NoTopicSelection(), std::optional<WireToUserHook> wireToUserHook=std::nullopt) {
-            class LocalI final : public M::template AbstractImporter<basic::TypedDataWithTopic<T>>, public virtual infra::IControllableNode<Env> {
-            private:
-                ConnectionLocator locator_;
-                std::variant<MulticastComponent::NoTopicSelection, std::string, std::regex> topic_;
-                std::optional<WireToUserHook> wireToUserHook_;
-                std::optional<uint32_t> client_;
-                std::mutex mutex_;
             public:
                 LocalI(ConnectionLocator const &locator, std::variant<MulticastComponent::NoTopicSelection, std::string, std::regex> const &topic, std::optional<WireToUserHook> wireToUserHook)
-                    : locator_(locator), topic_(topic), wireToUserHook_(wireToUserHook), client_(std::nullopt), mutex_()
+                    : locator_(locator), topic_(topic), wireToUserHook_(wireToUserHook), client_(std::nullopt), mutex_(), pipeline_()
                 {
                 }
                 virtual void start(Env *env) override final {
                     std::lock_guard<std::mutex> _(mutex_);
+                    pipeline_.setup(env, "multicast", locator_, [this,env](basic::ByteDataWithTopic &&d) {
+                        deliver(env, std::move(d));
+                    });
                     if (!wireToUserHook_) {
-                        wireToUserHook_ = DefaultHookFactory<Env>::template incomingHook<T>(env);
+                        wireToUserHook_ = Decoding::defaultIncomingHook(env);
                     }
                     if (!client_) {
                         client_ = env->multicast_addSubscriptionClient(
-                        locator_
+                            locator_
                             , topic_
                             , [this,env](basic::ByteDataWithTopic &&d) {
                                 TM_INFRA_IMPORTER_TRACER(env);
-                                T t;
-                                auto tRes = basic::bytedata_utils::RunDeserializer<T>::applyInPlace(t, d.content);
-                                if (tRes) {
-                                    this->publish(M::template pureInnerData<basic::TypedDataWithTopic<T>>(env, {std::move(d.topic), std::move(t)}));
-                                }
+                                pipeline_.push(std::move(d));
                             }
-                            , wireToUserHook_
+                            , pipeline_.incomingHook(wireToUserHook_)
                         );
                     }
                 }
@@ -114,6 +84,18 @@ namespace dev { namespace cd606 { namespace tm { namespace transport { namespace
             };
             return M::importer(new LocalI(locator, topic, wireToUserHook));
         }
+    public:
+        static std::shared_ptr<typename M::template Importer<basic::ByteDataWithTopic>> createImporter(ConnectionLocator const &locator, std::variant<MulticastComponent::NoTopicSelection, std::string, std::regex> const &topic=MulticastComponent::NoTopicSelection(), std::optional<WireToUserHook> wireToUserHook=std::nullopt) {
+            return createImporterWithDecoding<RawReceiveDecoding>(locator, topic, wireToUserHook);
+        }
+        template <class T>
+        static std::shared_ptr<typename M::template Importer<basic::TypedDataWithTopic<T>>> createTypedImporter(ConnectionLocator const &locator, std::variant<MulticastComponent::NoTopicSelection, std::string, std::regex> const &topic=MulticastComponent::NoTopicSelection(), std::optional<WireToUserHook> wireToUserHook=std::nullopt) {
+            return createImporterWithDecoding<TypedReceiveDecoding<T>>(locator, topic, wireToUserHook);
+        }
+        template <class T>
+        static std::shared_ptr<typename M::template Importer<LazilyDecodedDataWithTopic<T>>> createLazilyDecodedImporter(ConnectionLocator const &locator, std::variant<MulticastComponent::NoTopicSelection, std::string, std::regex> const &topic=MulticastComponent::NoTopicSelection(), std::optional<WireToUserHook> wireToUserHook=std::nullopt) {
+            return createImporterWithDecoding<LazyReceiveDecoding<T>>(locator, topic, wireToUserHook);
+        }
         static std::shared_ptr<typename M::template Exporter<basic::ByteDataWithTopic>> createExporter(ConnectionLocator const &locator, std::optional<UserToWireHook> userToWireHook=std::nullopt, std::string const &heartbeatName = "") {
             class LocalE final : public M::template AbstractExporter<basic::ByteDataWithTopic> {
             private:
@@ -123,9 +105,10 @@ namespace dev { namespace cd606 { namespace tm { namespace transport { namespace
                 std::function<void(basic::ByteDataWithTopic &&, int)> publisher_;
                 std::optional<UserToWireHook> userToWireHook_;
                 std::string heartbeatName_;
+                std::shared_ptr<TransportChannelMetrics> metrics_;
             public:
                 LocalE(ConnectionLocator const &locator, std::optional<UserToWireHook> userToWireHook, std::string const &heartbeatName)
-                    : locator_(locator), env_(nullptr), publisher_(), userToWireHook_(userToWireHook), heartbeatName_(heartbeatName)
+                    : locator_(locator), env_(nullptr), publisher_(), userToWireHook_(userToWireHook), heartbeatName_(heartbeatName), metrics_()
                 {
                     try {
                         ttl_ = boost::lexical_cast<int>(locator.query("ttl", "0"));
@@ -135,7 +118,8 @@ namespace dev { namespace cd606 { namespace tm { namespace transport { namespace
                 }
                 virtual void start(Env *env) override final {
                     env_ = env;
-                    publisher_ = env->multicast_getPublisher(locator_, userToWireHook_);
+                    metrics_ = transportChannelMetrics(env, "multicast", locator_);
+                    publisher_ = env->multicast_getPublisher(locator_, latencyStampedOutgoingHook(locator_, userToWireHook_));
                     if constexpr (std::is_convertible_v<
                         Env *
                         , HeartbeatAndAlertComponent *
@@ -149,6 +133,7 @@ namespace dev { namespace cd606 { namespace tm { namespace transport { namespace
                 virtual void handle(typename M::template InnerData<basic::ByteDataWithTopic> &&data) override final {
                     if (env_) {
                         TM_INFRA_EXPORTER_TRACER(env_);
+                        TransportMetricsSendScope metricsScope(metrics_.get(), data.timedData.value.content.length());
                         publisher_(std::move(data.timedData.value), ttl_);
                     }
                 }
@@ -165,9 +150,10 @@ namespace dev { namespace cd606 { namespace tm { namespace transport { namespace
                 std::function<void(basic::ByteDataWithTopic &&, int)> publisher_;
                 std::optional<UserToWireHook> userToWireHook_;
                 std::string heartbeatName_;
+                std::shared_ptr<TransportChannelMetrics> metrics_;
             public:
                 LocalE(ConnectionLocator const &locator, std::optional<UserToWireHook> userToWireHook, std::string const &heartbeatName)
-                    : locator_(locator), env_(nullptr), publisher_(), userToWireHook_(userToWireHook), heartbeatName_(heartbeatName)
+                    : locator_(locator), env_(nullptr), publisher_(), userToWireHook_(userToWireHook), heartbeatName_(heartbeatName), metrics_()
                 {
                     try {
                         ttl_ = boost::lexical_cast<int>(locator.query("ttl", "0"));
@@ -177,10 +163,11 @@ namespace dev { namespace cd606 { namespace tm { namespace transport { namespace
                 }
                 virtual void start(Env *env) override final {
                     env_ = env;
+                    metrics_ = transportChannelMetrics(env, "multicast", locator_);
                     if (!userToWireHook_) {
                         userToWireHook_ = DefaultHookFactory<Env>::template outgoingHook<T>(env);
                     }
-                    publisher_ = env->multicast_getPublisher(locator_, userToWireHook_);
+                    publisher_ = env->multicast_getPublisher(locator_, latencyStampedOutgoingHook(locator_, userToWireHook_));
                     if constexpr (std::is_convertible_v<
                         Env *
                         , HeartbeatAndAlertComponent *
@@ -195,6 +182,7 @@ namespace dev { namespace cd606 { namespace tm { namespace transport { namespace
                     if (env_) {
                         TM_INFRA_EXPORTER_TRACER(env_);
                         std::string s = basic::bytedata_utils::RunSerializer<T>::apply(data.timedData.value.content);
+                        TransportMetricsSendScope metricsScope(metrics_.get(), s.length());
                         publisher_({std::move(data.timedData.value.topic), std::move(s)}, ttl_);
                     }
                 }
@@ -222,7 +210,7 @@ namespace dev { namespace cd606 { namespace tm { namespace transport { namespace
                         }).detach();
                     }
                 }
-                , hook
+                , latencyStampedIncomingHook(env, "multicast", locator, hook)
             );
             return ret->get_future();
         }
@@ -260,7 +248,7 @@ namespace dev { namespace cd606 { namespace tm { namespace transport { namespace
                         }
                     }
                 }
-                , DefaultHookFactory<Env>::template supplyIncomingHook<T>(env, hook)
+                , latencyStampedIncomingHook(env, "multicast", locator, DefaultHookFactory<Env>::template supplyIncomingHook<T>(env, hook))
             );
             return ret->get_future();
         }
@@ -8,199 +8,139 @@
 #include <libetcd/rpc.grpc.pb.h>
 #include <libetcd/kv.pb.h>
 
+#include <mutex>
+#include <thread>
+#include <stdexcept>
+
 #include <tm_kit/infra/RealTimeApp.hpp>
+#include <tm_kit/infra/LogLevel.hpp>
 #include <tm_kit/infra/AppClassifier.hpp>
+#include <tm_kit/transport/EtcdWatchMultiplexer.hpp>
 
 namespace dev { namespace cd606 { namespace tm { namespace transport { namespace named_value_store_components {
     namespace etcd {
+        //The importers share one watch stream per etcd endpoint (through
+        //EtcdWatchMultiplexer) instead of opening a channel and a stream
+        //each. The current values are read first, and the watch starts
+        //right after the revision of that read, so no update is missed.
         template <class M, typename=std::enable_if_t<infra::AppClassifier<M>::TheClassification == infra::AppClassification::RealTime>>
         class EtcdLocalImporter {
-        public:
-            static std::shared_ptr<typename M::template Importer<std::string>> singleKeyImporter(std::string const &key) {
-                return M::template simpleImporter<std::string>(
-                    [key](typename M::template PublisherCall<std::string> const &pub) {
-                        etcdserverpb::RangeRequest range;
-                        range.set_key(key);
-
-                        etcdserverpb::RangeResponse initResponse;
-                        grpc::Status initStatus;
-
-                        etcdserverpb::WatchRequest req;
-                        auto *r = req.mutable_create_request();
-                        r->set_key(key); 
-                
-                        etcdserverpb::WatchResponse watchResponse;
-
-                        grpc::CompletionQueue queue;
-                        void *tag;
-                        bool ok; 
-
-                        bool wasShutdown = false;
-
-                        auto channel = grpc::CreateChannel("127.0.0.1:2379", grpc::InsecureChannelCredentials());
-                        auto initStub = etcdserverpb::KV::NewStub(channel);
-                        grpc::ClientContext initCtx;
-                        //All the requests in this app will die out after 24 hours
-                        //, this is to avoid too many dead requests in server.
-                        //(Please notice that if the deadline is set too early, then
-                        //the watch stream will also be cut off at that time point)
-                        initCtx.set_deadline(std::chrono::system_clock::now()+std::chrono::hours(24));
-                        std::shared_ptr<
-                                grpc::ClientAsyncResponseReader<etcdserverpb::RangeResponse>
-                            > initData { initStub->AsyncRange(&initCtx, range, &queue) };
-                        initData->Finish(&initResponse, &initStatus, (void *)1);
-
-                        auto watchStub = etcdserverpb::Watch::NewStub(channel);
-                        grpc::ClientContext watchCtx;
-                        watchCtx.set_deadline(std::chrono::system_clock::now()+std::chrono::hours(24));
-                
-                        std::shared_ptr<
-                            grpc::ClientAsyncReaderWriter<etcdserverpb::WatchRequest, etcdserverpb::WatchResponse>
-                        > watchStream { watchStub->AsyncWatch(&watchCtx, &queue, (void *)2) };
-
-                        while (true) {
-                            auto status = queue.AsyncNext(&tag, &ok, std::chrono::system_clock::now()+std::chrono::milliseconds(1));
-                            if (status == grpc::CompletionQueue::SHUTDOWN) {
-                                wasShutdown = true;
-                                break;
-                            }
-                            if (status == grpc::CompletionQueue::TIMEOUT) {
-                                continue;
-                            }
-                            if (!ok) {
-                                break;
+        private:
+            using Env = typename M::EnvironmentType;
+            template <class T>
+            class LocalI final : public M::template AbstractImporter<T> {
+            private:
+                std::shared_ptr<EtcdWatchMultiplexer> multiplexer_;
+                std::string key_;
+                std::string rangeEnd_;
+                std::function<T(mvccpb::KeyValue const &)> converter_;
+                std::optional<uint64_t> watchHandle_;
+                std::mutex watchMutex_;
+                bool stopped_;
+
+                //publishes the current values and returns the revision
+                //to watch from, or nullopt if the read fails
+                std::optional<int64_t> readCurrent(Env *env) {
+                    etcdserverpb::RangeRequest range;
+                    range.set_key(key_);
+                    if (rangeEnd_ != "") {
+                        range.set_range_end(rangeEnd_);
+                    }
+                    etcdserverpb::RangeResponse initResponse;
+                    auto initStub = etcdserverpb::KV::NewStub(multiplexer_->channel());
+                    grpc::ClientContext initCtx;
+                    initCtx.set_deadline(std::chrono::system_clock::now()+std::chrono::seconds(10));
+                    auto status = initStub->Range(&initCtx, range, &initResponse);
+                    if (!status.ok()) {
+                        env->log(infra::LogLevel::Warning, "[EtcdLocalImporter] cannot read '"+key_+"': "+status.error_message());
+                        return std::nullopt;
+                    }
+                    for (auto const &kv : initResponse.kvs()) {
+                        this->publish(M::template pureInnerData<T>(env, converter_(kv)));
+                    }
+                    return initResponse.header().revision()+1;
+                }
+                void watchNoLock(Env *env, int64_t startRevision) {
+                    watchHandle_ = multiplexer_->addWatch(
+                        key_, rangeEnd_
+                        , [this,env](etcdserverpb::WatchResponse const &resp) {
+                            if (resp.canceled()) {
+                                restartWatch(env, resp);
+                                return;
                             }
-                            auto tagNum = reinterpret_cast<intptr_t>(tag);
-                            switch (tagNum) {
-                            case 1:
-                                {
-                                    if (initResponse.kvs_size() > 0) {
-                                        for (auto const &kv : initResponse.kvs()) {
-                                            pub(std::string {kv.value()});
-                                        }
-                                    }
-                                }
-                                break;
-                            case 2:
-                                watchStream->Write(req, (void *)3);
-                                watchStream->Read(&watchResponse, (void *)4);
-                                break;
-                            case 3:
-                                watchStream->WritesDone((void *)5);
-                                break;
-                            case 4:
-                                if (watchResponse.events_size() > 0) {
-                                    for (auto const &ev : watchResponse.events()) {
-                                        pub(std::string {ev.kv().value()});
-                                    }
-                                }
-                                watchStream->Read(&watchResponse, (void *)4);  
-                                break;
-                            default:
-                                break;
+                            for (auto const &ev : resp.events()) {
+                                this->publish(M::template pureInnerData<T>(env, converter_(ev.kv())));
                             }
                         }
-                        if (!wasShutdown) {
-                            grpc::Status status;
-                            watchStream->Finish(&status, (void *)6);
+                        , startRevision
+                    );
+                }
+                //the multiplexer has dropped the watch (for example because
+                //the revision it was to resume from has been compacted), so
+                //the current values are published again and the watch
+                //resumes after them
+                void restartWatch(Env *env, etcdserverpb::WatchResponse const &resp) {
+                    env->log(infra::LogLevel::Warning, "[EtcdLocalImporter] watch on '"+key_+"' canceled (compact revision "+std::to_string(resp.compact_revision())+", reason '"+resp.cancel_reason()+"'), re-reading and watching again");
+                    auto startRevision = readCurrent(env);
+                    if (!startRevision) {
+                        env->log(infra::LogLevel::Error, "[EtcdLocalImporter] watching '"+key_+"' from now on, updates since the cancellation may be lost");
+                    }
+                    std::lock_guard<std::mutex> _(watchMutex_);
+                    if (!stopped_) {
+                        watchNoLock(env, startRevision.value_or(0));
+                    }
+                }
+            public:
+                LocalI(std::shared_ptr<EtcdWatchMultiplexer> const &multiplexer, std::string const &key, std::string const &rangeEnd, std::function<T(mvccpb::KeyValue const &)> const &converter)
+                    : multiplexer_(multiplexer), key_(key), rangeEnd_(rangeEnd), converter_(converter), watchHandle_(std::nullopt), watchMutex_(), stopped_(false)
+                {}
+                virtual ~LocalI() {
+                    std::optional<uint64_t> watchHandle;
+                    {
+                        std::lock_guard<std::mutex> _(watchMutex_);
+                        stopped_ = true;
+                        watchHandle = watchHandle_;
+                    }
+                    if (watchHandle) {
+                        multiplexer_->removeWatch(*watchHandle);
+                    }
+                }
+                //without the initial values the importer would silently
+                //start from an empty state, so the read is retried a few
+                //times and then the start fails
+                virtual void start(Env *env) override final {
+                    std::optional<int64_t> startRevision;
+                    for (int ii=0; ii<3 && !startRevision; ++ii) {
+                        if (ii > 0) {
+                            std::this_thread::sleep_for(std::chrono::seconds(1));
                         }
+                        startRevision = readCurrent(env);
+                    }
+                    if (!startRevision) {
+                        throw std::runtime_error("[EtcdLocalImporter] cannot read the initial values of '"+key_+"'");
                     }
-                    , infra::LiftParameters<typename M::TimePoint>().SuggestThreaded(true)
-                );
+                    std::lock_guard<std::mutex> _(watchMutex_);
+                    watchNoLock(env, *startRevision);
+                }
+            };
+        public:
+            static std::shared_ptr<typename M::template Importer<std::string>> singleKeyImporter(std::string const &key, std::shared_ptr<EtcdWatchMultiplexer> const &multiplexer = nullptr) {
+                return M::importer(new LocalI<std::string>(
+                    multiplexer?multiplexer:EtcdWatchMultiplexer::forEndpoint()
+                    , key, ""
+                    , [](mvccpb::KeyValue const &kv) {
+                        return std::string {kv.value()};
+                    }
+                ));
             }
-            static std::shared_ptr<typename M::template Importer<std::tuple<std::string, std::string>>> keyRangeImporter(std::string const &rangeStart, std::string const &rangeEnd) {
-                return M::template simpleImporter<std::tuple<std::string, std::string>>(
-                    [rangeStart, rangeEnd](typename M::template PublisherCall<std::tuple<std::string, std::string>> const &pub) {
-                        etcdserverpb::RangeRequest range;
-                        range.set_key(rangeStart);
-                        range.set_range_end(rangeEnd);
-
-                        etcdserverpb::RangeResponse initResponse;
-                        grpc::Status initStatus;
-
-                        etcdserverpb::WatchRequest req;
-                        auto *r = req.mutable_create_request();
-                        r->set_key(rangeStart); 
-                        r->set_range_end(rangeEnd);
-                
-                        etcdserverpb::WatchResponse watchResponse;
-
-                        grpc::CompletionQueue queue;
-                        void *tag;
-                        bool ok; 
-
-                        bool wasShutdown = false;
-
-                        auto channel = grpc::CreateChannel("127.0.0.1:2379", grpc::InsecureChannelCredentials());
-                        auto initStub = etcdserverpb::KV::NewStub(channel);
-                        grpc::ClientContext initCtx;
-                        //All the requests in this app will die out after 24 hours
-                        //, this is to avoid too many dead requests in server.
-                        //(Please notice that if the deadline is set too early, then
-                        //the watch stream will also be cut off at that time point)
-                        initCtx.set_deadline(std::chrono::system_clock::now()+std::chrono::hours(24));
-                        std::shared_ptr<
-                                grpc::ClientAsyncResponseReader<etcdserverpb::RangeResponse>
-                            > initData { initStub->AsyncRange(&initCtx, range, &queue) };
-                        initData->Finish(&initResponse, &initStatus, (void *)1);
-
-                        auto watchStub = etcdserverpb::Watch::NewStub(channel);
-                        grpc::ClientContext watchCtx;
-                        watchCtx.set_deadline(std::chrono::system_clock::now()+std::chrono::hours(24));
-                
-                        std::shared_ptr<
-                            grpc::ClientAsyncReaderWriter<etcdserverpb::WatchRequest, etcdserverpb::WatchResponse>
-                        > watchStream { watchStub->AsyncWatch(&watchCtx, &queue, (void *)2) };
-
-                        while (true) {
-                            auto status = queue.AsyncNext(&tag, &ok, std::chrono::system_clock::now()+std::chrono::milliseconds(1));
-                            if (status == grpc::CompletionQueue::SHUTDOWN) {
-                                wasShutdown = true;
-                                break;
-                            }
-                            if (status == grpc::CompletionQueue::TIMEOUT) {
-                                continue;
-                            }
-                            if (!ok) {
-                                break;
-                            }
-                            auto tagNum = reinterpret_cast<intptr_t>(tag);
-                            switch (tagNum) {
-                            case 1:
-                                {
-                                    if (initResponse.kvs_size() > 0) {
-                                        for (auto const &kv : initResponse.kvs()) {
-                                            pub({kv.key(), kv.value()});
-                                        }
-                                    }
-                                }
-                                break;
-                            case 2:
-                                watchStream->Write(req, (void *)3);
-                                watchStream->Read(&watchResponse, (void *)4);
-                                break;
-                            case 3:
-                                watchStream->WritesDone((void *)5);
-                                break;
-                            case 4:
-                                if (watchResponse.events_size() > 0) {
-                                    for (auto const &ev : watchResponse.events()) {
-                                        pub({ev.kv().key(), ev.kv().value()});
-                                    }
-                                }
-                                watchStream->Read(&watchResponse, (void *)4);  
-                                break;
-                            default:
-                                break;
-                            }
-                        }
-                        if (!wasShutdown) {
-                            grpc::Status status;
-                            watchStream->Finish(&status, (void *)6);
-                        }
+            static std::shared_ptr<typename M::template Importer<std::tuple<std::string, std::string>>> keyRangeImporter(std::string const &rangeStart, std::string const &rangeEnd, std::shared_ptr<EtcdWatchMultiplexer> const &multiplexer = nullptr) {
+                return M::importer(new LocalI<std::tuple<std::string, std::string>>(
+                    multiplexer?multiplexer:EtcdWatchMultiplexer::forEndpoint()
+                    , rangeStart, rangeEnd
+                    , [](mvccpb::KeyValue const &kv) {
+                        return std::tuple<std::string, std::string> {kv.key(), kv.value()};
                     }
-                    , infra::LiftParameters<typename M::TimePoint>().SuggestThreaded(true)
-                );
+                ));
             }
         };
     }
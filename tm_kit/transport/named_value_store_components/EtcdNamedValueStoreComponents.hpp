@@ -2,6 +2,7 @@
 #define TM_KIT_TRANSPORT_ETCD_NAMED_VALUE_STORE_COMPONENTS_HPP_
 
 #include <tm_kit/basic/transaction/named_value_store/DataModel.hpp>
+#include <tm_kit/transport/EtcdWatchMultiplexer.hpp>
 
 #include <grpcpp/grpcpp.h>
 #ifdef _MSC_VER
@@ -14,6 +15,7 @@
 #include <condition_variable>
 #include <atomic>
 #include <thread>
+#include <optional>
 
 #include <boost/algorithm/string.hpp>
 
@@ -32,7 +34,9 @@ namespace dev { namespace cd606 { namespace tm { namespace transport { namespace
 
             std::shared_ptr<grpc::ChannelInterface> channel_;
             std::function<void(std::string)> logger_;
-            std::thread watchThread_;
+            std::shared_ptr<EtcdWatchMultiplexer> watchMultiplexer_;
+            std::optional<uint64_t> watchHandle_;
+            std::mutex watchMutex_;
             std::atomic<bool> running_;
 
             Callback *watchListener_;
@@ -88,120 +92,124 @@ namespace dev { namespace cd606 { namespace tm { namespace transport { namespace
                     return std::nullopt;
                 }
             }
-            void runWatchThread() {
+            void startWatch() {
                 etcdserverpb::RangeRequest range;
                 range.set_key(storagePrefix_+":");
                 range.set_range_end(storagePrefix_+";");
 
                 etcdserverpb::RangeResponse initResponse;
-                grpc::Status initStatus;
-
-                etcdserverpb::WatchRequest req;
-                auto *r = req.mutable_create_request();
-                r->set_key(storagePrefix_+":");
-                r->set_range_end(storagePrefix_+";"); 
-        
-                etcdserverpb::WatchResponse watchResponse;
-
-                grpc::CompletionQueue queue;
-                void *tag;
-                bool ok; 
-
-                bool wasShutdown = false;
 
                 auto initStub = etcdserverpb::KV::NewStub(channel_);
                 grpc::ClientContext initCtx;
-                //All the requests in this app will die out after 24 hours
-                //, this is to avoid too many dead requests in server.
-                //(Please notice that if the deadline is set too early, then
-                //the watch stream will also be cut off at that time point)
                 initCtx.set_deadline(std::chrono::system_clock::now()+std::chrono::hours(24));
-                std::shared_ptr<
-                        grpc::ClientAsyncResponseReader<etcdserverpb::RangeResponse>
-                    > initData { initStub->AsyncRange(&initCtx, range, &queue) };
-                initData->Finish(&initResponse, &initStatus, (void *)1);
-
-                auto watchStub = etcdserverpb::Watch::NewStub(channel_);
-                grpc::ClientContext watchCtx;
-                watchCtx.set_deadline(std::chrono::system_clock::now()+std::chrono::hours(24));
-        
-                std::shared_ptr<
-                    grpc::ClientAsyncReaderWriter<etcdserverpb::WatchRequest, etcdserverpb::WatchResponse>
-                > watchStream { watchStub->AsyncWatch(&watchCtx, &queue, (void *)2) };
-
-                while (running_) {
-                    auto status = queue.AsyncNext(&tag, &ok, std::chrono::system_clock::now()+std::chrono::milliseconds(1));
-                    if (!running_) {
-                        break;
-                    }
-                    if (status == grpc::CompletionQueue::SHUTDOWN) {
-                        wasShutdown = true;
-                        break;
-                    }
-                    if (status == grpc::CompletionQueue::TIMEOUT) {
-                        continue;
-                    }
-                    if (!ok) {
-                        break;
+                int64_t startRevision = 0;
+                if (initStub->Range(&initCtx, range, &initResponse).ok()) {
+                    int64_t revision = initResponse.header().revision();
+                    if (initResponse.kvs_size() > 0) {
+                        std::vector<typename DI::OneUpdateItem> updates;
+                        for (auto const &kv : initResponse.kvs()) {
+                            auto delta = createDeltaUpdate(mvccpb::Event::PUT, kv, revision);
+                            if (delta) {
+                                updates.push_back({std::move(*delta)});
+                            }
+                        }
+                        watchListener_->onUpdate(typename DI::Update {
+                            revision
+                            , std::move(updates)
+                        });
                     }
-                    auto tagNum = reinterpret_cast<intptr_t>(tag);
-                    switch (tagNum) {
-                    case 1:
-                        {
-                            if (initResponse.kvs_size() > 0) {
-                                std::vector<typename DI::OneUpdateItem> updates;
-                                int64_t revision = watchResponse.header().revision();
-                                for (auto const &kv : initResponse.kvs()) {
-                                    auto delta = createDeltaUpdate(mvccpb::Event::PUT, kv, revision);
-                                    if (delta) {
-                                        updates.push_back({std::move(*delta)});
-                                    }
-                                }
-                                watchListener_->onUpdate(typename DI::Update {
-                                    revision
-                                    , std::move(updates)
-                                });
+                    startRevision = revision+1;
+                } else {
+                    logger_("DS component cannot read the initial values of "+storagePrefix_+", watching from now on");
+                }
+
+                //the watch shares the stream of the etcd channel with every
+                //other watch on it
+                watchMultiplexer_ = EtcdWatchMultiplexer::forChannel(channel_);
+                std::lock_guard<std::mutex> _(watchMutex_);
+                watchNoLock(startRevision);
+            }
+            void watchNoLock(int64_t startRevision) {
+                watchHandle_ = watchMultiplexer_->addWatch(
+                    storagePrefix_+":", storagePrefix_+";"
+                    , [this](etcdserverpb::WatchResponse const &watchResponse) {
+                        if (!running_) {
+                            return;
+                        }
+                        if (watchResponse.canceled()) {
+                            restartWatch(watchResponse);
+                            return;
+                        }
+                        if (watchResponse.events_size() == 0) {
+                            return;
+                        }
+                        std::vector<typename DI::OneUpdateItem> updates;
+                        int64_t revision = watchResponse.header().revision();
+                        for (auto const &ev : watchResponse.events()) {
+                            auto delta = createDeltaUpdate(ev.type(), ev.kv(), revision);
+                            if (delta) {
+                                updates.push_back({std::move(*delta)});
                             }
                         }
-                        break;
-                    case 2:
-                        watchStream->Write(req, (void *)3);
-                        watchStream->Read(&watchResponse, (void *)4);
-                        break;
-                    case 3:
-                        watchStream->WritesDone((void *)5);
-                        break;
-                    case 4:
-                        { 
-                            if (watchResponse.events_size() > 0) {
-                                std::vector<typename DI::OneUpdateItem> updates;
-                                int64_t revision = watchResponse.header().revision();
-                                for (auto const &ev : watchResponse.events()) {
-                                    auto delta = createDeltaUpdate(ev.type(), ev.kv(), revision);
-                                    if (delta) {
-                                        updates.push_back({std::move(*delta)});
-                                    }
-                                }
-                                watchListener_->onUpdate(typename DI::Update {
-                                    revision
-                                    , std::move(updates)
-                                });
+                        watchListener_->onUpdate(typename DI::Update {
+                            revision
+                            , std::move(updates)
+                        });
+                    }
+                    , startRevision
+                );
+            }
+            //the multiplexer has dropped the watch (for example because the
+            //revision it was to resume from has been compacted), so the
+            //whole collection is read again and replaces what the listener
+            //has, and the watch resumes after that read
+            void restartWatch(etcdserverpb::WatchResponse const &watchResponse) {
+                logger_("DS component watch on "+storagePrefix_+" canceled (compact revision "+std::to_string(watchResponse.compact_revision())+", reason '"+watchResponse.cancel_reason()+"'), re-reading and watching again");
+
+                etcdserverpb::RangeRequest range;
+                range.set_key(storagePrefix_+":");
+                range.set_range_end(storagePrefix_+";");
+
+                etcdserverpb::RangeResponse rangeResponse;
+
+                auto stub = etcdserverpb::KV::NewStub(channel_);
+                grpc::ClientContext ctx;
+                ctx.set_deadline(std::chrono::system_clock::now()+std::chrono::seconds(10));
+                int64_t startRevision = 0;
+                if (stub->Range(&ctx, range, &rangeResponse).ok()) {
+                    int64_t revision = rangeResponse.header().revision();
+                    basic::transaction::named_value_store::Collection<Data> collection;
+                    for (auto const &kv : rangeResponse.kvs()) {
+                        auto delta = createDeltaUpdate(mvccpb::Event::PUT, kv, revision);
+                        if (delta) {
+                            for (auto &item : std::get<2>(*delta).inserts_updates) {
+                                collection[std::get<0>(item)] = std::move(std::get<1>(item));
                             }
                         }
-                        watchStream->Read(&watchResponse, (void *)4);  
-                        break;
-                    default:
-                        break;
                     }
+                    watchListener_->onUpdate(typename DI::Update {
+                        revision
+                        , std::vector<typename DI::OneUpdateItem> {
+                            {typename DI::OneFullUpdateItem {
+                                basic::VoidStruct {}
+                                , revision
+                                , std::move(collection)
+                            }}
+                        }
+                    });
+                    startRevision = revision+1;
+                } else {
+                    logger_("DS component cannot re-read "+storagePrefix_+", watching from now on, updates since the cancellation may be lost");
                 }
-                if (!wasShutdown) {
-                    grpc::Status status;
-                    watchStream->Finish(&status, (void *)6);
+
+                std::lock_guard<std::mutex> _(watchMutex_);
+                if (running_) {
+                    watchNoLock(startRevision);
                 }
             }
         public:
             DSComponent()
-                : channel_(), logger_(), watchThread_(), running_(false)
+                : channel_(), logger_(), watchMultiplexer_(), watchHandle_(), watchMutex_(), running_(false)
                 , watchListener_(nullptr)
                 , storagePrefix_(), lockNumberKey_(), lockQueueKey_()
                 , lockQueueVersion_(nullptr), lockQueueRevision_(nullptr)
@@ -221,7 +229,7 @@ namespace dev { namespace cd606 { namespace tm { namespace transport { namespace
             } 
             DSComponent(std::shared_ptr<grpc::ChannelInterface> const &channel, std::function<void(std::string)> const &logger, std::string const &storagePrefix, std::string const &lockNumberKey = "", std::string const &lockQueueKey = "", std::atomic<int64_t> *lockQueueVersion = nullptr, std::atomic<int64_t> *lockQueueRevision = nullptr) 
                 : channel_(channel), logger_(logger)
-                , watchThread_(), running_(false)
+                , watchMultiplexer_(), watchHandle_(), watchMutex_(), running_(false)
                 , watchListener_(nullptr)
                 , storagePrefix_(storagePrefix)
                 , lockNumberKey_(lockNumberKey)
@@ -230,11 +238,14 @@ namespace dev { namespace cd606 { namespace tm { namespace transport { namespace
                 , lockQueueRevision_(lockQueueRevision)
             {}
             virtual ~DSComponent() {
-                if (running_) {
+                std::optional<uint64_t> watchHandle;
+                {
+                    std::lock_guard<std::mutex> _(watchMutex_);
                     running_ = false;
-                    try {
-                        watchThread_.join();
-                    } catch (...) {}
+                    watchHandle = watchHandle_;
+                }
+                if (watchMultiplexer_ && watchHandle) {
+                    watchMultiplexer_->removeWatch(*watchHandle);
                 }
             }
             void initialize(Callback *cb) {
@@ -254,8 +265,7 @@ namespace dev { namespace cd606 { namespace tm { namespace transport { namespace
                 });
 
                 running_ = true;
-                watchThread_ = std::thread(&DSComponent::runWatchThread, this);
-                watchThread_.detach();
+                startWatch();
 
                 logger_("DS component started");
             }
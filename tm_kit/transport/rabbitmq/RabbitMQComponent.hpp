@@ -7,6 +7,7 @@
 #include <exception>
 #include <unordered_map>
 #include <thread>
+#include <vector>
 
 #include <tm_kit/infra/WithTimeData.hpp>
 #include <tm_kit/basic/ByteData.hpp>
@@ -46,6 +47,13 @@ namespace dev { namespace cd606 { namespace tm { namespace transport { namespace
                         std::string const &topic,
                         std::function<void(basic::ByteDataWithTopic &&)> client,
                         std::optional<WireToUserHook> wireToUserHook = std::nullopt);
+        //the batch client gets all messages taken at one wakeup together,
+        //the batch size is controlled by the "consume_batch" property of
+        //the locator, and "prefetch" sets the consumer prefetch count
+        uint32_t rabbitmq_addExchangeBatchSubscriptionClient(ConnectionLocator const &locator,
+                        std::string const &topic,
+                        std::function<void(std::vector<basic::ByteDataWithTopic> &&)> client,
+                        std::optional<WireToUserHook> wireToUserHook = std::nullopt);
         void rabbitmq_removeExchangeSubscriptionClient(uint32_t);
         std::function<void(basic::ByteDataWithTopic &&)> rabbitmq_getExchangePublisher(ConnectionLocator const &locator, std::optional<UserToWireHook> userToWireHook = std::nullopt);
         //for RPC queues, the identifier in locator is the queue name
@@ -8,6 +8,11 @@
 #include <tm_kit/basic/ByteData.hpp>
 #include <tm_kit/transport/rabbitmq/RabbitMQComponent.hpp>
 #include <tm_kit/transport/HeartbeatAndAlertComponent.hpp>
+#include <tm_kit/transport/TransportMetricsComponent.hpp>
+#include <tm_kit/transport/LatencyStamping.hpp>
+#include <tm_kit/transport/ReceivePipeline.hpp>
+#include <tm_kit/transport/LazilyDecodedData.hpp>
+#include <tm_kit/transport/ReceiveDecoding.hpp>
 #include <tm_kit/transport/AbstractHookFactoryComponent.hpp>
 
 namespace dev { namespace cd606 { namespace tm { namespace transport { namespace rabbitmq {
@@ -16,68 +21,37 @@ namespace dev { namespace cd606 { namespace tm { namespace transport { namespace
     class RabbitMQImporterExporter {
     public:
         using M = infra::RealTimeApp<Env>;
-        static std::shared_ptr<typename M::template Importer<basic::ByteDataWithTopic>> createImporter(ConnectionLocator const &exchangeLocator, std::string const &topic="", std::optional<WireToUserHook> wireToUserHook=std::nullopt) {
-            class LocalI final : public M::template AbstractImporter<basic::ByteDataWithTopic>, public virtual infra::IControllableNode<Env> {
+    private:
+        template <class Decoding>
+        static std::shared_ptr<typename M::template Importer<typename Decoding::Output>> createImporterWithDecoding(ConnectionLocator const &exchangeLocator, std::string const &topic, std::optional<WireToUserHook> wireToUserHook) {
+            using Output = typename Decoding::Output;
+            class LocalI final : public M::template AbstractImporter<Output>, public virtual infra::IControllableNode<Env> {
             private:
                 ConnectionLocator exchangeLocator_;
                 std::string topic_;
                 std::optional<WireToUserHook> wireToUserHook_;
                 std::optional<uint32_t> client_;
                 std::mutex mutex_;
-            public:
-                LocalI(ConnectionLocator const &exchangeLocator, std::string const &topic, std::optional<WireToUserHook> wireToUserHook)
-                    : exchangeLocator_(exchangeLocator), topic_(topic), wireToUserHook_(wireToUserHook), client_(std::nullopt), mutex_()
-                {
-                }
-                virtual void start(Env *env) override final {
-                    std::lock_guard<std::mutex> _(mutex_);
-                    if (!client_) {
-                        client_ = env->rabbitmq_addExchangeSubscriptionClient(
-                            exchangeLocator_
-                            , topic_
-                            , [this,env](basic::ByteDataWithTopic &&d) {
-                                TM_INFRA_IMPORTER_TRACER(env);
-                                this->publish(M::template pureInnerData<basic::ByteDataWithTopic>(env, std::move(d)));
-                            }
-                            , wireToUserHook_
-                        );
+                ReceivePipeline pipeline_;
+
+                void deliver(Env *env, basic::ByteDataWithTopic &&d) {
+                    auto o = Decoding::decode(std::move(d), pipeline_.metrics());
+                    if (o) {
+                        this->publish(M::template pureInnerData<Output>(env, std::move(*o)));
                     }
                 }
-                virtual void control(Env *env, std::string const &command, std::vector<std::string> const &params) override final {
-                    std::thread th([this,env,command]() {
-                        if (command == "stop") {
-                            std::lock_guard<std::mutex> _(mutex_);
-                            if (client_) {
-                                env->rabbitmq_removeExchangeSubscriptionClient(*client_);
-                                client_ = std::nullopt;
-                            }
-                        } else if (command == "restart") {
-                            start(env);
-                        }
-                    });
-                    th.detach();
-                }
-            };
-            return M::importer(new LocalI(exchangeLocator, topic, wireToUserHook));
-        }
-        template <class T>
-        static std::shared_ptr<typename M::template Importer<basic::TypedDataWithTopic<T>>> createTypedImporter(ConnectionLocator const &exchangeLocator, std::string const &topic="", std::optional<WireToUserHook> wireToUserHook=std::nullopt) {
-            class LocalI final : public M::template AbstractImporter<basic::TypedDataWithTopic<T>>, public virtual infra::IControllableNode<Env> {
-            private:
-                ConnectionLocator exchangeLocator_;
-                std::string topic_;
-                std::optional<WireToUserHook> wireToUserHook_;
-                std::optional<uint32_t> client_;
-                std::mutex mutex_;
             public:
                 LocalI(ConnectionLocator const &exchangeLocator, std::string const &topic, std::optional<WireToUserHook> wireToUserHook)
-                    : exchangeLocator_(exchangeLocator), topic_(topic), wireToUserHook_(wireToUserHook), client_(std::nullopt), mutex_()
+                    : exchangeLocator_(exchangeLocator), topic_(topic), wireToUserHook_(wireToUserHook), client_(std::nullopt), mutex_(), pipeline_()
                 {
                 }
                 virtual void start(Env *env) override final {
                     std::lock_guard<std::mutex> _(mutex_);
+                    pipeline_.setup(env, "rabbitmq", exchangeLocator_, [this,env](basic::ByteDataWithTopic &&d) {
+                        deliver(env, std::move(d));
+                    });
                     if (!wireToUserHook_) {
-                        wireToUserHook_ = DefaultHookFactory<Env>::template incomingHook<T>(env);
+                        wireToUserHook_ = Decoding::defaultIncomingHook(env);
                     }
                     if (!client_) {
                         client_ = env->rabbitmq_addExchangeSubscriptionClient(
@@ -85,13 +59,9 @@ namespace dev { namespace cd606 { namespace tm { namespace transport { namespace
                             , topic_
                             , [this,env](basic::ByteDataWithTopic &&d) {
                                 TM_INFRA_IMPORTER_TRACER(env);
-                                T t;
-                                auto tRes = basic::bytedata_utils::RunDeserializer<T>::applyInPlace(t, d.content);
-                                if (tRes) {
-                                    this->publish(M::template pureInnerData<basic::TypedDataWithTopic<T>>(env, {std::move(d.topic), std::move(t)}));
-                                }
+                                pipeline_.push(std::move(d));
                             }
-                            , wireToUserHook_
+                            , pipeline_.incomingHook(wireToUserHook_)
                         );
                     }
                 }
@@ -112,6 +82,18 @@ namespace dev { namespace cd606 { namespace tm { namespace transport { namespace
             };
             return M::importer(new LocalI(exchangeLocator, topic, wireToUserHook));
         }
+    public:
+        static std::shared_ptr<typename M::template Importer<basic::ByteDataWithTopic>> createImporter(ConnectionLocator const &exchangeLocator, std::string const &topic="", std::optional<WireToUserHook> wireToUserHook=std::nullopt) {
+            return createImporterWithDecoding<RawReceiveDecoding>(exchangeLocator, topic, wireToUserHook);
+        }
+        template <class T>
+        static std::shared_ptr<typename M::template Importer<basic::TypedDataWithTopic<T>>> createTypedImporter(ConnectionLocator const &exchangeLocator, std::string const &topic="", std::optional<WireToUserHook> wireToUserHook=std::nullopt) {
+            return createImporterWithDecoding<TypedReceiveDecoding<T>>(exchangeLocator, topic, wireToUserHook);
+        }
+        template <class T>
+        static std::shared_ptr<typename M::template Importer<LazilyDecodedDataWithTopic<T>>> createLazilyDecodedImporter(ConnectionLocator const &exchangeLocator, std::string const &topic="", std::optional<WireToUserHook> wireToUserHook=std::nullopt) {
+            return createImporterWithDecoding<LazyReceiveDecoding<T>>(exchangeLocator, topic, wireToUserHook);
+        }
         static std::shared_ptr<typename M::template Exporter<basic::ByteDataWithTopic>> createExporter(ConnectionLocator const &exchangeLocator, std::optional<UserToWireHook> userToWireHook=std::nullopt, std::string const &heartbeatName="") {
             class LocalE final : public M::template AbstractExporter<basic::ByteDataWithTopic> {
             private:
@@ -120,14 +102,16 @@ namespace dev { namespace cd606 { namespace tm { namespace transport { namespace
                 std::function<void(basic::ByteDataWithTopic &&)> publisher_;
                 std::optional<UserToWireHook> userToWireHook_;
                 std::string heartbeatName_;
+                std::shared_ptr<TransportChannelMetrics> metrics_;
             public:
                 LocalE(ConnectionLocator const &exchangeLocator, std::optional<UserToWireHook> userToWireHook, std::string const &heartbeatName)
-                    : exchangeLocator_(exchangeLocator), env_(nullptr), publisher_(), userToWireHook_(userToWireHook), heartbeatName_(heartbeatName)
+                    : exchangeLocator_(exchangeLocator), env_(nullptr), publisher_(), userToWireHook_(userToWireHook), heartbeatName_(heartbeatName), metrics_()
                 {
                 }
                 virtual void start(Env *env) override final {
                     env_ = env;
-                    publisher_ = env_->rabbitmq_getExchangePublisher(exchangeLocator_, userToWireHook_);
+                    metrics_ = transportChannelMetrics(env, "rabbitmq", exchangeLocator_);
+                    publisher_ = env_->rabbitmq_getExchangePublisher(exchangeLocator_, latencyStampedOutgoingHook(exchangeLocator_, userToWireHook_));
                     if constexpr (std::is_convertible_v<
                         Env *
                         , HeartbeatAndAlertComponent *
@@ -141,6 +125,7 @@ namespace dev { namespace cd606 { namespace tm { namespace transport { namespace
                 virtual void handle(typename M::template InnerData<basic::ByteDataWithTopic> &&data) override final {
                     if (env_) {
                         TM_INFRA_EXPORTER_TRACER(env_);
+                        TransportMetricsSendScope metricsScope(metrics_.get(), data.timedData.value.content.length());
                         publisher_(std::move(data.timedData.value));
                     }
                 }
@@ -156,17 +141,19 @@ namespace dev { namespace cd606 { namespace tm { namespace transport { namespace
                 std::function<void(basic::ByteDataWithTopic &&)> publisher_;
                 std::optional<UserToWireHook> userToWireHook_;
                 std::string heartbeatName_;
+                std::shared_ptr<TransportChannelMetrics> metrics_;
             public:
                 LocalE(ConnectionLocator const &exchangeLocator, std::optional<UserToWireHook> userToWireHook, std::string const &heartbeatName)
-                    : exchangeLocator_(exchangeLocator), env_(nullptr), publisher_(), userToWireHook_(userToWireHook)
+                    : exchangeLocator_(exchangeLocator), env_(nullptr), publisher_(), userToWireHook_(userToWireHook), metrics_()
                 {
                 }
                 virtual void start(Env *env) override final {
                     env_ = env;
+                    metrics_ = transportChannelMetrics(env, "rabbitmq", exchangeLocator_);
                     if (!userToWireHook_) {
                         userToWireHook_ = DefaultHookFactory<Env>::template outgoingHook<T>(env);
                     }
-                    publisher_ = env_->rabbitmq_getExchangePublisher(exchangeLocator_, userToWireHook_);
+                    publisher_ = env_->rabbitmq_getExchangePublisher(exchangeLocator_, latencyStampedOutgoingHook(exchangeLocator_, userToWireHook_));
                     if constexpr (std::is_convertible_v<
                         Env *
                         , HeartbeatAndAlertComponent *
@@ -181,6 +168,7 @@ namespace dev { namespace cd606 { namespace tm { namespace transport { namespace
                     if (env_) {
                         TM_INFRA_EXPORTER_TRACER(env_);
                         std::string s = basic::bytedata_utils::RunSerializer<T>::apply(data.timedData.value.content);
+                        TransportMetricsSendScope metricsScope(metrics_.get(), s.length());
                         publisher_({std::move(data.timedData.value.topic), std::move(s)});
                     }
                 }
@@ -209,7 +197,7 @@ namespace dev { namespace cd606 { namespace tm { namespace transport { namespace
                         }).detach();
                     }
                 }
-                , hook
+                , latencyStampedIncomingHook(env, "rabbitmq", locator, hook)
             );
             return ret->get_future();
         }
@@ -247,7 +235,7 @@ namespace dev { namespace cd606 { namespace tm { namespace transport { namespace
                         }
                     }
                 }
-                , DefaultHookFactory<Env>::template supplyIncomingHook<T>(env, hook)
+                , latencyStampedIncomingHook(env, "rabbitmq", locator, DefaultHookFactory<Env>::template supplyIncomingHook<T>(env, hook))
             );
             return ret->get_future();
         }
@@ -27,10 +27,10 @@ namespace dev { namespace cd606 { namespace tm { namespace transport { namespace
         }
 
         template <class Identity, class Request>
-        static void sendRequestWithIdentity(Env *env, std::function<void(basic::ByteDataWithID &&)>requester, basic::ByteDataWithID &&req) {
+        static void sendRequestWithIdentity(Env *env, ConnectionLocator const &locator, std::function<void(basic::ByteDataWithID &&)>requester, basic::ByteDataWithID &&req) {
             requester({
                 std::move(req.id)
-                , static_cast<typename DetermineClientSideIdentityForRequest<Env,Request>::ComponentType *>(env)->attach_identity(basic::ByteData {std::move(req.content)}).content
+                , static_cast<typename DetermineClientSideIdentityForRequest<Env,Request>::ComponentType *>(env)->attach_identity_for(locator, basic::ByteData {std::move(req.content)}).content
             });
         }
 
@@ -608,8 +608,9 @@ namespace dev { namespace cd606 { namespace tm { namespace transport { namespace
                     virtual void start(Env *env) override final {
                         env_ = env;
                         requester_ = env->rabbitmq_setRPCQueueClient(locator_, [this](bool isFinal, basic::ByteDataWithID &&data) {
-                            auto processRes = static_cast<typename DetermineClientSideIdentityForRequest<Env,A>::ComponentType *>(env_)->process_incoming_data(
-                                basic::ByteData {std::move(data.content)}
+                            auto processRes = static_cast<typename DetermineClientSideIdentityForRequest<Env,A>::ComponentType *>(env_)->process_incoming_data_from(
+                                locator_
+                                , basic::ByteData {std::move(data.content)}
                             );
                             if (processRes) {
                                 B b;
@@ -627,7 +628,7 @@ namespace dev { namespace cd606 { namespace tm { namespace transport { namespace
                             basic::ByteData s = { basic::SerializationActions<M>::template serializeFunc<A>(
                                 data.timedData.value.key()
                             ) };
-                            sendRequestWithIdentity<Identity,A>(env_, requester_, basic::ByteDataWithID {
+                            sendRequestWithIdentity<Identity,A>(env_, locator_, requester_, basic::ByteDataWithID {
                                 Env::id_to_string(data.timedData.value.id())
                                 , std::move(s.content)
                             });
@@ -925,8 +926,9 @@ namespace dev { namespace cd606 { namespace tm { namespace transport { namespace
                 auto requester = env->rabbitmq_setRPCQueueClient(rpcQueueLocator, [autoDisconnect,ret,env,rpcQueueLocator,done,clientNum](bool isFinal, basic::ByteDataWithID &&data) mutable {    
                     if (!done) {
                         try {
-                            auto processRes = static_cast<typename DetermineClientSideIdentityForRequest<Env,A>::ComponentType *>(env)->process_incoming_data(
-                                basic::ByteData {std::move(data.content)}
+                            auto processRes = static_cast<typename DetermineClientSideIdentityForRequest<Env,A>::ComponentType *>(env)->process_incoming_data_from(
+                                rpcQueueLocator
+                                , basic::ByteData {std::move(data.content)}
                             );
                             if (processRes) {
                                 B b;
@@ -983,7 +985,7 @@ namespace dev { namespace cd606 { namespace tm { namespace transport { namespace
                 if (clientNumberOutput) {
                     *clientNumberOutput = *clientNum;
                 }
-                sendRequestWithIdentity<Identity,A>(env, requester, basic::ByteDataWithID {
+                sendRequestWithIdentity<Identity,A>(env, rpcQueueLocator, requester, basic::ByteDataWithID {
                     Env::id_to_string(keyInput.id())
                     , std::move(keyInput.key().content)
                 });
@@ -1001,7 +1003,7 @@ namespace dev { namespace cd606 { namespace tm { namespace transport { namespace
                 if (clientNumberOutput) {
                     *clientNumberOutput = clientNum;
                 }
-                sendRequestWithIdentity<Identity,A>(env, requester, basic::ByteDataWithID {
+                sendRequestWithIdentity<Identity,A>(env, rpcQueueLocator, requester, basic::ByteDataWithID {
                     Env::id_to_string(keyInput.id())
                     , std::move(keyInput.key().content)
                 });
@@ -24,12 +24,29 @@ namespace dev { namespace cd606 { namespace tm { namespace transport { namespace
         RedisComponentException(std::string const &info) : std::runtime_error(info) {}
     };
 
+    //All subscriptions, publishers and RPC channels on the same Redis
+    //server, with the same credentials and threading properties (see
+    //TransportThreading.hpp), share one connection and event loop thread,
+    //so the callbacks for one server are called on that thread one at a
+    //time.
+    //
+    //With the property "stream=true", the broadcast goes through the Redis
+    //stream named by the locator identifier instead of PUBLISH/PSUBSCRIBE,
+    //so it can be replayed and shared among consumers, e.g.
+    //  redis://127.0.0.1:6379:::prices[stream=true,group=pricers,consumer=p1,start_id=0]
+    //Publishers trim the stream to about "max_length" entries (default
+    //1000000, 0 for no trimming). Subscribers use "group", "consumer",
+    //"start_id" ("$" by default, or "0", or the ID to resume after),
+    //"count", "block_ms" and "claim_idle_ms", see RedisComponent.cpp.
+    //A consumer in a group acknowledges every entry it reads, including
+    //those its topic filters out, so all consumers of a group should
+    //subscribe to the same topic.
     class RedisComponent {
     private:
         std::unique_ptr<RedisComponentImpl> impl_;
     public:
         RedisComponent();
-        ~RedisComponent();
+        virtual ~RedisComponent();
         RedisComponent(RedisComponent const &) = delete;
         RedisComponent(RedisComponent &&);
         RedisComponent &operator=(RedisComponent const &) = delete;
@@ -43,6 +60,9 @@ namespace dev { namespace cd606 { namespace tm { namespace transport { namespace
         void redis_removeSubscriptionClient(uint32_t id);
         std::function<void(basic::ByteDataWithTopic &&)> redis_getPublisher(ConnectionLocator const &locator, std::optional<UserToWireHook> userToWireHook = std::nullopt);
         //for RPC, host, queue and an RPC channel name (as identifier) are needed in the locator
+        //With the property "rpc_batch=true" on the client side, requests sent
+        //close together go out as one message and the server replies in kind.
+        //Servers accept both batched and single requests.
         std::function<void(basic::ByteDataWithID &&)> redis_setRPCClient(ConnectionLocator const &locator,
                         std::function<std::string()> clientCommunicationIDCreator,
                         std::function<void(bool, basic::ByteDataWithID &&)> client,
@@ -0,0 +1,111 @@
+#ifndef TM_KIT_TRANSPORT_SECURITY_SESSION_KEY_HELPER_HPP_
+#define TM_KIT_TRANSPORT_SECURITY_SESSION_KEY_HELPER_HPP_
+
+#include <chrono>
+#include <memory>
+#include <string>
+#include <tuple>
+#include <optional>
+#include <cstdint>
+#include <tm_kit/basic/ByteData.hpp>
+#include <tm_kit/transport/security/SignatureHelper.hpp>
+
+namespace dev { namespace cd606 { namespace tm { namespace transport { namespace security {
+    class SessionKeyClientImpl;
+    class SessionKeyServerImpl;
+
+    //The session key mode uses the Ed25519 keys only to sign a handshake.
+    //The first request(s) of a session are signed as usual and also carry
+    //an ephemeral X25519 public key, the server attaches its own ephemeral
+    //public key to the replies, and both sides derive a per-session
+    //symmetric key from the two. After that, requests carry a keyed BLAKE2b
+    //MAC and a counter (for replay protection) instead of a signature.
+    //
+    //Since the session key on the server side can only be derived with the
+    //client's ephemeral secret, a MAC that verifies on the server side
+    //proves the same identity that the handshake signature proved.
+    //
+    //The client keeps one session per server connection (the connection
+    //is whatever string the caller uses to name the server, the identity
+    //attacher component uses the server's locator). The handshake messages
+    //carry the session's counter and a timestamp, so they are protected
+    //against replay just like the MAC'ed ones.
+    //
+    //The sessions live in the memory of one Server, so all the requests of
+    //a client must reach the same server. With competing consumers on one
+    //queue (e.g. several RPC servers on a RabbitMQ queue), a MAC'ed request
+    //can reach a server that never saw the handshake. Such a request is
+    //dropped, counted in unknownSessionRequests() and logged, and the
+    //client starts a new handshake once the request has gone unanswered
+    //for unansweredTimeout, so this mode should be used with one server
+    //per queue.
+    class SessionKeyHelper {
+    public:
+        static constexpr std::size_t SessionIDLength = 16;
+        static constexpr std::size_t MACLength = 16;
+
+        struct ClientOptions {
+            //a new handshake is started when the session gets older than this
+            std::chrono::steady_clock::duration sessionLifetime = std::chrono::hours(1);
+            //a new handshake is also started when requests have gone
+            //without any reply for this long, which is what happens when
+            //the server has lost the session (e.g. it restarted), 0 means
+            //never
+            std::chrono::steady_clock::duration unansweredTimeout = std::chrono::seconds(10);
+            //or when this many requests are sent without any reply coming
+            //back, 0 means no limit (so that bursts of requests do not
+            //force a handshake, the timeout above is the main trigger)
+            std::size_t maxUnansweredRequests = 0;
+            //whether the handshake signature carries the key ID
+            bool tagWithKeyID = false;
+        };
+        struct ServerOptions {
+            //sessions that have not been used for this long are dropped
+            std::chrono::steady_clock::duration sessionIdleTimeout = std::chrono::hours(2);
+            //handshake messages whose timestamp is further than this from
+            //the server's clock are rejected, this must be shorter than
+            //sessionIdleTimeout
+            std::chrono::system_clock::duration helloMaxAge = std::chrono::minutes(5);
+        };
+
+        class Client {
+        private:
+            std::unique_ptr<SessionKeyClientImpl> impl_;
+        public:
+            Client();
+            Client(SignatureHelper::PrivateKey const &privateKey);
+            Client(SignatureHelper::PrivateKey const &privateKey, ClientOptions const &options);
+            ~Client();
+            Client(Client const &) = delete;
+            Client &operator=(Client const &) = delete;
+            Client(Client &&);
+            Client &operator=(Client &&);
+            //these use one default connection
+            basic::ByteData wrapOutgoing(basic::ByteData &&);
+            std::optional<basic::ByteData> unwrapIncoming(basic::ByteData &&);
+            basic::ByteData wrapOutgoing(std::string const &connection, basic::ByteData &&);
+            std::optional<basic::ByteData> unwrapIncoming(std::string const &connection, basic::ByteData &&);
+        };
+
+        class Server {
+        private:
+            std::unique_ptr<SessionKeyServerImpl> impl_;
+        public:
+            Server();
+            Server(ServerOptions const &options);
+            ~Server();
+            Server(Server const &) = delete;
+            Server &operator=(Server const &) = delete;
+            Server(Server &&);
+            Server &operator=(Server &&);
+            void addKey(std::string const &name, SignatureHelper::PublicKey const &publicKey);
+            void addKeys(SignatureHelper::PublicKeyMap const &keys);
+            std::optional<std::tuple<std::string,basic::ByteData>> unwrapIncoming(basic::ByteData &&);
+            basic::ByteData wrapOutgoing(std::string const &identity, basic::ByteData &&);
+            //MAC'ed requests dropped because their session is not known
+            uint64_t unknownSessionRequests() const;
+        };
+    };
+} } } } }
+
+#endif
@@ -11,13 +11,24 @@ template <class T>
 class SignatureHookFactoryComponent : public AbstractOutgoingHookFactoryComponent<T> {
 private:
     SignatureHelper::PrivateKey signKey_;
+    bool tagWithKeyID_;
 public:
-    SignatureHookFactoryComponent() : signKey_() {}
-    SignatureHookFactoryComponent(SignatureHelper::PrivateKey const &signKey)
-        : signKey_(signKey) {}
+    SignatureHookFactoryComponent() : signKey_(), tagWithKeyID_(false) {}
+    //If tagWithKeyID is true, the signed data carries the key ID, which
+    //makes verification much cheaper when the verifier has many keys, but
+    //the receiving side must also be built with key ID support
+    SignatureHookFactoryComponent(SignatureHelper::PrivateKey const &signKey, bool tagWithKeyID=false)
+        : signKey_(signKey), tagWithKeyID_(tagWithKeyID) {}
     virtual ~SignatureHookFactoryComponent() {}
     virtual std::optional<UserToWireHook> defaultHook() override final {
         auto signer = std::make_shared<SignatureHelper::Signer>(signKey_);
+        if (tagWithKeyID_) {
+            return UserToWireHook { 
+                [signer](basic::ByteData &&d) {
+                    return signer->signWithKeyID(std::move(d));
+                }
+            };
+        }
         return UserToWireHook { 
             [signer](basic::ByteData &&d) {
                 return signer->sign(std::move(d));
@@ -3,6 +3,7 @@
 
 #include <tm_kit/transport/AbstractIdentityCheckerComponent.hpp>
 #include <tm_kit/transport/security/SignatureHelper.hpp>
+#include <tm_kit/transport/security/SessionKeyHelper.hpp>
 
 namespace dev { namespace cd606 { namespace tm {namespace transport {namespace security {
     template <class Req>
@@ -11,16 +12,21 @@ namespace dev { namespace cd606 { namespace tm {namespace transport {namespace s
     {
     private:
         SignatureHelper::Signer signer_;
+        bool tagWithKeyID_;
     public:
-        ClientSideSignatureBasedIdentityAttacherComponent() : signer_() {}
-        ClientSideSignatureBasedIdentityAttacherComponent(SignatureHelper::PrivateKey const &privateKey) : signer_(privateKey) {}
+        ClientSideSignatureBasedIdentityAttacherComponent() : signer_(), tagWithKeyID_(false) {}
+        ClientSideSignatureBasedIdentityAttacherComponent(SignatureHelper::PrivateKey const &privateKey, bool tagWithKeyID=false) : signer_(privateKey), tagWithKeyID_(tagWithKeyID) {}
         ClientSideSignatureBasedIdentityAttacherComponent(ClientSideSignatureBasedIdentityAttacherComponent const &) = delete;
         ClientSideSignatureBasedIdentityAttacherComponent &operator=(ClientSideSignatureBasedIdentityAttacherComponent const &) = delete;
         ClientSideSignatureBasedIdentityAttacherComponent(ClientSideSignatureBasedIdentityAttacherComponent &&) = default;
         ClientSideSignatureBasedIdentityAttacherComponent &operator=(ClientSideSignatureBasedIdentityAttacherComponent &&) = default;
         ~ClientSideSignatureBasedIdentityAttacherComponent() = default;
         virtual dev::cd606::tm::basic::ByteData attach_identity(dev::cd606::tm::basic::ByteData &&d) override final {
-            return signer_.sign(std::move(d));
+            if (tagWithKeyID_) {
+                return signer_.signWithKeyID(std::move(d));
+            } else {
+                return signer_.sign(std::move(d));
+            }
         }
         virtual std::optional<basic::ByteData> process_incoming_data(basic::ByteData &&d) override final {
             return {std::move(d)};
@@ -43,6 +49,9 @@ namespace dev { namespace cd606 { namespace tm {namespace transport {namespace s
         void add_identity_and_key(std::string const &name, SignatureHelper::PublicKey const &publicKey) {
             verifier_.addKey(name, publicKey);
         }
+        void add_identities_and_keys(SignatureHelper::PublicKeyMap const &keys) {
+            verifier_.addKeys(keys);
+        }
         virtual std::optional<std::tuple<std::string,dev::cd606::tm::basic::ByteData>> check_identity(dev::cd606::tm::basic::ByteData &&d) override final {
             return verifier_.verify(dev::cd606::tm::basic::byteDataView(d));
         }
@@ -50,6 +59,72 @@ namespace dev { namespace cd606 { namespace tm {namespace transport {namespace s
             return std::move(d);
         }
     };
+
+    //The session key based components give the same identity as the
+    //signature based components, but only the handshake of each session
+    //is signed, the following requests are authenticated with a MAC 
+    //under a per-session key (see SessionKeyHelper). Both sides of a 
+    //facility must use the session key based components. The client side
+    //keeps a session for each server it talks to.
+    template <class Req>
+    class ClientSideSessionKeyBasedIdentityAttacherComponent 
+        : public dev::cd606::tm::transport::ClientSideAbstractIdentityAttacherComponent<std::string, Req>
+    {
+    private:
+        SessionKeyHelper::Client client_;
+        static std::string connectionName(ConnectionLocator const &locator) {
+            return ConnectionLocator {locator.host(), locator.port(), "", "", locator.identifier()}.toSerializationFormat();
+        }
+    public:
+        ClientSideSessionKeyBasedIdentityAttacherComponent() : client_() {}
+        ClientSideSessionKeyBasedIdentityAttacherComponent(SignatureHelper::PrivateKey const &privateKey) : client_(privateKey) {}
+        ClientSideSessionKeyBasedIdentityAttacherComponent(SignatureHelper::PrivateKey const &privateKey, SessionKeyHelper::ClientOptions const &options) : client_(privateKey, options) {}
+        ClientSideSessionKeyBasedIdentityAttacherComponent(ClientSideSessionKeyBasedIdentityAttacherComponent const &) = delete;
+        ClientSideSessionKeyBasedIdentityAttacherComponent &operator=(ClientSideSessionKeyBasedIdentityAttacherComponent const &) = delete;
+        ClientSideSessionKeyBasedIdentityAttacherComponent(ClientSideSessionKeyBasedIdentityAttacherComponent &&) = default;
+        ClientSideSessionKeyBasedIdentityAttacherComponent &operator=(ClientSideSessionKeyBasedIdentityAttacherComponent &&) = default;
+        ~ClientSideSessionKeyBasedIdentityAttacherComponent() = default;
+        virtual dev::cd606::tm::basic::ByteData attach_identity(dev::cd606::tm::basic::ByteData &&d) override final {
+            return client_.wrapOutgoing(std::move(d));
+        }
+        virtual std::optional<basic::ByteData> process_incoming_data(basic::ByteData &&d) override final {
+            return client_.unwrapIncoming(std::move(d));
+        }
+        virtual dev::cd606::tm::basic::ByteData attach_identity_for(ConnectionLocator const &locator, dev::cd606::tm::basic::ByteData &&d) override final {
+            return client_.wrapOutgoing(connectionName(locator), std::move(d));
+        }
+        virtual std::optional<basic::ByteData> process_incoming_data_from(ConnectionLocator const &locator, basic::ByteData &&d) override final {
+            return client_.unwrapIncoming(connectionName(locator), std::move(d));
+        }
+    };
+
+    template <class Req>
+    class ServerSideSessionKeyBasedIdentityCheckerComponent 
+        : public dev::cd606::tm::transport::ServerSideAbstractIdentityCheckerComponent<std::string, Req>
+    {
+    private:
+        SessionKeyHelper::Server server_;
+    public:
+        ServerSideSessionKeyBasedIdentityCheckerComponent() : server_() {}
+        ServerSideSessionKeyBasedIdentityCheckerComponent(SessionKeyHelper::ServerOptions const &options) : server_(options) {}
+        ServerSideSessionKeyBasedIdentityCheckerComponent(ServerSideSessionKeyBasedIdentityCheckerComponent const &) = delete;
+        ServerSideSessionKeyBasedIdentityCheckerComponent &operator=(ServerSideSessionKeyBasedIdentityCheckerComponent const &) = delete;
+        ServerSideSessionKeyBasedIdentityCheckerComponent(ServerSideSessionKeyBasedIdentityCheckerComponent &&) = default;
+        ServerSideSessionKeyBasedIdentityCheckerComponent &operator=(ServerSideSessionKeyBasedIdentityCheckerComponent &&) = default;
+        ~ServerSideSessionKeyBasedIdentityCheckerComponent() = default;
+        void add_identity_and_key(std::string const &name, SignatureHelper::PublicKey const &publicKey) {
+            server_.addKey(name, publicKey);
+        }
+        void add_identities_and_keys(SignatureHelper::PublicKeyMap const &keys) {
+            server_.addKeys(keys);
+        }
+        virtual std::optional<std::tuple<std::string,dev::cd606::tm::basic::ByteData>> check_identity(dev::cd606::tm::basic::ByteData &&d) override final {
+            return server_.unwrapIncoming(std::move(d));
+        }
+        virtual basic::ByteData process_outgoing_data(std::string const &identity, basic::ByteData &&d) override final {
+            return server_.wrapOutgoing(identity, std::move(d));
+        }
+    };
 }}}}}
 
 #endif
\ No newline at end of file
@@ -8,9 +8,11 @@
 #include <tuple>
 #include <optional>
 #include <unordered_map>
+#include <vector>
 #include <tm_kit/basic/ByteData.hpp>
 
 #include <sodium/crypto_sign.h>
+#include <sodium/crypto_generichash.h>
 
 namespace dev { namespace cd606 { namespace tm { namespace transport { namespace security {
     class SignerImpl;
@@ -20,10 +22,19 @@ namespace dev { namespace cd606 { namespace tm { namespace transport { namespace
     public:
         static constexpr std::size_t PublicKeyLength = crypto_sign_PUBLICKEYBYTES;
         static constexpr std::size_t PrivateKeyLength = crypto_sign_SECRETKEYBYTES;
+        static constexpr std::size_t KeyIDLength = crypto_generichash_BYTES_MIN;
 
         using PublicKey = std::array<unsigned char, PublicKeyLength>;
         using PrivateKey = std::array<unsigned char, PrivateKeyLength>;
         using PublicKeyMap = std::unordered_map<std::string, PublicKey>;
+        //The key ID is a short BLAKE2b digest of the public key, it is
+        //carried in the envelope produced by signWithKeyID so that the
+        //verifier can find the key with one hash lookup instead of trying
+        //every registered key. 16 bytes is the shortest digest that
+        //crypto_generichash produces.
+        using KeyID = std::array<unsigned char, KeyIDLength>;
+
+        static KeyID keyIDForPublicKey(PublicKey const &publicKey);
 
         class Signer {
         private:
@@ -38,6 +49,7 @@ namespace dev { namespace cd606 { namespace tm { namespace transport { namespace
             Signer &operator=(Signer &&);
             basic::ByteData sign(basic::ByteData &&);
             basic::ByteData signWithName(std::string const &, basic::ByteData &&);
+            basic::ByteData signWithKeyID(basic::ByteData &&);
         };
 
         class Verifier {
@@ -52,8 +64,14 @@ namespace dev { namespace cd606 { namespace tm { namespace transport { namespace
             Verifier &operator=(Verifier &&);
             void addKey(std::string const &name, PublicKey const &publicKey);
             void addKeys(PublicKeyMap const &keys);
+            //verify accepts both the plain envelope produced by sign (which
+            //requires trying every registered key) and the envelope produced
+            //by signWithKeyID (which requires only one key lookup)
             std::optional<std::tuple<std::string,basic::ByteData>> verify(basic::ByteDataView const &);
             std::optional<basic::ByteData> verifyDataTaggedWithName(basic::ByteDataView const &);
+            //verifyBatch uses one snapshot of the key set for the whole batch,
+            //the results are in the same order as the input
+            std::vector<std::optional<std::tuple<std::string,basic::ByteData>>> verifyBatch(std::vector<basic::ByteDataView> const &);
         };
     };
 } } } } } 
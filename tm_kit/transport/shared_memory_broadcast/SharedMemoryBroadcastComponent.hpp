@@ -14,6 +14,7 @@
 #include <tm_kit/basic/ByteData.hpp>
 #include <tm_kit/transport/ConnectionLocator.hpp>
 #include <tm_kit/transport/ByteDataHook.hpp>
+#include <tm_kit/transport/SharedMemorySegment.hpp>
 
 namespace dev { namespace cd606 { namespace tm { namespace transport { namespace shared_memory_broadcast {
     
@@ -34,6 +35,10 @@ namespace dev { namespace cd606 { namespace tm { namespace transport { namespace
         void shared_memory_broadcast_removeSubscriptionClient(uint32_t id);
         std::function<void(basic::ByteDataWithTopic &&)> shared_memory_broadcast_getPublisher(ConnectionLocator const &locator, std::optional<UserToWireHook> userToWireHook = std::nullopt);
         std::unordered_map<ConnectionLocator, std::thread::native_handle_type> shared_memory_broadcast_threadHandles();
+        //how the segments were prepared, see SharedMemorySegment.hpp for
+        //the huge_pages, prefault and mlock locator properties
+        std::unordered_map<ConnectionLocator, SharedMemorySegmentLayout> shared_memory_broadcast_subscriptionSegmentLayouts();
+        std::unordered_map<ConnectionLocator, SharedMemorySegmentLayout> shared_memory_broadcast_publisherSegmentLayouts();
     };
 
 } } } } }
@@ -29,7 +29,7 @@ namespace dev { namespace cd606 { namespace tm { namespace transport { namespace
         std::unique_ptr<SocketRPCComponentImpl> impl_;
     public:
         SocketRPCComponent();
-        ~SocketRPCComponent();
+        virtual ~SocketRPCComponent();
         SocketRPCComponent(SocketRPCComponent &&);
         SocketRPCComponent &operator=(SocketRPCComponent &&);
         //for RPC client, only host and port are required in the locator
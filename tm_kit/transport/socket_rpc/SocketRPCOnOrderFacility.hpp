@@ -27,10 +27,10 @@ namespace dev { namespace cd606 { namespace tm { namespace transport { namespace
         }
 
         template <class Identity, class Request>
-        static void sendRequestWithIdentity(Env *env, std::function<void(basic::ByteDataWithID &&)>requester, basic::ByteDataWithID &&req) {
+        static void sendRequestWithIdentity(Env *env, ConnectionLocator const &locator, std::function<void(basic::ByteDataWithID &&)>requester, basic::ByteDataWithID &&req) {
             requester({
                 std::move(req.id)
-                , static_cast<typename DetermineClientSideIdentityForRequest<Env,Request>::ComponentType *>(env)->attach_identity(basic::ByteData {std::move(req.content)}).content
+                , static_cast<typename DetermineClientSideIdentityForRequest<Env,Request>::ComponentType *>(env)->attach_identity_for(locator, basic::ByteData {std::move(req.content)}).content
             });
         }
 
@@ -612,8 +612,9 @@ namespace dev { namespace cd606 { namespace tm { namespace transport { namespace
                         requester_ = env->socket_rpc_setRPCClient(
                             locator_
                             , [this](bool isFinal, basic::ByteDataWithID &&data) {
-                                auto processRes = static_cast<typename DetermineClientSideIdentityForRequest<Env,A>::ComponentType *>(env_)->process_incoming_data(
-                                    basic::ByteData {std::move(data.content)}
+                                auto processRes = static_cast<typename DetermineClientSideIdentityForRequest<Env,A>::ComponentType *>(env_)->process_incoming_data_from(
+                                    locator_
+                                    , basic::ByteData {std::move(data.content)}
                                 );
                                 if (processRes) {
                                     B b;
@@ -633,7 +634,7 @@ namespace dev { namespace cd606 { namespace tm { namespace transport { namespace
                             basic::ByteData s = { basic::SerializationActions<M>::template serializeFunc<A>(
                                 data.timedData.value.key()
                             ) };
-                            sendRequestWithIdentity<Identity,A>(env_, requester_, basic::ByteDataWithID {
+                            sendRequestWithIdentity<Identity,A>(env_, locator_, requester_, basic::ByteDataWithID {
                                 Env::id_to_string(data.timedData.value.id())
                                 , std::move(s.content)
                             });
@@ -932,8 +933,9 @@ namespace dev { namespace cd606 { namespace tm { namespace transport { namespace
                     , [autoDisconnect,ret,env,rpcQueueLocator,done](bool isFinal, basic::ByteDataWithID &&data) mutable {    
                         if (!done) {
                             try {
-                                auto processRes = static_cast<typename DetermineClientSideIdentityForRequest<Env,A>::ComponentType *>(env)->process_incoming_data(
-                                    basic::ByteData {std::move(data.content)}
+                                auto processRes = static_cast<typename DetermineClientSideIdentityForRequest<Env,A>::ComponentType *>(env)->process_incoming_data_from(
+                                    rpcQueueLocator
+                                    , basic::ByteData {std::move(data.content)}
                                 );
                                 if (processRes) {
                                     B b;
@@ -988,7 +990,7 @@ namespace dev { namespace cd606 { namespace tm { namespace transport { namespace
                     }
                     , DefaultHookFactory<Env>::template supplyFacilityHookPair_ClientSide<A,B>(env, hooks)
                 );
-                sendRequestWithIdentity<Identity,A>(env, requester, basic::ByteDataWithID {
+                sendRequestWithIdentity<Identity,A>(env, rpcQueueLocator, requester, basic::ByteDataWithID {
                     Env::id_to_string(keyInput.id())
                     , std::move(keyInput.key().content)
                 });
@@ -1005,7 +1007,7 @@ namespace dev { namespace cd606 { namespace tm { namespace transport { namespace
                     }
                     , DefaultHookFactory<Env>::template supplyFacilityHookPair_ClientSideOutgoingOnly<A>(env, hooks)
                 );
-                sendRequestWithIdentity<Identity,A>(env, requester, basic::ByteDataWithID {
+                sendRequestWithIdentity<Identity,A>(env, rpcQueueLocator, requester, basic::ByteDataWithID {
                     Env::id_to_string(keyInput.id())
                     , std::move(keyInput.key().content)
                 });
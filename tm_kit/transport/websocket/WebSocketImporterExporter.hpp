@@ -10,6 +10,11 @@
 #include <tm_kit/basic/ByteData.hpp>
 #include <tm_kit/transport/websocket/WebSocketComponent.hpp>
 #include <tm_kit/transport/HeartbeatAndAlertComponent.hpp>
+#include <tm_kit/transport/TransportMetricsComponent.hpp>
+#include <tm_kit/transport/LatencyStamping.hpp>
+#include <tm_kit/transport/ReceivePipeline.hpp>
+#include <tm_kit/transport/LazilyDecodedData.hpp>
+#include <tm_kit/transport/ReceiveDecoding.hpp>
 #include <tm_kit/transport/AbstractHookFactoryComponent.hpp>
 
 namespace dev { namespace cd606 { namespace tm { namespace transport { namespace web_socket {
@@ -18,8 +23,11 @@ namespace dev { namespace cd606 { namespace tm { namespace transport { namespace
     class WebSocketImporterExporter {
     public:
         using M = infra::RealTimeApp<Env>;
-        static std::shared_ptr<typename M::template Importer<basic::ByteDataWithTopic>> createImporter(ConnectionLocator const &locator, std::variant<WebSocketComponent::NoTopicSelection, std::string, std::regex> const &topic=WebSocketComponent::NoTopicSelection(), std::optional<WireToUserHook> wireToUserHook=std::nullopt, std::optional<basic::ByteData> &&initialMessage = std::nullopt, std::function<std::optional<basic::ByteData>(basic::ByteDataView const &)> const &protocolReactor = {}, std::function<void()> const &protocolRestartReactor = {}) {
-            class LocalI final : public M::template AbstractImporter<basic::ByteDataWithTopic>, public virtual infra::IControllableNode<Env> {
+    private:
+        template <class Decoding>
+        static std::shared_ptr<typename M::template Importer<typename Decoding::Output>> createImporterWithDecoding(ConnectionLocator const &locator, std::variant<WebSocketComponent::NoTopicSelection, std::string, std::regex> const &topic, std::optional<WireToUserHook> wireToUserHook, std::optional<basic::ByteData> &&initialMessage, std::function<std::optional<basic::ByteData>(basic::ByteDataView const &)> const &protocolReactor, std::function<void()> const &protocolRestartReactor) {
+            using Output = typename Decoding::Output;
+            class LocalI final : public M::template AbstractImporter<Output>, public virtual infra::IControllableNode<Env> {
             private:
                 ConnectionLocator locator_;
                 std::variant<WebSocketComponent::NoTopicSelection, std::string, std::regex> topic_;
@@ -29,80 +37,36 @@ namespace dev { namespace cd606 { namespace tm { namespace transport { namespace
                 std::function<void()> protocolRestartReactor_;
                 std::optional<uint32_t> client_;
                 std::mutex mutex_;
-            public:
-                LocalI(ConnectionLocator const &locator, std::variant<WebSocketComponent::NoTopicSelection, std::string, std::regex> const &topic, std::optional<WireToUserHook> wireToUserHook, std::optional<basic::ByteData> &&initialMessage, std::function<std::optional<basic::ByteData>(basic::ByteDataView const &)> const &protocolReactor, std::function<void()> const &protocolRestartReactor)
-                    : locator_(locator), topic_(topic), wireToUserHook_(wireToUserHook), initialMessage_(std::move(initialMessage)), protocolReactor_(protocolReactor), protocolRestartReactor_(protocolRestartReactor), client_(std::nullopt), mutex_()
-                {
-                }
-                virtual void start(Env *env) override final {
-                    std::lock_guard<std::mutex> _(mutex_);
-                    if (!client_) {
-                        client_ = env->websocket_addSubscriptionClient(
-                            locator_
-                            , topic_
-                            , [this,env](basic::ByteDataWithTopic &&d) {
-                                TM_INFRA_IMPORTER_TRACER(env);
-                                this->publish(M::template pureInnerData<basic::ByteDataWithTopic>(env, std::move(d)));
-                            }
-                            , wireToUserHook_
-                            , std::move(initialMessage_)
-                            , protocolReactor_
-                            , protocolRestartReactor_
-                        );
+                ReceivePipeline pipeline_;
+
+                void deliver(Env *env, basic::ByteDataWithTopic &&d) {
+                    auto o = Decoding::decode(std::move(d), pipeline_.metrics());
+                    if (o) {
+                        this->publish(M::template pureInnerData<Output>(env, std::move(*o)));
                     }
                 }
-                virtual void control(Env *env, std::string const &command, std::vector<std::string> const &params) override final {
-                    std::thread th([this,env,command]() {
-                        if (command == "stop") {
-                            std::lock_guard<std::mutex> _(mutex_);
-                            if (client_) {
-                                env->websocket_removeSubscriptionClient(*client_);
-                                client_ = std::nullopt;
-                            }
-                        } else if (command == "restart") {
-                            start(env);
-                        }
-                    });
-                    th.detach();
-                }
-            };
-            return M::importer(new LocalI(locator, topic, wireToUserHook, std::move(initialMessage), protocolReactor, protocolRestartReactor));
-        }
-        template <class T>
-        static std::shared_ptr<typename M::template Importer<basic::TypedDataWithTopic<T>>> createTypedImporter(ConnectionLocator const &locator, std::variant<WebSocketComponent::NoTopicSelection, std::string, std::regex> const &topic=WebSocketComponent::NoTopicSelection(), std::optional<WireToUserHook> wireToUserHook=std::nullopt, std::optional<basic::ByteData> &&initialMessage=std::nullopt, std::function<std::optional<basic::ByteData>(basic::ByteDataView const &)> const &protocolReactor = {}, std::function<void()> const &protocolRestartReactor = {}) {
-            class LocalI final : public M::template AbstractImporter<basic::TypedDataWithTopic<T>>, public virtual infra::IControllableNode<Env> {
-            private:
-                ConnectionLocator locator_;
-                std::variant<WebSocketComponent::NoTopicSelection, std::string, std::regex> topic_;
-                std::optional<WireToUserHook> wireToUserHook_;
-                std::optional<basic::ByteData> initialMessage_;
-                std::function<std::optional<basic::ByteData>(basic::ByteDataView const &)> protocolReactor_;
-                std::function<void()> protocolRestartReactor_;
-                std::optional<uint32_t> client_;
-                std::mutex mutex_;
             public:
                 LocalI(ConnectionLocator const &locator, std::variant<WebSocketComponent::NoTopicSelection, std::string, std::regex> const &topic, std::optional<WireToUserHook> wireToUserHook, std::optional<basic::ByteData> &&initialMessage, std::function<std::optional<basic::ByteData>(basic::ByteDataView const &)> const &protocolReactor, std::function<void()> const &protocolRestartReactor)
-                    : locator_(locator), topic_(topic), wireToUserHook_(wireToUserHook), initialMessage_(std::move(initialMessage)), protocolReactor_(protocolReactor), protocolRestartReactor_(protocolRestartReactor), client_(std::nullopt), mutex_()
+                    : locator_(locator), topic_(topic), wireToUserHook_(wireToUserHook), initialMessage_(std::move(initialMessage)), protocolReactor_(protocolReactor), protocolRestartReactor_(protocolRestartReactor), client_(std::nullopt), mutex_(), pipeline_()
                 {
                 }
                 virtual void start(Env *env) override final {
                     std::lock_guard<std::mutex> _(mutex_);
+                    pipeline_.setup(env, "websocket", locator_, [this,env](basic::ByteDataWithTopic &&d) {
+                        deliver(env, std::move(d));
+                    });
                     if (!wireToUserHook_) {
-                        wireToUserHook_ = DefaultHookFactory<Env>::template incomingHook<T>(env);
+                        wireToUserHook_ = Decoding::defaultIncomingHook(env);
                     }
                     if (!client_) {
                         client_ = env->websocket_addSubscriptionClient(
-                        locator_
+                            locator_
                             , topic_
                             , [this,env](basic::ByteDataWithTopic &&d) {
                                 TM_INFRA_IMPORTER_TRACER(env);
-                                T t;
-                                auto tRes = basic::bytedata_utils::RunDeserializer<T>::applyInPlace(t, d.content);
-                                if (tRes) {
-                                    this->publish(M::template pureInnerData<basic::TypedDataWithTopic<T>>(env, {std::move(d.topic), std::move(t)}));
-                                }
+                                pipeline_.push(std::move(d));
                             }
-                            , wireToUserHook_
+                            , pipeline_.incomingHook(wireToUserHook_)
                             , std::move(initialMessage_)
                             , protocolReactor_
                             , protocolRestartReactor_
@@ -126,6 +90,18 @@ namespace dev { namespace cd606 { namespace tm { namespace transport { namespace
             };
             return M::importer(new LocalI(locator, topic, wireToUserHook, std::move(initialMessage), protocolReactor, protocolRestartReactor));
         }
+    public:
+        static std::shared_ptr<typename M::template Importer<basic::ByteDataWithTopic>> createImporter(ConnectionLocator const &locator, std::variant<WebSocketComponent::NoTopicSelection, std::string, std::regex> const &topic=WebSocketComponent::NoTopicSelection(), std::optional<WireToUserHook> wireToUserHook=std::nullopt, std::optional<basic::ByteData> &&initialMessage = std::nullopt, std::function<std::optional<basic::ByteData>(basic::ByteDataView const &)> const &protocolReactor = {}, std::function<void()> const &protocolRestartReactor = {}) {
+            return createImporterWithDecoding<RawReceiveDecoding>(locator, topic, wireToUserHook, std::move(initialMessage), protocolReactor, protocolRestartReactor);
+        }
+        template <class T>
+        static std::shared_ptr<typename M::template Importer<basic::TypedDataWithTopic<T>>> createTypedImporter(ConnectionLocator const &locator, std::variant<WebSocketComponent::NoTopicSelection, std::string, std::regex> const &topic=WebSocketComponent::NoTopicSelection(), std::optional<WireToUserHook> wireToUserHook=std::nullopt, std::optional<basic::ByteData> &&initialMessage=std::nullopt, std::function<std::optional<basic::ByteData>(basic::ByteDataView const &)> const &protocolReactor = {}, std::function<void()> const &protocolRestartReactor = {}) {
+            return createImporterWithDecoding<TypedReceiveDecoding<T>>(locator, topic, wireToUserHook, std::move(initialMessage), protocolReactor, protocolRestartReactor);
+        }
+        template <class T>
+        static std::shared_ptr<typename M::template Importer<LazilyDecodedDataWithTopic<T>>> createLazilyDecodedImporter(ConnectionLocator const &locator, std::variant<WebSocketComponent::NoTopicSelection, std::string, std::regex> const &topic=WebSocketComponent::NoTopicSelection(), std::optional<WireToUserHook> wireToUserHook=std::nullopt, std::optional<basic::ByteData> &&initialMessage=std::nullopt, std::function<std::optional<basic::ByteData>(basic::ByteDataView const &)> const &protocolReactor = {}, std::function<void()> const &protocolRestartReactor = {}) {
+            return createImporterWithDecoding<LazyReceiveDecoding<T>>(locator, topic, wireToUserHook, std::move(initialMessage), protocolReactor, protocolRestartReactor);
+        }
         static std::shared_ptr<typename M::template Exporter<basic::ByteDataWithTopic>> createExporter(ConnectionLocator const &locator, std::optional<UserToWireHook> userToWireHook=std::nullopt, std::string const &heartbeatName = "", std::function<std::function<std::optional<basic::ByteData>(basic::ByteDataView const &, std::atomic<bool> &)>()> const &protocolReactorFactory = {}) {
             class LocalE final : public M::template AbstractExporter<basic::ByteDataWithTopic> {
             private:
@@ -135,14 +111,16 @@ namespace dev { namespace cd606 { namespace tm { namespace transport { namespace
                 std::optional<UserToWireHook> userToWireHook_;
                 std::string heartbeatName_;
                 std::function<std::function<std::optional<basic::ByteData>(basic::ByteDataView const &, std::atomic<bool> &)>()> protocolReactorFactory_;
+                std::shared_ptr<TransportChannelMetrics> metrics_;
             public:
                 LocalE(ConnectionLocator const &locator, std::optional<UserToWireHook> userToWireHook, std::string const &heartbeatName, std::function<std::function<std::optional<basic::ByteData>(basic::ByteDataView const &, std::atomic<bool> &)>()> const &protocolReactorFactory)
-                    : locator_(locator), env_(nullptr), publisher_(), userToWireHook_(userToWireHook), heartbeatName_(heartbeatName), protocolReactorFactory_(protocolReactorFactory)
+                    : locator_(locator), env_(nullptr), publisher_(), userToWireHook_(userToWireHook), heartbeatName_(heartbeatName), protocolReactorFactory_(protocolReactorFactory), metrics_()
                 {
                 }
                 virtual void start(Env *env) override final {
                     env_ = env;
-                    publisher_ = env->websocket_getPublisher(locator_, userToWireHook_, protocolReactorFactory_);
+                    metrics_ = transportChannelMetrics(env, "websocket", locator_);
+                    publisher_ = env->websocket_getPublisher(locator_, latencyStampedOutgoingHook(locator_, userToWireHook_), protocolReactorFactory_);
                     if constexpr (std::is_convertible_v<
                         Env *
                         , HeartbeatAndAlertComponent *
@@ -156,6 +134,7 @@ namespace dev { namespace cd606 { namespace tm { namespace transport { namespace
                 virtual void handle(typename M::template InnerData<basic::ByteDataWithTopic> &&data) override final {
                     if (env_) {
                         TM_INFRA_EXPORTER_TRACER(env_);
+                        TransportMetricsSendScope metricsScope(metrics_.get(), data.timedData.value.content.length());
                         publisher_(std::move(data.timedData.value));
                     }
                 }
@@ -172,17 +151,19 @@ namespace dev { namespace cd606 { namespace tm { namespace transport { namespace
                 std::optional<UserToWireHook> userToWireHook_;
                 std::string heartbeatName_;
                 std::function<std::function<std::optional<basic::ByteData>(basic::ByteDataView const &, std::atomic<bool> &)>()> protocolReactorFactory_;
+                std::shared_ptr<TransportChannelMetrics> metrics_;
             public:
                 LocalE(ConnectionLocator const &locator, std::optional<UserToWireHook> userToWireHook, std::string const &heartbeatName, std::function<std::function<std::optional<basic::ByteData>(basic::ByteDataView const &, std::atomic<bool> &)>()> const &protocolReactorFactory)
-                    : locator_(locator), env_(nullptr), publisher_(), userToWireHook_(userToWireHook), heartbeatName_(heartbeatName), protocolReactorFactory_(protocolReactorFactory)
+                    : locator_(locator), env_(nullptr), publisher_(), userToWireHook_(userToWireHook), heartbeatName_(heartbeatName), protocolReactorFactory_(protocolReactorFactory), metrics_()
                 {
                 }
                 virtual void start(Env *env) override final {
                     env_ = env;
+                    metrics_ = transportChannelMetrics(env, "websocket", locator_);
                     if (!userToWireHook_) {
                         userToWireHook_ = DefaultHookFactory<Env>::template outgoingHook<T>(env);
                     }
-                    publisher_ = env->websocket_getPublisher(locator_, userToWireHook_, protocolReactorFactory_);
+                    publisher_ = env->websocket_getPublisher(locator_, latencyStampedOutgoingHook(locator_, userToWireHook_), protocolReactorFactory_);
                     if constexpr (std::is_convertible_v<
                         Env *
                         , HeartbeatAndAlertComponent *
@@ -197,6 +178,7 @@ namespace dev { namespace cd606 { namespace tm { namespace transport { namespace
                     if (env_) {
                         TM_INFRA_EXPORTER_TRACER(env_);
                         std::string s = basic::bytedata_utils::RunSerializer<T>::apply(data.timedData.value.content);
+                        TransportMetricsSendScope metricsScope(metrics_.get(), s.length());
                         publisher_({std::move(data.timedData.value.topic), std::move(s)});
                     }
                 }
@@ -224,7 +206,7 @@ namespace dev { namespace cd606 { namespace tm { namespace transport { namespace
                         }).detach();
                     }
                 }
-                , hook
+                , latencyStampedIncomingHook(env, "websocket", locator, hook)
             );
             return ret->get_future();
         }
@@ -262,7 +244,7 @@ namespace dev { namespace cd606 { namespace tm { namespace transport { namespace
                         }
                     }
                 }
-                , DefaultHookFactory<Env>::template supplyIncomingHook<T>(env, hook)
+                , latencyStampedIncomingHook(env, "websocket", locator, DefaultHookFactory<Env>::template supplyIncomingHook<T>(env, hook))
             );
             return ret->get_future();
         }
@@ -59,6 +59,11 @@ namespace dev { namespace cd606 { namespace tm { namespace transport { namespace
                     if (!client_) {
                         env_ = input.environment;
                         if (hookPair_ && hookPair_->userToWire) {
+                            auto initialMessage = byte_data_hook_utils::tryUserToWireHook(hookPair_->userToWire->hook, std::move(input.timedData.value));
+                            if (!initialMessage) {
+                                //the next input tries to subscribe again
+                                return;
+                            }
                             client_ = env_->websocket_addSubscriptionClient(
                                 locator_
                                 , topic_
@@ -67,7 +72,7 @@ namespace dev { namespace cd606 { namespace tm { namespace transport { namespace
                                     this->publish(M::template pureInnerData<basic::ByteDataWithTopic>(env_, std::move(d)));
                                 }
                                 , (hookPair_?hookPair_->wireToUser:std::nullopt)
-                                , hookPair_->userToWire->hook(std::move(input.timedData.value))
+                                , std::move(*initialMessage)
                                 , protocolReactor_
                             );
                         } else {
@@ -139,6 +144,11 @@ namespace dev { namespace cd606 { namespace tm { namespace transport { namespace
                         }
                         auto initialData = basic::bytedata_utils::RunSerializer<A>::apply(std::move(input.timedData.value));
                         if (userToWire) {
+                            auto initialMessage = byte_data_hook_utils::tryUserToWireHook(userToWire->hook, basic::ByteData {std::move(initialData)});
+                            if (!initialMessage) {
+                                //the next input tries to subscribe again
+                                return;
+                            }
                             client_ = env_->websocket_addSubscriptionClient(
                                 locator_
                                 , topic_
@@ -151,7 +161,7 @@ namespace dev { namespace cd606 { namespace tm { namespace transport { namespace
                                     }
                                 }
                                 , wireToUser
-                                , userToWire->hook(std::move(initialData))
+                                , std::move(*initialMessage)
                                 , protocolReactor_
                             );
                         } else {